@@ -0,0 +1,1140 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_AES_GCM_X86 1
+#endif
+
+#include "ConstantTime.hpp"
+#include "CpuFeatures.hpp"
+#include "Key.hpp"
+#include "KeyBinding.hpp"
+#include "Zeroize.hpp"
+
+namespace Pique
+{
+
+/**
+ * AES-GCM authenticated encryption as specified in NIST SP 800-38D, with
+ * 128, 192 or 256 bit keys and 128 bit tags.
+ *
+ * seal() and open() make a single pass over the message: each group of
+ * counter blocks is encrypted while the previous group of ciphertext is
+ * folded into GHASH, so the AES and carry-less multiply units work side by
+ * side. The kernel is chosen by CpuFeatures: sixteen blocks at a time in
+ * AVX-512 registers with VAES and VPCLMULQDQ, eight at a time with AES-NI and
+ * PCLMULQDQ, or a portable kernel without table lookups, which encrypts four
+ * blocks at a time with a bitsliced AES and multiplies in GF(2^128) with
+ * masked integer multiplication, so that no path leaks the key or the data
+ * through its timing. GHASH aggregates its reductions over all the blocks of
+ * a group with precomputed powers of the hash key.
+ *
+ * The round keys and hash key powers are bound to the key material of the
+ * Key they were expanded from. Once every Key sharing that material has been
+ * cleared, set or destroyed, the next call zeroizes them and fails, as with
+ * HMAC.
+ *
+ * The output may be the input, to encrypt or decrypt in place. A nonce must
+ * never be used twice with the same key.
+ *
+ * An instance is not safe for concurrent use; give each thread its own copy.
+ */
+class AESGCM final
+{
+public:
+	/**
+	 * Length of the recommended nonce, in bytes. Other lengths are hashed
+	 * into the initial counter block.
+	 */
+	static constexpr size_t NONCE_SIZE = 12;
+
+	/**
+	 * Length of the authentication tag, in bytes.
+	 */
+	static constexpr size_t TAG_SIZE = 16;
+
+	/**
+	 * Length of the longest message, in bytes: 2^32 - 2 blocks.
+	 */
+	static constexpr uint64_t MAXIMUM_MESSAGE_SIZE = ( ( uint64_t( 1 ) << 32 ) - 2 ) * 16;
+
+private:
+	static constexpr size_t BLOCK_SIZE = 16;
+	static constexpr uint32_t MAXIMUM_ROUNDS = 14;
+
+	/**
+	 * Number of powers of the hash key kept for aggregated reduction, one per
+	 * block of the widest kernel.
+	 */
+	static constexpr size_t HASH_KEY_POWERS = 16;
+
+	/**
+	 * The expanded key. A GF(2^128) element is held as the big endian 128 bit
+	 * integer of its block, low word first, so that it loads straight into an
+	 * SSE register. mHashKeyPowers[ index ] holds H^( HASH_KEY_POWERS - index ),
+	 * so the blocks of a group line up with their powers.
+	 */
+	struct alignas( 64 ) Schedule
+	{
+		uint64_t mHashKeyPowers[ HASH_KEY_POWERS ][ 2 ];
+		uint8_t mRoundKeys[ MAXIMUM_ROUNDS + 1 ][ BLOCK_SIZE ];
+		uint64_t mBitslicedRoundKeys[ MAXIMUM_ROUNDS + 1 ][ 8 ];
+		uint32_t mRounds;
+	};
+
+	typedef void ( *EncryptBlockFunction )( const Schedule& schedule, uint8_t* output, const uint8_t* input );
+	typedef void ( *GhashFunction )( const Schedule& schedule, uint64_t* hash, const uint8_t* blocks, uint64_t blockCount );
+	typedef void ( *CryptFunction )( const Schedule& schedule, uint8_t* output, const uint8_t* input, uint64_t blockCount,
+		uint8_t* counterBlock, uint64_t* hash );
+
+	KeyBinding mKeyBinding;
+	mutable Schedule mSchedule;
+
+	static uint64_t __loadBigEndian( const uint8_t* bytes )
+	{
+		uint64_t value = 0;
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			value = ( value << 8 ) | bytes[ index ];
+		}
+
+		return value;
+	}
+
+	static void __storeBigEndian( uint8_t* bytes, uint64_t value )
+	{
+		for ( size_t index( 8 ); index-- > 0; value >>= 8 )
+		{
+			bytes[ index ] = uint8_t( value );
+		}
+	}
+
+	/**
+	 * Increment the 32 bit big endian counter that ends {@param counterBlock}.
+	 */
+	static void __incrementCounter( uint8_t* counterBlock )
+	{
+		for ( size_t index( BLOCK_SIZE ); index-- > BLOCK_SIZE - 4; )
+		{
+			if ( 0 != ++counterBlock[ index ] )
+			{
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Transpose the 8x8 bit matrix whose rows are the bytes of {@param word}.
+	 */
+	static uint64_t __transposeBits( uint64_t word )
+	{
+		uint64_t swap = ( word ^ ( word >> 7 ) ) & 0x00AA00AA00AA00AAULL;
+		word ^= swap ^ ( swap << 7 );
+		swap = ( word ^ ( word >> 14 ) ) & 0x0000CCCC0000CCCCULL;
+		word ^= swap ^ ( swap << 14 );
+		swap = ( word ^ ( word >> 28 ) ) & 0x00000000F0F0F0F0ULL;
+		return word ^ swap ^ ( swap << 28 );
+	}
+
+	/**
+	 * Gather bit b of each of 64 bytes into planes[ b ], byte j at bit j, so
+	 * that four blocks go through the S-box circuit in one pass.
+	 */
+	static void __bitslice( uint64_t* planes, const uint8_t* bytes )
+	{
+		std::memset( planes, 0, 8 * sizeof( uint64_t ) );
+		for ( size_t word( -1 ); ++word < 8; )
+		{
+			uint64_t rows = 0;
+			std::memcpy( &rows, bytes + 8 * word, 8 );
+			rows = __transposeBits( rows );
+			for ( size_t plane( -1 ); ++plane < 8; )
+			{
+				planes[ plane ] |= ( ( rows >> ( 8 * plane ) ) & 0xFF ) << ( 8 * word );
+			}
+		}
+	}
+
+	static void __unbitslice( uint8_t* bytes, const uint64_t* planes )
+	{
+		for ( size_t word( -1 ); ++word < 8; )
+		{
+			uint64_t rows = 0;
+			for ( size_t plane( -1 ); ++plane < 8; )
+			{
+				rows |= ( ( planes[ plane ] >> ( 8 * word ) ) & 0xFF ) << ( 8 * plane );
+			}
+
+			rows = __transposeBits( rows );
+			std::memcpy( bytes + 8 * word, &rows, 8 );
+		}
+	}
+
+	/**
+	 * The AES S-box of every byte of the planes, by the 113 gate circuit of
+	 * Boyar and Peralta.
+	 */
+	static void __substituteBytes( uint64_t* planes )
+	{
+		const uint64_t x0 = planes[ 7 ], x1 = planes[ 6 ], x2 = planes[ 5 ], x3 = planes[ 4 ];
+		const uint64_t x4 = planes[ 3 ], x5 = planes[ 2 ], x6 = planes[ 1 ], x7 = planes[ 0 ];
+
+		// Top linear transformation.
+		const uint64_t y14 = x3 ^ x5, y13 = x0 ^ x6, y9 = x0 ^ x3, y8 = x0 ^ x5;
+		const uint64_t t0 = x1 ^ x2, y1 = t0 ^ x7, y4 = y1 ^ x3, y12 = y13 ^ y14;
+		const uint64_t y2 = y1 ^ x0, y5 = y1 ^ x6, y3 = y5 ^ y8, t1 = x4 ^ y12;
+		const uint64_t y15 = t1 ^ x5, y20 = t1 ^ x1, y6 = y15 ^ x7, y10 = y15 ^ t0;
+		const uint64_t y11 = y20 ^ y9, y7 = x7 ^ y11, y17 = y10 ^ y11, y19 = y10 ^ y8;
+		const uint64_t y16 = t0 ^ y11, y21 = y13 ^ y16, y18 = x0 ^ y16;
+
+		// Non-linear section.
+		const uint64_t t2 = y12 & y15, t3 = y3 & y6, t4 = t3 ^ t2, t5 = y4 & x7;
+		const uint64_t t6 = t5 ^ t2, t7 = y13 & y16, t8 = y5 & y1, t9 = t8 ^ t7;
+		const uint64_t t10 = y2 & y7, t11 = t10 ^ t7, t12 = y9 & y11, t13 = y14 & y17;
+		const uint64_t t14 = t13 ^ t12, t15 = y8 & y10, t16 = t15 ^ t12, t17 = t4 ^ t14;
+		const uint64_t t18 = t6 ^ t16, t19 = t9 ^ t14, t20 = t11 ^ t16, t21 = t17 ^ y20;
+		const uint64_t t22 = t18 ^ y19, t23 = t19 ^ y21, t24 = t20 ^ y18, t25 = t21 ^ t22;
+		const uint64_t t26 = t21 & t23, t27 = t24 ^ t26, t28 = t25 & t27, t29 = t28 ^ t22;
+		const uint64_t t30 = t23 ^ t24, t31 = t22 ^ t26, t32 = t31 & t30, t33 = t32 ^ t24;
+		const uint64_t t34 = t23 ^ t33, t35 = t27 ^ t33, t36 = t24 & t35, t37 = t36 ^ t34;
+		const uint64_t t38 = t27 ^ t36, t39 = t29 & t38, t40 = t25 ^ t39, t41 = t40 ^ t37;
+		const uint64_t t42 = t29 ^ t33, t43 = t29 ^ t40, t44 = t33 ^ t37, t45 = t42 ^ t41;
+		const uint64_t z0 = t44 & y15, z1 = t37 & y6, z2 = t33 & x7, z3 = t43 & y16;
+		const uint64_t z4 = t40 & y1, z5 = t29 & y7, z6 = t42 & y11, z7 = t45 & y17;
+		const uint64_t z8 = t41 & y10, z9 = t44 & y12, z10 = t37 & y3, z11 = t33 & y4;
+		const uint64_t z12 = t43 & y13, z13 = t40 & y5, z14 = t29 & y2, z15 = t42 & y9;
+		const uint64_t z16 = t45 & y14, z17 = t41 & y8;
+
+		// Bottom linear transformation.
+		const uint64_t t46 = z15 ^ z16, t47 = z10 ^ z11, t48 = z5 ^ z13, t49 = z9 ^ z10;
+		const uint64_t t50 = z2 ^ z12, t51 = z2 ^ z5, t52 = z7 ^ z8, t53 = z0 ^ z3;
+		const uint64_t t54 = z6 ^ z7, t55 = z16 ^ z17, t56 = z12 ^ t48, t57 = t50 ^ t53;
+		const uint64_t t58 = z4 ^ t46, t59 = z3 ^ t54, t60 = t46 ^ t57, t61 = z14 ^ t57;
+		const uint64_t t62 = t52 ^ t58, t63 = t49 ^ t58, t64 = z4 ^ t59, t65 = t61 ^ t62;
+		const uint64_t t66 = z1 ^ t63, t67 = t64 ^ t65;
+		const uint64_t s3 = t53 ^ t66;
+
+		planes[ 7 ] = t59 ^ t63;
+		planes[ 6 ] = t64 ^ ~s3;
+		planes[ 5 ] = t55 ^ ~t67;
+		planes[ 4 ] = s3;
+		planes[ 3 ] = t51 ^ t66;
+		planes[ 2 ] = t47 ^ t65;
+		planes[ 1 ] = t56 ^ ~t62;
+		planes[ 0 ] = t48 ^ ~t60;
+	}
+
+	/**
+	 * ShiftRows on one plane. Byte r + 4c of a block sits at bit r + 4c of its
+	 * 16 bit lane, so row r rotates right by 4r bits within the lane.
+	 */
+	static uint64_t __shiftRows( uint64_t plane )
+	{
+		return ( plane & 0x1111111111111111ULL )
+			| ( ( plane >> 4 ) & 0x0222022202220222ULL ) | ( ( plane << 12 ) & 0x2000200020002000ULL )
+			| ( ( plane >> 8 ) & 0x0044004400440044ULL ) | ( ( plane << 8 ) & 0x4400440044004400ULL )
+			| ( ( plane >> 12 ) & 0x0008000800080008ULL ) | ( ( plane << 4 ) & 0x8880888088808880ULL );
+	}
+
+	/**
+	 * Move row r + {@param count} of every column of one plane to row r.
+	 */
+	static uint64_t __rotateRows( uint64_t plane, unsigned count )
+	{
+		static constexpr uint64_t LOW_ROWS[ 4 ] = { 0, 0x7777777777777777ULL, 0x3333333333333333ULL, 0x1111111111111111ULL };
+		return ( ( plane >> count ) & LOW_ROWS[ count ] ) | ( ( plane << ( 4 - count ) ) & ~LOW_ROWS[ count ] );
+	}
+
+	static void __mixColumns( uint64_t* planes )
+	{
+		uint64_t rotated[ 8 ];
+		uint64_t sum[ 8 ];
+		for ( size_t plane( -1 ); ++plane < 8; )
+		{
+			rotated[ plane ] = __rotateRows( planes[ plane ], 1 );
+			sum[ plane ] = planes[ plane ] ^ rotated[ plane ];
+			planes[ plane ] = rotated[ plane ] ^ __rotateRows( planes[ plane ], 2 ) ^ __rotateRows( planes[ plane ], 3 );
+		}
+
+		// Add twice the sum of each byte and its successor in the column, reducing by 0x1B.
+		planes[ 0 ] ^= sum[ 7 ];
+		planes[ 1 ] ^= sum[ 0 ] ^ sum[ 7 ];
+		planes[ 2 ] ^= sum[ 1 ];
+		planes[ 3 ] ^= sum[ 2 ] ^ sum[ 7 ];
+		planes[ 4 ] ^= sum[ 3 ] ^ sum[ 7 ];
+		planes[ 5 ] ^= sum[ 4 ];
+		planes[ 6 ] ^= sum[ 5 ];
+		planes[ 7 ] ^= sum[ 6 ];
+	}
+
+	/**
+	 * Encrypt the four blocks of {@param input} into {@param output}.
+	 */
+	static void __encryptBlocksPortable( const Schedule& schedule, uint8_t* output, const uint8_t* input )
+	{
+		uint64_t planes[ 8 ];
+		__bitslice( planes, input );
+		for ( uint32_t round( 0 ); round <= schedule.mRounds; ++round )
+		{
+			if ( 0 != round )
+			{
+				__substituteBytes( planes );
+				for ( size_t plane( -1 ); ++plane < 8; )
+				{
+					planes[ plane ] = __shiftRows( planes[ plane ] );
+				}
+
+				if ( round != schedule.mRounds )
+				{
+					__mixColumns( planes );
+				}
+			}
+
+			for ( size_t plane( -1 ); ++plane < 8; )
+			{
+				planes[ plane ] ^= schedule.mBitslicedRoundKeys[ round ][ plane ];
+			}
+		}
+
+		__unbitslice( output, planes );
+		zeroize( planes, sizeof( planes ) );
+	}
+
+	static void __encryptBlockPortable( const Schedule& schedule, uint8_t* output, const uint8_t* input )
+	{
+		uint8_t blocks[ 4 * BLOCK_SIZE ] = { 0 };
+		std::memcpy( blocks, input, BLOCK_SIZE );
+		__encryptBlocksPortable( schedule, blocks, blocks );
+		std::memcpy( output, blocks, BLOCK_SIZE );
+		zeroize( blocks, sizeof( blocks ) );
+	}
+
+	/**
+	 * Carry-less multiply of 32 bit words by integer multiplication. The bits
+	 * of each operand are split four ways, so that every column of a product
+	 * sums at most eight bits and its carries never reach the next bit kept.
+	 */
+	static uint64_t __carrylessMultiply32( uint32_t left, uint32_t right )
+	{
+		const uint64_t left0 = left & 0x11111111u, left1 = left & 0x22222222u;
+		const uint64_t left2 = left & 0x44444444u, left3 = left & 0x88888888u;
+		const uint64_t right0 = right & 0x11111111u, right1 = right & 0x22222222u;
+		const uint64_t right2 = right & 0x44444444u, right3 = right & 0x88888888u;
+		const uint64_t product0 = ( left0 * right0 ) ^ ( left1 * right3 ) ^ ( left2 * right2 ) ^ ( left3 * right1 );
+		const uint64_t product1 = ( left0 * right1 ) ^ ( left1 * right0 ) ^ ( left2 * right3 ) ^ ( left3 * right2 );
+		const uint64_t product2 = ( left0 * right2 ) ^ ( left1 * right1 ) ^ ( left2 * right0 ) ^ ( left3 * right3 );
+		const uint64_t product3 = ( left0 * right3 ) ^ ( left1 * right2 ) ^ ( left2 * right1 ) ^ ( left3 * right0 );
+		return ( product0 & 0x1111111111111111ULL ) | ( product1 & 0x2222222222222222ULL )
+			| ( product2 & 0x4444444444444444ULL ) | ( product3 & 0x8888888888888888ULL );
+	}
+
+	/**
+	 * Carry-less multiply of 64 bit words, by Karatsuba over 32 bit halves.
+	 * The product is stored to {@param product}, low word first.
+	 */
+	static void __carrylessMultiply64( uint64_t* product, uint64_t left, uint64_t right )
+	{
+		const uint64_t low = __carrylessMultiply32( uint32_t( left ), uint32_t( right ) );
+		const uint64_t high = __carrylessMultiply32( uint32_t( left >> 32 ), uint32_t( right >> 32 ) );
+		const uint64_t middle = __carrylessMultiply32( uint32_t( left ^ ( left >> 32 ) ), uint32_t( right ^ ( right >> 32 ) ) ) ^ low ^ high;
+		product[ 0 ] = low ^ ( middle << 32 );
+		product[ 1 ] = high ^ ( middle >> 32 );
+	}
+
+	/**
+	 * Replace {@param hash} with its product by {@param hashKey} in GF(2^128).
+	 * The elements are bit reflected, so the 255 bit product is shifted left
+	 * by one and its low half folded into its high half by x^128 = x^7 + x^2 + x + 1.
+	 */
+	static void __multiplyPortable( uint64_t* hash, const uint64_t* hashKey )
+	{
+		uint64_t low[ 2 ], high[ 2 ], middle[ 2 ], cross[ 2 ];
+		__carrylessMultiply64( low, hash[ 0 ], hashKey[ 0 ] );
+		__carrylessMultiply64( high, hash[ 1 ], hashKey[ 1 ] );
+		__carrylessMultiply64( middle, hash[ 0 ], hashKey[ 1 ] );
+		__carrylessMultiply64( cross, hash[ 1 ], hashKey[ 0 ] );
+
+		uint64_t word0 = low[ 0 ];
+		uint64_t word1 = low[ 1 ] ^ middle[ 0 ] ^ cross[ 0 ];
+		uint64_t word2 = high[ 0 ] ^ middle[ 1 ] ^ cross[ 1 ];
+		uint64_t word3 = high[ 1 ];
+
+		word3 = ( word3 << 1 ) | ( word2 >> 63 );
+		word2 = ( word2 << 1 ) | ( word1 >> 63 );
+		word1 = ( word1 << 1 ) | ( word0 >> 63 );
+		word0 <<= 1;
+
+		word1 ^= ( word0 << 63 ) ^ ( word0 << 62 ) ^ ( word0 << 57 );
+		hash[ 0 ] = word2 ^ word0 ^ ( word0 >> 1 ) ^ ( word1 << 63 ) ^ ( word0 >> 2 ) ^ ( word1 << 62 ) ^ ( word0 >> 7 ) ^ ( word1 << 57 );
+		hash[ 1 ] = word3 ^ word1 ^ ( word1 >> 1 ) ^ ( word1 >> 2 ) ^ ( word1 >> 7 );
+	}
+
+	static void __ghashPortable( const Schedule& schedule, uint64_t* hash, const uint8_t* blocks, uint64_t blockCount )
+	{
+		for ( ; 0 < blockCount; --blockCount, blocks += BLOCK_SIZE )
+		{
+			hash[ 0 ] ^= __loadBigEndian( blocks + 8 );
+			hash[ 1 ] ^= __loadBigEndian( blocks );
+			__multiplyPortable( hash, schedule.mHashKeyPowers[ HASH_KEY_POWERS - 1 ] );
+		}
+	}
+
+	template < bool Encrypt >
+	static void __cryptPortable( const Schedule& schedule, uint8_t* output, const uint8_t* input, uint64_t blockCount,
+		uint8_t* counterBlock, uint64_t* hash )
+	{
+		uint8_t counterBlocks[ 4 * BLOCK_SIZE ];
+		uint8_t keyStream[ 4 * BLOCK_SIZE ];
+		std::memcpy( counterBlocks, counterBlock, BLOCK_SIZE );
+
+		while ( 0 < blockCount )
+		{
+			const uint64_t groupCount = std::min< uint64_t >( blockCount, 4 );
+			for ( size_t block( 0 ); ++block < 4; )
+			{
+				std::memcpy( counterBlocks + block * BLOCK_SIZE, counterBlocks + ( block - 1 ) * BLOCK_SIZE, BLOCK_SIZE );
+				__incrementCounter( counterBlocks + block * BLOCK_SIZE );
+			}
+
+			__encryptBlocksPortable( schedule, keyStream, counterBlocks );
+			for ( uint64_t block( -1 ); ++block < groupCount; input += BLOCK_SIZE, output += BLOCK_SIZE )
+			{
+				// Hash the ciphertext before it is overwritten when decrypting in place.
+				if ( not Encrypt )
+				{
+					__ghashPortable( schedule, hash, input, 1 );
+				}
+
+				for ( size_t index( -1 ); ++index < BLOCK_SIZE; )
+				{
+					output[ index ] = input[ index ] ^ keyStream[ block * BLOCK_SIZE + index ];
+				}
+
+				if ( Encrypt )
+				{
+					__ghashPortable( schedule, hash, output, 1 );
+				}
+			}
+
+			std::memcpy( counterBlocks, counterBlocks + ( groupCount - 1 ) * BLOCK_SIZE, BLOCK_SIZE );
+			__incrementCounter( counterBlocks );
+			blockCount -= groupCount;
+		}
+
+		std::memcpy( counterBlock, counterBlocks, BLOCK_SIZE );
+		zeroize( keyStream, sizeof( keyStream ) );
+	}
+
+#if defined( PIQUE_AES_GCM_X86 )
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static __m128i __reverseBytes( __m128i block )
+	{
+		return _mm_shuffle_epi8( block, _mm_set_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ) );
+	}
+
+	/**
+	 * Add the unreduced product of {@param element} and {@param hashKey} to
+	 * the low, middle and high accumulators.
+	 */
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static void __multiplyAccumulateAesNi( __m128i element, __m128i hashKey, __m128i& low, __m128i& middle, __m128i& high )
+	{
+		low = _mm_xor_si128( low, _mm_clmulepi64_si128( element, hashKey, 0x00 ) );
+		high = _mm_xor_si128( high, _mm_clmulepi64_si128( element, hashKey, 0x11 ) );
+		middle = _mm_xor_si128( middle, _mm_xor_si128(
+			_mm_clmulepi64_si128( element, hashKey, 0x01 ), _mm_clmulepi64_si128( element, hashKey, 0x10 ) ) );
+	}
+
+	/**
+	 * Reduce a sum of products, as __multiplyPortable() does.
+	 */
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static __m128i __reduceAesNi( __m128i low, __m128i middle, __m128i high )
+	{
+		low = _mm_xor_si128( low, _mm_slli_si128( middle, 8 ) );
+		high = _mm_xor_si128( high, _mm_srli_si128( middle, 8 ) );
+
+		const __m128i lowCarry = _mm_srli_epi64( low, 63 );
+		low = _mm_or_si128( _mm_slli_epi64( low, 1 ), _mm_slli_si128( lowCarry, 8 ) );
+		high = _mm_or_si128( _mm_or_si128( _mm_slli_epi64( high, 1 ), _mm_slli_si128( _mm_srli_epi64( high, 63 ), 8 ) ),
+			_mm_srli_si128( lowCarry, 8 ) );
+
+		const __m128i lowFold = _mm_xor_si128( _mm_xor_si128( _mm_slli_epi64( low, 63 ), _mm_slli_epi64( low, 62 ) ), _mm_slli_epi64( low, 57 ) );
+		low = _mm_xor_si128( low, _mm_slli_si128( lowFold, 8 ) );
+
+		const __m128i highFold = _mm_xor_si128( _mm_xor_si128( _mm_slli_epi64( low, 63 ), _mm_slli_epi64( low, 62 ) ), _mm_slli_epi64( low, 57 ) );
+		return _mm_xor_si128( _mm_xor_si128( high, low ), _mm_xor_si128(
+			_mm_xor_si128( _mm_srli_epi64( low, 1 ), _mm_srli_epi64( low, 2 ) ),
+			_mm_xor_si128( _mm_srli_epi64( low, 7 ), _mm_srli_si128( highFold, 8 ) ) ) );
+	}
+
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static __m128i __multiplyAesNi( __m128i element, __m128i hashKey )
+	{
+		__m128i low = _mm_setzero_si128(), middle = _mm_setzero_si128(), high = _mm_setzero_si128();
+		__multiplyAccumulateAesNi( element, hashKey, low, middle, high );
+		return __reduceAesNi( low, middle, high );
+	}
+
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static __m128i __hashKeyPowerAesNi( const Schedule& schedule, size_t index )
+	{
+		return _mm_load_si128( reinterpret_cast< const __m128i* >( schedule.mHashKeyPowers[ index ] ) );
+	}
+
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static __m128i __encryptAesNi( const Schedule& schedule, __m128i block )
+	{
+		block = _mm_xor_si128( block, _mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ 0 ] ) ) );
+		for ( uint32_t round( 0 ); ++round < schedule.mRounds; )
+		{
+			block = _mm_aesenc_si128( block, _mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ round ] ) ) );
+		}
+
+		return _mm_aesenclast_si128( block,
+			_mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ schedule.mRounds ] ) ) );
+	}
+
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static void __encryptBlockAesNi( const Schedule& schedule, uint8_t* output, const uint8_t* input )
+	{
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( output ),
+			__encryptAesNi( schedule, _mm_loadu_si128( reinterpret_cast< const __m128i* >( input ) ) ) );
+	}
+
+	/**
+	 * Hash eight blocks at a time, with one reduction for the eight products.
+	 */
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static void __ghashAesNi( const Schedule& schedule, uint64_t* hash, const uint8_t* blocks, uint64_t blockCount )
+	{
+		__m128i accumulator = _mm_loadu_si128( reinterpret_cast< const __m128i* >( hash ) );
+		for ( ; 8 <= blockCount; blockCount -= 8, blocks += 8 * BLOCK_SIZE )
+		{
+			__m128i low = _mm_setzero_si128(), middle = _mm_setzero_si128(), high = _mm_setzero_si128();
+			for ( size_t block( -1 ); ++block < 8; )
+			{
+				__m128i element = __reverseBytes( _mm_loadu_si128( reinterpret_cast< const __m128i* >( blocks + block * BLOCK_SIZE ) ) );
+				element = ( 0 == block ) ? _mm_xor_si128( element, accumulator ) : element;
+				__multiplyAccumulateAesNi( element, __hashKeyPowerAesNi( schedule, HASH_KEY_POWERS - 8 + block ), low, middle, high );
+			}
+
+			accumulator = __reduceAesNi( low, middle, high );
+		}
+
+		for ( ; 0 < blockCount; --blockCount, blocks += BLOCK_SIZE )
+		{
+			accumulator = __multiplyAesNi( _mm_xor_si128( accumulator,
+				__reverseBytes( _mm_loadu_si128( reinterpret_cast< const __m128i* >( blocks ) ) ) ),
+				__hashKeyPowerAesNi( schedule, HASH_KEY_POWERS - 1 ) );
+		}
+
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( hash ), accumulator );
+	}
+
+	/**
+	 * Encrypt eight counter blocks at a time, multiplying one block of the
+	 * group being hashed after each of the first eight rounds. Decryption
+	 * hashes the ciphertext of the same group; encryption hashes the
+	 * ciphertext of the previous group, as its own is not known yet.
+	 */
+	template < bool Encrypt >
+	__attribute__(( target( "aes,pclmul,sse4.1" ) ))
+	static void __cryptAesNi( const Schedule& schedule, uint8_t* output, const uint8_t* input, uint64_t blockCount,
+		uint8_t* counterBlock, uint64_t* hash )
+	{
+		const __m128i one = _mm_set_epi32( 0, 0, 0, 1 );
+		const __m128i firstRoundKey = _mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ 0 ] ) );
+		const __m128i lastRoundKey = _mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ schedule.mRounds ] ) );
+		__m128i accumulator = _mm_loadu_si128( reinterpret_cast< const __m128i* >( hash ) );
+		__m128i counter = __reverseBytes( _mm_loadu_si128( reinterpret_cast< const __m128i* >( counterBlock ) ) );
+		__m128i hashBlocks[ 8 ] = {};
+		bool hashing = not Encrypt;
+
+		for ( ; 8 <= blockCount; blockCount -= 8, input += 8 * BLOCK_SIZE, output += 8 * BLOCK_SIZE )
+		{
+			__m128i blocks[ 8 ];
+			for ( size_t block( -1 ); ++block < 8; )
+			{
+				blocks[ block ] = _mm_xor_si128( __reverseBytes( counter ), firstRoundKey );
+				counter = _mm_add_epi32( counter, one );
+				if ( not Encrypt )
+				{
+					hashBlocks[ block ] = __reverseBytes( _mm_loadu_si128( reinterpret_cast< const __m128i* >( input + block * BLOCK_SIZE ) ) );
+				}
+			}
+
+			hashBlocks[ 0 ] = hashing ? _mm_xor_si128( hashBlocks[ 0 ], accumulator ) : hashBlocks[ 0 ];
+			__m128i low = _mm_setzero_si128(), middle = _mm_setzero_si128(), high = _mm_setzero_si128();
+			for ( uint32_t round( 0 ); ++round < schedule.mRounds; )
+			{
+				const __m128i roundKey = _mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ round ] ) );
+				for ( size_t block( -1 ); ++block < 8; )
+				{
+					blocks[ block ] = _mm_aesenc_si128( blocks[ block ], roundKey );
+				}
+
+				if ( hashing and ( round <= 8 ) )
+				{
+					__multiplyAccumulateAesNi( hashBlocks[ round - 1 ], __hashKeyPowerAesNi( schedule, HASH_KEY_POWERS - 9 + round ),
+						low, middle, high );
+				}
+			}
+
+			accumulator = hashing ? __reduceAesNi( low, middle, high ) : accumulator;
+			for ( size_t block( -1 ); ++block < 8; )
+			{
+				blocks[ block ] = _mm_xor_si128( _mm_aesenclast_si128( blocks[ block ], lastRoundKey ),
+					_mm_loadu_si128( reinterpret_cast< const __m128i* >( input + block * BLOCK_SIZE ) ) );
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( output + block * BLOCK_SIZE ), blocks[ block ] );
+				if ( Encrypt )
+				{
+					hashBlocks[ block ] = __reverseBytes( blocks[ block ] );
+				}
+			}
+
+			hashing = true;
+		}
+
+		if ( Encrypt and hashing )
+		{
+			hashBlocks[ 0 ] = _mm_xor_si128( hashBlocks[ 0 ], accumulator );
+			__m128i low = _mm_setzero_si128(), middle = _mm_setzero_si128(), high = _mm_setzero_si128();
+			for ( size_t block( -1 ); ++block < 8; )
+			{
+				__multiplyAccumulateAesNi( hashBlocks[ block ], __hashKeyPowerAesNi( schedule, HASH_KEY_POWERS - 8 + block ), low, middle, high );
+			}
+
+			accumulator = __reduceAesNi( low, middle, high );
+		}
+
+		const __m128i hashKey = __hashKeyPowerAesNi( schedule, HASH_KEY_POWERS - 1 );
+		for ( ; 0 < blockCount; --blockCount, input += BLOCK_SIZE, output += BLOCK_SIZE )
+		{
+			const __m128i keyStream = __encryptAesNi( schedule, __reverseBytes( counter ) );
+			const __m128i inputBlock = _mm_loadu_si128( reinterpret_cast< const __m128i* >( input ) );
+			const __m128i outputBlock = _mm_xor_si128( inputBlock, keyStream );
+			counter = _mm_add_epi32( counter, one );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( output ), outputBlock );
+			accumulator = __multiplyAesNi( _mm_xor_si128( accumulator, __reverseBytes( Encrypt ? outputBlock : inputBlock ) ), hashKey );
+		}
+
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( hash ), accumulator );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( counterBlock ), __reverseBytes( counter ) );
+	}
+
+	/**
+	 * Sum the four 128 bit lanes of {@param lanes}.
+	 */
+	__attribute__(( target( "aes,pclmul,sse4.1,avx512f,avx512bw,avx512vl,vaes,vpclmulqdq" ) ))
+	static __m128i __foldLanesVaes( __m512i lanes )
+	{
+		return _mm_xor_si128(
+			_mm_xor_si128( _mm512_extracti32x4_epi32( lanes, 0 ), _mm512_extracti32x4_epi32( lanes, 1 ) ),
+			_mm_xor_si128( _mm512_extracti32x4_epi32( lanes, 2 ), _mm512_extracti32x4_epi32( lanes, 3 ) ) );
+	}
+
+	__attribute__(( target( "aes,pclmul,sse4.1,avx512f,avx512bw,avx512vl,vaes,vpclmulqdq" ) ))
+	static void __multiplyAccumulateVaes( __m512i elements, __m512i hashKeys, __m512i& low, __m512i& middle, __m512i& high )
+	{
+		low = _mm512_xor_si512( low, _mm512_clmulepi64_epi128( elements, hashKeys, 0x00 ) );
+		high = _mm512_xor_si512( high, _mm512_clmulepi64_epi128( elements, hashKeys, 0x11 ) );
+		middle = _mm512_ternarylogic_epi64( middle,
+			_mm512_clmulepi64_epi128( elements, hashKeys, 0x01 ), _mm512_clmulepi64_epi128( elements, hashKeys, 0x10 ), 0x96 );
+	}
+
+	/**
+	 * Encrypt sixteen counter blocks at a time, four to a register, hashing
+	 * four blocks of the group after each of the first four rounds, as
+	 * __cryptAesNi() does with eight. The products accumulate lane by lane
+	 * and the lanes are summed once per group, before the reduction. The
+	 * last fifteen blocks or fewer are left to __cryptAesNi().
+	 */
+	template < bool Encrypt >
+	__attribute__(( target( "aes,pclmul,sse4.1,avx512f,avx512bw,avx512vl,vaes,vpclmulqdq" ) ))
+	static void __cryptVaes( const Schedule& schedule, uint8_t* output, const uint8_t* input, uint64_t blockCount,
+		uint8_t* counterBlock, uint64_t* hash )
+	{
+		if ( blockCount < 16 )
+		{
+			__cryptAesNi< Encrypt >( schedule, output, input, blockCount, counterBlock, hash );
+			return;
+		}
+
+		const __m512i reverse = _mm512_broadcast_i32x4( _mm_set_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ) );
+		const __m512i four = _mm512_broadcast_i32x4( _mm_set_epi32( 0, 0, 0, 4 ) );
+		__m512i roundKeys[ MAXIMUM_ROUNDS + 1 ];
+		for ( uint32_t round( -1 ); ++round <= schedule.mRounds; )
+		{
+			roundKeys[ round ] = _mm512_broadcast_i32x4( _mm_loadu_si128( reinterpret_cast< const __m128i* >( schedule.mRoundKeys[ round ] ) ) );
+		}
+
+		__m512i hashKeys[ 4 ];
+		for ( size_t lanes( -1 ); ++lanes < 4; )
+		{
+			hashKeys[ lanes ] = _mm512_load_si512( schedule.mHashKeyPowers[ 4 * lanes ] );
+		}
+
+		__m512i accumulator = _mm512_zextsi128_si512( _mm_loadu_si128( reinterpret_cast< const __m128i* >( hash ) ) );
+		__m512i counters = _mm512_add_epi32(
+			_mm512_shuffle_epi8( _mm512_broadcast_i32x4( _mm_loadu_si128( reinterpret_cast< const __m128i* >( counterBlock ) ) ), reverse ),
+			_mm512_set_epi32( 0, 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 0 ) );
+		__m512i hashBlocks[ 4 ] = {};
+		bool hashing = not Encrypt;
+
+		for ( ; 16 <= blockCount; blockCount -= 16, input += 16 * BLOCK_SIZE, output += 16 * BLOCK_SIZE )
+		{
+			__m512i blocks[ 4 ];
+			for ( size_t lanes( -1 ); ++lanes < 4; )
+			{
+				blocks[ lanes ] = _mm512_xor_si512( _mm512_shuffle_epi8( counters, reverse ), roundKeys[ 0 ] );
+				counters = _mm512_add_epi32( counters, four );
+				if ( not Encrypt )
+				{
+					hashBlocks[ lanes ] = _mm512_shuffle_epi8( _mm512_loadu_si512( input + 4 * lanes * BLOCK_SIZE ), reverse );
+				}
+			}
+
+			hashBlocks[ 0 ] = hashing ? _mm512_xor_si512( hashBlocks[ 0 ], accumulator ) : hashBlocks[ 0 ];
+			__m512i low = _mm512_setzero_si512(), middle = _mm512_setzero_si512(), high = _mm512_setzero_si512();
+			for ( uint32_t round( 0 ); ++round < schedule.mRounds; )
+			{
+				for ( size_t lanes( -1 ); ++lanes < 4; )
+				{
+					blocks[ lanes ] = _mm512_aesenc_epi128( blocks[ lanes ], roundKeys[ round ] );
+				}
+
+				if ( hashing and ( round <= 4 ) )
+				{
+					__multiplyAccumulateVaes( hashBlocks[ round - 1 ], hashKeys[ round - 1 ], low, middle, high );
+				}
+			}
+
+			if ( hashing )
+			{
+				accumulator = _mm512_zextsi128_si512( __reduceAesNi( __foldLanesVaes( low ), __foldLanesVaes( middle ), __foldLanesVaes( high ) ) );
+			}
+
+			for ( size_t lanes( -1 ); ++lanes < 4; )
+			{
+				blocks[ lanes ] = _mm512_xor_si512( _mm512_aesenclast_epi128( blocks[ lanes ], roundKeys[ schedule.mRounds ] ),
+					_mm512_loadu_si512( input + 4 * lanes * BLOCK_SIZE ) );
+				_mm512_storeu_si512( output + 4 * lanes * BLOCK_SIZE, blocks[ lanes ] );
+				if ( Encrypt )
+				{
+					hashBlocks[ lanes ] = _mm512_shuffle_epi8( blocks[ lanes ], reverse );
+				}
+			}
+
+			hashing = true;
+		}
+
+		if ( Encrypt )
+		{
+			hashBlocks[ 0 ] = _mm512_xor_si512( hashBlocks[ 0 ], accumulator );
+			__m512i low = _mm512_setzero_si512(), middle = _mm512_setzero_si512(), high = _mm512_setzero_si512();
+			for ( size_t lanes( -1 ); ++lanes < 4; )
+			{
+				__multiplyAccumulateVaes( hashBlocks[ lanes ], hashKeys[ lanes ], low, middle, high );
+			}
+
+			accumulator = _mm512_zextsi128_si512( __reduceAesNi( __foldLanesVaes( low ), __foldLanesVaes( middle ), __foldLanesVaes( high ) ) );
+		}
+
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( hash ), _mm512_castsi512_si128( accumulator ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( counterBlock ), __reverseBytes( _mm512_castsi512_si128( counters ) ) );
+		zeroize( roundKeys, sizeof( roundKeys ) );
+		__cryptAesNi< Encrypt >( schedule, output, input, blockCount, counterBlock, hash );
+	}
+#endif
+
+	/**
+	 * The kernels chosen for the enabled processor features.
+	 */
+	struct DispatchTable
+	{
+		std::atomic< EncryptBlockFunction > mEncryptBlock;
+		std::atomic< GhashFunction > mGhash;
+		std::atomic< CryptFunction > mSeal;
+		std::atomic< CryptFunction > mOpen;
+	};
+
+	static DispatchTable& __dispatchTable()
+	{
+		static DispatchTable dispatchTable;
+		return dispatchTable;
+	}
+
+	static void __selectKernels()
+	{
+		EncryptBlockFunction encryptBlock = __encryptBlockPortable;
+		GhashFunction ghash = __ghashPortable;
+		CryptFunction seal = __cryptPortable< true >;
+		CryptFunction open = __cryptPortable< false >;
+#if defined( PIQUE_AES_GCM_X86 )
+		if ( CpuFeatures::supports( CpuFeatures::AES | CpuFeatures::PCLMULQDQ | CpuFeatures::SSE4_1 ) )
+		{
+			encryptBlock = __encryptBlockAesNi;
+			ghash = __ghashAesNi;
+			seal = __cryptAesNi< true >;
+			open = __cryptAesNi< false >;
+		}
+
+		if ( CpuFeatures::supports( CpuFeatures::AES | CpuFeatures::PCLMULQDQ | CpuFeatures::SSE4_1 | CpuFeatures::VAES
+			| CpuFeatures::VPCLMULQDQ | CpuFeatures::AVX512F | CpuFeatures::AVX512BW | CpuFeatures::AVX512VL ) )
+		{
+			seal = __cryptVaes< true >;
+			open = __cryptVaes< false >;
+		}
+#endif
+		__dispatchTable().mEncryptBlock.store( encryptBlock, std::memory_order_relaxed );
+		__dispatchTable().mGhash.store( ghash, std::memory_order_relaxed );
+		__dispatchTable().mSeal.store( seal, std::memory_order_relaxed );
+		__dispatchTable().mOpen.store( open, std::memory_order_relaxed );
+	}
+
+	static const DispatchTable& __kernels()
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		return __dispatchTable();
+	}
+
+	/**
+	 * Apply the S-box to the four bytes of {@param word}, through the same
+	 * circuit as the blocks.
+	 */
+	static void __substituteWord( uint8_t* word )
+	{
+		uint8_t bytes[ 4 * BLOCK_SIZE ] = { 0 };
+		uint64_t planes[ 8 ];
+		std::memcpy( bytes, word, 4 );
+		__bitslice( planes, bytes );
+		__substituteBytes( planes );
+		__unbitslice( bytes, planes );
+		std::memcpy( word, bytes, 4 );
+		zeroize( bytes, sizeof( bytes ) );
+		zeroize( planes, sizeof( planes ) );
+	}
+
+	/**
+	 * Expand {@param key} into the round keys, in both layouts, and the
+	 * powers of the hash key.
+	 */
+	static void __expandKey( Schedule& schedule, const uint8_t* key, size_t keyLength )
+	{
+		const size_t keyWords = keyLength / 4;
+		const size_t scheduleWords = 4 * ( keyWords + 7 );
+		uint8_t* words = &schedule.mRoundKeys[ 0 ][ 0 ];
+		uint8_t roundConstant = 0x01;
+
+		schedule.mRounds = uint32_t( keyWords + 6 );
+		std::memcpy( words, key, keyLength );
+		for ( size_t word( keyWords - 1 ); ++word < scheduleWords; )
+		{
+			uint8_t temporary[ 4 ];
+			std::memcpy( temporary, words + 4 * ( word - 1 ), 4 );
+			if ( 0 == word % keyWords )
+			{
+				const uint8_t first = temporary[ 0 ];
+				temporary[ 0 ] = temporary[ 1 ];
+				temporary[ 1 ] = temporary[ 2 ];
+				temporary[ 2 ] = temporary[ 3 ];
+				temporary[ 3 ] = first;
+				__substituteWord( temporary );
+				temporary[ 0 ] ^= roundConstant;
+				roundConstant = uint8_t( ( roundConstant << 1 ) ^ ( ( roundConstant >> 7 ) * 0x1B ) );
+			}
+			else if ( ( 6 < keyWords ) and ( 4 == word % keyWords ) )
+			{
+				__substituteWord( temporary );
+			}
+
+			for ( size_t index( -1 ); ++index < 4; )
+			{
+				words[ 4 * word + index ] = words[ 4 * ( word - keyWords ) + index ] ^ temporary[ index ];
+			}
+
+			zeroize( temporary, sizeof( temporary ) );
+		}
+
+		uint8_t roundKeys[ 4 * BLOCK_SIZE ];
+		for ( uint32_t round( -1 ); ++round <= schedule.mRounds; )
+		{
+			for ( size_t block( -1 ); ++block < 4; )
+			{
+				std::memcpy( roundKeys + block * BLOCK_SIZE, schedule.mRoundKeys[ round ], BLOCK_SIZE );
+			}
+
+			__bitslice( schedule.mBitslicedRoundKeys[ round ], roundKeys );
+		}
+
+		zeroize( roundKeys, sizeof( roundKeys ) );
+
+		// H = E( 0^128 ), then H^2 to H^16 below it.
+		uint8_t hashKey[ BLOCK_SIZE ] = { 0 };
+		__kernels().mEncryptBlock.load( std::memory_order_relaxed )( schedule, hashKey, hashKey );
+		uint64_t* power = schedule.mHashKeyPowers[ HASH_KEY_POWERS - 1 ];
+		power[ 0 ] = __loadBigEndian( hashKey + 8 );
+		power[ 1 ] = __loadBigEndian( hashKey );
+		zeroize( hashKey, sizeof( hashKey ) );
+
+		for ( size_t index( HASH_KEY_POWERS - 1 ); index-- > 0; )
+		{
+			std::memcpy( schedule.mHashKeyPowers[ index ], schedule.mHashKeyPowers[ index + 1 ], sizeof( schedule.mHashKeyPowers[ index ] ) );
+			__multiplyPortable( schedule.mHashKeyPowers[ index ], power );
+		}
+	}
+
+	bool __isKeyed() const
+	{
+		return mKeyBinding.isBound( [ this ]() { __clearSchedule(); } );
+	}
+
+	void __clearSchedule() const
+	{
+		zeroize( &mSchedule, sizeof( mSchedule ) );
+	}
+
+	/**
+	 * Hash {@param length} bytes, the last block padded with zeros.
+	 */
+	void __ghashPadded( const DispatchTable& kernels, uint64_t* hash, const uint8_t* bytes, uint64_t length ) const
+	{
+		kernels.mGhash.load( std::memory_order_relaxed )( mSchedule, hash, bytes, length / BLOCK_SIZE );
+		if ( 0 != length % BLOCK_SIZE )
+		{
+			uint8_t block[ BLOCK_SIZE ] = { 0 };
+			std::memcpy( block, bytes + length - length % BLOCK_SIZE, length % BLOCK_SIZE );
+			kernels.mGhash.load( std::memory_order_relaxed )( mSchedule, hash, block, 1 );
+			zeroize( block, sizeof( block ) );
+		}
+	}
+
+	/**
+	 * Encrypt or decrypt {@param input} into {@param output} and compute the
+	 * tag over the associated data and the ciphertext.
+	 * @return True is returned if the arguments are valid and a key is set, else false.
+	 */
+	template < bool Encrypt >
+	bool __crypt( uint8_t* output, uint8_t* tag, const uint8_t* input, uint64_t length, const uint8_t* nonce, size_t nonceLength,
+		const uint8_t* associatedData, uint64_t associatedDataLength ) const
+	{
+		if ( ( not __isKeyed() ) or ( 0 == nonceLength ) or ( nullptr == nonce ) or ( MAXIMUM_MESSAGE_SIZE < length )
+			or ( ( 0 != length ) and ( ( nullptr == input ) or ( nullptr == output ) ) )
+			or ( ( uint64_t( -1 ) >> 3 ) < associatedDataLength ) or ( ( 0 != associatedDataLength ) and ( nullptr == associatedData ) ) )
+		{
+			return false;
+		}
+
+		const DispatchTable& kernels = __kernels();
+		uint8_t counterBlock[ BLOCK_SIZE ] = { 0 };
+		uint64_t hash[ 2 ] = { 0, 0 };
+		if ( NONCE_SIZE == nonceLength )
+		{
+			std::memcpy( counterBlock, nonce, NONCE_SIZE );
+			counterBlock[ BLOCK_SIZE - 1 ] = 1;
+		}
+		else
+		{
+			uint8_t lengths[ BLOCK_SIZE ] = { 0 };
+			__storeBigEndian( lengths + 8, uint64_t( nonceLength ) * 8 );
+			__ghashPadded( kernels, hash, nonce, nonceLength );
+			kernels.mGhash.load( std::memory_order_relaxed )( mSchedule, hash, lengths, 1 );
+			__storeBigEndian( counterBlock, hash[ 1 ] );
+			__storeBigEndian( counterBlock + 8, hash[ 0 ] );
+			hash[ 0 ] = hash[ 1 ] = 0;
+		}
+
+		uint8_t tagMask[ BLOCK_SIZE ];
+		kernels.mEncryptBlock.load( std::memory_order_relaxed )( mSchedule, tagMask, counterBlock );
+		__incrementCounter( counterBlock );
+		__ghashPadded( kernels, hash, associatedData, associatedDataLength );
+
+		const uint64_t blockCount = length / BLOCK_SIZE;
+		( Encrypt ? kernels.mSeal : kernels.mOpen ).load( std::memory_order_relaxed )(
+			mSchedule, output, input, blockCount, counterBlock, hash );
+
+		const size_t remainder = size_t( length % BLOCK_SIZE );
+		if ( 0 != remainder )
+		{
+			uint8_t keyStream[ BLOCK_SIZE ];
+			uint8_t block[ BLOCK_SIZE ] = { 0 };
+			input += blockCount * BLOCK_SIZE;
+			output += blockCount * BLOCK_SIZE;
+			kernels.mEncryptBlock.load( std::memory_order_relaxed )( mSchedule, keyStream, counterBlock );
+			for ( size_t index( -1 ); ++index < remainder; )
+			{
+				const uint8_t outputByte = input[ index ] ^ keyStream[ index ];
+				block[ index ] = Encrypt ? outputByte : input[ index ];
+				output[ index ] = outputByte;
+			}
+
+			kernels.mGhash.load( std::memory_order_relaxed )( mSchedule, hash, block, 1 );
+			zeroize( keyStream, sizeof( keyStream ) );
+			zeroize( block, sizeof( block ) );
+		}
+
+		uint8_t lengths[ BLOCK_SIZE ];
+		__storeBigEndian( lengths, associatedDataLength * 8 );
+		__storeBigEndian( lengths + 8, length * 8 );
+		kernels.mGhash.load( std::memory_order_relaxed )( mSchedule, hash, lengths, 1 );
+
+		__storeBigEndian( tag, hash[ 1 ] );
+		__storeBigEndian( tag + 8, hash[ 0 ] );
+		for ( size_t index( -1 ); ++index < TAG_SIZE; )
+		{
+			tag[ index ] ^= tagMask[ index ];
+		}
+
+		zeroize( tagMask, sizeof( tagMask ) );
+		zeroize( hash, sizeof( hash ) );
+		return true;
+	}
+
+public:
+	/**
+	 * Default construct an AESGCM without a key.
+	 */
+	AESGCM()
+	{
+		__clearSchedule();
+	}
+
+	/**
+	 * Construct an AESGCM and expand {@param key}.
+	 * @param key Constant reference to the Key to encrypt with.
+	 */
+	explicit AESGCM( const Key& key ) :
+		AESGCM()
+	{
+		setKey( key );
+	}
+
+	/**
+	 * Copy constructor. The copy is bound to the same key material.
+	 * @param other Constant reference to the AESGCM object to copy.
+	 */
+	AESGCM( const AESGCM& other ) = default;
+
+	/**
+	 * Copy assignment operator. This instance is bound to the key material of {@param other}.
+	 * @param other Constant reference to the AESGCM object to copy.
+	 * @return Reference to this AESGCM instance is returned.
+	 */
+	AESGCM& operator=( const AESGCM& other ) = default;
+
+	/**
+	 * AESGCM destructor. The schedule is zeroized.
+	 */
+	~AESGCM()
+	{
+		__clearSchedule();
+	}
+
+	/**
+	 * Expand {@param key}, discarding any previous key.
+	 * @param key Constant reference to the Key to encrypt with, of 16, 24 or 32 bytes.
+	 * @return True if {@param key} has a valid length, else false is returned
+	 *     and this instance is left without a key.
+	 */
+	bool setKey( const Key& key )
+	{
+		__clearSchedule();
+		return mKeyBinding.bind( key, [ this ]( const uint8_t* buffer, size_t length )
+			{
+				if ( ( 16 != length ) and ( 24 != length ) and ( 32 != length ) )
+				{
+					return false;
+				}
+
+				__expandKey( mSchedule, buffer, length );
+				return true;
+			} );
+	}
+
+	/**
+	 * Zeroize the schedule and unbind this instance from its key.
+	 */
+	void clear()
+	{
+		__clearSchedule();
+		mKeyBinding.reset();
+	}
+
+	/**
+	 * Cast this AESGCM instance to a boolean value.
+	 * If a key is set and its material has not been discarded, then True is returned, else False.
+	 */
+	explicit operator bool() const
+	{
+		return __isKeyed();
+	}
+
+	/**
+	 * Encrypt and authenticate a message.
+	 * @param ciphertext Pointer to receive {@param length} bytes of ciphertext; may be {@param plaintext}.
+	 * @param tag Reference to receive the authentication tag.
+	 * @param plaintext Pointer to an array of {@param length} const bytes.
+	 * @param length Length of the message in bytes, at most MAXIMUM_MESSAGE_SIZE.
+	 * @param nonce Pointer to the nonce, unique for this key.
+	 * @param nonceLength Length of the nonce in bytes, preferably NONCE_SIZE.
+	 * @param associatedData Pointer to an array of const bytes to authenticate but not encrypt.
+	 * @param associatedDataLength Length of the associated data in bytes.
+	 * @return True if the message was sealed, else false is returned as no key
+	 *     is set or an argument is invalid, and nothing is written.
+	 */
+	bool seal( uint8_t* ciphertext, uint8_t ( &tag )[ TAG_SIZE ], const uint8_t* plaintext, uint64_t length,
+		const uint8_t* nonce, size_t nonceLength, const uint8_t* associatedData = nullptr, uint64_t associatedDataLength = 0 ) const
+	{
+		return __crypt< true >( ciphertext, tag, plaintext, length, nonce, nonceLength, associatedData, associatedDataLength );
+	}
+
+	/**
+	 * Verify and decrypt a message. The plaintext is written as the
+	 * ciphertext is authenticated, and zeroized if the tag does not match, so
+	 * in place the ciphertext is lost on failure.
+	 * @param plaintext Pointer to receive {@param length} bytes of plaintext; may be {@param ciphertext}.
+	 * @param ciphertext Pointer to an array of {@param length} const bytes.
+	 * @param length Length of the message in bytes, at most MAXIMUM_MESSAGE_SIZE.
+	 * @param tag Constant reference to the authentication tag to verify.
+	 * @param nonce Pointer to the nonce the message was sealed with.
+	 * @param nonceLength Length of the nonce in bytes.
+	 * @param associatedData Pointer to the associated data the message was sealed with.
+	 * @param associatedDataLength Length of the associated data in bytes.
+	 * @return True if the message is authentic, else false is returned and
+	 *     the plaintext is zeroized, or not written if no key is set or an
+	 *     argument is invalid.
+	 */
+	bool open( uint8_t* plaintext, const uint8_t* ciphertext, uint64_t length, const uint8_t ( &tag )[ TAG_SIZE ],
+		const uint8_t* nonce, size_t nonceLength, const uint8_t* associatedData = nullptr, uint64_t associatedDataLength = 0 ) const
+	{
+		uint8_t expectedTag[ TAG_SIZE ];
+		if ( not __crypt< false >( plaintext, expectedTag, ciphertext, length, nonce, nonceLength, associatedData, associatedDataLength ) )
+		{
+			return false;
+		}
+
+		const bool authentic = ConstantTime::equal( expectedTag, tag, TAG_SIZE );
+		if ( not authentic and ( 0 != length ) )
+		{
+			zeroize( plaintext, size_t( length ) );
+		}
+
+		zeroize( expectedTag, sizeof( expectedTag ) );
+		return authentic;
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,217 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "HashFunction.hpp"
+
+namespace Pique
+{
+
+/**
+ * A type erased holder of any HashFunction, for code that chooses the hash at
+ * runtime. Every call goes through one virtual dispatch, so prefer the concrete
+ * hash type on hot paths.
+ */
+class AnyHashFunction final
+{
+private:
+	class Concept
+	{
+	public:
+		virtual ~Concept() = default;
+		virtual std::unique_ptr< Concept > clone() const = 0;
+		virtual uint64_t digest( uint8_t* messageDigest, uint64_t digestSize ) const = 0;
+		virtual void update( const uint8_t* message, uint64_t messageLength ) = 0;
+		virtual void update( const MessageSegment* segments, uint64_t segmentCount ) = 0;
+#if defined( PIQUE_HASH_FUNCTION_IOVEC )
+		virtual void update( const struct iovec* segments, uint64_t segmentCount ) = 0;
+#endif
+		virtual void reset() = 0;
+	};
+
+	template < typename Hash >
+	class Model final : public Concept
+	{
+	private:
+		Hash mHash;
+
+	public:
+		explicit Model( const Hash& hash ) :
+			mHash( hash )
+		{
+		}
+
+		std::unique_ptr< Concept > clone() const override
+		{
+			return std::unique_ptr< Concept >( new Model( mHash ) );
+		}
+
+		uint64_t digest( uint8_t* messageDigest, uint64_t digestSize ) const override
+		{
+			if constexpr ( Hash::UNLIMITED_DIGEST_SIZE == Hash::DIGEST_SIZE )
+			{
+				mHash.digest( messageDigest, digestSize );
+				return digestSize;
+			}
+			else
+			{
+				uint8_t fullDigest[ Hash::DIGEST_SIZE ];
+				uint64_t length = std::min( digestSize, Hash::DIGEST_SIZE );
+				mHash.digest( fullDigest );
+				std::memcpy( messageDigest, fullDigest, length );
+				return length;
+			}
+		}
+
+		void update( const uint8_t* message, uint64_t messageLength ) override
+		{
+			mHash.update( message, messageLength );
+		}
+
+		void update( const MessageSegment* segments, uint64_t segmentCount ) override
+		{
+			mHash.update( segments, segmentCount );
+		}
+
+#if defined( PIQUE_HASH_FUNCTION_IOVEC )
+		void update( const struct iovec* segments, uint64_t segmentCount ) override
+		{
+			mHash.update( segments, segmentCount );
+		}
+#endif
+
+		void reset() override
+		{
+			mHash.reset();
+		}
+	};
+
+	std::unique_ptr< Concept > mHash;
+	uint64_t mBlockSize;
+	uint64_t mDigestSize;
+
+public:
+	/**
+	 * Wrap a copy of {@param hash}, including any message it has already absorbed.
+	 * @param hash Constant reference to the hash to wrap.
+	 */
+	template < typename Hash, typename = typename std::enable_if< not std::is_same< Hash, AnyHashFunction >::value >::type >
+	explicit AnyHashFunction( const Hash& hash ) :
+		mHash( new Model< Hash >( hash ) ),
+		mBlockSize( Hash::BLOCK_SIZE ),
+		mDigestSize( Hash::DIGEST_SIZE )
+	{
+	}
+
+	/**
+	 * Copy constructor. The wrapped hash, and its state, is duplicated.
+	 * @param other Constant reference to the AnyHashFunction object to copy.
+	 */
+	AnyHashFunction( const AnyHashFunction& other ) :
+		mHash( other.mHash->clone() ),
+		mBlockSize( other.mBlockSize ),
+		mDigestSize( other.mDigestSize )
+	{
+	}
+
+	/**
+	 * Copy assignment operator. The wrapped hash, and its state, is duplicated.
+	 * @param other Constant reference to the AnyHashFunction object to copy.
+	 * @return Reference to this AnyHashFunction instance is returned.
+	 */
+	AnyHashFunction& operator=( const AnyHashFunction& other )
+	{
+		if ( this != &other )
+		{
+			mHash = other.mHash->clone();
+			mBlockSize = other.mBlockSize;
+			mDigestSize = other.mDigestSize;
+		}
+
+		return *this;
+	}
+
+	/**
+	 * Get the message block size of the wrapped hash, in bytes.
+	 * @return BLOCK_SIZE of the wrapped hash is returned.
+	 */
+	uint64_t blockSize() const
+	{
+		return mBlockSize;
+	}
+
+	/**
+	 * Get the digest size of the wrapped hash, in bytes.
+	 * @return DIGEST_SIZE of the wrapped hash is returned, zero for a user chosen length.
+	 */
+	uint64_t digestSize() const
+	{
+		return mDigestSize;
+	}
+
+	/**
+	 * Compute the digest of the message and output to {@param messageDigest}.
+	 * A fixed size digest is truncated to {@param digestSize} if that is shorter.
+	 * @param messageDigest Pointer to a byte array of at least {@param digestSize} bytes.
+	 * @param digestSize Requested length of the digest, in bytes.
+	 * @return The number of bytes written to {@param messageDigest} is returned.
+	 */
+	uint64_t digest( uint8_t* messageDigest, uint64_t digestSize ) const
+	{
+		return mHash->digest( messageDigest, digestSize );
+	}
+
+	/**
+	 * Incorporate the provided message segment into the hash computation.
+	 * @param message Pointer to an array of const bytes.
+	 * @param messageLength Length of the message in bytes.
+	 */
+	void update( const uint8_t* message, uint64_t messageLength )
+	{
+		mHash->update( message, messageLength );
+	}
+
+	/**
+	 * Incorporate the message segments, in order, into the hash computation.
+	 * The whole list costs a single virtual call.
+	 * @param segments Pointer to an array of message segments.
+	 * @param segmentCount Number of segments in {@param segments}.
+	 */
+	void update( const MessageSegment* segments, uint64_t segmentCount )
+	{
+		mHash->update( segments, segmentCount );
+	}
+
+#if defined( PIQUE_HASH_FUNCTION_IOVEC )
+	/**
+	 * Incorporate the buffers of a POSIX scatter/gather list, in order, into the
+	 * hash computation. The whole list costs a single virtual call.
+	 * @param segments Pointer to an array of iovec, as passed to readv().
+	 * @param segmentCount Number of segments in {@param segments}.
+	 */
+	void update( const struct iovec* segments, uint64_t segmentCount )
+	{
+		mHash->update( segments, segmentCount );
+	}
+#endif
+
+	/**
+	 * Reset the internal state of the hash function to the initial state.
+	 */
+	void reset()
+	{
+		mHash->reset();
+	}
+};
+
+} // namespace Pique
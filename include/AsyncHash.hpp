@@ -0,0 +1,464 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined( __cpp_impl_coroutine ) && defined( __has_include )
+#if __has_include( <coroutine> )
+#include <coroutine>
+#define PIQUE_ASYNC_HASH_COROUTINE 1
+#endif
+#endif
+
+/**
+ * Updates shorter than this many bytes run on the calling thread by default.
+ */
+#ifndef PIQUE_ASYNC_HASH_INLINE_THRESHOLD
+#define PIQUE_ASYNC_HASH_INLINE_THRESHOLD ( 16 * 1024 )
+#endif
+
+/**
+ * The default limit, in bytes, on the updates an AsyncHashPool hashes or has
+ * queued for its threads at once.
+ */
+#ifndef PIQUE_ASYNC_HASH_MAXIMUM_PENDING_BYTES
+#define PIQUE_ASYNC_HASH_MAXIMUM_PENDING_BYTES ( 64 * 1024 * 1024 )
+#endif
+
+namespace Pique
+{
+
+/**
+ * A bounded pool of threads that runs the large updates of AsyncHash, off the
+ * thread of an event loop.
+ *
+ * The pool admits updates while the bytes they hold in its queue and on its
+ * threads stay within a limit; an update beyond the limit waits, in order of
+ * arrival, until earlier ones finish. An update longer than the limit is
+ * admitted alone. As the completion of an update is not called until it has
+ * been hashed, a stream that awaits each update before reading the next
+ * buffer is held back, and the memory of every stream together stays bounded.
+ */
+class AsyncHashPool final
+{
+public:
+	static constexpr uint64_t DEFAULT_MAXIMUM_PENDING_BYTES = PIQUE_ASYNC_HASH_MAXIMUM_PENDING_BYTES;
+
+private:
+	/**
+	 * A run of the operations of one hasher, of which the first costs mCost bytes.
+	 */
+	struct Job
+	{
+		void ( *mRun )( void* context );
+		void* mContext;
+		uint64_t mCost;
+	};
+
+	const uint64_t mMaximumPendingBytes;
+	mutable std::mutex mMutex;
+	std::condition_variable mJobQueued;
+	std::deque< Job > mJobs;
+	std::deque< Job > mWaitingJobs;
+	uint64_t mPendingBytes;
+	bool mStopping;
+	std::vector< std::thread > mThreads;
+
+	/**
+	 * Admit waiting jobs, oldest first, while they fit the limit. The caller
+	 * holds the mutex.
+	 */
+	void __admit()
+	{
+		while ( ( not mWaitingJobs.empty() )
+			and ( ( 0 == mPendingBytes ) or ( ( mPendingBytes <= mMaximumPendingBytes )
+				and ( mWaitingJobs.front().mCost <= mMaximumPendingBytes - mPendingBytes ) ) ) )
+		{
+			mPendingBytes += mWaitingJobs.front().mCost;
+			mJobs.push_back( mWaitingJobs.front() );
+			mWaitingJobs.pop_front();
+			mJobQueued.notify_one();
+		}
+	}
+
+	void __work()
+	{
+		std::unique_lock< std::mutex > lock( mMutex );
+		while ( true )
+		{
+			mJobQueued.wait( lock, [ this ]() { return mStopping or not mJobs.empty(); } );
+			if ( mJobs.empty() )
+			{
+				return;
+			}
+
+			Job job = mJobs.front();
+			mJobs.pop_front();
+			lock.unlock();
+
+			job.mRun( job.mContext );
+
+			lock.lock();
+			mPendingBytes -= job.mCost;
+			__admit();
+		}
+	}
+
+	/**
+	 * Queue {@param job} for a thread, or behind the waiting jobs if it does
+	 * not fit the limit.
+	 */
+	void __submit( const Job& job )
+	{
+		std::lock_guard< std::mutex > lock( mMutex );
+		mWaitingJobs.push_back( job );
+		__admit();
+	}
+
+	template < typename Hash >
+	friend class AsyncHash;
+
+public:
+	/**
+	 * Start a pool.
+	 * @param threadCount The number of threads to start, at least one.
+	 * @param maximumPendingBytes The limit on the bytes of the updates queued
+	 *     or being hashed at once.
+	 */
+	explicit AsyncHashPool( size_t threadCount, uint64_t maximumPendingBytes = DEFAULT_MAXIMUM_PENDING_BYTES ) :
+		mMaximumPendingBytes( maximumPendingBytes ),
+		mPendingBytes( 0 ),
+		mStopping( false )
+	{
+		threadCount = ( 0 == threadCount ) ? 1 : threadCount;
+		mThreads.reserve( threadCount );
+		for ( size_t index( -1 ); ++index < threadCount; )
+		{
+			mThreads.emplace_back( &AsyncHashPool::__work, this );
+		}
+	}
+
+	AsyncHashPool( const AsyncHashPool& ) = delete;
+	AsyncHashPool& operator=( const AsyncHashPool& ) = delete;
+
+	/**
+	 * Finish every queued update, then stop and join the threads. No update
+	 * may be started once destruction has begun.
+	 */
+	~AsyncHashPool()
+	{
+		{
+			std::lock_guard< std::mutex > lock( mMutex );
+			mStopping = true;
+		}
+
+		mJobQueued.notify_all();
+		for ( std::thread& thread : mThreads )
+		{
+			thread.join();
+		}
+	}
+
+	/**
+	 * Get the bytes of the updates admitted to the threads and not yet hashed.
+	 * @return The number of pending bytes is returned.
+	 */
+	uint64_t pendingBytes() const
+	{
+		std::lock_guard< std::mutex > lock( mMutex );
+		return mPendingBytes;
+	}
+};
+
+/**
+ * Drive a HashFunction from an event loop without hashing large messages on
+ * the loop's thread.
+ *
+ * update() and digest() queue an operation and return at once. Operations
+ * run one at a time, in the order they were started, and the completion of
+ * each is called once it is done. An update shorter than the inline threshold
+ * that finds nothing queued ahead of it runs on the calling thread, with its
+ * completion called before update() returns; a longer one is handed to the
+ * AsyncHashPool, which also runs whatever short operations queue behind it.
+ * Completions run on the thread that ran the operation, so a loop that is not
+ * thread safe should post them back to itself.
+ *
+ * The message of an update is not copied, and must stay valid until its
+ * completion is called. The hasher must outlive its operations; it may be
+ * destroyed from the completion of its last operation.
+ *
+ * With C++20 coroutines, co_await hasher.update( message, messageLength ) and
+ * co_await hasher.digest( messageDigest ) suspend until the operation is done,
+ * or not at all if it ran on the calling thread.
+ */
+template < typename Hash >
+class AsyncHash final
+{
+public:
+	static constexpr uint64_t DEFAULT_INLINE_THRESHOLD = PIQUE_ASYNC_HASH_INLINE_THRESHOLD;
+
+	/**
+	 * Called with the context passed along with it once an operation is done.
+	 */
+	typedef void ( *Completion )( void* context );
+
+private:
+	/**
+	 * An update of mMessage, or a digest to mMessageDigest if it is not null.
+	 */
+	struct Operation
+	{
+		const uint8_t* mMessage;
+		uint64_t mLength;
+		uint8_t* mMessageDigest;
+		Completion mCompletion;
+		void* mContext;
+	};
+
+	Hash mHash;
+	AsyncHashPool& mPool;
+	const uint64_t mInlineThreshold;
+	std::mutex mMutex;
+	std::deque< Operation > mOperations;
+	bool mRunning;
+
+	void __perform( const Operation& operation )
+	{
+		if ( nullptr == operation.mMessageDigest )
+		{
+			mHash.update( operation.mMessage, operation.mLength );
+		}
+		else if constexpr ( Hash::UNLIMITED_DIGEST_SIZE == Hash::DIGEST_SIZE )
+		{
+			mHash.digest( operation.mMessageDigest, operation.mLength );
+		}
+		else
+		{
+			mHash.digest( *reinterpret_cast< uint8_t ( * )[ Hash::DIGEST_SIZE ] >( operation.mMessageDigest ) );
+		}
+	}
+
+	/**
+	 * Run the queued operations, as the one thread that holds mRunning. A
+	 * long update that {@param admitted} does not cover is handed to the pool
+	 * along with the rest of the queue. Once the queue is empty mRunning is
+	 * released before the last completion is called, as it may destroy the
+	 * hasher.
+	 */
+	void __run( bool admitted )
+	{
+		std::unique_lock< std::mutex > lock( mMutex );
+		while ( true )
+		{
+			Operation operation = mOperations.front();
+			if ( ( nullptr == operation.mMessageDigest ) and ( mInlineThreshold <= operation.mLength ) and not admitted )
+			{
+				lock.unlock();
+				mPool.__submit( AsyncHashPool::Job { __runAdmitted, this, operation.mLength } );
+				return;
+			}
+
+			admitted = false;
+			lock.unlock();
+			__perform( operation );
+
+			lock.lock();
+			mOperations.pop_front();
+			if ( mOperations.empty() )
+			{
+				mRunning = false;
+				lock.unlock();
+				__complete( operation );
+				return;
+			}
+
+			lock.unlock();
+			__complete( operation );
+			lock.lock();
+		}
+	}
+
+	static void __complete( const Operation& operation )
+	{
+		if ( nullptr != operation.mCompletion )
+		{
+			operation.mCompletion( operation.mContext );
+		}
+	}
+
+	static void __runAdmitted( void* context )
+	{
+		static_cast< AsyncHash* >( context )->__run( true );
+	}
+
+	void __start( const Operation& operation )
+	{
+		{
+			std::lock_guard< std::mutex > lock( mMutex );
+			mOperations.push_back( operation );
+			if ( mRunning )
+			{
+				return;
+			}
+
+			mRunning = true;
+		}
+
+		__run( false );
+	}
+
+#if defined( PIQUE_ASYNC_HASH_COROUTINE )
+	/**
+	 * Suspends the awaiting coroutine until the operation is done, unless it
+	 * is done before the coroutine could be suspended.
+	 */
+	class Awaiter final
+	{
+	private:
+		static constexpr int STARTED = 0;
+		static constexpr int SUSPENDED = 1;
+		static constexpr int DONE = 2;
+
+		AsyncHash& mAsyncHash;
+		Operation mOperation;
+		std::coroutine_handle<> mHandle;
+		std::atomic< int > mState;
+
+		static void __complete( void* context )
+		{
+			Awaiter* awaiter = static_cast< Awaiter* >( context );
+			if ( SUSPENDED == awaiter->mState.exchange( DONE, std::memory_order_acq_rel ) )
+			{
+				awaiter->mHandle.resume();
+			}
+		}
+
+	public:
+		Awaiter( AsyncHash& asyncHash, const uint8_t* message, uint64_t length, uint8_t* messageDigest ) :
+			mAsyncHash( asyncHash ),
+			mOperation { message, length, messageDigest, __complete, this },
+			mState( STARTED )
+		{
+		}
+
+		bool await_ready() const
+		{
+			return false;
+		}
+
+		bool await_suspend( std::coroutine_handle<> handle )
+		{
+			mHandle = handle;
+			mAsyncHash.__start( mOperation );
+			int state = STARTED;
+			return mState.compare_exchange_strong( state, SUSPENDED, std::memory_order_acq_rel );
+		}
+
+		void await_resume() const
+		{
+		}
+	};
+#endif
+
+public:
+	/**
+	 * Construct a hasher that starts from {@param hash}.
+	 * @param pool Reference to the pool that runs long updates.
+	 * @param inlineThreshold Updates of fewer bytes run on the calling thread
+	 *     when nothing is queued ahead of them.
+	 * @param hash The hash to continue, such as a keyed or cloned one.
+	 */
+	explicit AsyncHash( AsyncHashPool& pool, uint64_t inlineThreshold = DEFAULT_INLINE_THRESHOLD, const Hash& hash = Hash() ) :
+		mHash( hash ),
+		mPool( pool ),
+		mInlineThreshold( inlineThreshold ),
+		mRunning( false )
+	{
+	}
+
+	AsyncHash( const AsyncHash& ) = delete;
+	AsyncHash& operator=( const AsyncHash& ) = delete;
+
+	/**
+	 * Incorporate the message into the hash computation after every
+	 * operation started before it, then call {@param completion}.
+	 * @param message Pointer to an array of const bytes, valid until the completion is called.
+	 * @param messageLength Length of the message in bytes.
+	 * @param completion Called as completion( {@param context} ) once the message is hashed, if not null.
+	 * @param context Passed to {@param completion}.
+	 */
+	void update( const uint8_t* message, uint64_t messageLength, Completion completion, void* context )
+	{
+		__start( Operation { message, ( nullptr == message ) ? 0 : messageLength, nullptr, completion, context } );
+	}
+
+	/**
+	 * Compute the digest of the message after every operation started before
+	 * it, then call {@param completion}. As with HashFunction::digest(), the
+	 * message may be extended afterwards.
+	 * @param messageDigest Pointer to DIGEST_SIZE bytes, valid until the completion is called.
+	 * @param completion Called as completion( {@param context} ) once the digest is written, if not null.
+	 * @param context Passed to {@param completion}.
+	 */
+	template < uint64_t Size = Hash::DIGEST_SIZE, typename std::enable_if< Hash::UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	void digest( uint8_t* messageDigest, Completion completion, void* context )
+	{
+		__start( Operation { nullptr, Size, messageDigest, completion, context } );
+	}
+
+	/**
+	 * Compute {@param digestSize} bytes of the digest of the message, as with
+	 * digest() of hashes with a fixed digest size.
+	 * @param messageDigest Pointer to {@param digestSize} bytes, valid until the completion is called.
+	 * @param digestSize Requested length of the digest, in bytes.
+	 * @param completion Called as completion( {@param context} ) once the digest is written, if not null.
+	 * @param context Passed to {@param completion}.
+	 */
+	template < uint64_t Size = Hash::DIGEST_SIZE, typename std::enable_if< Hash::UNLIMITED_DIGEST_SIZE == Size, int >::type = 0 >
+	void digest( uint8_t* messageDigest, uint64_t digestSize, Completion completion, void* context )
+	{
+		__start( Operation { nullptr, digestSize, messageDigest, completion, context } );
+	}
+
+#if defined( PIQUE_ASYNC_HASH_COROUTINE )
+	/**
+	 * Awaitable form of update(), for co_await.
+	 */
+	Awaiter update( const uint8_t* message, uint64_t messageLength )
+	{
+		return Awaiter( *this, message, ( nullptr == message ) ? 0 : messageLength, nullptr );
+	}
+
+	/**
+	 * Awaitable form of digest(), for co_await.
+	 */
+	template < uint64_t Size = Hash::DIGEST_SIZE, typename std::enable_if< Hash::UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	Awaiter digest( uint8_t* messageDigest )
+	{
+		return Awaiter( *this, nullptr, Size, messageDigest );
+	}
+
+	/**
+	 * Awaitable form of digest() for hashes without a fixed digest size, for co_await.
+	 */
+	template < uint64_t Size = Hash::DIGEST_SIZE, typename std::enable_if< Hash::UNLIMITED_DIGEST_SIZE == Size, int >::type = 0 >
+	Awaiter digest( uint8_t* messageDigest, uint64_t digestSize )
+	{
+		return Awaiter( *this, nullptr, digestSize, messageDigest );
+	}
+#endif
+};
+
+} // namespace Pique
@@ -0,0 +1,1558 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_BLAKE3_X86 1
+#endif
+
+#include "CpuFeatures.hpp"
+#include "HashFunction.hpp"
+#include "Instrumentation.hpp"
+#include "Key.hpp"
+#include "ThreadPool.hpp"
+#include "Zeroize.hpp"
+
+namespace Pique
+{
+
+/**
+ * BLAKE3, as specified by O'Connor, Aumasson, Neves and Wilcox-O'Hearn, with
+ * a digest of any length.
+ *
+ * The message is split into chunks of 1 KiB, the leaves of a binary tree.
+ * Whole subtrees of an update() are hashed straight from the caller's memory,
+ * up to sixteen chunks or parents at once across the AVX-512, AVX2 or SSE4.1
+ * lanes allowed by CpuFeatures, and the halves of a large subtree are hashed
+ * on different threads of a ThreadPool. The chaining values of complete
+ * subtrees wait on a stack until the next update shows where they belong, so
+ * any split of the message into updates gives the same digest.
+ *
+ * Besides plain hashing, setKey() selects the keyed hash mode, a MAC keyed
+ * with a Pique::Key, and setDeriveKeyContext() the key derivation mode, for
+ * which deriveKey() is the shorthand. reset() keeps the mode and its key.
+ */
+class BLAKE3 final : public HashFunction< BLAKE3, 64, 0 >
+{
+private:
+	friend class HashFunction< BLAKE3, 64, 0 >;
+
+	typedef void ( *CompressFunction )( uint32_t* output, const uint32_t* chainingValue, const uint8_t* block,
+		uint8_t blockLength, uint64_t counter, uint8_t flags );
+	typedef void ( *HashManyFunction )( const uint8_t* const* inputs, size_t inputCount, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues );
+
+	static constexpr uint32_t IV[ 8 ] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+	/**
+	 * The message word order of every round: the permutation of the
+	 * specification applied once more for each round.
+	 */
+	static constexpr uint8_t MESSAGE_SCHEDULE[ 7 ][ 16 ] = {
+		{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+		{ 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+		{ 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+		{ 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+		{ 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+		{ 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+		{ 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 } };
+
+	static constexpr uint8_t CHUNK_START = 1 << 0;
+	static constexpr uint8_t CHUNK_END = 1 << 1;
+	static constexpr uint8_t PARENT = 1 << 2;
+	static constexpr uint8_t ROOT = 1 << 3;
+	static constexpr uint8_t KEYED_HASH = 1 << 4;
+	static constexpr uint8_t DERIVE_KEY_CONTEXT = 1 << 5;
+	static constexpr uint8_t DERIVE_KEY_MATERIAL = 1 << 6;
+
+	static constexpr uint64_t CHUNK_SIZE = 1024;
+	static constexpr uint64_t CHAINING_VALUE_SIZE = 32;
+
+	/**
+	 * The height of the tree of the longest message, 2^64 bytes in chunks of
+	 * 2^10, which bounds the chaining value stack.
+	 */
+	static constexpr uint64_t MAXIMUM_DEPTH = 54;
+
+	/**
+	 * The most chunks or parents hashed by one call to a HashManyFunction.
+	 */
+	static constexpr uint64_t MAXIMUM_LANES = 16;
+
+	/**
+	 * The least length of a subtree whose halves are hashed on two threads,
+	 * so that queueing costs little next to hashing.
+	 */
+	static constexpr uint64_t PARALLEL_MINIMUM_SIZE = 512 * 1024;
+
+	/**
+	 * Leads a serialized state: "PQ", the algorithm and the format version.
+	 */
+	static constexpr uint32_t STATE_TAG = 0x50510501;
+
+	/**
+	 * The kernels chosen for the enabled processor features, and the number
+	 * of chunks the many-input kernel hashes at once.
+	 */
+	struct Kernels
+	{
+		CompressFunction mCompress;
+		HashManyFunction mHashMany;
+		uint64_t mDegree;
+	};
+
+	/**
+	 * The chunk being absorbed: the chaining value of its compressed blocks
+	 * and the last, possibly partial, block, compressed only once the chunk
+	 * is known not to end with it.
+	 */
+	struct ChunkState
+	{
+		uint32_t mChainingValue[ 8 ];
+		uint64_t mCounter;
+		alignas( 64 ) uint8_t mBlock[ BLOCK_SIZE ];
+		uint8_t mBlockLength;
+		uint8_t mBlocksCompressed;
+	};
+
+	/**
+	 * The inputs to the last compression of a node, from which either its
+	 * chaining value or, for the root, any length of output is produced.
+	 */
+	struct Output
+	{
+		uint32_t mChainingValue[ 8 ];
+		uint8_t mBlock[ BLOCK_SIZE ];
+		uint64_t mCounter;
+		uint8_t mBlockLength;
+		uint8_t mFlags;
+	};
+
+	uint32_t mKey[ 8 ];
+	uint8_t mFlags;
+	ThreadPool* mThreadPool;
+	ChunkState mChunk;
+	uint8_t mStack[ ( MAXIMUM_DEPTH + 1 ) * CHAINING_VALUE_SIZE ];
+	uint8_t mStackLength;
+
+	static constexpr uint32_t __rotateRight( uint32_t value, unsigned count )
+	{
+		return ( value >> count ) | ( value << ( 32 - count ) );
+	}
+
+	static constexpr uint32_t __loadLittleEndian( const uint8_t* bytes )
+	{
+		return ( uint32_t( bytes[ 0 ] ) << 0 ) | ( uint32_t( bytes[ 1 ] ) << 8 )
+			| ( uint32_t( bytes[ 2 ] ) << 16 ) | ( uint32_t( bytes[ 3 ] ) << 24 );
+	}
+
+	static constexpr void __storeLittleEndian( uint8_t* bytes, uint32_t value )
+	{
+		bytes[ 0 ] = uint8_t( value >> 0 );
+		bytes[ 1 ] = uint8_t( value >> 8 );
+		bytes[ 2 ] = uint8_t( value >> 16 );
+		bytes[ 3 ] = uint8_t( value >> 24 );
+	}
+
+	static void __loadKey( uint32_t* key, const uint8_t* bytes )
+	{
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			key[ index ] = __loadLittleEndian( bytes + 4 * index );
+		}
+	}
+
+	static uint64_t __roundDownToPowerOfTwo( uint64_t value )
+	{
+		return uint64_t( 1 ) << ( 63 - __builtin_clzll( value | 1 ) );
+	}
+
+	static constexpr void __quarterRound( uint32_t* state, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y )
+	{
+		state[ a ] = state[ a ] + state[ b ] + x;
+		state[ d ] = __rotateRight( state[ d ] ^ state[ a ], 16 );
+		state[ c ] = state[ c ] + state[ d ];
+		state[ b ] = __rotateRight( state[ b ] ^ state[ c ], 12 );
+		state[ a ] = state[ a ] + state[ b ] + y;
+		state[ d ] = __rotateRight( state[ d ] ^ state[ a ], 8 );
+		state[ c ] = state[ c ] + state[ d ];
+		state[ b ] = __rotateRight( state[ b ] ^ state[ c ], 7 );
+	}
+
+	/**
+	 * Compress one block and write all sixteen words of the result: the new
+	 * chaining value followed by the extended output of a root node.
+	 */
+	static constexpr void __compressPortable( uint32_t* output, const uint32_t* chainingValue, const uint8_t* block,
+		uint8_t blockLength, uint64_t counter, uint8_t flags )
+	{
+		uint32_t message[ 16 ] = { 0 };
+		for ( size_t index( -1 ); ++index < 16; )
+		{
+			message[ index ] = __loadLittleEndian( block + 4 * index );
+		}
+
+		uint32_t state[ 16 ] = {
+			chainingValue[ 0 ], chainingValue[ 1 ], chainingValue[ 2 ], chainingValue[ 3 ],
+			chainingValue[ 4 ], chainingValue[ 5 ], chainingValue[ 6 ], chainingValue[ 7 ],
+			IV[ 0 ], IV[ 1 ], IV[ 2 ], IV[ 3 ],
+			uint32_t( counter ), uint32_t( counter >> 32 ), blockLength, flags };
+
+		for ( size_t round( -1 ); ++round < 7; )
+		{
+			const uint8_t* schedule = MESSAGE_SCHEDULE[ round ];
+			__quarterRound( state, 0, 4, 8, 12, message[ schedule[ 0 ] ], message[ schedule[ 1 ] ] );
+			__quarterRound( state, 1, 5, 9, 13, message[ schedule[ 2 ] ], message[ schedule[ 3 ] ] );
+			__quarterRound( state, 2, 6, 10, 14, message[ schedule[ 4 ] ], message[ schedule[ 5 ] ] );
+			__quarterRound( state, 3, 7, 11, 15, message[ schedule[ 6 ] ], message[ schedule[ 7 ] ] );
+			__quarterRound( state, 0, 5, 10, 15, message[ schedule[ 8 ] ], message[ schedule[ 9 ] ] );
+			__quarterRound( state, 1, 6, 11, 12, message[ schedule[ 10 ] ], message[ schedule[ 11 ] ] );
+			__quarterRound( state, 2, 7, 8, 13, message[ schedule[ 12 ] ], message[ schedule[ 13 ] ] );
+			__quarterRound( state, 3, 4, 9, 14, message[ schedule[ 14 ] ], message[ schedule[ 15 ] ] );
+		}
+
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			output[ index ] = state[ index ] ^ state[ index + 8 ];
+			output[ index + 8 ] = state[ index + 8 ] ^ chainingValue[ index ];
+		}
+	}
+
+	/**
+	 * Write the chaining values of a kernel that keeps word i of lane l at
+	 * words[ i * lanes + l ], one lane after another.
+	 */
+	static void __storeLanes( uint8_t* chainingValues, const uint32_t* words, size_t lanes )
+	{
+		for ( size_t lane( -1 ); ++lane < lanes; )
+		{
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				__storeLittleEndian( chainingValues + lane * CHAINING_VALUE_SIZE + 4 * index, words[ index * lanes + lane ] );
+			}
+		}
+	}
+
+	/**
+	 * Hash {@param inputCount} inputs of {@param blockCount} blocks each, one
+	 * after the other, writing one chaining value per input. The first block
+	 * of each input adds {@param startFlags} and the last {@param endFlags};
+	 * the counter is that of the first input, and of every following input
+	 * too unless {@param incrementCounter} is set.
+	 */
+	static void __hashManyPortable( const uint8_t* const* inputs, size_t inputCount, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		for ( size_t input( -1 ); ++input < inputCount; )
+		{
+			uint32_t chainingValue[ 8 ];
+			std::memcpy( chainingValue, key, sizeof( chainingValue ) );
+			uint8_t blockFlags = flags | startFlags;
+			for ( size_t block( -1 ); ++block < blockCount; )
+			{
+				if ( block + 1 == blockCount )
+				{
+					blockFlags |= endFlags;
+				}
+
+				__compressInPlace( chainingValue, inputs[ input ] + block * BLOCK_SIZE, BLOCK_SIZE, counter, blockFlags );
+				blockFlags = flags;
+			}
+
+			__storeLanes( chainingValues + input * CHAINING_VALUE_SIZE, chainingValue, 1 );
+			counter += incrementCounter ? 1 : 0;
+		}
+	}
+
+#if defined( PIQUE_BLAKE3_X86 )
+	__attribute__(( target( "sse4.1" ) ))
+	static __m128i __rotateRightSse41( __m128i word, int count )
+	{
+		return _mm_or_si128( _mm_srli_epi32( word, count ), _mm_slli_epi32( word, 32 - count ) );
+	}
+
+	/**
+	 * The quarter round on four words at once, with the rotations by 16 and
+	 * 8 done as byte shuffles.
+	 */
+	__attribute__(( target( "sse4.1" ) ))
+	static void __quarterRoundSse41( __m128i& a, __m128i& b, __m128i& c, __m128i& d, __m128i x, __m128i y )
+	{
+		const __m128i rotate16 = _mm_set_epi8( 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2 );
+		const __m128i rotate8 = _mm_set_epi8( 12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1 );
+
+		a = _mm_add_epi32( _mm_add_epi32( a, b ), x );
+		d = _mm_shuffle_epi8( _mm_xor_si128( d, a ), rotate16 );
+		c = _mm_add_epi32( c, d );
+		b = __rotateRightSse41( _mm_xor_si128( b, c ), 12 );
+		a = _mm_add_epi32( _mm_add_epi32( a, b ), y );
+		d = _mm_shuffle_epi8( _mm_xor_si128( d, a ), rotate8 );
+		c = _mm_add_epi32( c, d );
+		b = __rotateRightSse41( _mm_xor_si128( b, c ), 7 );
+	}
+
+	/**
+	 * Compress one block with a row of the state per register: the column
+	 * step works on the rows as they are, and the diagonal step on rows
+	 * rotated so that each diagonal lines up in one lane. The message words
+	 * are kept in the order the steps take them, (s0 s2 s4 s6), (s1 s3 s5 s7),
+	 * (s8 s10 s12 s14) and (s9 s11 s13 s15) for the schedule s of the round,
+	 * and shuffled into the order of the next round in registers.
+	 */
+	__attribute__(( target( "sse4.1" ) ))
+	static void __compressSse41( uint32_t* output, const uint32_t* chainingValue, const uint8_t* block,
+		uint8_t blockLength, uint64_t counter, uint8_t flags )
+	{
+		const __m128i block0 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + 0 ) );
+		const __m128i block1 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + 16 ) );
+		const __m128i block2 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + 32 ) );
+		const __m128i block3 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + 48 ) );
+		__m128i message0 = _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( block0 ), _mm_castsi128_ps( block1 ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+		__m128i message1 = _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( block0 ), _mm_castsi128_ps( block1 ), _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+		__m128i message2 = _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( block2 ), _mm_castsi128_ps( block3 ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+		__m128i message3 = _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( block2 ), _mm_castsi128_ps( block3 ), _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+
+		const __m128i chainingValue0 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( chainingValue + 0 ) );
+		const __m128i chainingValue1 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( chainingValue + 4 ) );
+		__m128i row0 = chainingValue0;
+		__m128i row1 = chainingValue1;
+		__m128i row2 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( IV ) );
+		__m128i row3 = _mm_set_epi32( int( flags ), int( blockLength ), int( uint32_t( counter >> 32 ) ), int( uint32_t( counter ) ) );
+
+		for ( size_t round( 0 ); true; ++round )
+		{
+			__quarterRoundSse41( row0, row1, row2, row3, message0, message1 );
+			row1 = _mm_shuffle_epi32( row1, 0x39 );
+			row2 = _mm_shuffle_epi32( row2, 0x4E );
+			row3 = _mm_shuffle_epi32( row3, 0x93 );
+			__quarterRoundSse41( row0, row1, row2, row3, message2, message3 );
+			row1 = _mm_shuffle_epi32( row1, 0x93 );
+			row2 = _mm_shuffle_epi32( row2, 0x4E );
+			row3 = _mm_shuffle_epi32( row3, 0x39 );
+			if ( 6 == round )
+			{
+				break;
+			}
+
+			// Word i of the next round is word MESSAGE_SCHEDULE[ 1 ][ i ] of this one.
+			__m128i next0 = _mm_shuffle_epi32( _mm_castps_si128( _mm_shuffle_ps(
+				_mm_castsi128_ps( message0 ), _mm_castsi128_ps( message1 ), _MM_SHUFFLE( 3, 1, 2, 1 ) ) ), _MM_SHUFFLE( 1, 3, 2, 0 ) );
+			__m128i next1 = _mm_blend_epi16( _mm_shuffle_epi32( _mm_castps_si128( _mm_shuffle_ps(
+				_mm_castsi128_ps( message0 ), _mm_castsi128_ps( message3 ), _MM_SHUFFLE( 2, 2, 0, 3 ) ) ), _MM_SHUFFLE( 3, 1, 0, 0 ) ), message2, 0x0C );
+			__m128i next2 = _mm_blend_epi16( _mm_castps_si128( _mm_shuffle_ps(
+				_mm_castsi128_ps( message1 ), _mm_castsi128_ps( message3 ), _MM_SHUFFLE( 3, 0, 0, 0 ) ) ), _mm_shuffle_epi32( message2, 0xAA ), 0x0C );
+			__m128i next3 = _mm_blend_epi16( _mm_castps_si128( _mm_shuffle_ps(
+				_mm_castsi128_ps( message3 ), _mm_castsi128_ps( message2 ), _MM_SHUFFLE( 0, 3, 1, 1 ) ) ), _mm_shuffle_epi32( message1, 0xAA ), 0x0C );
+			message0 = next0;
+			message1 = next1;
+			message2 = next2;
+			message3 = next3;
+		}
+
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( output + 0 ), _mm_xor_si128( row0, row2 ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( output + 4 ), _mm_xor_si128( row1, row3 ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( output + 8 ), _mm_xor_si128( row2, chainingValue0 ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( output + 12 ), _mm_xor_si128( row3, chainingValue1 ) );
+	}
+
+	/**
+	 * One round on the transposed states of the lanes: word i of every lane
+	 * in state[ i ] and message word i of every lane in message[ i ].
+	 */
+	__attribute__(( target( "sse4.1" ) ))
+	static void __roundSse41( __m128i* state, const __m128i* message, const uint8_t* schedule )
+	{
+		__quarterRoundSse41( state[ 0 ], state[ 4 ], state[ 8 ], state[ 12 ], message[ schedule[ 0 ] ], message[ schedule[ 1 ] ] );
+		__quarterRoundSse41( state[ 1 ], state[ 5 ], state[ 9 ], state[ 13 ], message[ schedule[ 2 ] ], message[ schedule[ 3 ] ] );
+		__quarterRoundSse41( state[ 2 ], state[ 6 ], state[ 10 ], state[ 14 ], message[ schedule[ 4 ] ], message[ schedule[ 5 ] ] );
+		__quarterRoundSse41( state[ 3 ], state[ 7 ], state[ 11 ], state[ 15 ], message[ schedule[ 6 ] ], message[ schedule[ 7 ] ] );
+		__quarterRoundSse41( state[ 0 ], state[ 5 ], state[ 10 ], state[ 15 ], message[ schedule[ 8 ] ], message[ schedule[ 9 ] ] );
+		__quarterRoundSse41( state[ 1 ], state[ 6 ], state[ 11 ], state[ 12 ], message[ schedule[ 10 ] ], message[ schedule[ 11 ] ] );
+		__quarterRoundSse41( state[ 2 ], state[ 7 ], state[ 8 ], state[ 13 ], message[ schedule[ 12 ] ], message[ schedule[ 13 ] ] );
+		__quarterRoundSse41( state[ 3 ], state[ 4 ], state[ 9 ], state[ 14 ], message[ schedule[ 14 ] ], message[ schedule[ 15 ] ] );
+	}
+
+	/**
+	 * Transpose four rows of four words into four columns.
+	 */
+	__attribute__(( target( "sse4.1" ) ))
+	static void __transposeSse41( const __m128i* rows, __m128i* columns )
+	{
+		__m128i low01 = _mm_unpacklo_epi32( rows[ 0 ], rows[ 1 ] );
+		__m128i high01 = _mm_unpackhi_epi32( rows[ 0 ], rows[ 1 ] );
+		__m128i low23 = _mm_unpacklo_epi32( rows[ 2 ], rows[ 3 ] );
+		__m128i high23 = _mm_unpackhi_epi32( rows[ 2 ], rows[ 3 ] );
+		columns[ 0 ] = _mm_unpacklo_epi64( low01, low23 );
+		columns[ 1 ] = _mm_unpackhi_epi64( low01, low23 );
+		columns[ 2 ] = _mm_unpacklo_epi64( high01, high23 );
+		columns[ 3 ] = _mm_unpackhi_epi64( high01, high23 );
+	}
+
+	/**
+	 * Hash four inputs at once, one per 32-bit lane, as __hashManyPortable().
+	 */
+	__attribute__(( target( "sse4.1" ) ))
+	static void __hash4Sse41( const uint8_t* const* inputs, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		const size_t LANES = 4;
+		alignas( 16 ) uint32_t counterLow[ LANES ];
+		alignas( 16 ) uint32_t counterHigh[ LANES ];
+		for ( size_t lane( -1 ); ++lane < LANES; )
+		{
+			uint64_t laneCounter = counter + ( incrementCounter ? lane : 0 );
+			counterLow[ lane ] = uint32_t( laneCounter );
+			counterHigh[ lane ] = uint32_t( laneCounter >> 32 );
+		}
+
+		__m128i chainingValue[ 8 ];
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			chainingValue[ index ] = _mm_set1_epi32( int( key[ index ] ) );
+		}
+
+		uint8_t blockFlags = flags | startFlags;
+		for ( size_t block( -1 ); ++block < blockCount; )
+		{
+			if ( block + 1 == blockCount )
+			{
+				blockFlags |= endFlags;
+			}
+
+			__m128i message[ 16 ];
+			for ( size_t group( -1 ); ++group < 4; )
+			{
+				__m128i rows[ LANES ];
+				for ( size_t lane( -1 ); ++lane < LANES; )
+				{
+					rows[ lane ] = _mm_loadu_si128( reinterpret_cast< const __m128i* >( inputs[ lane ] + block * BLOCK_SIZE + 16 * group ) );
+				}
+
+				__transposeSse41( rows, message + 4 * group );
+			}
+
+			__m128i state[ 16 ] = {
+				chainingValue[ 0 ], chainingValue[ 1 ], chainingValue[ 2 ], chainingValue[ 3 ],
+				chainingValue[ 4 ], chainingValue[ 5 ], chainingValue[ 6 ], chainingValue[ 7 ],
+				_mm_set1_epi32( int( IV[ 0 ] ) ), _mm_set1_epi32( int( IV[ 1 ] ) ), _mm_set1_epi32( int( IV[ 2 ] ) ), _mm_set1_epi32( int( IV[ 3 ] ) ),
+				_mm_load_si128( reinterpret_cast< const __m128i* >( counterLow ) ),
+				_mm_load_si128( reinterpret_cast< const __m128i* >( counterHigh ) ),
+				_mm_set1_epi32( int( BLOCK_SIZE ) ), _mm_set1_epi32( blockFlags ) };
+
+			for ( size_t round( -1 ); ++round < 7; )
+			{
+				__roundSse41( state, message, MESSAGE_SCHEDULE[ round ] );
+			}
+
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				chainingValue[ index ] = _mm_xor_si128( state[ index ], state[ index + 8 ] );
+			}
+
+			blockFlags = flags;
+		}
+
+		alignas( 16 ) uint32_t words[ 8 * LANES ];
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			_mm_store_si128( reinterpret_cast< __m128i* >( words + index * LANES ), chainingValue[ index ] );
+		}
+
+		__storeLanes( chainingValues, words, LANES );
+	}
+
+	static void __hashManySse41( const uint8_t* const* inputs, size_t inputCount, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		for ( ; 4 <= inputCount; inputs += 4, inputCount -= 4, chainingValues += 4 * CHAINING_VALUE_SIZE )
+		{
+			__hash4Sse41( inputs, blockCount, key, counter, incrementCounter, flags, startFlags, endFlags, chainingValues );
+			counter += incrementCounter ? 4 : 0;
+		}
+
+		__hashManyPortable( inputs, inputCount, blockCount, key, counter, incrementCounter, flags, startFlags, endFlags, chainingValues );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __rotateRightAvx2( __m256i word, int count )
+	{
+		return _mm256_or_si256( _mm256_srli_epi32( word, count ), _mm256_slli_epi32( word, 32 - count ) );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static void __quarterRoundAvx2( __m256i& a, __m256i& b, __m256i& c, __m256i& d, __m256i x, __m256i y )
+	{
+		const __m256i rotate16 = _mm256_set_epi8(
+			13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+			13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2 );
+		const __m256i rotate8 = _mm256_set_epi8(
+			12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+			12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1 );
+
+		a = _mm256_add_epi32( _mm256_add_epi32( a, b ), x );
+		d = _mm256_shuffle_epi8( _mm256_xor_si256( d, a ), rotate16 );
+		c = _mm256_add_epi32( c, d );
+		b = __rotateRightAvx2( _mm256_xor_si256( b, c ), 12 );
+		a = _mm256_add_epi32( _mm256_add_epi32( a, b ), y );
+		d = _mm256_shuffle_epi8( _mm256_xor_si256( d, a ), rotate8 );
+		c = _mm256_add_epi32( c, d );
+		b = __rotateRightAvx2( _mm256_xor_si256( b, c ), 7 );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static void __roundAvx2( __m256i* state, const __m256i* message, const uint8_t* schedule )
+	{
+		__quarterRoundAvx2( state[ 0 ], state[ 4 ], state[ 8 ], state[ 12 ], message[ schedule[ 0 ] ], message[ schedule[ 1 ] ] );
+		__quarterRoundAvx2( state[ 1 ], state[ 5 ], state[ 9 ], state[ 13 ], message[ schedule[ 2 ] ], message[ schedule[ 3 ] ] );
+		__quarterRoundAvx2( state[ 2 ], state[ 6 ], state[ 10 ], state[ 14 ], message[ schedule[ 4 ] ], message[ schedule[ 5 ] ] );
+		__quarterRoundAvx2( state[ 3 ], state[ 7 ], state[ 11 ], state[ 15 ], message[ schedule[ 6 ] ], message[ schedule[ 7 ] ] );
+		__quarterRoundAvx2( state[ 0 ], state[ 5 ], state[ 10 ], state[ 15 ], message[ schedule[ 8 ] ], message[ schedule[ 9 ] ] );
+		__quarterRoundAvx2( state[ 1 ], state[ 6 ], state[ 11 ], state[ 12 ], message[ schedule[ 10 ] ], message[ schedule[ 11 ] ] );
+		__quarterRoundAvx2( state[ 2 ], state[ 7 ], state[ 8 ], state[ 13 ], message[ schedule[ 12 ] ], message[ schedule[ 13 ] ] );
+		__quarterRoundAvx2( state[ 3 ], state[ 4 ], state[ 9 ], state[ 14 ], message[ schedule[ 14 ] ], message[ schedule[ 15 ] ] );
+	}
+
+	/**
+	 * Transpose eight rows of eight words into eight columns.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __transposeAvx2( const __m256i* rows, __m256i* columns )
+	{
+		__m256i pairs[ 8 ];
+		for ( size_t index( 0 ); index < 8; index += 2 )
+		{
+			pairs[ index + 0 ] = _mm256_unpacklo_epi32( rows[ index ], rows[ index + 1 ] );
+			pairs[ index + 1 ] = _mm256_unpackhi_epi32( rows[ index ], rows[ index + 1 ] );
+		}
+
+		// quads[ j ] and quads[ 4 + j ] hold words j and 4 + j of rows 0 to 3 and 4 to 7, one per 128-bit half.
+		__m256i quads[ 8 ];
+		for ( size_t index( 0 ); index < 8; index += 4 )
+		{
+			quads[ index + 0 ] = _mm256_unpacklo_epi64( pairs[ index + 0 ], pairs[ index + 2 ] );
+			quads[ index + 1 ] = _mm256_unpackhi_epi64( pairs[ index + 0 ], pairs[ index + 2 ] );
+			quads[ index + 2 ] = _mm256_unpacklo_epi64( pairs[ index + 1 ], pairs[ index + 3 ] );
+			quads[ index + 3 ] = _mm256_unpackhi_epi64( pairs[ index + 1 ], pairs[ index + 3 ] );
+		}
+
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			columns[ index ] = _mm256_permute2x128_si256( quads[ index ], quads[ index + 4 ], 0x20 );
+			columns[ index + 4 ] = _mm256_permute2x128_si256( quads[ index ], quads[ index + 4 ], 0x31 );
+		}
+	}
+
+	/**
+	 * Hash eight inputs at once, one per 32-bit lane, as __hashManyPortable().
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __hash8Avx2( const uint8_t* const* inputs, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		const size_t LANES = 8;
+		alignas( 32 ) uint32_t counterLow[ LANES ];
+		alignas( 32 ) uint32_t counterHigh[ LANES ];
+		for ( size_t lane( -1 ); ++lane < LANES; )
+		{
+			uint64_t laneCounter = counter + ( incrementCounter ? lane : 0 );
+			counterLow[ lane ] = uint32_t( laneCounter );
+			counterHigh[ lane ] = uint32_t( laneCounter >> 32 );
+		}
+
+		__m256i chainingValue[ 8 ];
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			chainingValue[ index ] = _mm256_set1_epi32( int( key[ index ] ) );
+		}
+
+		uint8_t blockFlags = flags | startFlags;
+		for ( size_t block( -1 ); ++block < blockCount; )
+		{
+			if ( block + 1 == blockCount )
+			{
+				blockFlags |= endFlags;
+			}
+
+			__m256i message[ 16 ];
+			for ( size_t half( -1 ); ++half < 2; )
+			{
+				__m256i rows[ LANES ];
+				for ( size_t lane( -1 ); ++lane < LANES; )
+				{
+					rows[ lane ] = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( inputs[ lane ] + block * BLOCK_SIZE + 32 * half ) );
+				}
+
+				__transposeAvx2( rows, message + 8 * half );
+			}
+
+			__m256i state[ 16 ] = {
+				chainingValue[ 0 ], chainingValue[ 1 ], chainingValue[ 2 ], chainingValue[ 3 ],
+				chainingValue[ 4 ], chainingValue[ 5 ], chainingValue[ 6 ], chainingValue[ 7 ],
+				_mm256_set1_epi32( int( IV[ 0 ] ) ), _mm256_set1_epi32( int( IV[ 1 ] ) ), _mm256_set1_epi32( int( IV[ 2 ] ) ), _mm256_set1_epi32( int( IV[ 3 ] ) ),
+				_mm256_load_si256( reinterpret_cast< const __m256i* >( counterLow ) ),
+				_mm256_load_si256( reinterpret_cast< const __m256i* >( counterHigh ) ),
+				_mm256_set1_epi32( int( BLOCK_SIZE ) ), _mm256_set1_epi32( blockFlags ) };
+
+			for ( size_t round( -1 ); ++round < 7; )
+			{
+				__roundAvx2( state, message, MESSAGE_SCHEDULE[ round ] );
+			}
+
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				chainingValue[ index ] = _mm256_xor_si256( state[ index ], state[ index + 8 ] );
+			}
+
+			blockFlags = flags;
+		}
+
+		alignas( 32 ) uint32_t words[ 8 * LANES ];
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			_mm256_store_si256( reinterpret_cast< __m256i* >( words + index * LANES ), chainingValue[ index ] );
+		}
+
+		__storeLanes( chainingValues, words, LANES );
+	}
+
+	static void __hashManyAvx2( const uint8_t* const* inputs, size_t inputCount, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		for ( ; 8 <= inputCount; inputs += 8, inputCount -= 8, chainingValues += 8 * CHAINING_VALUE_SIZE )
+		{
+			__hash8Avx2( inputs, blockCount, key, counter, incrementCounter, flags, startFlags, endFlags, chainingValues );
+			counter += incrementCounter ? 8 : 0;
+		}
+
+		__hashManySse41( inputs, inputCount, blockCount, key, counter, incrementCounter, flags, startFlags, endFlags, chainingValues );
+	}
+
+	__attribute__(( target( "avx512f" ) ))
+	static void __quarterRoundAvx512( __m512i& a, __m512i& b, __m512i& c, __m512i& d, __m512i x, __m512i y )
+	{
+		a = _mm512_add_epi32( _mm512_add_epi32( a, b ), x );
+		d = _mm512_ror_epi32( _mm512_xor_si512( d, a ), 16 );
+		c = _mm512_add_epi32( c, d );
+		b = _mm512_ror_epi32( _mm512_xor_si512( b, c ), 12 );
+		a = _mm512_add_epi32( _mm512_add_epi32( a, b ), y );
+		d = _mm512_ror_epi32( _mm512_xor_si512( d, a ), 8 );
+		c = _mm512_add_epi32( c, d );
+		b = _mm512_ror_epi32( _mm512_xor_si512( b, c ), 7 );
+	}
+
+	__attribute__(( target( "avx512f" ) ))
+	static void __roundAvx512( __m512i* state, const __m512i* message, const uint8_t* schedule )
+	{
+		__quarterRoundAvx512( state[ 0 ], state[ 4 ], state[ 8 ], state[ 12 ], message[ schedule[ 0 ] ], message[ schedule[ 1 ] ] );
+		__quarterRoundAvx512( state[ 1 ], state[ 5 ], state[ 9 ], state[ 13 ], message[ schedule[ 2 ] ], message[ schedule[ 3 ] ] );
+		__quarterRoundAvx512( state[ 2 ], state[ 6 ], state[ 10 ], state[ 14 ], message[ schedule[ 4 ] ], message[ schedule[ 5 ] ] );
+		__quarterRoundAvx512( state[ 3 ], state[ 7 ], state[ 11 ], state[ 15 ], message[ schedule[ 6 ] ], message[ schedule[ 7 ] ] );
+		__quarterRoundAvx512( state[ 0 ], state[ 5 ], state[ 10 ], state[ 15 ], message[ schedule[ 8 ] ], message[ schedule[ 9 ] ] );
+		__quarterRoundAvx512( state[ 1 ], state[ 6 ], state[ 11 ], state[ 12 ], message[ schedule[ 10 ] ], message[ schedule[ 11 ] ] );
+		__quarterRoundAvx512( state[ 2 ], state[ 7 ], state[ 8 ], state[ 13 ], message[ schedule[ 12 ] ], message[ schedule[ 13 ] ] );
+		__quarterRoundAvx512( state[ 3 ], state[ 4 ], state[ 9 ], state[ 14 ], message[ schedule[ 14 ] ], message[ schedule[ 15 ] ] );
+	}
+
+	/**
+	 * Transpose sixteen rows of sixteen words into sixteen columns.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __transposeAvx512( const __m512i* rows, __m512i* columns )
+	{
+		__m512i pairs[ 16 ];
+		for ( size_t index( 0 ); index < 16; index += 2 )
+		{
+			pairs[ index + 0 ] = _mm512_unpacklo_epi32( rows[ index ], rows[ index + 1 ] );
+			pairs[ index + 1 ] = _mm512_unpackhi_epi32( rows[ index ], rows[ index + 1 ] );
+		}
+
+		// Lane k of quads[ 4 * r + j ] holds word 4 * k + j of rows 4 * r to 4 * r + 3.
+		__m512i quads[ 16 ];
+		for ( size_t index( 0 ); index < 16; index += 4 )
+		{
+			quads[ index + 0 ] = _mm512_unpacklo_epi64( pairs[ index + 0 ], pairs[ index + 2 ] );
+			quads[ index + 1 ] = _mm512_unpackhi_epi64( pairs[ index + 0 ], pairs[ index + 2 ] );
+			quads[ index + 2 ] = _mm512_unpacklo_epi64( pairs[ index + 1 ], pairs[ index + 3 ] );
+			quads[ index + 3 ] = _mm512_unpackhi_epi64( pairs[ index + 1 ], pairs[ index + 3 ] );
+		}
+
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			__m512i rows0To7Low = _mm512_shuffle_i32x4( quads[ index ], quads[ 4 + index ], 0x44 );
+			__m512i rows0To7High = _mm512_shuffle_i32x4( quads[ index ], quads[ 4 + index ], 0xEE );
+			__m512i rows8To15Low = _mm512_shuffle_i32x4( quads[ 8 + index ], quads[ 12 + index ], 0x44 );
+			__m512i rows8To15High = _mm512_shuffle_i32x4( quads[ 8 + index ], quads[ 12 + index ], 0xEE );
+			columns[ index + 0 ] = _mm512_shuffle_i32x4( rows0To7Low, rows8To15Low, 0x88 );
+			columns[ index + 4 ] = _mm512_shuffle_i32x4( rows0To7Low, rows8To15Low, 0xDD );
+			columns[ index + 8 ] = _mm512_shuffle_i32x4( rows0To7High, rows8To15High, 0x88 );
+			columns[ index + 12 ] = _mm512_shuffle_i32x4( rows0To7High, rows8To15High, 0xDD );
+		}
+	}
+
+	/**
+	 * Hash sixteen inputs at once, one per 32-bit lane, as __hashManyPortable().
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __hash16Avx512( const uint8_t* const* inputs, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		const size_t LANES = 16;
+		alignas( 64 ) uint32_t counterLow[ LANES ];
+		alignas( 64 ) uint32_t counterHigh[ LANES ];
+		for ( size_t lane( -1 ); ++lane < LANES; )
+		{
+			uint64_t laneCounter = counter + ( incrementCounter ? lane : 0 );
+			counterLow[ lane ] = uint32_t( laneCounter );
+			counterHigh[ lane ] = uint32_t( laneCounter >> 32 );
+		}
+
+		__m512i chainingValue[ 8 ];
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			chainingValue[ index ] = _mm512_set1_epi32( int( key[ index ] ) );
+		}
+
+		uint8_t blockFlags = flags | startFlags;
+		for ( size_t block( -1 ); ++block < blockCount; )
+		{
+			if ( block + 1 == blockCount )
+			{
+				blockFlags |= endFlags;
+			}
+
+			__m512i rows[ LANES ];
+			for ( size_t lane( -1 ); ++lane < LANES; )
+			{
+				rows[ lane ] = _mm512_loadu_si512( inputs[ lane ] + block * BLOCK_SIZE );
+			}
+
+			__m512i message[ 16 ];
+			__transposeAvx512( rows, message );
+
+			__m512i state[ 16 ] = {
+				chainingValue[ 0 ], chainingValue[ 1 ], chainingValue[ 2 ], chainingValue[ 3 ],
+				chainingValue[ 4 ], chainingValue[ 5 ], chainingValue[ 6 ], chainingValue[ 7 ],
+				_mm512_set1_epi32( int( IV[ 0 ] ) ), _mm512_set1_epi32( int( IV[ 1 ] ) ), _mm512_set1_epi32( int( IV[ 2 ] ) ), _mm512_set1_epi32( int( IV[ 3 ] ) ),
+				_mm512_load_si512( counterLow ), _mm512_load_si512( counterHigh ),
+				_mm512_set1_epi32( int( BLOCK_SIZE ) ), _mm512_set1_epi32( blockFlags ) };
+
+			for ( size_t round( -1 ); ++round < 7; )
+			{
+				__roundAvx512( state, message, MESSAGE_SCHEDULE[ round ] );
+			}
+
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				chainingValue[ index ] = _mm512_xor_si512( state[ index ], state[ index + 8 ] );
+			}
+
+			blockFlags = flags;
+		}
+
+		alignas( 64 ) uint32_t words[ 8 * LANES ];
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			_mm512_store_si512( words + index * LANES, chainingValue[ index ] );
+		}
+
+		__storeLanes( chainingValues, words, LANES );
+	}
+
+	static void __hashManyAvx512( const uint8_t* const* inputs, size_t inputCount, size_t blockCount, const uint32_t* key,
+		uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t startFlags, uint8_t endFlags, uint8_t* chainingValues )
+	{
+		for ( ; 16 <= inputCount; inputs += 16, inputCount -= 16, chainingValues += 16 * CHAINING_VALUE_SIZE )
+		{
+			__hash16Avx512( inputs, blockCount, key, counter, incrementCounter, flags, startFlags, endFlags, chainingValues );
+			counter += incrementCounter ? 16 : 0;
+		}
+
+		__hashManyAvx2( inputs, inputCount, blockCount, key, counter, incrementCounter, flags, startFlags, endFlags, chainingValues );
+	}
+#endif
+
+	struct DispatchTable
+	{
+		std::atomic< const Kernels* > mKernels;
+	};
+
+	static DispatchTable& __dispatchTable()
+	{
+		static DispatchTable dispatchTable;
+		return dispatchTable;
+	}
+
+	static void __selectKernels()
+	{
+		static const Kernels PORTABLE_KERNELS = { __compressPortable, __hashManyPortable, 1 };
+		const Kernels* kernels = &PORTABLE_KERNELS;
+#if defined( PIQUE_BLAKE3_X86 )
+		static const Kernels SSE41_KERNELS = { __compressSse41, __hashManySse41, 4 };
+		static const Kernels AVX2_KERNELS = { __compressSse41, __hashManyAvx2, 8 };
+		static const Kernels AVX512_KERNELS = { __compressSse41, __hashManyAvx512, 16 };
+
+		// Each many-input kernel hands the inputs left over to the next narrower one.
+		if ( CpuFeatures::supports( CpuFeatures::SSSE3 | CpuFeatures::SSE4_1 ) )
+		{
+			kernels = &SSE41_KERNELS;
+			if ( CpuFeatures::supports( CpuFeatures::AVX2 ) )
+			{
+				kernels = &AVX2_KERNELS;
+				if ( CpuFeatures::supports( CpuFeatures::AVX512F ) )
+				{
+					kernels = &AVX512_KERNELS;
+				}
+			}
+		}
+#endif
+		__dispatchTable().mKernels.store( kernels, std::memory_order_relaxed );
+	}
+
+	/**
+	 * Get the kernels chosen for the enabled processor features. Reading them
+	 * through one pointer keeps the many-input kernel and its degree in step.
+	 */
+	static const Kernels& __kernels()
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		return *__dispatchTable().mKernels.load( std::memory_order_relaxed );
+	}
+
+	static void __compress( uint32_t* output, const uint32_t* chainingValue, const uint8_t* block,
+		uint8_t blockLength, uint64_t counter, uint8_t flags )
+	{
+		Instrumentation::count( Instrumentation::HASH_BLOCKS_COMPRESSED );
+		__kernels().mCompress( output, chainingValue, block, blockLength, counter, flags );
+	}
+
+	static void __compressInPlace( uint32_t* chainingValue, const uint8_t* block, uint8_t blockLength, uint64_t counter, uint8_t flags )
+	{
+		uint32_t output[ 16 ];
+		__compress( output, chainingValue, block, blockLength, counter, flags );
+		std::memcpy( chainingValue, output, 8 * sizeof( uint32_t ) );
+	}
+
+	static void __outputChainingValue( const Output& output, uint8_t* chainingValue )
+	{
+		uint32_t words[ 16 ];
+		__compress( words, output.mChainingValue, output.mBlock, output.mBlockLength, output.mCounter, output.mFlags );
+		__storeLanes( chainingValue, words, 1 );
+	}
+
+	/**
+	 * Write {@param length} bytes of the output of the root node, one
+	 * compression for every 64 bytes.
+	 */
+	static void __outputRootBytes( const Output& output, uint8_t* bytes, uint64_t length )
+	{
+		uint32_t words[ 16 ];
+		uint8_t block[ BLOCK_SIZE ];
+		for ( uint64_t counter( 0 ); 0 != length; ++counter )
+		{
+			__compress( words, output.mChainingValue, output.mBlock, output.mBlockLength, counter, output.mFlags | ROOT );
+			for ( size_t index( -1 ); ++index < 16; )
+			{
+				__storeLittleEndian( block + 4 * index, words[ index ] );
+			}
+
+			uint64_t take = std::min( length, BLOCK_SIZE );
+			std::memcpy( bytes, block, take );
+			bytes += take;
+			length -= take;
+		}
+	}
+
+	static Output __parentOutput( const uint8_t* children, const uint32_t* key, uint8_t flags )
+	{
+		Output output;
+		std::memcpy( output.mChainingValue, key, sizeof( output.mChainingValue ) );
+		std::memcpy( output.mBlock, children, BLOCK_SIZE );
+		output.mCounter = 0;
+		output.mBlockLength = BLOCK_SIZE;
+		output.mFlags = flags | PARENT;
+		return output;
+	}
+
+	static void __chunkReset( ChunkState& chunk, const uint32_t* key, uint64_t counter )
+	{
+		std::memcpy( chunk.mChainingValue, key, sizeof( chunk.mChainingValue ) );
+		chunk.mCounter = counter;
+		std::memset( chunk.mBlock, 0, BLOCK_SIZE );
+		chunk.mBlockLength = 0;
+		chunk.mBlocksCompressed = 0;
+	}
+
+	static uint64_t __chunkLength( const ChunkState& chunk )
+	{
+		return BLOCK_SIZE * chunk.mBlocksCompressed + chunk.mBlockLength;
+	}
+
+	static uint8_t __chunkStartFlag( const ChunkState& chunk )
+	{
+		return ( 0 == chunk.mBlocksCompressed ) ? CHUNK_START : 0;
+	}
+
+	/**
+	 * Absorb at most the rest of the chunk. The last block stays buffered,
+	 * as it is compressed with CHUNK_END if nothing follows it.
+	 */
+	static void __chunkUpdate( ChunkState& chunk, uint8_t flags, const uint8_t* input, uint64_t inputLength )
+	{
+		if ( 0 != chunk.mBlockLength )
+		{
+			uint64_t take = std::min( BLOCK_SIZE - chunk.mBlockLength, inputLength );
+			std::memcpy( chunk.mBlock + chunk.mBlockLength, input, take );
+			chunk.mBlockLength += uint8_t( take );
+			input += take;
+			inputLength -= take;
+			if ( 0 == inputLength )
+			{
+				return;
+			}
+
+			__compressInPlace( chunk.mChainingValue, chunk.mBlock, BLOCK_SIZE, chunk.mCounter, flags | __chunkStartFlag( chunk ) );
+			++chunk.mBlocksCompressed;
+			std::memset( chunk.mBlock, 0, BLOCK_SIZE );
+			chunk.mBlockLength = 0;
+		}
+
+		for ( ; BLOCK_SIZE < inputLength; input += BLOCK_SIZE, inputLength -= BLOCK_SIZE )
+		{
+			__compressInPlace( chunk.mChainingValue, input, BLOCK_SIZE, chunk.mCounter, flags | __chunkStartFlag( chunk ) );
+			++chunk.mBlocksCompressed;
+		}
+
+		std::memcpy( chunk.mBlock, input, inputLength );
+		chunk.mBlockLength = uint8_t( inputLength );
+	}
+
+	static Output __chunkOutput( const ChunkState& chunk, uint8_t flags )
+	{
+		Output output;
+		std::memcpy( output.mChainingValue, chunk.mChainingValue, sizeof( output.mChainingValue ) );
+		std::memcpy( output.mBlock, chunk.mBlock, BLOCK_SIZE );
+		output.mCounter = chunk.mCounter;
+		output.mBlockLength = chunk.mBlockLength;
+		output.mFlags = flags | __chunkStartFlag( chunk ) | CHUNK_END;
+		return output;
+	}
+
+	/**
+	 * Hash the whole chunks of at most kernels.mDegree chunks with one call
+	 * to the many-input kernel, and a final partial chunk on its own.
+	 * @return The number of chaining values written is returned.
+	 */
+	static size_t __compressChunks( const uint8_t* input, uint64_t inputLength, const uint32_t* key, uint64_t chunkCounter,
+		uint8_t flags, uint8_t* chainingValues, const Kernels& kernels )
+	{
+		const uint8_t* chunks[ MAXIMUM_LANES ];
+		size_t chunkCount = 0;
+		for ( ; CHUNK_SIZE <= inputLength; input += CHUNK_SIZE, inputLength -= CHUNK_SIZE )
+		{
+			chunks[ chunkCount++ ] = input;
+		}
+
+		kernels.mHashMany( chunks, chunkCount, CHUNK_SIZE / BLOCK_SIZE, key, chunkCounter, true, flags, CHUNK_START, CHUNK_END, chainingValues );
+		Instrumentation::count( Instrumentation::HASH_BLOCKS_COMPRESSED, chunkCount * ( CHUNK_SIZE / BLOCK_SIZE ) );
+		if ( 0 == inputLength )
+		{
+			return chunkCount;
+		}
+
+		ChunkState chunk;
+		__chunkReset( chunk, key, chunkCounter + chunkCount );
+		__chunkUpdate( chunk, flags, input, inputLength );
+		__outputChainingValue( __chunkOutput( chunk, flags ), chainingValues + chunkCount * CHAINING_VALUE_SIZE );
+		return chunkCount + 1;
+	}
+
+	/**
+	 * Hash pairs of child chaining values into parents with one call to the
+	 * many-input kernel. An odd child is passed up as it is.
+	 * @return The number of chaining values written is returned.
+	 */
+	static size_t __compressParents( const uint8_t* children, size_t childCount, const uint32_t* key, uint8_t flags,
+		uint8_t* chainingValues, const Kernels& kernels )
+	{
+		const uint8_t* parents[ MAXIMUM_LANES ];
+		size_t parentCount = 0;
+		for ( ; 2 * parentCount + 2 <= childCount; ++parentCount )
+		{
+			parents[ parentCount ] = children + 2 * parentCount * CHAINING_VALUE_SIZE;
+		}
+
+		kernels.mHashMany( parents, parentCount, 1, key, 0, false, flags | PARENT, 0, 0, chainingValues );
+		Instrumentation::count( Instrumentation::HASH_BLOCKS_COMPRESSED, parentCount );
+		if ( 2 * parentCount == childCount )
+		{
+			return parentCount;
+		}
+
+		std::memcpy( chainingValues + parentCount * CHAINING_VALUE_SIZE, children + 2 * parentCount * CHAINING_VALUE_SIZE, CHAINING_VALUE_SIZE );
+		return parentCount + 1;
+	}
+
+	/**
+	 * Hash a subtree, a power of two chunks but for a shorter last one, down
+	 * to at most max( kernels.mDegree, 2 ) chaining values, so that every call
+	 * to the many-input kernel is as wide as it can be. The halves of a large
+	 * subtree are hashed on two threads of {@param threadPool}, if not null.
+	 * @return The number of chaining values written is returned.
+	 */
+	static size_t __compressSubtree( const uint8_t* input, uint64_t inputLength, const uint32_t* key, uint64_t chunkCounter,
+		uint8_t flags, uint8_t* chainingValues, const Kernels& kernels, ThreadPool* threadPool )
+	{
+		if ( inputLength <= kernels.mDegree * CHUNK_SIZE )
+		{
+			return __compressChunks( input, inputLength, key, chunkCounter, flags, chainingValues, kernels );
+		}
+
+		// The left subtree takes the largest power of two chunks that leaves the right one non-empty.
+		uint64_t leftLength = __roundDownToPowerOfTwo( ( inputLength - 1 ) / CHUNK_SIZE ) * CHUNK_SIZE;
+		uint64_t degree = std::max< uint64_t >( kernels.mDegree, ( CHUNK_SIZE < leftLength ) ? 2 : 1 );
+		uint8_t childChainingValues[ 2 * MAXIMUM_LANES * CHAINING_VALUE_SIZE ];
+		size_t childCounts[ 2 ];
+		auto compressHalf = [ & ]( uint64_t half )
+		{
+			childCounts[ half ] = ( 0 == half )
+				? __compressSubtree( input, leftLength, key, chunkCounter, flags, childChainingValues, kernels, threadPool )
+				: __compressSubtree( input + leftLength, inputLength - leftLength, key, chunkCounter + leftLength / CHUNK_SIZE,
+					flags, childChainingValues + degree * CHAINING_VALUE_SIZE, kernels, threadPool );
+		};
+
+		if ( ( nullptr != threadPool ) and ( PARALLEL_MINIMUM_SIZE <= inputLength ) )
+		{
+			threadPool->parallelFor( 0, 2, 1, [ & ]( uint64_t half, uint64_t ) { compressHalf( half ); } );
+		}
+		else
+		{
+			compressHalf( 0 );
+			compressHalf( 1 );
+		}
+
+		// With one chaining value per half there is nothing left to merge at this level.
+		if ( 1 == childCounts[ 0 ] )
+		{
+			std::memcpy( chainingValues, childChainingValues, 2 * CHAINING_VALUE_SIZE );
+			return 2;
+		}
+
+		return __compressParents( childChainingValues, childCounts[ 0 ] + childCounts[ 1 ], key, flags, chainingValues, kernels );
+	}
+
+	/**
+	 * Hash a subtree of more than one chunk down to the two chaining values
+	 * of its root's children.
+	 */
+	static void __compressSubtreeToChildren( const uint8_t* input, uint64_t inputLength, const uint32_t* key, uint64_t chunkCounter,
+		uint8_t flags, uint8_t* children, const Kernels& kernels, ThreadPool* threadPool )
+	{
+		uint8_t chainingValues[ MAXIMUM_LANES * CHAINING_VALUE_SIZE ];
+		uint8_t parents[ MAXIMUM_LANES / 2 * CHAINING_VALUE_SIZE ];
+		size_t count = __compressSubtree( input, inputLength, key, chunkCounter, flags, chainingValues, kernels, threadPool );
+		while ( 2 < count )
+		{
+			count = __compressParents( chainingValues, count, key, flags, parents, kernels );
+			std::memcpy( chainingValues, parents, count * CHAINING_VALUE_SIZE );
+		}
+
+		std::memcpy( children, chainingValues, 2 * CHAINING_VALUE_SIZE );
+	}
+
+	/**
+	 * Merge the stack down to one chaining value per complete subtree of
+	 * the first {@param chunkCount} chunks. Merging waits until more input
+	 * arrives, as the rightmost subtree must be finished as the root's child.
+	 */
+	void __mergeStack( uint64_t chunkCount )
+	{
+		size_t mergedLength = size_t( __builtin_popcountll( chunkCount ) );
+		for ( ; mStackLength > mergedLength; --mStackLength )
+		{
+			uint8_t* children = mStack + ( mStackLength - 2 ) * CHAINING_VALUE_SIZE;
+			__outputChainingValue( __parentOutput( children, mKey, mFlags ), children );
+		}
+	}
+
+	void __pushChainingValue( const uint8_t* chainingValue, uint64_t chunkCounter )
+	{
+		__mergeStack( chunkCounter );
+		std::memcpy( mStack + mStackLength * CHAINING_VALUE_SIZE, chainingValue, CHAINING_VALUE_SIZE );
+		++mStackLength;
+	}
+
+	/**
+	 * Get the root node: the chunk in progress merged with every chaining
+	 * value of the stack, right to left.
+	 */
+	Output __rootOutput() const
+	{
+		if ( 0 == mStackLength )
+		{
+			return __chunkOutput( mChunk, mFlags );
+		}
+
+		size_t remaining = mStackLength;
+		Output output;
+		if ( 0 != __chunkLength( mChunk ) )
+		{
+			output = __chunkOutput( mChunk, mFlags );
+		}
+		else
+		{
+			remaining -= 2;
+			output = __parentOutput( mStack + remaining * CHAINING_VALUE_SIZE, mKey, mFlags );
+		}
+
+		uint8_t children[ 2 * CHAINING_VALUE_SIZE ];
+		while ( 0 != remaining-- )
+		{
+			std::memcpy( children, mStack + remaining * CHAINING_VALUE_SIZE, CHAINING_VALUE_SIZE );
+			__outputChainingValue( output, children + CHAINING_VALUE_SIZE );
+			output = __parentOutput( children, mKey, mFlags );
+		}
+
+		return output;
+	}
+
+	void __update( const uint8_t* message, uint64_t messageLength )
+	{
+		if ( 0 != __chunkLength( mChunk ) )
+		{
+			uint64_t take = std::min( CHUNK_SIZE - __chunkLength( mChunk ), messageLength );
+			__chunkUpdate( mChunk, mFlags, message, take );
+			message += take;
+			messageLength -= take;
+			if ( 0 == messageLength )
+			{
+				return;
+			}
+
+			uint8_t chainingValue[ CHAINING_VALUE_SIZE ];
+			__outputChainingValue( __chunkOutput( mChunk, mFlags ), chainingValue );
+			__pushChainingValue( chainingValue, mChunk.mCounter );
+			__chunkReset( mChunk, mKey, mChunk.mCounter + 1 );
+		}
+
+		const Kernels& kernels = __kernels();
+		ThreadPool* threadPool = nullptr;
+		if ( PARALLEL_MINIMUM_SIZE <= messageLength )
+		{
+			threadPool = ( nullptr != mThreadPool ) ? mThreadPool : &ThreadPool::instance();
+			threadPool = ( 1 < threadPool->concurrency() ) ? threadPool : nullptr;
+		}
+
+		// Hash the largest subtree that both fits and starts on a multiple of its own size, leaving the last chunk.
+		while ( CHUNK_SIZE < messageLength )
+		{
+			uint64_t subtreeLength = __roundDownToPowerOfTwo( messageLength );
+			while ( 0 != ( ( subtreeLength - 1 ) & ( mChunk.mCounter * CHUNK_SIZE ) ) )
+			{
+				subtreeLength /= 2;
+			}
+
+			uint64_t subtreeChunks = subtreeLength / CHUNK_SIZE;
+			if ( subtreeLength <= CHUNK_SIZE )
+			{
+				ChunkState chunk;
+				uint8_t chainingValue[ CHAINING_VALUE_SIZE ];
+				__chunkReset( chunk, mKey, mChunk.mCounter );
+				__chunkUpdate( chunk, mFlags, message, subtreeLength );
+				__outputChainingValue( __chunkOutput( chunk, mFlags ), chainingValue );
+				__pushChainingValue( chainingValue, mChunk.mCounter );
+			}
+			else
+			{
+				uint8_t children[ 2 * CHAINING_VALUE_SIZE ];
+				__compressSubtreeToChildren( message, subtreeLength, mKey, mChunk.mCounter, mFlags, children, kernels, threadPool );
+				__pushChainingValue( children, mChunk.mCounter );
+				__pushChainingValue( children + CHAINING_VALUE_SIZE, mChunk.mCounter + subtreeChunks / 2 );
+			}
+
+			mChunk.mCounter += subtreeChunks;
+			message += subtreeLength;
+			messageLength -= subtreeLength;
+		}
+
+		if ( 0 != messageLength )
+		{
+			__chunkUpdate( mChunk, mFlags, message, messageLength );
+			__mergeStack( mChunk.mCounter );
+		}
+	}
+
+	/**
+	 * Output {@param digestSize} bytes of the root without modifying this instance.
+	 */
+	void __digest( uint8_t* messageDigest, uint64_t digestSize ) const
+	{
+		__outputRootBytes( __rootOutput(), messageDigest, digestSize );
+	}
+
+	/**
+	 * Hash {@param message} in the default mode with the portable compression
+	 * only, a chunk at a time, so that it may be evaluated in a constant
+	 * expression. The last compression, of the last chunk or of the parent
+	 * of the root, is held back until it is known to be the root.
+	 */
+	template < uint64_t Length >
+	static constexpr std::array< uint8_t, Length > __digestConstant( std::string_view message )
+	{
+		uint32_t chainingValue[ 8 ] = { 0 };
+		uint8_t block[ BLOCK_SIZE ] = { 0 };
+		uint8_t blockLength = 0;
+		uint64_t counter = 0;
+		uint8_t flags = 0;
+		uint32_t output[ 16 ] = { 0 };
+		uint32_t stack[ MAXIMUM_DEPTH ][ 8 ] = { { 0 } };
+		size_t stackLength = 0;
+
+		for ( uint64_t chunkOffset = 0; true; chunkOffset += CHUNK_SIZE, ++counter )
+		{
+			uint64_t chunkLength = std::min( CHUNK_SIZE, message.size() - chunkOffset );
+			uint64_t blockCount = ( 0 == chunkLength ) ? 1 : ( chunkLength + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				chainingValue[ index ] = IV[ index ];
+			}
+
+			for ( uint64_t blockIndex( 0 ); blockIndex < blockCount; ++blockIndex )
+			{
+				uint64_t blockOffset = blockIndex * BLOCK_SIZE;
+				blockLength = uint8_t( std::min( BLOCK_SIZE, chunkLength - blockOffset ) );
+				for ( size_t index( -1 ); ++index < BLOCK_SIZE; )
+				{
+					block[ index ] = ( index < blockLength ) ? uint8_t( message[ chunkOffset + blockOffset + index ] ) : 0;
+				}
+
+				flags = ( ( 0 == blockIndex ) ? CHUNK_START : 0 ) | ( ( blockIndex + 1 == blockCount ) ? CHUNK_END : 0 );
+				if ( blockIndex + 1 < blockCount )
+				{
+					__compressPortable( output, chainingValue, block, blockLength, counter, flags );
+					for ( size_t index( -1 ); ++index < 8; )
+					{
+						chainingValue[ index ] = output[ index ];
+					}
+				}
+			}
+
+			if ( message.size() <= chunkOffset + chunkLength )
+			{
+				break;
+			}
+
+			// More input follows, so the chunk is not the root: push its chaining value, merging completed subtrees.
+			__compressPortable( output, chainingValue, block, blockLength, counter, flags );
+			for ( uint64_t chunkCount = counter + 1; 0 == ( chunkCount & 1 ); chunkCount >>= 1 )
+			{
+				--stackLength;
+				for ( size_t index( -1 ); ++index < 8; )
+				{
+					__storeLittleEndian( block + 4 * index, stack[ stackLength ][ index ] );
+					__storeLittleEndian( block + 32 + 4 * index, output[ index ] );
+				}
+
+				__compressPortable( output, IV, block, BLOCK_SIZE, 0, PARENT );
+			}
+
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				stack[ stackLength ][ index ] = output[ index ];
+			}
+
+			++stackLength;
+		}
+
+		// Fold the stack from the right into the parent of the root.
+		while ( 0 != stackLength )
+		{
+			__compressPortable( output, chainingValue, block, blockLength, counter, flags );
+			--stackLength;
+			for ( size_t index( -1 ); ++index < 8; )
+			{
+				__storeLittleEndian( block + 4 * index, stack[ stackLength ][ index ] );
+				__storeLittleEndian( block + 32 + 4 * index, output[ index ] );
+				chainingValue[ index ] = IV[ index ];
+			}
+
+			blockLength = BLOCK_SIZE;
+			counter = 0;
+			flags = PARENT;
+		}
+
+		std::array< uint8_t, Length > messageDigest = { 0 };
+		for ( uint64_t offset( 0 ); offset < Length; offset += BLOCK_SIZE )
+		{
+			__compressPortable( output, chainingValue, block, blockLength, offset / BLOCK_SIZE, flags | ROOT );
+			for ( uint64_t index( 0 ); ( index < BLOCK_SIZE ) and ( offset + index < Length ); ++index )
+			{
+				messageDigest[ offset + index ] = uint8_t( output[ index / 4 ] >> ( 8 * ( index % 4 ) ) );
+			}
+		}
+
+		return messageDigest;
+	}
+
+	void __reset()
+	{
+		__chunkReset( mChunk, mKey, 0 );
+		mStackLength = 0;
+	}
+
+	/**
+	 * Switch to the mode of {@param flags} with {@param key}, discarding any
+	 * message in progress.
+	 */
+	void __setMode( const uint32_t* key, uint8_t flags )
+	{
+		std::memcpy( mKey, key, sizeof( mKey ) );
+		mFlags = flags;
+		__reset();
+	}
+
+	/**
+	 * The serialized state is the tag, the mode and its key, the chunk in
+	 * progress and the stack:
+	 *     tag (4) | flags (1) | key (32) | chunk counter (8) | chunk chaining value (32)
+	 *     | blocks compressed (1) | stack length (1) | stack (32 each) | block length (1) | block
+	 */
+	uint64_t __serialize( uint8_t* state ) const
+	{
+		uint8_t* position = state;
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			*position++ = uint8_t( STATE_TAG >> ( 24 - 8 * index ) );
+		}
+
+		*position++ = mFlags;
+		__storeLanes( position, mKey, 1 );
+		position += 32;
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			*position++ = uint8_t( mChunk.mCounter >> ( 8 * index ) );
+		}
+
+		__storeLanes( position, mChunk.mChainingValue, 1 );
+		position += 32;
+		*position++ = mChunk.mBlocksCompressed;
+		*position++ = mStackLength;
+		std::memcpy( position, mStack, mStackLength * CHAINING_VALUE_SIZE );
+		position += mStackLength * CHAINING_VALUE_SIZE;
+		*position++ = mChunk.mBlockLength;
+		std::memcpy( position, mChunk.mBlock, mChunk.mBlockLength );
+		position += mChunk.mBlockLength;
+		return uint64_t( position - state );
+	}
+
+	bool __deserialize( const uint8_t* state, uint64_t stateSize )
+	{
+		static const uint64_t FIXED_SIZE = 4 + 1 + 32 + 8 + 32 + 1 + 1 + 1;
+		if ( ( stateSize < FIXED_SIZE ) or ( STATE_TAG != ( ( uint32_t( state[ 0 ] ) << 24 ) | ( uint32_t( state[ 1 ] ) << 16 )
+			| ( uint32_t( state[ 2 ] ) << 8 ) | uint32_t( state[ 3 ] ) ) ) )
+		{
+			return false;
+		}
+
+		uint8_t flags = state[ 4 ];
+		uint8_t blocksCompressed = state[ 4 + 1 + 32 + 8 + 32 ];
+		uint8_t stackLength = state[ 4 + 1 + 32 + 8 + 32 + 1 ];
+		if ( ( ( 0 != flags ) and ( KEYED_HASH != flags ) and ( DERIVE_KEY_MATERIAL != flags ) )
+			or ( MAXIMUM_DEPTH + 1 < stackLength ) or ( stateSize < FIXED_SIZE + stackLength * CHAINING_VALUE_SIZE ) )
+		{
+			return false;
+		}
+
+		const uint8_t* block = state + FIXED_SIZE + stackLength * CHAINING_VALUE_SIZE;
+		uint8_t blockLength = block[ -1 ];
+		uint64_t chunkLength = BLOCK_SIZE * blocksCompressed + blockLength;
+
+		// The last block of a chunk stays buffered until the chunk is finished.
+		if ( ( BLOCK_SIZE < blockLength ) or ( CHUNK_SIZE / BLOCK_SIZE <= blocksCompressed ) or ( ( 0 != blocksCompressed ) and ( 0 == blockLength ) )
+			or ( stateSize != FIXED_SIZE + stackLength * CHAINING_VALUE_SIZE + blockLength ) )
+		{
+			return false;
+		}
+
+		uint64_t chunkCounter = 0;
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			chunkCounter |= uint64_t( state[ 4 + 1 + 32 + index ] ) << ( 8 * index );
+		}
+
+		// The stack holds one chaining value per complete subtree before the chunk, and an empty chunk
+		// after the first follows the two children of the root, which are never merged before the next update.
+		size_t mergedLength = size_t( __builtin_popcountll( chunkCounter ) );
+		size_t expectedStackLength = ( ( 0 != chunkLength ) or ( 0 == chunkCounter ) ) ? mergedLength : mergedLength + 1;
+		if ( ( ( uint64_t( 1 ) << MAXIMUM_DEPTH ) <= chunkCounter ) or ( expectedStackLength != stackLength ) )
+		{
+			return false;
+		}
+
+		mFlags = flags;
+		__loadKey( mKey, state + 4 + 1 );
+		__chunkReset( mChunk, mKey, chunkCounter );
+		__loadKey( mChunk.mChainingValue, state + 4 + 1 + 32 + 8 );
+		mChunk.mBlocksCompressed = blocksCompressed;
+		mChunk.mBlockLength = blockLength;
+		std::memcpy( mChunk.mBlock, block, blockLength );
+		std::memcpy( mStack, state + FIXED_SIZE - 1, stackLength * CHAINING_VALUE_SIZE );
+		mStackLength = stackLength;
+		return true;
+	}
+
+public:
+	/**
+	 * Length of a key of the keyed hash mode, in bytes.
+	 */
+	static constexpr uint64_t KEY_SIZE = 32;
+
+	/**
+	 * Largest length of a serialized state: the tag, the mode and its key,
+	 * the chunk in progress and a full stack.
+	 */
+	static constexpr uint64_t STATE_SIZE = 4 + 1 + 32 + 8 + 32 + 1 + 1 + ( MAXIMUM_DEPTH + 1 ) * CHAINING_VALUE_SIZE + 1 + BLOCK_SIZE;
+
+	/**
+	 * Construct a BLAKE3 instance in its initial state, in the plain hash mode.
+	 * Large updates are hashed on ThreadPool::instance().
+	 */
+	BLAKE3() :
+		mFlags( 0 ),
+		mThreadPool( nullptr )
+	{
+		__setMode( IV, 0 );
+	}
+
+	/**
+	 * Clear the key of the keyed modes, and what has been derived from it.
+	 */
+	~BLAKE3()
+	{
+		if ( 0 != mFlags )
+		{
+			zeroize( mKey, sizeof( mKey ) );
+			zeroize( &mChunk, sizeof( mChunk ) );
+			zeroize( mStack, sizeof( mStack ) );
+		}
+	}
+
+	BLAKE3( const BLAKE3& ) = default;
+	BLAKE3& operator=( const BLAKE3& ) = default;
+
+	/**
+	 * Hash the halves of large updates on {@param threadPool} instead of the
+	 * shared pool. A pool without workers hashes on the calling thread only.
+	 * @param threadPool The pool to hash on, which must outlive this instance.
+	 */
+	void setThreadPool( ThreadPool& threadPool )
+	{
+		mThreadPool = &threadPool;
+	}
+
+	/**
+	 * Switch to the keyed hash mode, discarding any message in progress. The
+	 * digest is then a MAC of the message under {@param key}.
+	 * @param key Constant reference to a Key of KEY_SIZE bytes.
+	 * @return True is returned if {@param key} is KEY_SIZE bytes long, else
+	 *     false is returned and this instance is left untouched.
+	 */
+	bool setKey( const Key& key )
+	{
+		uint32_t keyWords[ 8 ];
+		bool isKeySize = key.read( [ &keyWords ]( const uint8_t* buffer, size_t length )
+			{
+				if ( KEY_SIZE != length )
+				{
+					return false;
+				}
+
+				__loadKey( keyWords, buffer );
+				return true;
+			} );
+
+		if ( not isKeySize )
+		{
+			return false;
+		}
+
+		__setMode( keyWords, KEYED_HASH );
+		zeroize( keyWords, sizeof( keyWords ) );
+		return true;
+	}
+
+	/**
+	 * Switch to the key derivation mode, discarding any message in progress.
+	 * The message is then the key material, and the digest the key derived
+	 * from it for {@param context}.
+	 * @param context Null terminated string, fixed for the application and
+	 *     the purpose of the key, such as "example.com 2021-06-01 session keys".
+	 */
+	void setDeriveKeyContext( const char* context )
+	{
+		BLAKE3 contextHash;
+		contextHash.mFlags = DERIVE_KEY_CONTEXT;
+		contextHash.update( reinterpret_cast< const uint8_t* >( context ), ( nullptr == context ) ? 0 : std::strlen( context ) );
+
+		uint8_t contextKey[ KEY_SIZE ];
+		uint32_t keyWords[ 8 ];
+		contextHash.digest( contextKey, KEY_SIZE );
+		__loadKey( keyWords, contextKey );
+		__setMode( keyWords, DERIVE_KEY_MATERIAL );
+	}
+
+	/**
+	 * Derive a key from {@param keyMaterial} for {@param context}, as the
+	 * digest of the key derivation mode.
+	 * @param context Null terminated string, as for setDeriveKeyContext().
+	 * @param keyMaterial Constant reference to the Key to derive from.
+	 * @param derivedKeyLength Length of the derived key, in bytes.
+	 * @return The derived Key is returned, or a null Key if {@param keyMaterial}
+	 *     is null or {@param derivedKeyLength} is zero.
+	 */
+	static Key deriveKey( const char* context, const Key& keyMaterial, size_t derivedKeyLength = KEY_SIZE )
+	{
+		BLAKE3 hash;
+		hash.setDeriveKeyContext( context );
+		bool hasKeyMaterial = keyMaterial.read( [ &hash ]( const uint8_t* buffer, size_t length )
+			{
+				hash.update( buffer, length );
+				return 0 != length;
+			} );
+
+		if ( not hasKeyMaterial or ( 0 == derivedKeyLength ) )
+		{
+			return Key();
+		}
+
+		uint8_t derivedKeyBuffer[ 64 ];
+		std::vector< uint8_t > largeDerivedKeyBuffer;
+		uint8_t* derivedKeyBytes = derivedKeyBuffer;
+		if ( sizeof( derivedKeyBuffer ) < derivedKeyLength )
+		{
+			largeDerivedKeyBuffer.resize( derivedKeyLength );
+			derivedKeyBytes = largeDerivedKeyBuffer.data();
+		}
+
+		hash.digest( derivedKeyBytes, derivedKeyLength );
+		Key derivedKey( derivedKeyBytes, derivedKeyLength );
+		zeroize( derivedKeyBytes, derivedKeyLength );
+		return derivedKey;
+	}
+};
+
+} // namespace Pique
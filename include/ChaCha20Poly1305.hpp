@@ -0,0 +1,1081 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_CHACHA20_POLY1305_X86 1
+#endif
+
+#include "ConstantTime.hpp"
+#include "CpuFeatures.hpp"
+#include "Key.hpp"
+#include "KeyBinding.hpp"
+#include "Zeroize.hpp"
+
+namespace Pique
+{
+
+/**
+ * ChaCha20-Poly1305 authenticated encryption as specified in RFC 8439, and
+ * XChaCha20-Poly1305 with 24 byte nonces, which derives a subkey from the
+ * first 16 bytes of the nonce with HChaCha20.
+ *
+ * seal() and open() make a single pass over the message, a few kilobytes at
+ * a time: each chunk is encrypted and authenticated while it is still in the
+ * first level cache. The key stream is generated by the kernel chosen by
+ * CpuFeatures, sixteen blocks at a time in AVX-512 registers, eight at a time
+ * in AVX2 registers, or a block at a time. Poly1305 keeps its accumulator in
+ * 26 bit limbs; with AVX2 it absorbs four blocks at a time in four lanes,
+ * multiplying each by the fourth power of the key, and folds the lanes
+ * together with the first to fourth powers at the end. With AVX-512 it does
+ * the same with eight lanes and the eighth power.
+ *
+ * The copy of the key is bound to the key material of the Key it was read
+ * from, and zeroized once that material is discarded, as with HMAC.
+ *
+ * The output may be the input, to encrypt or decrypt in place. A nonce must
+ * never be used twice with the same key; random nonces are safe with
+ * EXTENDED_NONCE_SIZE bytes only.
+ *
+ * An instance is not safe for concurrent use; give each thread its own copy.
+ */
+class ChaCha20Poly1305 final
+{
+public:
+	/**
+	 * Length of the key, in bytes.
+	 */
+	static constexpr size_t KEY_SIZE = 32;
+
+	/**
+	 * Length of the ChaCha20-Poly1305 nonce, in bytes.
+	 */
+	static constexpr size_t NONCE_SIZE = 12;
+
+	/**
+	 * Length of the XChaCha20-Poly1305 nonce, in bytes.
+	 */
+	static constexpr size_t EXTENDED_NONCE_SIZE = 24;
+
+	/**
+	 * Length of the authentication tag, in bytes.
+	 */
+	static constexpr size_t TAG_SIZE = 16;
+
+	/**
+	 * Length of the longest message, in bytes: the 32 bit block counter
+	 * starts at one.
+	 */
+	static constexpr uint64_t MAXIMUM_MESSAGE_SIZE = ( ( uint64_t( 1 ) << 32 ) - 1 ) * 64;
+
+private:
+	static constexpr size_t BLOCK_SIZE = 64;
+	static constexpr size_t MAC_BLOCK_SIZE = 16;
+
+	/**
+	 * Length of the chunks encrypted and then authenticated in turn, a
+	 * multiple of the block size that fits in the first level cache.
+	 */
+	static constexpr size_t CHUNK_SIZE = 4096;
+
+	/**
+	 * Length of the longest message encrypted together with block zero, in
+	 * one pass of the AVX2 kernel.
+	 */
+	static constexpr size_t SHORT_MESSAGE_SIZE = 7 * BLOCK_SIZE;
+
+	static constexpr uint32_t LIMB_MASK = 0x3FFFFFF;
+
+	/**
+	 * "expand 32-byte k"
+	 */
+	static constexpr uint32_t CONSTANTS[ 4 ] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+
+	/**
+	 * The state of a Poly1305 MAC. Numbers modulo 2^130 - 5 are held in five
+	 * limbs of 26 bits, least significant first, possibly a little over.
+	 */
+	struct Poly1305
+	{
+		/**
+		 * r to r^8, for the vector kernels.
+		 */
+		uint32_t mPowers[ 8 ][ 5 ];
+		uint32_t mAccumulator[ 5 ];
+		uint32_t mPad[ 4 ];
+	};
+
+	typedef void ( *XorKeyStreamFunction )( const uint32_t* state, uint8_t* output, const uint8_t* input, uint64_t length );
+	typedef void ( *Poly1305Function )( Poly1305& poly1305, const uint8_t* blocks, uint64_t blockCount );
+
+	KeyBinding mKeyBinding;
+	mutable uint32_t mKeyWords[ 8 ];
+
+	static uint32_t __loadLittleEndian( const uint8_t* bytes )
+	{
+		return ( uint32_t( bytes[ 0 ] ) << 0 ) | ( uint32_t( bytes[ 1 ] ) << 8 )
+			| ( uint32_t( bytes[ 2 ] ) << 16 ) | ( uint32_t( bytes[ 3 ] ) << 24 );
+	}
+
+	static void __storeLittleEndian( uint8_t* bytes, uint32_t value )
+	{
+		bytes[ 0 ] = uint8_t( value >> 0 );
+		bytes[ 1 ] = uint8_t( value >> 8 );
+		bytes[ 2 ] = uint8_t( value >> 16 );
+		bytes[ 3 ] = uint8_t( value >> 24 );
+	}
+
+	static uint32_t __rotateLeft( uint32_t value, unsigned count )
+	{
+		return ( value << count ) | ( value >> ( 32 - count ) );
+	}
+
+	static void __quarterRound( uint32_t* x, size_t a, size_t b, size_t c, size_t d )
+	{
+		x[ a ] += x[ b ]; x[ d ] = __rotateLeft( x[ d ] ^ x[ a ], 16 );
+		x[ c ] += x[ d ]; x[ b ] = __rotateLeft( x[ b ] ^ x[ c ], 12 );
+		x[ a ] += x[ b ]; x[ d ] = __rotateLeft( x[ d ] ^ x[ a ], 8 );
+		x[ c ] += x[ d ]; x[ b ] = __rotateLeft( x[ b ] ^ x[ c ], 7 );
+	}
+
+	/**
+	 * The twenty rounds of ChaCha20, without the final addition.
+	 */
+	static void __rounds( uint32_t* x )
+	{
+		for ( size_t doubleRound( -1 ); ++doubleRound < 10; )
+		{
+			__quarterRound( x, 0, 4, 8, 12 );
+			__quarterRound( x, 1, 5, 9, 13 );
+			__quarterRound( x, 2, 6, 10, 14 );
+			__quarterRound( x, 3, 7, 11, 15 );
+			__quarterRound( x, 0, 5, 10, 15 );
+			__quarterRound( x, 1, 6, 11, 12 );
+			__quarterRound( x, 2, 7, 8, 13 );
+			__quarterRound( x, 3, 4, 9, 14 );
+		}
+	}
+
+	/**
+	 * XOR {@param length} bytes of key stream, from block state[ 12 ] on,
+	 * into {@param output}.
+	 */
+	static void __xorKeyStreamPortable( const uint32_t* state, uint8_t* output, const uint8_t* input, uint64_t length )
+	{
+		uint32_t x[ 16 ];
+		uint8_t keyStream[ BLOCK_SIZE ];
+		for ( uint32_t counter = state[ 12 ]; 0 < length; ++counter )
+		{
+			std::memcpy( x, state, sizeof( x ) );
+			x[ 12 ] = counter;
+			__rounds( x );
+			for ( size_t index( -1 ); ++index < 16; )
+			{
+				__storeLittleEndian( keyStream + 4 * index, x[ index ] + ( ( 12 == index ) ? counter : state[ index ] ) );
+			}
+
+			const size_t blockLength = size_t( std::min< uint64_t >( length, BLOCK_SIZE ) );
+			for ( size_t index( -1 ); ++index < blockLength; )
+			{
+				output[ index ] = input[ index ] ^ keyStream[ index ];
+			}
+
+			input += blockLength;
+			output += blockLength;
+			length -= blockLength;
+		}
+
+		zeroize( x, sizeof( x ) );
+		zeroize( keyStream, sizeof( keyStream ) );
+	}
+
+	/**
+	 * XOR the rest of a message with {@param kernel}, from block {@param counter}.
+	 */
+	static void __xorKeyStreamFrom( XorKeyStreamFunction kernel, const uint32_t* state, uint32_t counter,
+		uint8_t* output, const uint8_t* input, uint64_t length )
+	{
+		if ( 0 != length )
+		{
+			uint32_t rest[ 16 ];
+			std::memcpy( rest, state, sizeof( rest ) );
+			rest[ 12 ] = counter;
+			kernel( rest, output, input, length );
+			zeroize( rest, sizeof( rest ) );
+		}
+	}
+
+	/**
+	 * Replace {@param h} with h * {@param r} modulo 2^130 - 5, carrying
+	 * every limb back to about 26 bits.
+	 */
+	static void __multiplyPortable( uint32_t* h, const uint32_t* r )
+	{
+		const uint64_t s1 = r[ 1 ] * 5, s2 = r[ 2 ] * 5, s3 = r[ 3 ] * 5, s4 = r[ 4 ] * 5;
+		const uint64_t h0 = h[ 0 ], h1 = h[ 1 ], h2 = h[ 2 ], h3 = h[ 3 ], h4 = h[ 4 ];
+		uint64_t d0 = h0 * r[ 0 ] + h1 * s4 + h2 * s3 + h3 * s2 + h4 * s1;
+		uint64_t d1 = h0 * r[ 1 ] + h1 * r[ 0 ] + h2 * s4 + h3 * s3 + h4 * s2;
+		uint64_t d2 = h0 * r[ 2 ] + h1 * r[ 1 ] + h2 * r[ 0 ] + h3 * s4 + h4 * s3;
+		uint64_t d3 = h0 * r[ 3 ] + h1 * r[ 2 ] + h2 * r[ 1 ] + h3 * r[ 0 ] + h4 * s4;
+		uint64_t d4 = h0 * r[ 4 ] + h1 * r[ 3 ] + h2 * r[ 2 ] + h3 * r[ 1 ] + h4 * r[ 0 ];
+		__carry( h, d0, d1, d2, d3, d4 );
+	}
+
+	/**
+	 * Carry the sums of products {@param d0} to {@param d4} into {@param h}.
+	 */
+	static void __carry( uint32_t* h, uint64_t d0, uint64_t d1, uint64_t d2, uint64_t d3, uint64_t d4 )
+	{
+		d1 += d0 >> 26;
+		d2 += d1 >> 26;
+		d3 += d2 >> 26;
+		d4 += d3 >> 26;
+		d0 = ( d0 & LIMB_MASK ) + ( d4 >> 26 ) * 5;
+		h[ 0 ] = uint32_t( d0 & LIMB_MASK );
+		h[ 1 ] = uint32_t( ( d1 & LIMB_MASK ) + ( d0 >> 26 ) );
+		h[ 2 ] = uint32_t( d2 & LIMB_MASK );
+		h[ 3 ] = uint32_t( d3 & LIMB_MASK );
+		h[ 4 ] = uint32_t( d4 & LIMB_MASK );
+	}
+
+	/**
+	 * Absorb whole 16 byte blocks, each with a 1 bit appended.
+	 */
+	static void __poly1305Portable( Poly1305& poly1305, const uint8_t* blocks, uint64_t blockCount )
+	{
+		uint32_t* h = poly1305.mAccumulator;
+		for ( ; 0 < blockCount; --blockCount, blocks += MAC_BLOCK_SIZE )
+		{
+			h[ 0 ] += ( __loadLittleEndian( blocks + 0 ) >> 0 ) & LIMB_MASK;
+			h[ 1 ] += ( __loadLittleEndian( blocks + 3 ) >> 2 ) & LIMB_MASK;
+			h[ 2 ] += ( __loadLittleEndian( blocks + 6 ) >> 4 ) & LIMB_MASK;
+			h[ 3 ] += ( __loadLittleEndian( blocks + 9 ) >> 6 ) & LIMB_MASK;
+			h[ 4 ] += ( __loadLittleEndian( blocks + 12 ) >> 8 ) | ( 1u << 24 );
+			__multiplyPortable( h, poly1305.mPowers[ 0 ] );
+		}
+	}
+
+#if defined( PIQUE_CHACHA20_POLY1305_X86 )
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __rotateLeftAvx2( __m256i value, int count )
+	{
+		return _mm256_or_si256( _mm256_slli_epi32( value, count ), _mm256_srli_epi32( value, 32 - count ) );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static void __quarterRoundAvx2( __m256i& a, __m256i& b, __m256i& c, __m256i& d, __m256i rotate16, __m256i rotate8 )
+	{
+		a = _mm256_add_epi32( a, b ); d = _mm256_shuffle_epi8( _mm256_xor_si256( d, a ), rotate16 );
+		c = _mm256_add_epi32( c, d ); b = __rotateLeftAvx2( _mm256_xor_si256( b, c ), 12 );
+		a = _mm256_add_epi32( a, b ); d = _mm256_shuffle_epi8( _mm256_xor_si256( d, a ), rotate8 );
+		c = _mm256_add_epi32( c, d ); b = __rotateLeftAvx2( _mm256_xor_si256( b, c ), 7 );
+	}
+
+	/**
+	 * Transpose eight rows of eight words, so that row b holds word b of
+	 * every row.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __transposeAvx2( __m256i* rows )
+	{
+		__m256i pairs[ 8 ];
+		for ( size_t row( -1 ); ++row < 4; )
+		{
+			pairs[ 2 * row + 0 ] = _mm256_unpacklo_epi32( rows[ 2 * row ], rows[ 2 * row + 1 ] );
+			pairs[ 2 * row + 1 ] = _mm256_unpackhi_epi32( rows[ 2 * row ], rows[ 2 * row + 1 ] );
+		}
+
+		__m256i quads[ 8 ];
+		for ( size_t half( -1 ); ++half < 2; )
+		{
+			quads[ 4 * half + 0 ] = _mm256_unpacklo_epi64( pairs[ 4 * half + 0 ], pairs[ 4 * half + 2 ] );
+			quads[ 4 * half + 1 ] = _mm256_unpackhi_epi64( pairs[ 4 * half + 0 ], pairs[ 4 * half + 2 ] );
+			quads[ 4 * half + 2 ] = _mm256_unpacklo_epi64( pairs[ 4 * half + 1 ], pairs[ 4 * half + 3 ] );
+			quads[ 4 * half + 3 ] = _mm256_unpackhi_epi64( pairs[ 4 * half + 1 ], pairs[ 4 * half + 3 ] );
+		}
+
+		for ( size_t column( -1 ); ++column < 4; )
+		{
+			rows[ column ] = _mm256_permute2x128_si256( quads[ column ], quads[ 4 + column ], 0x20 );
+			rows[ 4 + column ] = _mm256_permute2x128_si256( quads[ column ], quads[ 4 + column ], 0x31 );
+		}
+	}
+
+	/**
+	 * Generate eight blocks at a time, block b in lane b of sixteen
+	 * registers, then transpose them to XOR whole blocks.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __xorKeyStreamAvx2( const uint32_t* state, uint8_t* output, const uint8_t* input, uint64_t length )
+	{
+		const __m256i rotate16 = _mm256_set_epi8(
+			13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+			13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2 );
+		const __m256i rotate8 = _mm256_set_epi8(
+			14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+			14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3 );
+		alignas( 32 ) uint8_t keyStream[ 8 * BLOCK_SIZE ];
+		uint32_t counter = state[ 12 ];
+
+		// A last block costs less on its own.
+		for ( ; BLOCK_SIZE < length; counter += 8 )
+		{
+			const __m256i counters = _mm256_add_epi32( _mm256_set1_epi32( int( counter ) ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+			__m256i x[ 16 ];
+			for ( size_t index( -1 ); ++index < 16; )
+			{
+				x[ index ] = ( 12 == index ) ? counters : _mm256_set1_epi32( int( state[ index ] ) );
+			}
+
+			for ( size_t doubleRound( -1 ); ++doubleRound < 10; )
+			{
+				__quarterRoundAvx2( x[ 0 ], x[ 4 ], x[ 8 ], x[ 12 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 1 ], x[ 5 ], x[ 9 ], x[ 13 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 2 ], x[ 6 ], x[ 10 ], x[ 14 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 3 ], x[ 7 ], x[ 11 ], x[ 15 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 0 ], x[ 5 ], x[ 10 ], x[ 15 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 1 ], x[ 6 ], x[ 11 ], x[ 12 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 2 ], x[ 7 ], x[ 8 ], x[ 13 ], rotate16, rotate8 );
+				__quarterRoundAvx2( x[ 3 ], x[ 4 ], x[ 9 ], x[ 14 ], rotate16, rotate8 );
+			}
+
+			for ( size_t index( -1 ); ++index < 16; )
+			{
+				x[ index ] = _mm256_add_epi32( x[ index ], ( 12 == index ) ? counters : _mm256_set1_epi32( int( state[ index ] ) ) );
+			}
+
+			__transposeAvx2( x );
+			__transposeAvx2( x + 8 );
+
+			// Block b is now words 0 to 7 in x[ b ] and words 8 to 15 in x[ 8 + b ].
+			if ( 8 * BLOCK_SIZE <= length )
+			{
+				for ( size_t block( -1 ); ++block < 8; )
+				{
+					for ( size_t half( -1 ); ++half < 2; )
+					{
+						const size_t offset = block * BLOCK_SIZE + half * 32;
+						_mm256_storeu_si256( reinterpret_cast< __m256i* >( output + offset ), _mm256_xor_si256( x[ 8 * half + block ],
+							_mm256_loadu_si256( reinterpret_cast< const __m256i* >( input + offset ) ) ) );
+					}
+				}
+
+				input += 8 * BLOCK_SIZE;
+				output += 8 * BLOCK_SIZE;
+				length -= 8 * BLOCK_SIZE;
+				continue;
+			}
+
+			for ( size_t block( -1 ); ++block < 8; )
+			{
+				_mm256_store_si256( reinterpret_cast< __m256i* >( keyStream + block * BLOCK_SIZE ), x[ block ] );
+				_mm256_store_si256( reinterpret_cast< __m256i* >( keyStream + block * BLOCK_SIZE + 32 ), x[ 8 + block ] );
+			}
+
+			for ( size_t index( -1 ); ++index < length; )
+			{
+				output[ index ] = input[ index ] ^ keyStream[ index ];
+			}
+
+			zeroize( keyStream, sizeof( keyStream ) );
+			return;
+		}
+
+		__xorKeyStreamFrom( __xorKeyStreamPortable, state, counter, output, input, length );
+	}
+
+	__attribute__(( target( "avx512f" ) ))
+	static void __quarterRoundAvx512( __m512i& a, __m512i& b, __m512i& c, __m512i& d )
+	{
+		a = _mm512_add_epi32( a, b ); d = _mm512_rol_epi32( _mm512_xor_si512( d, a ), 16 );
+		c = _mm512_add_epi32( c, d ); b = _mm512_rol_epi32( _mm512_xor_si512( b, c ), 12 );
+		a = _mm512_add_epi32( a, b ); d = _mm512_rol_epi32( _mm512_xor_si512( d, a ), 8 );
+		c = _mm512_add_epi32( c, d ); b = _mm512_rol_epi32( _mm512_xor_si512( b, c ), 7 );
+	}
+
+	/**
+	 * Transpose sixteen rows of sixteen words, so that row b holds word b
+	 * of every row: words are interleaved within 128 bit lanes, then the
+	 * lanes of each set of four rows are transposed.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __transposeAvx512( __m512i* rows )
+	{
+		// quads[ 4 * group + k ] lane l holds words 4 * group to 4 * group + 3 of block 4 * l + k.
+		__m512i quads[ 16 ];
+		for ( size_t group( -1 ); ++group < 4; )
+		{
+			const __m512i* groupRows = rows + 4 * group;
+			const __m512i low01 = _mm512_unpacklo_epi32( groupRows[ 0 ], groupRows[ 1 ] );
+			const __m512i high01 = _mm512_unpackhi_epi32( groupRows[ 0 ], groupRows[ 1 ] );
+			const __m512i low23 = _mm512_unpacklo_epi32( groupRows[ 2 ], groupRows[ 3 ] );
+			const __m512i high23 = _mm512_unpackhi_epi32( groupRows[ 2 ], groupRows[ 3 ] );
+			quads[ 4 * group + 0 ] = _mm512_unpacklo_epi64( low01, low23 );
+			quads[ 4 * group + 1 ] = _mm512_unpackhi_epi64( low01, low23 );
+			quads[ 4 * group + 2 ] = _mm512_unpacklo_epi64( high01, high23 );
+			quads[ 4 * group + 3 ] = _mm512_unpackhi_epi64( high01, high23 );
+		}
+
+		for ( size_t k( -1 ); ++k < 4; )
+		{
+			const __m512i lanes01Low = _mm512_shuffle_i32x4( quads[ k ], quads[ 4 + k ], 0x44 );
+			const __m512i lanes01High = _mm512_shuffle_i32x4( quads[ k ], quads[ 4 + k ], 0xEE );
+			const __m512i lanes23Low = _mm512_shuffle_i32x4( quads[ 8 + k ], quads[ 12 + k ], 0x44 );
+			const __m512i lanes23High = _mm512_shuffle_i32x4( quads[ 8 + k ], quads[ 12 + k ], 0xEE );
+			rows[ 0 + k ] = _mm512_shuffle_i32x4( lanes01Low, lanes23Low, 0x88 );
+			rows[ 4 + k ] = _mm512_shuffle_i32x4( lanes01Low, lanes23Low, 0xDD );
+			rows[ 8 + k ] = _mm512_shuffle_i32x4( lanes01High, lanes23High, 0x88 );
+			rows[ 12 + k ] = _mm512_shuffle_i32x4( lanes01High, lanes23High, 0xDD );
+		}
+	}
+
+	/**
+	 * Generate sixteen blocks at a time, as __xorKeyStreamAvx2() does eight.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __xorKeyStreamAvx512( const uint32_t* state, uint8_t* output, const uint8_t* input, uint64_t length )
+	{
+		alignas( 64 ) uint8_t keyStream[ 16 * BLOCK_SIZE ];
+		uint32_t counter = state[ 12 ];
+
+		// Eight blocks or fewer cost less in AVX2 registers.
+		for ( ; 8 * BLOCK_SIZE < length; counter += 16 )
+		{
+			const __m512i counters = _mm512_add_epi32( _mm512_set1_epi32( int( counter ) ),
+				_mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ) );
+			__m512i x[ 16 ];
+			for ( size_t index( -1 ); ++index < 16; )
+			{
+				x[ index ] = ( 12 == index ) ? counters : _mm512_set1_epi32( int( state[ index ] ) );
+			}
+
+			for ( size_t doubleRound( -1 ); ++doubleRound < 10; )
+			{
+				__quarterRoundAvx512( x[ 0 ], x[ 4 ], x[ 8 ], x[ 12 ] );
+				__quarterRoundAvx512( x[ 1 ], x[ 5 ], x[ 9 ], x[ 13 ] );
+				__quarterRoundAvx512( x[ 2 ], x[ 6 ], x[ 10 ], x[ 14 ] );
+				__quarterRoundAvx512( x[ 3 ], x[ 7 ], x[ 11 ], x[ 15 ] );
+				__quarterRoundAvx512( x[ 0 ], x[ 5 ], x[ 10 ], x[ 15 ] );
+				__quarterRoundAvx512( x[ 1 ], x[ 6 ], x[ 11 ], x[ 12 ] );
+				__quarterRoundAvx512( x[ 2 ], x[ 7 ], x[ 8 ], x[ 13 ] );
+				__quarterRoundAvx512( x[ 3 ], x[ 4 ], x[ 9 ], x[ 14 ] );
+			}
+
+			for ( size_t index( -1 ); ++index < 16; )
+			{
+				x[ index ] = _mm512_add_epi32( x[ index ], ( 12 == index ) ? counters : _mm512_set1_epi32( int( state[ index ] ) ) );
+			}
+
+			__transposeAvx512( x );
+			if ( 16 * BLOCK_SIZE <= length )
+			{
+				for ( size_t block( -1 ); ++block < 16; )
+				{
+					_mm512_storeu_si512( output + block * BLOCK_SIZE,
+						_mm512_xor_si512( x[ block ], _mm512_loadu_si512( input + block * BLOCK_SIZE ) ) );
+				}
+
+				input += 16 * BLOCK_SIZE;
+				output += 16 * BLOCK_SIZE;
+				length -= 16 * BLOCK_SIZE;
+				continue;
+			}
+
+			for ( size_t block( -1 ); ++block < 16; )
+			{
+				_mm512_store_si512( keyStream + block * BLOCK_SIZE, x[ block ] );
+			}
+
+			for ( size_t index( -1 ); ++index < length; )
+			{
+				output[ index ] = input[ index ] ^ keyStream[ index ];
+			}
+
+			zeroize( keyStream, sizeof( keyStream ) );
+			return;
+		}
+
+		__xorKeyStreamFrom( __xorKeyStreamAvx2, state, counter, output, input, length );
+	}
+
+	/**
+	 * Sum the products of the limbs of {@param h} and {@param a0} to {@param a4}.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __dotAvx2( const __m256i* h, __m256i a0, __m256i a1, __m256i a2, __m256i a3, __m256i a4 )
+	{
+		return _mm256_add_epi64(
+			_mm256_add_epi64( _mm256_mul_epu32( h[ 0 ], a0 ), _mm256_mul_epu32( h[ 1 ], a1 ) ),
+			_mm256_add_epi64( _mm256_add_epi64( _mm256_mul_epu32( h[ 2 ], a2 ), _mm256_mul_epu32( h[ 3 ], a3 ) ),
+				_mm256_mul_epu32( h[ 4 ], a4 ) ) );
+	}
+
+	/**
+	 * Multiply four numbers in four lanes by {@param r}, with {@param s}
+	 * holding 5 * r for the limbs that wrap around past 2^130, and carry
+	 * every limb back to about 26 bits in two interleaved chains.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __multiplyAvx2( __m256i* h, const __m256i* r, const __m256i* s )
+	{
+		__m256i d0 = __dotAvx2( h, r[ 0 ], s[ 4 ], s[ 3 ], s[ 2 ], s[ 1 ] );
+		__m256i d1 = __dotAvx2( h, r[ 1 ], r[ 0 ], s[ 4 ], s[ 3 ], s[ 2 ] );
+		__m256i d2 = __dotAvx2( h, r[ 2 ], r[ 1 ], r[ 0 ], s[ 4 ], s[ 3 ] );
+		__m256i d3 = __dotAvx2( h, r[ 3 ], r[ 2 ], r[ 1 ], r[ 0 ], s[ 4 ] );
+		__m256i d4 = __dotAvx2( h, r[ 4 ], r[ 3 ], r[ 2 ], r[ 1 ], r[ 0 ] );
+
+		const __m256i mask = _mm256_set1_epi64x( LIMB_MASK );
+		d1 = _mm256_add_epi64( d1, _mm256_srli_epi64( d0, 26 ) ); d0 = _mm256_and_si256( d0, mask );
+		d4 = _mm256_add_epi64( d4, _mm256_srli_epi64( d3, 26 ) ); d3 = _mm256_and_si256( d3, mask );
+		d2 = _mm256_add_epi64( d2, _mm256_srli_epi64( d1, 26 ) ); d1 = _mm256_and_si256( d1, mask );
+		const __m256i wrap = _mm256_srli_epi64( d4, 26 ); d4 = _mm256_and_si256( d4, mask );
+		d0 = _mm256_add_epi64( d0, _mm256_add_epi64( wrap, _mm256_slli_epi64( wrap, 2 ) ) );
+		d3 = _mm256_add_epi64( d3, _mm256_srli_epi64( d2, 26 ) ); d2 = _mm256_and_si256( d2, mask );
+		d1 = _mm256_add_epi64( d1, _mm256_srli_epi64( d0, 26 ) ); d0 = _mm256_and_si256( d0, mask );
+		d4 = _mm256_add_epi64( d4, _mm256_srli_epi64( d3, 26 ) ); d3 = _mm256_and_si256( d3, mask );
+		h[ 0 ] = d0; h[ 1 ] = d1; h[ 2 ] = d2; h[ 3 ] = d3; h[ 4 ] = d4;
+	}
+
+	/**
+	 * Add four blocks to the four lanes of {@param h}.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __addBlocksAvx2( __m256i* h, const uint8_t* blocks )
+	{
+		const __m256i first = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( blocks ) );
+		const __m256i second = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( blocks + 32 ) );
+		const __m256i low = _mm256_permute4x64_epi64( _mm256_unpacklo_epi64( first, second ), 0xD8 );
+		const __m256i high = _mm256_permute4x64_epi64( _mm256_unpackhi_epi64( first, second ), 0xD8 );
+		const __m256i mask = _mm256_set1_epi64x( LIMB_MASK );
+		h[ 0 ] = _mm256_add_epi64( h[ 0 ], _mm256_and_si256( low, mask ) );
+		h[ 1 ] = _mm256_add_epi64( h[ 1 ], _mm256_and_si256( _mm256_srli_epi64( low, 26 ), mask ) );
+		h[ 2 ] = _mm256_add_epi64( h[ 2 ], _mm256_and_si256( _mm256_or_si256( _mm256_srli_epi64( low, 52 ), _mm256_slli_epi64( high, 12 ) ), mask ) );
+		h[ 3 ] = _mm256_add_epi64( h[ 3 ], _mm256_and_si256( _mm256_srli_epi64( high, 14 ), mask ) );
+		h[ 4 ] = _mm256_add_epi64( h[ 4 ], _mm256_or_si256( _mm256_srli_epi64( high, 40 ), _mm256_set1_epi64x( 1 << 24 ) ) );
+	}
+
+	/**
+	 * Absorb blocks four at a time: lane j accumulates blocks j, j + 4, ...
+	 * multiplied by r^4 each step, and is multiplied by r^( 4 - j ) at the
+	 * end, so that the sum of the lanes is the serial result.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __poly1305Avx2( Poly1305& poly1305, const uint8_t* blocks, uint64_t blockCount )
+	{
+		if ( 8 <= blockCount )
+		{
+			__m256i r[ 5 ], s[ 5 ], h[ 5 ];
+			for ( size_t limb( -1 ); ++limb < 5; )
+			{
+				r[ limb ] = _mm256_set1_epi64x( poly1305.mPowers[ 3 ][ limb ] );
+				s[ limb ] = _mm256_set1_epi64x( 5 * uint64_t( poly1305.mPowers[ 3 ][ limb ] ) );
+				h[ limb ] = _mm256_set_epi64x( 0, 0, 0, poly1305.mAccumulator[ limb ] );
+			}
+
+			__addBlocksAvx2( h, blocks );
+			for ( blocks += 4 * MAC_BLOCK_SIZE, blockCount -= 4; 4 <= blockCount; blocks += 4 * MAC_BLOCK_SIZE, blockCount -= 4 )
+			{
+				__multiplyAvx2( h, r, s );
+				__addBlocksAvx2( h, blocks );
+			}
+
+			for ( size_t limb( -1 ); ++limb < 5; )
+			{
+				r[ limb ] = _mm256_set_epi64x( poly1305.mPowers[ 0 ][ limb ], poly1305.mPowers[ 1 ][ limb ],
+					poly1305.mPowers[ 2 ][ limb ], poly1305.mPowers[ 3 ][ limb ] );
+				s[ limb ] = _mm256_add_epi64( r[ limb ], _mm256_slli_epi64( r[ limb ], 2 ) );
+			}
+
+			__multiplyAvx2( h, r, s );
+
+			alignas( 32 ) uint64_t lanes[ 5 ][ 4 ];
+			std::memcpy( lanes, h, sizeof( lanes ) );
+			__carry( poly1305.mAccumulator,
+				lanes[ 0 ][ 0 ] + lanes[ 0 ][ 1 ] + lanes[ 0 ][ 2 ] + lanes[ 0 ][ 3 ],
+				lanes[ 1 ][ 0 ] + lanes[ 1 ][ 1 ] + lanes[ 1 ][ 2 ] + lanes[ 1 ][ 3 ],
+				lanes[ 2 ][ 0 ] + lanes[ 2 ][ 1 ] + lanes[ 2 ][ 2 ] + lanes[ 2 ][ 3 ],
+				lanes[ 3 ][ 0 ] + lanes[ 3 ][ 1 ] + lanes[ 3 ][ 2 ] + lanes[ 3 ][ 3 ],
+				lanes[ 4 ][ 0 ] + lanes[ 4 ][ 1 ] + lanes[ 4 ][ 2 ] + lanes[ 4 ][ 3 ] );
+			zeroize( lanes, sizeof( lanes ) );
+		}
+
+		__poly1305Portable( poly1305, blocks, blockCount );
+	}
+
+	__attribute__(( target( "avx512f" ) ))
+	static __m512i __dotAvx512( const __m512i* h, __m512i a0, __m512i a1, __m512i a2, __m512i a3, __m512i a4 )
+	{
+		return _mm512_add_epi64(
+			_mm512_add_epi64( _mm512_mul_epu32( h[ 0 ], a0 ), _mm512_mul_epu32( h[ 1 ], a1 ) ),
+			_mm512_add_epi64( _mm512_add_epi64( _mm512_mul_epu32( h[ 2 ], a2 ), _mm512_mul_epu32( h[ 3 ], a3 ) ),
+				_mm512_mul_epu32( h[ 4 ], a4 ) ) );
+	}
+
+	/**
+	 * Multiply eight numbers in eight lanes, as __multiplyAvx2() does four.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __multiplyAvx512( __m512i* h, const __m512i* r, const __m512i* s )
+	{
+		__m512i d0 = __dotAvx512( h, r[ 0 ], s[ 4 ], s[ 3 ], s[ 2 ], s[ 1 ] );
+		__m512i d1 = __dotAvx512( h, r[ 1 ], r[ 0 ], s[ 4 ], s[ 3 ], s[ 2 ] );
+		__m512i d2 = __dotAvx512( h, r[ 2 ], r[ 1 ], r[ 0 ], s[ 4 ], s[ 3 ] );
+		__m512i d3 = __dotAvx512( h, r[ 3 ], r[ 2 ], r[ 1 ], r[ 0 ], s[ 4 ] );
+		__m512i d4 = __dotAvx512( h, r[ 4 ], r[ 3 ], r[ 2 ], r[ 1 ], r[ 0 ] );
+
+		const __m512i mask = _mm512_set1_epi64( LIMB_MASK );
+		d1 = _mm512_add_epi64( d1, _mm512_srli_epi64( d0, 26 ) ); d0 = _mm512_and_si512( d0, mask );
+		d4 = _mm512_add_epi64( d4, _mm512_srli_epi64( d3, 26 ) ); d3 = _mm512_and_si512( d3, mask );
+		d2 = _mm512_add_epi64( d2, _mm512_srli_epi64( d1, 26 ) ); d1 = _mm512_and_si512( d1, mask );
+		const __m512i wrap = _mm512_srli_epi64( d4, 26 ); d4 = _mm512_and_si512( d4, mask );
+		d0 = _mm512_add_epi64( d0, _mm512_add_epi64( wrap, _mm512_slli_epi64( wrap, 2 ) ) );
+		d3 = _mm512_add_epi64( d3, _mm512_srli_epi64( d2, 26 ) ); d2 = _mm512_and_si512( d2, mask );
+		d1 = _mm512_add_epi64( d1, _mm512_srli_epi64( d0, 26 ) ); d0 = _mm512_and_si512( d0, mask );
+		d4 = _mm512_add_epi64( d4, _mm512_srli_epi64( d3, 26 ) ); d3 = _mm512_and_si512( d3, mask );
+		h[ 0 ] = d0; h[ 1 ] = d1; h[ 2 ] = d2; h[ 3 ] = d3; h[ 4 ] = d4;
+	}
+
+	/**
+	 * Add eight blocks to the eight lanes of {@param h}.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __addBlocksAvx512( __m512i* h, const uint8_t* blocks )
+	{
+		const __m512i first = _mm512_loadu_si512( blocks );
+		const __m512i second = _mm512_loadu_si512( blocks + 64 );
+		const __m512i order = _mm512_setr_epi64( 0, 2, 4, 6, 1, 3, 5, 7 );
+		const __m512i low = _mm512_permutexvar_epi64( order, _mm512_unpacklo_epi64( first, second ) );
+		const __m512i high = _mm512_permutexvar_epi64( order, _mm512_unpackhi_epi64( first, second ) );
+		const __m512i mask = _mm512_set1_epi64( LIMB_MASK );
+		h[ 0 ] = _mm512_add_epi64( h[ 0 ], _mm512_and_si512( low, mask ) );
+		h[ 1 ] = _mm512_add_epi64( h[ 1 ], _mm512_and_si512( _mm512_srli_epi64( low, 26 ), mask ) );
+		h[ 2 ] = _mm512_add_epi64( h[ 2 ], _mm512_and_si512( _mm512_or_si512( _mm512_srli_epi64( low, 52 ), _mm512_slli_epi64( high, 12 ) ), mask ) );
+		h[ 3 ] = _mm512_add_epi64( h[ 3 ], _mm512_and_si512( _mm512_srli_epi64( high, 14 ), mask ) );
+		h[ 4 ] = _mm512_add_epi64( h[ 4 ], _mm512_or_si512( _mm512_srli_epi64( high, 40 ), _mm512_set1_epi64( 1 << 24 ) ) );
+	}
+
+	/**
+	 * Absorb blocks eight at a time, as __poly1305Avx2() does four, with r^8.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __poly1305Avx512( Poly1305& poly1305, const uint8_t* blocks, uint64_t blockCount )
+	{
+		if ( 16 <= blockCount )
+		{
+			const uint32_t ( &powers )[ 8 ][ 5 ] = poly1305.mPowers;
+			__m512i r[ 5 ], s[ 5 ], h[ 5 ];
+			for ( size_t limb( -1 ); ++limb < 5; )
+			{
+				r[ limb ] = _mm512_set1_epi64( powers[ 7 ][ limb ] );
+				s[ limb ] = _mm512_set1_epi64( 5 * uint64_t( powers[ 7 ][ limb ] ) );
+				h[ limb ] = _mm512_setr_epi64( poly1305.mAccumulator[ limb ], 0, 0, 0, 0, 0, 0, 0 );
+			}
+
+			__addBlocksAvx512( h, blocks );
+			for ( blocks += 8 * MAC_BLOCK_SIZE, blockCount -= 8; 8 <= blockCount; blocks += 8 * MAC_BLOCK_SIZE, blockCount -= 8 )
+			{
+				__multiplyAvx512( h, r, s );
+				__addBlocksAvx512( h, blocks );
+			}
+
+			for ( size_t limb( -1 ); ++limb < 5; )
+			{
+				r[ limb ] = _mm512_setr_epi64( powers[ 7 ][ limb ], powers[ 6 ][ limb ], powers[ 5 ][ limb ], powers[ 4 ][ limb ],
+					powers[ 3 ][ limb ], powers[ 2 ][ limb ], powers[ 1 ][ limb ], powers[ 0 ][ limb ] );
+				s[ limb ] = _mm512_add_epi64( r[ limb ], _mm512_slli_epi64( r[ limb ], 2 ) );
+			}
+
+			__multiplyAvx512( h, r, s );
+			__carry( poly1305.mAccumulator, _mm512_reduce_add_epi64( h[ 0 ] ), _mm512_reduce_add_epi64( h[ 1 ] ),
+				_mm512_reduce_add_epi64( h[ 2 ] ), _mm512_reduce_add_epi64( h[ 3 ] ), _mm512_reduce_add_epi64( h[ 4 ] ) );
+		}
+
+		__poly1305Portable( poly1305, blocks, blockCount );
+	}
+#endif
+
+	/**
+	 * The kernels chosen for the enabled processor features.
+	 */
+	struct DispatchTable
+	{
+		std::atomic< XorKeyStreamFunction > mXorKeyStream;
+		std::atomic< Poly1305Function > mPoly1305;
+	};
+
+	static DispatchTable& __dispatchTable()
+	{
+		static DispatchTable dispatchTable;
+		return dispatchTable;
+	}
+
+	static void __selectKernels()
+	{
+		XorKeyStreamFunction xorKeyStream = __xorKeyStreamPortable;
+		Poly1305Function poly1305 = __poly1305Portable;
+#if defined( PIQUE_CHACHA20_POLY1305_X86 )
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 ) )
+		{
+			xorKeyStream = __xorKeyStreamAvx2;
+			poly1305 = __poly1305Avx2;
+		}
+
+		// The AVX-512 key stream hands its last eight blocks to the AVX2 one.
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 | CpuFeatures::AVX512F ) )
+		{
+			xorKeyStream = __xorKeyStreamAvx512;
+			poly1305 = __poly1305Avx512;
+		}
+#endif
+		__dispatchTable().mXorKeyStream.store( xorKeyStream, std::memory_order_relaxed );
+		__dispatchTable().mPoly1305.store( poly1305, std::memory_order_relaxed );
+	}
+
+	static const DispatchTable& __kernels()
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		return __dispatchTable();
+	}
+
+	/**
+	 * Derive the XChaCha20 subkey from {@param key} and the first 16 bytes
+	 * of the nonce: the words of ChaCha20 rounds that do not depend on the
+	 * key once it is added back.
+	 */
+	static void __hChaCha20( uint32_t* subkey, const uint32_t* key, const uint8_t* nonce )
+	{
+		uint32_t x[ 16 ];
+		std::memcpy( x, CONSTANTS, sizeof( CONSTANTS ) );
+		std::memcpy( x + 4, key, 8 * sizeof( uint32_t ) );
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			x[ 12 + index ] = __loadLittleEndian( nonce + 4 * index );
+		}
+
+		__rounds( x );
+		std::memcpy( subkey, x, 4 * sizeof( uint32_t ) );
+		std::memcpy( subkey + 4, x + 12, 4 * sizeof( uint32_t ) );
+		zeroize( x, sizeof( x ) );
+	}
+
+	/**
+	 * Set up Poly1305 with the one-time key of the first 32 bytes of key
+	 * stream block zero, and the first {@param powerCount} powers of r.
+	 */
+	static void __initializePoly1305( Poly1305& poly1305, const uint8_t* oneTimeKey, size_t powerCount )
+	{
+		uint32_t* r = poly1305.mPowers[ 0 ];
+		r[ 0 ] = ( __loadLittleEndian( oneTimeKey + 0 ) >> 0 ) & 0x3FFFFFF;
+		r[ 1 ] = ( __loadLittleEndian( oneTimeKey + 3 ) >> 2 ) & 0x3FFFF03;
+		r[ 2 ] = ( __loadLittleEndian( oneTimeKey + 6 ) >> 4 ) & 0x3FFC0FF;
+		r[ 3 ] = ( __loadLittleEndian( oneTimeKey + 9 ) >> 6 ) & 0x3F03FFF;
+		r[ 4 ] = ( __loadLittleEndian( oneTimeKey + 12 ) >> 8 ) & 0x00FFFFF;
+		for ( size_t power( 0 ); ++power < powerCount; )
+		{
+			std::memcpy( poly1305.mPowers[ power ], poly1305.mPowers[ power - 1 ], sizeof( poly1305.mPowers[ power ] ) );
+			__multiplyPortable( poly1305.mPowers[ power ], r );
+		}
+
+		std::memset( poly1305.mAccumulator, 0, sizeof( poly1305.mAccumulator ) );
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			poly1305.mPad[ index ] = __loadLittleEndian( oneTimeKey + 16 + 4 * index );
+		}
+	}
+
+	/**
+	 * Reduce the accumulator modulo 2^130 - 5, without branching on it, and
+	 * add the pad modulo 2^128.
+	 */
+	static void __finishPoly1305( uint8_t* tag, Poly1305& poly1305 )
+	{
+		uint32_t* h = poly1305.mAccumulator;
+		__carry( h, h[ 0 ], h[ 1 ], h[ 2 ], h[ 3 ], h[ 4 ] );
+		__carry( h, h[ 0 ], h[ 1 ], h[ 2 ], h[ 3 ], h[ 4 ] );
+
+		// g = h + 5 - 2^130 is the reduced value unless it is negative.
+		uint32_t g[ 5 ];
+		uint32_t carry = 5;
+		for ( size_t limb( -1 ); ++limb < 5; )
+		{
+			g[ limb ] = h[ limb ] + carry;
+			carry = g[ limb ] >> 26;
+			g[ limb ] &= LIMB_MASK;
+		}
+
+		const uint32_t keepG = 0 - carry;
+		for ( size_t limb( -1 ); ++limb < 5; )
+		{
+			h[ limb ] = ( h[ limb ] & ~keepG ) | ( g[ limb ] & keepG );
+		}
+
+		const uint32_t words[ 4 ] = {
+			h[ 0 ] | ( h[ 1 ] << 26 ),
+			( h[ 1 ] >> 6 ) | ( h[ 2 ] << 20 ),
+			( h[ 2 ] >> 12 ) | ( h[ 3 ] << 14 ),
+			( h[ 3 ] >> 18 ) | ( h[ 4 ] << 8 ) };
+		uint64_t sum = 0;
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			sum = ( sum >> 32 ) + words[ index ] + poly1305.mPad[ index ];
+			__storeLittleEndian( tag + 4 * index, uint32_t( sum ) );
+		}
+
+		zeroize( g, sizeof( g ) );
+	}
+
+	/**
+	 * Authenticate {@param length} bytes, the last block padded with zeros.
+	 */
+	static void __authenticatePadded( const DispatchTable& kernels, Poly1305& poly1305, const uint8_t* bytes, uint64_t length )
+	{
+		kernels.mPoly1305.load( std::memory_order_relaxed )( poly1305, bytes, length / MAC_BLOCK_SIZE );
+		if ( 0 != length % MAC_BLOCK_SIZE )
+		{
+			uint8_t block[ MAC_BLOCK_SIZE ] = { 0 };
+			std::memcpy( block, bytes + length - length % MAC_BLOCK_SIZE, length % MAC_BLOCK_SIZE );
+			__poly1305Portable( poly1305, block, 1 );
+			zeroize( block, sizeof( block ) );
+		}
+	}
+
+	bool __isKeyed() const
+	{
+		return mKeyBinding.isBound( [ this ]() { __clearKeyWords(); } );
+	}
+
+	void __clearKeyWords() const
+	{
+		zeroize( mKeyWords, sizeof( mKeyWords ) );
+	}
+
+	/**
+	 * Encrypt or decrypt {@param input} into {@param output} and compute the
+	 * tag over the associated data and the ciphertext, a chunk at a time.
+	 * @return True is returned if the arguments are valid and a key is set, else false.
+	 */
+	template < bool Encrypt >
+	bool __crypt( uint8_t* output, uint8_t* tag, const uint8_t* input, uint64_t length, const uint8_t* nonce, size_t nonceLength,
+		const uint8_t* associatedData, uint64_t associatedDataLength ) const
+	{
+		if ( ( not __isKeyed() ) or ( nullptr == nonce ) or ( ( NONCE_SIZE != nonceLength ) and ( EXTENDED_NONCE_SIZE != nonceLength ) )
+			or ( MAXIMUM_MESSAGE_SIZE < length ) or ( ( 0 != length ) and ( ( nullptr == input ) or ( nullptr == output ) ) )
+			or ( ( 0 != associatedDataLength ) and ( nullptr == associatedData ) ) )
+		{
+			return false;
+		}
+
+		uint32_t state[ 16 ];
+		std::memcpy( state, CONSTANTS, sizeof( CONSTANTS ) );
+		if ( EXTENDED_NONCE_SIZE == nonceLength )
+		{
+			__hChaCha20( state + 4, mKeyWords, nonce );
+			nonce += EXTENDED_NONCE_SIZE - NONCE_SIZE + 4;
+			state[ 13 ] = 0;
+		}
+		else
+		{
+			std::memcpy( state + 4, mKeyWords, sizeof( mKeyWords ) );
+			state[ 13 ] = __loadLittleEndian( nonce );
+			nonce += 4;
+		}
+
+		state[ 12 ] = 0;
+		state[ 14 ] = __loadLittleEndian( nonce );
+		state[ 15 ] = __loadLittleEndian( nonce + 4 );
+
+		// Block zero keys Poly1305, in the same vector pass as a short message.
+		const DispatchTable& kernels = __kernels();
+		const XorKeyStreamFunction xorKeyStream = kernels.mXorKeyStream.load( std::memory_order_relaxed );
+		const bool isShort = ( length <= SHORT_MESSAGE_SIZE );
+		uint8_t buffer[ BLOCK_SIZE + SHORT_MESSAGE_SIZE ] = { 0 };
+		if ( isShort and ( 0 != length ) )
+		{
+			std::memcpy( buffer + BLOCK_SIZE, input, size_t( length ) );
+		}
+
+		xorKeyStream( state, buffer, buffer, isShort ? ( BLOCK_SIZE + length ) : ( 2 * MAC_BLOCK_SIZE ) );
+
+		// The vector kernels only use the powers of r for eight blocks or more at once.
+		Poly1305 poly1305;
+		__initializePoly1305( poly1305, buffer, ( 8 * MAC_BLOCK_SIZE <= std::max( associatedDataLength, length ) ) ? 8 : 1 );
+		__authenticatePadded( kernels, poly1305, associatedData, associatedDataLength );
+
+		if ( isShort )
+		{
+			__authenticatePadded( kernels, poly1305, Encrypt ? ( buffer + BLOCK_SIZE ) : input, length );
+			if ( 0 != length )
+			{
+				std::memcpy( output, buffer + BLOCK_SIZE, size_t( length ) );
+			}
+		}
+
+		state[ 12 ] = 1;
+		for ( uint64_t offset = 0; ( not isShort ) and ( offset < length ); offset += CHUNK_SIZE, state[ 12 ] += CHUNK_SIZE / BLOCK_SIZE )
+		{
+			const uint64_t chunkLength = std::min< uint64_t >( CHUNK_SIZE, length - offset );
+			if ( not Encrypt )
+			{
+				__authenticatePadded( kernels, poly1305, input + offset, chunkLength );
+			}
+
+			xorKeyStream( state, output + offset, input + offset, chunkLength );
+			if ( Encrypt )
+			{
+				__authenticatePadded( kernels, poly1305, output + offset, chunkLength );
+			}
+		}
+
+		uint8_t lengths[ MAC_BLOCK_SIZE ];
+		__storeLittleEndian( lengths + 0, uint32_t( associatedDataLength ) );
+		__storeLittleEndian( lengths + 4, uint32_t( associatedDataLength >> 32 ) );
+		__storeLittleEndian( lengths + 8, uint32_t( length ) );
+		__storeLittleEndian( lengths + 12, uint32_t( length >> 32 ) );
+		__poly1305Portable( poly1305, lengths, 1 );
+		__finishPoly1305( tag, poly1305 );
+
+		zeroize( state, sizeof( state ) );
+		zeroize( buffer, sizeof( buffer ) );
+		zeroize( &poly1305, sizeof( poly1305 ) );
+		return true;
+	}
+
+public:
+	/**
+	 * Default construct a ChaCha20Poly1305 without a key.
+	 */
+	ChaCha20Poly1305()
+	{
+		__clearKeyWords();
+	}
+
+	/**
+	 * Construct a ChaCha20Poly1305 with {@param key}.
+	 * @param key Constant reference to the Key to encrypt with.
+	 */
+	explicit ChaCha20Poly1305( const Key& key ) :
+		ChaCha20Poly1305()
+	{
+		setKey( key );
+	}
+
+	/**
+	 * A copy holds its own copy of the key, bound to the same key material.
+	 */
+	ChaCha20Poly1305( const ChaCha20Poly1305& other ) = default;
+	ChaCha20Poly1305& operator=( const ChaCha20Poly1305& other ) = default;
+
+	/**
+	 * ChaCha20Poly1305 destructor. The key copy is zeroized.
+	 */
+	~ChaCha20Poly1305()
+	{
+		__clearKeyWords();
+	}
+
+	/**
+	 * Take {@param key}, discarding any previous key.
+	 * @param key Constant reference to the Key to encrypt with, of KEY_SIZE bytes.
+	 * @return True if {@param key} has KEY_SIZE bytes, else false is returned
+	 *     and this instance is left without a key.
+	 */
+	bool setKey( const Key& key )
+	{
+		__clearKeyWords();
+		return mKeyBinding.bind( key, [ this ]( const uint8_t* buffer, size_t length )
+			{
+				for ( size_t index( -1 ); ( KEY_SIZE == length ) and ( ++index < 8 ); )
+				{
+					mKeyWords[ index ] = __loadLittleEndian( buffer + 4 * index );
+				}
+
+				return KEY_SIZE == length;
+			} );
+	}
+
+	/**
+	 * Zeroize the key copy and unbind this instance from its key.
+	 */
+	void clear()
+	{
+		__clearKeyWords();
+		mKeyBinding.reset();
+	}
+
+	/**
+	 * Cast this ChaCha20Poly1305 instance to a boolean value.
+	 * If a key is set and its material has not been discarded, then True is returned, else False.
+	 */
+	explicit operator bool() const
+	{
+		return __isKeyed();
+	}
+
+	/**
+	 * Encrypt and authenticate a message.
+	 * @param ciphertext Pointer to receive {@param length} bytes of ciphertext; may be {@param plaintext}.
+	 * @param tag Reference to receive the authentication tag.
+	 * @param plaintext Pointer to an array of {@param length} const bytes.
+	 * @param length Length of the message in bytes, at most MAXIMUM_MESSAGE_SIZE.
+	 * @param nonce Pointer to the nonce, unique for this key.
+	 * @param nonceLength Length of the nonce in bytes, NONCE_SIZE, or
+	 *     EXTENDED_NONCE_SIZE for XChaCha20-Poly1305.
+	 * @param associatedData Pointer to an array of const bytes to authenticate but not encrypt.
+	 * @param associatedDataLength Length of the associated data in bytes.
+	 * @return True if the message was sealed, else false is returned as no key
+	 *     is set or an argument is invalid, and nothing is written.
+	 */
+	bool seal( uint8_t* ciphertext, uint8_t ( &tag )[ TAG_SIZE ], const uint8_t* plaintext, uint64_t length,
+		const uint8_t* nonce, size_t nonceLength, const uint8_t* associatedData = nullptr, uint64_t associatedDataLength = 0 ) const
+	{
+		return __crypt< true >( ciphertext, tag, plaintext, length, nonce, nonceLength, associatedData, associatedDataLength );
+	}
+
+	/**
+	 * Verify and decrypt a message. The plaintext is written as the
+	 * ciphertext is authenticated, and zeroized if the tag does not match, so
+	 * in place the ciphertext is lost on failure.
+	 * @param plaintext Pointer to receive {@param length} bytes of plaintext; may be {@param ciphertext}.
+	 * @param ciphertext Pointer to an array of {@param length} const bytes.
+	 * @param length Length of the message in bytes, at most MAXIMUM_MESSAGE_SIZE.
+	 * @param tag Constant reference to the authentication tag to verify.
+	 * @param nonce Pointer to the nonce the message was sealed with.
+	 * @param nonceLength Length of the nonce in bytes.
+	 * @param associatedData Pointer to the associated data the message was sealed with.
+	 * @param associatedDataLength Length of the associated data in bytes.
+	 * @return True if the message is authentic, else false is returned and
+	 *     the plaintext is zeroized, or not written if no key is set or an
+	 *     argument is invalid.
+	 */
+	bool open( uint8_t* plaintext, const uint8_t* ciphertext, uint64_t length, const uint8_t ( &tag )[ TAG_SIZE ],
+		const uint8_t* nonce, size_t nonceLength, const uint8_t* associatedData = nullptr, uint64_t associatedDataLength = 0 ) const
+	{
+		uint8_t expectedTag[ TAG_SIZE ];
+		if ( not __crypt< false >( plaintext, expectedTag, ciphertext, length, nonce, nonceLength, associatedData, associatedDataLength ) )
+		{
+			return false;
+		}
+
+		const bool authentic = ConstantTime::equal( expectedTag, tag, TAG_SIZE );
+		if ( not authentic and ( 0 != length ) )
+		{
+			zeroize( plaintext, size_t( length ) );
+		}
+
+		zeroize( expectedTag, sizeof( expectedTag ) );
+		return authentic;
+	}
+};
+
+} // namespace Pique
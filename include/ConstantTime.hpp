@@ -0,0 +1,156 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_CONSTANT_TIME_X86 1
+#endif
+
+#include "CpuFeatures.hpp"
+
+namespace Pique
+{
+
+/**
+ * Comparisons whose running time depends on the length of their operands
+ * only, never on their content, for checking secrets such as keys and MACs.
+ * The XOR of both operands is ORed together over the whole length, with no
+ * branch on the data, and only the final accumulator is tested. Whole vectors
+ * are compared by the widest kernel allowed by CpuFeatures: AVX2, SSE2 or
+ * portable 64-bit words.
+ */
+class ConstantTime final
+{
+private:
+	typedef uint64_t ( *DifferenceFunction )( const uint8_t* left, const uint8_t* right, size_t length );
+
+	/**
+	 * Keep the compiler from reasoning about {@param value}, so that it cannot
+	 * turn the accumulation into a loop that exits early.
+	 */
+	static uint64_t __opaque( uint64_t value )
+	{
+		__asm__( "" : "+r"( value ) );
+		return value;
+	}
+
+	static uint64_t __differencePortable( const uint8_t* left, const uint8_t* right, size_t length )
+	{
+		uint64_t difference = 0;
+		size_t index = 0;
+		for ( ; index + 8 <= length; index += 8 )
+		{
+			uint64_t leftWord, rightWord;
+			std::memcpy( &leftWord, left + index, 8 );
+			std::memcpy( &rightWord, right + index, 8 );
+			difference |= leftWord ^ rightWord;
+		}
+
+		for ( ; index < length; ++index )
+		{
+			difference |= uint64_t( left[ index ] ^ right[ index ] );
+		}
+
+		return __opaque( difference );
+	}
+
+#if defined( PIQUE_CONSTANT_TIME_X86 )
+	__attribute__(( target( "sse2" ) ))
+	static uint64_t __differenceSse2( const uint8_t* left, const uint8_t* right, size_t length )
+	{
+		__m128i difference = _mm_setzero_si128();
+		size_t index = 0;
+		for ( ; index + 16 <= length; index += 16 )
+		{
+			difference = _mm_or_si128( difference, _mm_xor_si128(
+				_mm_loadu_si128( reinterpret_cast< const __m128i* >( left + index ) ),
+				_mm_loadu_si128( reinterpret_cast< const __m128i* >( right + index ) ) ) );
+		}
+
+		alignas( 16 ) uint64_t lanes[ 2 ];
+		_mm_store_si128( reinterpret_cast< __m128i* >( lanes ), difference );
+		return lanes[ 0 ] | lanes[ 1 ] | __differencePortable( left + index, right + index, length - index );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static uint64_t __differenceAvx2( const uint8_t* left, const uint8_t* right, size_t length )
+	{
+		__m256i difference[ 2 ] = { _mm256_setzero_si256(), _mm256_setzero_si256() };
+		size_t index = 0;
+		for ( ; index + 64 <= length; index += 64 )
+		{
+			difference[ 0 ] = _mm256_or_si256( difference[ 0 ], _mm256_xor_si256(
+				_mm256_loadu_si256( reinterpret_cast< const __m256i* >( left + index ) ),
+				_mm256_loadu_si256( reinterpret_cast< const __m256i* >( right + index ) ) ) );
+			difference[ 1 ] = _mm256_or_si256( difference[ 1 ], _mm256_xor_si256(
+				_mm256_loadu_si256( reinterpret_cast< const __m256i* >( left + index + 32 ) ),
+				_mm256_loadu_si256( reinterpret_cast< const __m256i* >( right + index + 32 ) ) ) );
+		}
+
+		for ( ; index + 32 <= length; index += 32 )
+		{
+			difference[ 0 ] = _mm256_or_si256( difference[ 0 ], _mm256_xor_si256(
+				_mm256_loadu_si256( reinterpret_cast< const __m256i* >( left + index ) ),
+				_mm256_loadu_si256( reinterpret_cast< const __m256i* >( right + index ) ) ) );
+		}
+
+		alignas( 32 ) uint64_t lanes[ 4 ];
+		_mm256_store_si256( reinterpret_cast< __m256i* >( lanes ), _mm256_or_si256( difference[ 0 ], difference[ 1 ] ) );
+		return lanes[ 0 ] | lanes[ 1 ] | lanes[ 2 ] | lanes[ 3 ] | __differenceSse2( left + index, right + index, length - index );
+	}
+#endif
+
+	static std::atomic< DifferenceFunction >& __dispatchTable()
+	{
+		static std::atomic< DifferenceFunction > difference;
+		return difference;
+	}
+
+	static void __selectKernels()
+	{
+		DifferenceFunction difference = __differencePortable;
+#if defined( PIQUE_CONSTANT_TIME_X86 )
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 ) )
+		{
+			difference = __differenceAvx2;
+		}
+		else if ( CpuFeatures::supports( CpuFeatures::SSE2 ) )
+		{
+			difference = __differenceSse2;
+		}
+#endif
+		__dispatchTable().store( difference, std::memory_order_relaxed );
+	}
+
+public:
+	/**
+	 * Check that two byte arrays of equal length have equal content, in time
+	 * that depends on {@param length} only.
+	 * @param left Pointer to an array of {@param length} const bytes.
+	 * @param right Pointer to an array of {@param length} const bytes.
+	 * @param length Length of both arrays in bytes.
+	 * @return True is returned if the arrays are equal, else false is returned.
+	 */
+	static bool equal( const void* left, const void* right, size_t length )
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+
+		uint64_t difference = __dispatchTable().load( std::memory_order_relaxed )(
+			static_cast< const uint8_t* >( left ), static_cast< const uint8_t* >( right ), length );
+
+		// Fold to one bit without a branch: the top bit of difference | -difference is set unless difference is zero.
+		return 0 == ( ( difference | ( 0 - difference ) ) >> 63 );
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,309 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <cpuid.h>
+#define PIQUE_CPU_FEATURES_X86 1
+#endif
+
+namespace Pique
+{
+
+/**
+ * The processor features that the kernels of this library depend on, detected
+ * once with cpuid and xgetbv. A feature is only reported when the operating
+ * system also saves the register state it needs.
+ *
+ * Algorithms keep a table of kernel function pointers and subscribe() a
+ * function that fills it from enabled(). The table is filled once, and again
+ * only when the enabled features are forced, so hashing never branches on the
+ * processor per call.
+ *
+ * The enabled features may be narrowed to test every kernel on one machine,
+ * either with force() or by setting the environment variable
+ * PIQUE_CRYPTO_CPU_TIER before the first use of the library. The variable is
+ * a comma separated list of tier and feature names, see parse(), for example
+ * PIQUE_CRYPTO_CPU_TIER=portable or PIQUE_CRYPTO_CPU_TIER=sse4,sha.
+ */
+class CpuFeatures final
+{
+public:
+	static constexpr uint32_t SSE2 = 1u << 0;
+	static constexpr uint32_t SSSE3 = 1u << 1;
+	static constexpr uint32_t SSE4_1 = 1u << 2;
+	static constexpr uint32_t SSE4_2 = 1u << 3;
+	static constexpr uint32_t AVX = 1u << 4;
+	static constexpr uint32_t AVX2 = 1u << 5;
+	static constexpr uint32_t BMI2 = 1u << 6;
+	static constexpr uint32_t FMA = 1u << 7;
+	static constexpr uint32_t AVX512F = 1u << 8;
+	static constexpr uint32_t AVX512DQ = 1u << 9;
+	static constexpr uint32_t AVX512BW = 1u << 10;
+	static constexpr uint32_t AVX512VL = 1u << 11;
+	static constexpr uint32_t AVX512IFMA = 1u << 12;
+	static constexpr uint32_t AVX512VBMI = 1u << 13;
+	static constexpr uint32_t SHA = 1u << 16;
+	static constexpr uint32_t AES = 1u << 17;
+	static constexpr uint32_t PCLMULQDQ = 1u << 18;
+	static constexpr uint32_t VAES = 1u << 19;
+	static constexpr uint32_t VPCLMULQDQ = 1u << 20;
+
+	/**
+	 * Tiers are the vector extensions of a processor generation. They do not
+	 * include the SHA and AES extensions, which are named separately, so that
+	 * every kernel can be reached by some combination.
+	 */
+	static constexpr uint32_t TIER_PORTABLE = 0;
+	static constexpr uint32_t TIER_SSE4 = SSE2 | SSSE3 | SSE4_1 | SSE4_2;
+	static constexpr uint32_t TIER_AVX2 = TIER_SSE4 | AVX | AVX2 | BMI2 | FMA;
+	static constexpr uint32_t TIER_AVX512 = TIER_AVX2 | AVX512F | AVX512DQ | AVX512BW | AVX512VL | AVX512IFMA | AVX512VBMI;
+	static constexpr uint32_t ALL_FEATURES = TIER_AVX512 | SHA | AES | PCLMULQDQ | VAES | VPCLMULQDQ;
+
+	/**
+	 * Signature of the function an algorithm subscribes to fill its kernel table.
+	 */
+	typedef void ( *SelectFunction )();
+
+private:
+	struct DispatchState
+	{
+		std::mutex mMutex;
+		std::vector< SelectFunction > mSubscribers;
+		std::atomic< uint32_t > mEnabled;
+		uint32_t mDetected;
+		uint32_t mEnvironment;
+
+		DispatchState() :
+			mEnabled( 0 ),
+			mDetected( __detect() ),
+			mEnvironment( ALL_FEATURES )
+		{
+			const char* environment = std::getenv( "PIQUE_CRYPTO_CPU_TIER" );
+			if ( nullptr != environment )
+			{
+				parse( environment, mEnvironment );
+			}
+
+			mEnabled.store( mDetected & mEnvironment );
+		}
+	};
+
+	struct FeatureName
+	{
+		const char* name;
+		uint32_t features;
+	};
+
+	static constexpr FeatureName FEATURE_NAMES[] = {
+		{ "native", ALL_FEATURES },
+		{ "portable", TIER_PORTABLE },
+		{ "sse4", TIER_SSE4 },
+		{ "avx2", TIER_AVX2 },
+		{ "avx512", TIER_AVX512 },
+		{ "sha", SHA },
+		{ "aes", AES },
+		{ "pclmulqdq", PCLMULQDQ },
+		{ "vaes", VAES },
+		{ "vpclmulqdq", VPCLMULQDQ },
+	};
+
+	static uint32_t __detect()
+	{
+		uint32_t features = 0;
+#if defined( PIQUE_CPU_FEATURES_X86 )
+		unsigned int eax, ebx, ecx, edx;
+		if ( 0 == __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+		{
+			return features;
+		}
+
+		features |= ( edx & ( 1u << 26 ) ) ? SSE2 : 0;
+		features |= ( ecx & ( 1u << 9 ) ) ? SSSE3 : 0;
+		features |= ( ecx & ( 1u << 19 ) ) ? SSE4_1 : 0;
+		features |= ( ecx & ( 1u << 20 ) ) ? SSE4_2 : 0;
+		features |= ( ecx & ( 1u << 25 ) ) ? AES : 0;
+		features |= ( ecx & ( 1u << 1 ) ) ? PCLMULQDQ : 0;
+
+		// The wider registers are only usable once the operating system saves them.
+		uint64_t registerState = 0;
+		if ( ecx & ( 1u << 27 ) )
+		{
+			uint32_t low, high;
+			__asm__ __volatile__( "xgetbv" : "=a"( low ), "=d"( high ) : "c"( 0 ) );
+			registerState = ( uint64_t( high ) << 32 ) | low;
+		}
+
+		bool avxState = ( 0x06 == ( registerState & 0x06 ) );
+		bool avx512State = ( 0xE6 == ( registerState & 0xE6 ) );
+		bool hasAvx = avxState and ( ecx & ( 1u << 28 ) );
+		features |= hasAvx ? AVX : 0;
+		features |= ( hasAvx and ( ecx & ( 1u << 12 ) ) ) ? FMA : 0;
+
+		if ( 0 == __get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+		{
+			return features;
+		}
+
+		features |= ( ebx & ( 1u << 8 ) ) ? BMI2 : 0;
+		features |= ( ebx & ( 1u << 29 ) ) ? SHA : 0;
+
+		if ( hasAvx )
+		{
+			features |= ( ebx & ( 1u << 5 ) ) ? AVX2 : 0;
+			features |= ( ecx & ( 1u << 9 ) ) ? VAES : 0;
+			features |= ( ecx & ( 1u << 10 ) ) ? VPCLMULQDQ : 0;
+		}
+
+		if ( hasAvx and avx512State and ( ebx & ( 1u << 16 ) ) )
+		{
+			features |= AVX512F;
+			features |= ( ebx & ( 1u << 17 ) ) ? AVX512DQ : 0;
+			features |= ( ebx & ( 1u << 21 ) ) ? AVX512IFMA : 0;
+			features |= ( ebx & ( 1u << 30 ) ) ? AVX512BW : 0;
+			features |= ( ebx & ( 1u << 31 ) ) ? AVX512VL : 0;
+			features |= ( ecx & ( 1u << 1 ) ) ? AVX512VBMI : 0;
+		}
+#endif
+		return features;
+	}
+
+	static DispatchState& __state()
+	{
+		static DispatchState state;
+		return state;
+	}
+
+	static void __enable( uint32_t features )
+	{
+		DispatchState& state = __state();
+		std::lock_guard< std::mutex > lock( state.mMutex );
+		state.mEnabled.store( state.mDetected & features );
+		for ( SelectFunction select : state.mSubscribers )
+		{
+			select();
+		}
+	}
+
+public:
+	/**
+	 * Get the features supported by the processor and operating system.
+	 * @return Bitwise or of the detected feature constants is returned.
+	 */
+	static uint32_t detected()
+	{
+		return __state().mDetected;
+	}
+
+	/**
+	 * Get the features that kernels are allowed to use. These are the
+	 * detected features, narrowed by PIQUE_CRYPTO_CPU_TIER or force().
+	 * @return Bitwise or of the enabled feature constants is returned.
+	 */
+	static uint32_t enabled()
+	{
+		return __state().mEnabled.load( std::memory_order_acquire );
+	}
+
+	/**
+	 * Check that every feature in {@param features} is enabled.
+	 * @param features Bitwise or of feature constants.
+	 * @return True if all of {@param features} are enabled, else false is returned.
+	 */
+	static bool supports( uint32_t features )
+	{
+		return features == ( enabled() & features );
+	}
+
+	/**
+	 * Restrict the kernels to {@param features}, as far as the processor
+	 * supports them, and refill every kernel table. This is intended for
+	 * testing; hashing on other threads picks up the new kernels on its next
+	 * call, and every kernel produces the same digest.
+	 * @param features Bitwise or of feature and tier constants.
+	 */
+	static void force( uint32_t features )
+	{
+		__enable( features );
+	}
+
+	/**
+	 * Undo force(), returning to the features chosen at startup.
+	 */
+	static void restore()
+	{
+		__enable( __state().mEnvironment );
+	}
+
+	/**
+	 * Translate a comma separated list of names into features. The names are
+	 * "native", "portable", "sse4", "avx2" and "avx512" for the tiers, and
+	 * "sha", "aes", "pclmulqdq", "vaes" and "vpclmulqdq" for the extensions.
+	 * @param names Null terminated list of names.
+	 * @param features Reference to receive the union of the named features.
+	 * @return True if every name was recognized, else false is returned and
+	 *     {@param features} is left untouched.
+	 */
+	static bool parse( const char* names, uint32_t& features )
+	{
+		uint32_t parsedFeatures = 0;
+		while ( true )
+		{
+			const char* end = std::strchr( names, ',' );
+			size_t length = ( nullptr == end ) ? std::strlen( names ) : size_t( end - names );
+			bool recognized = false;
+
+			for ( const FeatureName& featureName : FEATURE_NAMES )
+			{
+				if ( ( length == std::strlen( featureName.name ) ) and ( 0 == std::strncmp( names, featureName.name, length ) ) )
+				{
+					parsedFeatures |= featureName.features;
+					recognized = true;
+					break;
+				}
+			}
+
+			if ( not recognized )
+			{
+				return false;
+			}
+
+			if ( nullptr == end )
+			{
+				break;
+			}
+
+			names = end + 1;
+		}
+
+		features = parsedFeatures;
+		return true;
+	}
+
+	/**
+	 * Register {@param select} to fill a kernel table from enabled(). It is
+	 * called immediately and again after every force() or restore().
+	 * @param select Function that reads enabled() and stores its kernels.
+	 * @return True is returned, so the call may initialize a function local static.
+	 */
+	static bool subscribe( SelectFunction select )
+	{
+		DispatchState& state = __state();
+		std::lock_guard< std::mutex > lock( state.mMutex );
+		state.mSubscribers.push_back( select );
+		select();
+		return true;
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,320 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PIQUE_FILE_HASH_POSIX 1
+#endif
+
+/**
+ * The length, in bytes, of the window of a regular file mapped at once.
+ */
+#ifndef PIQUE_FILE_HASH_MAP_WINDOW_SIZE
+#define PIQUE_FILE_HASH_MAP_WINDOW_SIZE ( 64 * 1024 * 1024 )
+#endif
+
+/**
+ * The length, in bytes, of each of the two buffers of the reader thread.
+ */
+#ifndef PIQUE_FILE_HASH_BUFFER_SIZE
+#define PIQUE_FILE_HASH_BUFFER_SIZE ( 1024 * 1024 )
+#endif
+
+#if defined( PIQUE_FILE_HASH_POSIX )
+namespace Pique
+{
+
+/**
+ * Hash the contents of files and file descriptors with any HashFunction, so
+ * that reading and hashing overlap.
+ *
+ * A regular file is memory mapped a window at a time and hashed straight from
+ * the page cache, without copying. The kernel is told the access is
+ * sequential, and is asked to read the next window ahead while the current
+ * one is hashed.
+ *
+ * Pipes, sockets, devices and files that cannot be mapped are read into two
+ * buffers: a reader thread fills one while the calling thread hashes the
+ * other, so every byte is copied once, by read(). An input that fits in one
+ * buffer is read and hashed without starting the thread.
+ *
+ * A mapped file that is truncated while it is hashed raises SIGBUS, as with
+ * any memory mapping.
+ */
+class FileHash final
+{
+public:
+	static constexpr size_t MAP_WINDOW_SIZE = PIQUE_FILE_HASH_MAP_WINDOW_SIZE;
+	static constexpr size_t BUFFER_SIZE = PIQUE_FILE_HASH_BUFFER_SIZE;
+
+	static_assert( 0 == MAP_WINDOW_SIZE % ( 64 * 1024 ), "The map window must be a whole number of pages" );
+	static_assert( 0 < BUFFER_SIZE, "The buffers must not be empty" );
+
+private:
+	/**
+	 * Marks a buffer of the reader thread that may be filled.
+	 */
+	static constexpr ptrdiff_t EMPTY = -2;
+
+	/**
+	 * Read until {@param buffer} is full or the input ends, retrying
+	 * interrupted reads.
+	 * @return The number of bytes read is returned, less than {@param length}
+	 *     only at the end of the input, or -1 on a read error.
+	 */
+	static ptrdiff_t __readFully( int fd, uint8_t* buffer, size_t length )
+	{
+		size_t filled = 0;
+		while ( filled < length )
+		{
+			ssize_t result = ::read( fd, buffer + filled, length - filled );
+			if ( 0 < result )
+			{
+				filled += size_t( result );
+			}
+			else if ( 0 == result )
+			{
+				break;
+			}
+			else if ( EINTR != errno )
+			{
+				return -1;
+			}
+		}
+
+		return ptrdiff_t( filled );
+	}
+
+	/**
+	 * Hash a regular file of {@param fileSize} bytes from {@param offset} on,
+	 * a mapped window at a time.
+	 * @return True is returned if the file was hashed, else false if a window
+	 *     could not be mapped.
+	 */
+	template < typename Hash >
+	static bool __hashMapped( Hash& hash, int fd, uint64_t offset, uint64_t fileSize )
+	{
+		const uint64_t pageSize = uint64_t( ::sysconf( _SC_PAGESIZE ) );
+#if defined( POSIX_FADV_SEQUENTIAL )
+		::posix_fadvise( fd, off_t( offset ), 0, POSIX_FADV_SEQUENTIAL );
+#endif
+
+		for ( uint64_t position = offset; position < fileSize; )
+		{
+			uint64_t mapOffset = position - position % pageSize;
+			size_t mapLength = size_t( std::min< uint64_t >( MAP_WINDOW_SIZE, fileSize - mapOffset ) );
+			void* map = ::mmap( nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, off_t( mapOffset ) );
+			if ( MAP_FAILED == map )
+			{
+				return false;
+			}
+
+			::madvise( map, mapLength, MADV_SEQUENTIAL );
+#if defined( POSIX_FADV_WILLNEED )
+			// Start reading the next window while this one is hashed.
+			if ( mapOffset + mapLength < fileSize )
+			{
+				::posix_fadvise( fd, off_t( mapOffset + mapLength ), off_t( MAP_WINDOW_SIZE ), POSIX_FADV_WILLNEED );
+			}
+#endif
+
+			hash.update( static_cast< const uint8_t* >( map ) + ( position - mapOffset ), mapOffset + mapLength - position );
+			::munmap( map, mapLength );
+			position = mapOffset + mapLength;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Hash {@param fd} to its end with read(), overlapped by a reader thread
+	 * once the input outgrows one buffer.
+	 * @return True is returned if the input was hashed to its end, else false.
+	 */
+	template < typename Hash >
+	static bool __hashRead( Hash& hash, int fd )
+	{
+		std::unique_ptr< uint8_t[] > buffers( new uint8_t[ 2 * BUFFER_SIZE ] );
+		ptrdiff_t lengths[ 2 ] = { __readFully( fd, buffers.get(), BUFFER_SIZE ), EMPTY };
+		if ( lengths[ 0 ] < 0 )
+		{
+			return false;
+		}
+
+		if ( size_t( lengths[ 0 ] ) < BUFFER_SIZE )
+		{
+			hash.update( buffers.get(), uint64_t( lengths[ 0 ] ) );
+			return true;
+		}
+
+		// Each buffer is either EMPTY, owned by the reader, or holds a length, owned by the hasher.
+		// The reader stops after a short read, so it has returned by the time the hasher stops.
+		std::mutex lengthsMutex;
+		std::condition_variable lengthsChanged;
+		std::thread reader( [ & ]()
+			{
+				for ( size_t slot = 1; true; slot ^= 1 )
+				{
+					{
+						std::unique_lock< std::mutex > lengthsLock( lengthsMutex );
+						lengthsChanged.wait( lengthsLock, [ & ]() { return EMPTY == lengths[ slot ]; } );
+					}
+
+					ptrdiff_t length = __readFully( fd, buffers.get() + slot * BUFFER_SIZE, BUFFER_SIZE );
+					{
+						std::lock_guard< std::mutex > lengthsLock( lengthsMutex );
+						lengths[ slot ] = length;
+					}
+
+					lengthsChanged.notify_one();
+					if ( ( length < 0 ) or ( size_t( length ) < BUFFER_SIZE ) )
+					{
+						return;
+					}
+				}
+			} );
+
+		bool hashed = true;
+		for ( size_t slot = 0; true; slot ^= 1 )
+		{
+			ptrdiff_t length;
+			{
+				std::unique_lock< std::mutex > lengthsLock( lengthsMutex );
+				lengthsChanged.wait( lengthsLock, [ & ]() { return EMPTY != lengths[ slot ]; } );
+				length = lengths[ slot ];
+			}
+
+			if ( length < 0 )
+			{
+				hashed = false;
+				break;
+			}
+
+			hash.update( buffers.get() + slot * BUFFER_SIZE, uint64_t( length ) );
+			if ( size_t( length ) < BUFFER_SIZE )
+			{
+				break;
+			}
+
+			{
+				std::lock_guard< std::mutex > lengthsLock( lengthsMutex );
+				lengths[ slot ] = EMPTY;
+			}
+
+			lengthsChanged.notify_one();
+		}
+
+		reader.join();
+		return hashed;
+	}
+
+public:
+	/**
+	 * Incorporate everything that can be read from {@param fd} into the hash
+	 * computation, as one update() of the whole input would. A regular file is
+	 * hashed from its current offset to its end, and the offset is left at
+	 * the end.
+	 * @param hash Reference to the hash to update; any HashFunction or an
+	 *     AnyHashFunction.
+	 * @param fd The open file descriptor to read.
+	 * @return True is returned if the input was hashed to its end, else false
+	 *     is returned and {@param hash} is left untouched.
+	 */
+	template < typename Hash >
+	static bool hashFd( Hash& hash, int fd )
+	{
+		struct stat status;
+		if ( ( fd < 0 ) or ( 0 != ::fstat( fd, &status ) ) )
+		{
+			return false;
+		}
+
+		Hash workingHash( hash );
+		bool hashed = false;
+
+		// Files of size zero, such as those of /proc, may still have contents to read.
+		off_t offset = S_ISREG( status.st_mode ) ? ::lseek( fd, 0, SEEK_CUR ) : off_t( -1 );
+		if ( ( 0 <= offset ) and ( 0 < status.st_size ) )
+		{
+			if ( status.st_size <= offset )
+			{
+				return true;
+			}
+
+			hashed = __hashMapped( workingHash, fd, uint64_t( offset ), uint64_t( status.st_size ) );
+			if ( hashed )
+			{
+				::lseek( fd, status.st_size, SEEK_SET );
+			}
+			else
+			{
+				// Mapping does not move the offset, so the file can be read from the start instead.
+				workingHash = hash;
+				hashed = __hashRead( workingHash, fd );
+			}
+		}
+		else
+		{
+			hashed = __hashRead( workingHash, fd );
+		}
+
+		if ( hashed )
+		{
+			hash = workingHash;
+		}
+
+		return hashed;
+	}
+
+	/**
+	 * Incorporate the contents of the file at {@param path} into the hash
+	 * computation, as with hashFd().
+	 * @param hash Reference to the hash to update.
+	 * @param path Path of the file to hash.
+	 * @return True is returned if the file was opened and hashed, else false
+	 *     is returned and {@param hash} is left untouched.
+	 */
+	template < typename Hash >
+	static bool hashFile( Hash& hash, const char* path )
+	{
+		if ( nullptr == path )
+		{
+			return false;
+		}
+
+		int fd;
+		do
+		{
+			fd = ::open( path, O_RDONLY | O_CLOEXEC );
+		}
+		while ( ( fd < 0 ) and ( EINTR == errno ) );
+
+		if ( fd < 0 )
+		{
+			return false;
+		}
+
+		bool hashed = hashFd( hash, fd );
+		::close( fd );
+		return hashed;
+	}
+};
+
+} // namespace Pique
+#endif
@@ -0,0 +1,256 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "Key.hpp"
+#include "KeyBinding.hpp"
+#include "Zeroize.hpp"
+
+namespace Pique
+{
+
+/**
+ * HMAC as specified in RFC 2104 over any fixed size HashFunction.
+ * The key xor ipad and key xor opad blocks are compressed once, when the key
+ * is set, and the resulting midstates are cloned for every message. A MAC of
+ * a short message therefore costs the compressions of the message and of the
+ * two final blocks only, without any heap allocation.
+ *
+ * The midstates are bound to the key material of the Key they were computed
+ * from. Once every Key sharing that material has been cleared, set or
+ * destroyed, the next call zeroizes the midstates and fails, so a MAC is never
+ * produced with a key its owner has discarded.
+ *
+ * An instance is not safe for concurrent use; give each thread its own copy.
+ */
+template < typename Hash >
+class HMAC final
+{
+	static_assert( Hash::UNLIMITED_DIGEST_SIZE != Hash::DIGEST_SIZE, "HMAC requires a fixed size digest" );
+
+public:
+	/**
+	 * Length of the hash function message block, in bytes.
+	 */
+	static constexpr uint64_t BLOCK_SIZE = Hash::BLOCK_SIZE;
+
+	/**
+	 * Length of the message authentication code, in bytes.
+	 */
+	static constexpr uint64_t DIGEST_SIZE = Hash::DIGEST_SIZE;
+
+private:
+	KeyBinding mKeyBinding;
+	mutable Hash mInnerPad;
+	mutable Hash mOuterPad;
+	mutable Hash mInner;
+
+	bool __isKeyed() const
+	{
+		return mKeyBinding.isBound( [ this ]() { __clearMidstates(); } );
+	}
+
+	void __clearMidstates() const
+	{
+		zeroize( &mInnerPad, sizeof( mInnerPad ) );
+		zeroize( &mOuterPad, sizeof( mOuterPad ) );
+		zeroize( &mInner, sizeof( mInner ) );
+		mInnerPad.reset();
+		mOuterPad.reset();
+		mInner.reset();
+	}
+
+public:
+	/**
+	 * Default construct an HMAC without a key.
+	 */
+	HMAC()
+	{
+	}
+
+	/**
+	 * Construct an HMAC and precompute the midstates of {@param key}.
+	 * @param key Constant reference to the Key to authenticate with.
+	 */
+	explicit HMAC( const Key& key )
+	{
+		setKey( key );
+	}
+
+	/**
+	 * Copy constructor. The copy is bound to the same key material.
+	 * @param other Constant reference to the HMAC object to copy.
+	 */
+	HMAC( const HMAC& other ) = default;
+
+	/**
+	 * Copy assignment operator. This instance is bound to the key material of {@param other}.
+	 * @param other Constant reference to the HMAC object to copy.
+	 * @return Reference to this HMAC instance is returned.
+	 */
+	HMAC& operator=( const HMAC& other ) = default;
+
+	/**
+	 * HMAC destructor. The midstates are zeroized.
+	 */
+	~HMAC()
+	{
+		__clearMidstates();
+	}
+
+	/**
+	 * Precompute the midstates of {@param key}, discarding any previous key
+	 * and any message in progress.
+	 * @param key Constant reference to the Key to authenticate with.
+	 * @return True if {@param key} is non-null, else false is returned and this
+	 *     instance is left without a key.
+	 */
+	bool setKey( const Key& key )
+	{
+		__clearMidstates();
+
+		uint8_t paddedKey[ BLOCK_SIZE ] = { 0 };
+		bool isKeyed = mKeyBinding.bind( key, [ &paddedKey ]( const uint8_t* buffer, size_t length )
+			{
+				if ( BLOCK_SIZE < length )
+				{
+					uint8_t keyDigest[ DIGEST_SIZE ];
+					Hash::digestMessage( keyDigest, buffer, length );
+					std::memcpy( paddedKey, keyDigest, DIGEST_SIZE );
+					zeroize( keyDigest, sizeof( keyDigest ) );
+				}
+				else
+				{
+					std::memcpy( paddedKey, buffer, length );
+				}
+
+				return true;
+			} );
+
+		if ( not isKeyed )
+		{
+			return false;
+		}
+
+		for ( size_t index( -1 ); ++index < BLOCK_SIZE; )
+		{
+			paddedKey[ index ] ^= 0x36;
+		}
+
+		mInnerPad.update( paddedKey, BLOCK_SIZE );
+
+		for ( size_t index( -1 ); ++index < BLOCK_SIZE; )
+		{
+			paddedKey[ index ] ^= 0x36 ^ 0x5C;
+		}
+
+		mOuterPad.update( paddedKey, BLOCK_SIZE );
+		zeroize( paddedKey, sizeof( paddedKey ) );
+
+		mInner = mInnerPad;
+		return true;
+	}
+
+	/**
+	 * Zeroize the midstates and unbind this instance from its key.
+	 */
+	void clear()
+	{
+		__clearMidstates();
+		mKeyBinding.reset();
+	}
+
+	/**
+	 * Cast this HMAC instance to a boolean value.
+	 * If a key is set and its material has not been discarded, then True is returned, else False.
+	 */
+	explicit operator bool() const
+	{
+		return __isKeyed();
+	}
+
+	/**
+	 * Incorporate the provided message segment into the MAC computation.
+	 * @param message Pointer to an array of const bytes.
+	 * @param messageLength Length of the message in bytes.
+	 * @return True if the segment was incorporated, else false is returned as no key is set.
+	 */
+	bool update( const uint8_t* message, uint64_t messageLength )
+	{
+		if ( not __isKeyed() )
+		{
+			return false;
+		}
+
+		mInner.update( message, messageLength );
+		return true;
+	}
+
+	/**
+	 * Compute the MAC of the message passed to update() since the key was set
+	 * or reset() was last called. The message may be extended afterwards.
+	 * @param messageDigest Reference to an unsigned byte array of size DIGEST_SIZE.
+	 * @return True if the MAC was computed, else false is returned as no key is set.
+	 */
+	bool digest( uint8_t ( &messageDigest )[ DIGEST_SIZE ] ) const
+	{
+		if ( not __isKeyed() )
+		{
+			return false;
+		}
+
+		uint8_t innerDigest[ DIGEST_SIZE ];
+		mInner.digest( innerDigest );
+
+		Hash outer( mOuterPad );
+		outer.update( innerDigest, DIGEST_SIZE );
+		outer.digest( messageDigest );
+		zeroize( &outer, sizeof( outer ) );
+		zeroize( innerDigest, sizeof( innerDigest ) );
+		return true;
+	}
+
+	/**
+	 * Compute the MAC of the provided message, independent of any message passed to update().
+	 * @param messageDigest Reference to an unsigned byte array of size DIGEST_SIZE.
+	 * @param message Pointer to an array of const bytes.
+	 * @param messageLength Length of the message in bytes.
+	 * @return True if the MAC was computed, else false is returned as no key is set.
+	 */
+	bool digestMessage( uint8_t ( &messageDigest )[ DIGEST_SIZE ], const uint8_t* message, uint64_t messageLength ) const
+	{
+		if ( not __isKeyed() )
+		{
+			return false;
+		}
+
+		uint8_t innerDigest[ DIGEST_SIZE ];
+		Hash inner( mInnerPad );
+		inner.update( message, messageLength );
+		inner.digest( innerDigest );
+		zeroize( &inner, sizeof( inner ) );
+
+		Hash outer( mOuterPad );
+		outer.update( innerDigest, DIGEST_SIZE );
+		outer.digest( messageDigest );
+		zeroize( &outer, sizeof( outer ) );
+		zeroize( innerDigest, sizeof( innerDigest ) );
+		return true;
+	}
+
+	/**
+	 * Discard the message passed to update(), keeping the key.
+	 */
+	void reset()
+	{
+		mInner = mInnerPad;
+	}
+};
+
+} // namespace Pique
@@ -5,60 +5,319 @@
  */
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <string_view>
 #include <type_traits>
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/uio.h>
+#define PIQUE_HASH_FUNCTION_IOVEC 1
+#endif
+
+#if defined( __has_builtin )
+#if __has_builtin( __builtin_is_constant_evaluated )
+#define PIQUE_HASH_FUNCTION_CONSTANT_EVALUATED 1
+#endif
+#endif
+
+#include "Hex.hpp"
+#include "Instrumentation.hpp"
+
 namespace Pique
 {
 
 /**
- * The base abstract class for hashing functions.
+ * One segment of a message passed to update() as a scatter/gather list.
+ */
+struct MessageSegment
+{
+	/**
+	 * Pointer to an array of const bytes.
+	 */
+	const uint8_t* message;
+
+	/**
+	 * Length of the segment in bytes.
+	 */
+	uint64_t messageLength;
+};
+
+/**
+ * Staging for the partial block of a block based hash function. Whole blocks
+ * of an update() are handed to the compression function straight from the
+ * caller's memory, so only the partial head and tail of a message are copied.
+ * The buffer is cache line aligned so that compressing it never splits a line
+ * more than the block size requires.
+ */
+template < uint64_t BlockSize >
+class BlockBuffer final
+{
+	static_assert( 0 < BlockSize, "BlockSize is required to be greater than zero" );
+
+private:
+	alignas( 64 ) uint8_t mBuffer[ BlockSize ];
+	uint64_t mBufferLength;
+	uint64_t mMessageLength;
+
+public:
+	/**
+	 * Largest length of the serialized buffer: the message length followed by
+	 * the buffered bytes.
+	 */
+	static constexpr uint64_t STATE_SIZE = 8 + BlockSize - 1;
+
+	/**
+	 * Construct an empty buffer.
+	 */
+	BlockBuffer()
+	{
+		reset();
+	}
+
+	/**
+	 * Get the buffered bytes that do not yet fill a block.
+	 * @return Pointer to the first of bufferLength() buffered bytes is returned.
+	 */
+	const uint8_t* buffer() const
+	{
+		return mBuffer;
+	}
+
+	/**
+	 * Get the number of buffered bytes, always less than BlockSize.
+	 * @return The number of buffered bytes is returned.
+	 */
+	uint64_t bufferLength() const
+	{
+		return mBufferLength;
+	}
+
+	/**
+	 * Get the total length of every message segment passed to update().
+	 * @return The message length, in bytes, is returned.
+	 */
+	uint64_t messageLength() const
+	{
+		return mMessageLength;
+	}
+
+	/**
+	 * Split the message segment into whole blocks for {@param compress}, buffering
+	 * what is left over. A buffered head is completed and compressed on its own,
+	 * then every remaining whole block is compressed in one call without copying.
+	 * @param message Pointer to an array of const bytes.
+	 * @param messageLength Length of the message in bytes.
+	 * @param compress Callable as compress( const uint8_t* blocks, uint64_t blockCount ).
+	 */
+	template < typename Compress >
+	void update( const uint8_t* message, uint64_t messageLength, Compress&& compress )
+	{
+		mMessageLength += messageLength;
+
+		if ( 0 != mBufferLength )
+		{
+			uint64_t fill = BlockSize - mBufferLength;
+			if ( messageLength < fill )
+			{
+				std::memcpy( mBuffer + mBufferLength, message, messageLength );
+				mBufferLength += messageLength;
+				return;
+			}
+
+			std::memcpy( mBuffer + mBufferLength, message, fill );
+			compress( static_cast< const uint8_t* >( mBuffer ), uint64_t( 1 ) );
+			message += fill;
+			messageLength -= fill;
+			mBufferLength = 0;
+		}
+
+		uint64_t blockCount = messageLength / BlockSize;
+		if ( 0 != blockCount )
+		{
+			compress( message, blockCount );
+			message += blockCount * BlockSize;
+			messageLength -= blockCount * BlockSize;
+		}
+
+		std::memcpy( mBuffer, message, messageLength );
+		mBufferLength = messageLength;
+	}
+
+	/**
+	 * Write the message length, big endian, followed by the buffered bytes.
+	 * @param state Pointer to a byte array of at least STATE_SIZE bytes.
+	 * @return The number of bytes written to {@param state} is returned.
+	 */
+	uint64_t serialize( uint8_t* state ) const
+	{
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			state[ index ] = uint8_t( mMessageLength >> ( 56 - 8 * index ) );
+		}
+
+		std::memcpy( state + 8, mBuffer, mBufferLength );
+		return 8 + mBufferLength;
+	}
+
+	/**
+	 * Restore the buffer from the output of serialize(). The buffered length
+	 * is implied by the message length, so {@param stateSize} must match it.
+	 * @param state Pointer to the serialized buffer.
+	 * @param stateSize Length of {@param state} in bytes.
+	 * @return True if the buffer was restored, else false is returned and the
+	 *     buffer is left untouched.
+	 */
+	bool deserialize( const uint8_t* state, uint64_t stateSize )
+	{
+		if ( stateSize < 8 )
+		{
+			return false;
+		}
+
+		uint64_t messageLength = 0;
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			messageLength = ( messageLength << 8 ) | state[ index ];
+		}
+
+		if ( stateSize - 8 != messageLength % BlockSize )
+		{
+			return false;
+		}
+
+		std::memset( mBuffer, 0, sizeof( mBuffer ) );
+		std::memcpy( mBuffer, state + 8, stateSize - 8 );
+		mBufferLength = stateSize - 8;
+		mMessageLength = messageLength;
+		return true;
+	}
+
+	/**
+	 * Discard the buffered bytes and the message length.
+	 */
+	void reset()
+	{
+		std::memset( mBuffer, 0, sizeof( mBuffer ) );
+		mBufferLength = 0;
+		mMessageLength = 0;
+	}
+};
+
+/**
+ * The base class for hashing functions, statically bound to the derived hash.
+ * Hash is the derived class itself (CRTP), so every call resolves at compile
+ * time and may be inlined; use AnyHashFunction where runtime polymorphism is needed.
  * BlockSize is the length, in bytes, that the message is broken into before
  * the hashing procedure is performed. BlockSize is required to be greater than
  * zero. DigestSize is the length, in bytes, of the resulting hash digest.
  * A DigestSize of zero is reserved for hashing functions that let the user
  * choose the digest length.
+ *
+ * The derived class provides the following, which may be private if the base is a friend:
+ *     void __update( const uint8_t* message, uint64_t messageLength );
+ *     void __digest( uint8_t* messageDigest ) const;                          // DigestSize != 0
+ *     void __digest( uint8_t* messageDigest, uint64_t digestSize ) const;     // DigestSize == 0
+ *     void __reset();
+ *     uint64_t __serialize( uint8_t* state ) const;                          // Writes at most STATE_SIZE bytes
+ *     bool __deserialize( const uint8_t* state, uint64_t stateSize );        // Untouched on failure
+ * and a public constant STATE_SIZE, the largest length of a serialized state.
+ * A serialized state starts with a four byte tag: "PQ", a number unique to the
+ * hash function (SHA-256 1, SHA-512 2, SHA-384 3, SHA-512/256 4, BLAKE3 5,
+ * SHA3-256 6, SHA3-512 7, SHAKE128 8, SHAKE256 9) and the format version.
+ * __digest() must leave the state untouched so that the message may be extended afterwards.
+ * Block based hashes implement __update() with a BlockBuffer< BlockSize >,
+ * and count every block they compress with Instrumentation::HASH_BLOCKS_COMPRESSED.
  */
-template < uint64_t BlockSize, uint64_t DigestSize >
+template < typename Hash, uint64_t BlockSize, uint64_t DigestSize >
 class HashFunction
 {
+	static_assert( 0 < BlockSize, "BlockSize is required to be greater than zero" );
+
 public:
 	/**
 	 * Constant used to denote that the digest is not a fixed size.
 	 */
-	static const uint64_t UNLIMITED_DIGEST_SIZE = 0;
+	static constexpr uint64_t UNLIMITED_DIGEST_SIZE = 0;
 
 	/**
 	 * Length of the message block size, in bytes.
 	 */
-	static const uint64_t BLOCK_SIZE = BlockSize;
+	static constexpr uint64_t BLOCK_SIZE = BlockSize;
 
 	/**
 	 * Length of the hash function digest. If the length is zero, then
 	 * the digest size is non-fixed.
 	 */
-	static const uint64_t DIGEST_SIZE = DigestSize;
+	static constexpr uint64_t DIGEST_SIZE = DigestSize;
 
 	/**
-	 * Default virtual destructor to ensure that the derived class's
-	 * destructor will be called when using the abstract class.
+	 * One independent message of a batch passed to digestMessages().
 	 */
-	virtual ~HashFunction() = default;
+	struct BatchMessage
+	{
+		/**
+		 * Pointer to an array of const bytes.
+		 */
+		const uint8_t* message;
+
+		/**
+		 * Length of the message in bytes.
+		 */
+		uint64_t messageLength;
+
+		/**
+		 * Pointer to an unsigned byte array of size DIGEST_SIZE to receive the digest.
+		 */
+		uint8_t* messageDigest;
+	};
 
 	/**
 	 * Compute the digest of the message and output to {@param messageDigest}.
+	 * The state is left untouched, so the message may be extended with further
+	 * calls to update().
 	 * @param messageDigest Reference to an unsigned byte array of size DIGEST_SIZE.
 	 */
-	template < typename = typename std::enable_if< UNLIMITED_DIGEST_SIZE != DIGEST_SIZE >::type >
-	virtual void digest( uint8_t ( &messageDigest )[ DIGEST_SIZE ] ) = 0;
+	template < uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	void digest( uint8_t ( &messageDigest )[ Size ] ) const
+	{
+		Instrumentation::DigestTimer digestTimer;
+		__hash().__digest( messageDigest );
+	}
+
+	/**
+	 * Compute the digest of the message and output its lowercase hexadecimal
+	 * representation to {@param hexMessageDigest}, without allocating. No
+	 * terminating null character is written. The state is left untouched, so
+	 * the message may be extended with further calls to update().
+	 * @param hexMessageDigest Reference to a char array of size 2 * DIGEST_SIZE.
+	 */
+	template < uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	void hexDigest( char ( &hexMessageDigest )[ 2 * Size ] ) const
+	{
+		uint8_t messageDigest[ Size ];
+		{
+			Instrumentation::DigestTimer digestTimer;
+			__hash().__digest( messageDigest );
+		}
+
+		Hex::encode( hexMessageDigest, messageDigest, Size );
+	}
 
 	/**
 	 * Compute the digest of the message and output to {@param messageDigest}.
+	 * The state is left untouched, so the message may be extended with further
+	 * calls to update().
 	 * @param messageDigest Pointer to a byte array large enough to hold the requested length.
 	 * @param digestSize Requested length of the digest, in bytes.
 	 */
-	template < typename = typename std::enable_if< UNLIMITED_DIGEST_SIZE == DIGEST_SIZE >::type >
-	virtual void digest( uint8_t* messageDigest, uint64_t digestSize ) = 0;
+	template < uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE == Size, int >::type = 0 >
+	void digest( uint8_t* messageDigest, uint64_t digestSize ) const
+	{
+		Instrumentation::DigestTimer digestTimer;
+		__hash().__digest( messageDigest, digestSize );
+	}
 
 	/**
 	 * Compute the digest of the provided message without maintaining state information.
@@ -66,8 +325,13 @@ public:
 	 * @param message Pointer to an array of const bytes.
 	 * @param messageLength Length of the message in bytes.
 	 */
-	template < typename = typename std::enable_if< UNLIMITED_DIGEST_SIZE != DIGEST_SIZE >::type >
-	virtual static void digestMessage( uint8_t ( &messageDigest )[ DIGEST_SIZE ], const uint8_t* message, uint64_t messageLength ) = 0;
+	template < uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	static void digestMessage( uint8_t ( &messageDigest )[ Size ], const uint8_t* message, uint64_t messageLength )
+	{
+		Hash hash;
+		hash.update( message, messageLength );
+		hash.digest( messageDigest );
+	}
 
 	/**
 	 * Compute the digest of the provided message without maintaining state information.
@@ -76,20 +340,211 @@ public:
 	 * @param message Pointer to an array of const bytes.
 	 * @param messageLength Length of the message in bytes.
 	 */
-	template < typename = typename std::enable_if< UNLIMITED_DIGEST_SIZE == DIGEST_SIZE >::type >
-	virtual static void digestMessage( uint8_t* messageDigest, uint64_t digestSize, const uint8_t* message, uint64_t messageLength ) = 0;
+	template < uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE == Size, int >::type = 0 >
+	static void digestMessage( uint8_t* messageDigest, uint64_t digestSize, const uint8_t* message, uint64_t messageLength )
+	{
+		Hash hash;
+		hash.update( message, messageLength );
+		hash.digest( messageDigest, digestSize );
+	}
+
+	/**
+	 * Compute the digest of {@param message}, in a constant expression if the
+	 * message is a constant, so that the digest of a string literal costs
+	 * nothing at run time and its bytes may serve as template arguments and
+	 * case labels. A message that is not a constant is hashed by the kernels
+	 * chosen at run time, as by the other digestMessage(). Only hashes that
+	 * provide __digestConstant(), SHA-256 and BLAKE3, offer this.
+	 * @param message The message, such as a string literal without its terminating null character.
+	 * @return The digest is returned.
+	 */
+	template < uint64_t Size = DigestSize, typename std::enable_if< ( UNLIMITED_DIGEST_SIZE != Size ) and ( DigestSize == Size ), int >::type = 0 >
+	static constexpr std::array< uint8_t, Size > digestMessage( std::string_view message )
+	{
+#if defined( PIQUE_HASH_FUNCTION_CONSTANT_EVALUATED )
+		if ( not __builtin_is_constant_evaluated() )
+		{
+			std::array< uint8_t, Size > messageDigest = { 0 };
+			Hash::digestMessage( *reinterpret_cast< uint8_t ( * )[ Size ] >( messageDigest.data() ),
+				reinterpret_cast< const uint8_t* >( message.data() ), message.size() );
+			return messageDigest;
+		}
+#endif
+		return Hash::__digestConstant( message );
+	}
+
+	/**
+	 * Compute {@param Length} bytes of the digest of {@param message}, in a
+	 * constant expression if the message is a constant, as with the
+	 * digestMessage() of hashes with a fixed digest size.
+	 * @param message The message, such as a string literal without its terminating null character.
+	 * @return The digest is returned.
+	 */
+	template < uint64_t Length = 32, uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE == Size, int >::type = 0 >
+	static constexpr std::array< uint8_t, Length > digestMessage( std::string_view message )
+	{
+#if defined( PIQUE_HASH_FUNCTION_CONSTANT_EVALUATED )
+		if ( not __builtin_is_constant_evaluated() )
+		{
+			std::array< uint8_t, Length > messageDigest = { 0 };
+			Hash::digestMessage( messageDigest.data(), Length, reinterpret_cast< const uint8_t* >( message.data() ), message.size() );
+			return messageDigest;
+		}
+#endif
+		return Hash::template __digestConstant< Length >( message );
+	}
+
+	/**
+	 * Compute the digests of a batch of independent messages without maintaining
+	 * state information. Hashes with a multi-buffer kernel hide this with their own.
+	 * @param messages Pointer to an array of messages to digest.
+	 * @param messageCount Number of messages in {@param messages}.
+	 */
+	template < uint64_t Size = DigestSize, typename std::enable_if< UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	static void digestMessages( BatchMessage* messages, uint64_t messageCount )
+	{
+		for ( uint64_t index( 0 ); index < messageCount; ++index )
+		{
+			Hash::digestMessage( *reinterpret_cast< uint8_t ( * )[ Size ] >( messages[ index ].messageDigest ),
+				messages[ index ].message, messages[ index ].messageLength );
+		}
+	}
 
 	/**
 	 * Incorporate the provided message segment into the hash computation.
 	 * @param message Pointer to an array of const bytes.
 	 * @param messageLength Length of the message in bytes.
 	 */
-	virtual void update( const uint8_t* message, uint64_t messageLength ) = 0;
+	void update( const uint8_t* message, uint64_t messageLength )
+	{
+		if ( ( nullptr == message ) or ( 0 == messageLength ) )
+		{
+			return;
+		}
+
+		Instrumentation::countUpdate( messageLength );
+		__hash().__update( message, messageLength );
+	}
+
+	/**
+	 * Incorporate the message segments, in order, into the hash computation.
+	 * The result is the same as one update() of the concatenated segments;
+	 * partial blocks are carried across segment boundaries so nothing is copied
+	 * beyond what a contiguous message would need.
+	 * @param segments Pointer to an array of message segments.
+	 * @param segmentCount Number of segments in {@param segments}.
+	 */
+	void update( const MessageSegment* segments, uint64_t segmentCount )
+	{
+		if ( nullptr == segments )
+		{
+			return;
+		}
+
+		for ( uint64_t index( 0 ); index < segmentCount; ++index )
+		{
+			update( segments[ index ].message, segments[ index ].messageLength );
+		}
+	}
+
+#if defined( PIQUE_HASH_FUNCTION_IOVEC )
+	/**
+	 * Incorporate the buffers of a POSIX scatter/gather list, in order, into the
+	 * hash computation, as with update( const MessageSegment*, uint64_t ).
+	 * @param segments Pointer to an array of iovec, as passed to readv().
+	 * @param segmentCount Number of segments in {@param segments}.
+	 */
+	void update( const struct iovec* segments, uint64_t segmentCount )
+	{
+		if ( nullptr == segments )
+		{
+			return;
+		}
+
+		for ( uint64_t index( 0 ); index < segmentCount; ++index )
+		{
+			update( static_cast< const uint8_t* >( segments[ index ].iov_base ), segments[ index ].iov_len );
+		}
+	}
+#endif
 
 	/**
 	 * Reset the internal state of the hash function to the initial state.
 	 */
-	virtual void reset() = 0;
+	void reset()
+	{
+		__hash().__reset();
+	}
+
+	/**
+	 * Copy this instance, including the message absorbed so far. Capturing the
+	 * midstate after a shared prefix lets every suffix be hashed from the clone
+	 * without absorbing the prefix again.
+	 * @return A copy of the derived hash is returned.
+	 */
+	Hash clone() const
+	{
+		return __hash();
+	}
+
+	/**
+	 * Write the midstate in a compact, portable format so that hashing may be
+	 * resumed by deserialize(), possibly in another process. The format names
+	 * the hash, so a state cannot be restored into a different hash function.
+	 * The output contains unprocessed message bytes and should be protected
+	 * like the message itself.
+	 * @param state Pointer to a byte array of {@param stateSize} bytes.
+	 * @param stateSize Length of {@param state}, at least Hash::STATE_SIZE bytes.
+	 * @return The number of bytes written is returned, or zero if {@param state}
+	 *     is null or too small.
+	 */
+	uint64_t serialize( uint8_t* state, uint64_t stateSize ) const
+	{
+		if ( ( nullptr == state ) or ( stateSize < Hash::STATE_SIZE ) )
+		{
+			return 0;
+		}
+
+		return __hash().__serialize( state );
+	}
+
+	/**
+	 * Restore a midstate written by serialize().
+	 * @param state Pointer to the serialized state.
+	 * @param stateSize Exact length of the serialized state, as returned by serialize().
+	 * @return True if the state was restored, else false is returned and this
+	 *     instance is left untouched.
+	 */
+	bool deserialize( const uint8_t* state, uint64_t stateSize )
+	{
+		if ( nullptr == state )
+		{
+			return false;
+		}
+
+		return __hash().__deserialize( state, stateSize );
+	}
+
+protected:
+	/**
+	 * Only derived classes may construct or destroy the base, which keeps
+	 * it free of a vtable without allowing deletion through a base pointer.
+	 */
+	HashFunction() = default;
+	HashFunction( const HashFunction& ) = default;
+	HashFunction& operator=( const HashFunction& ) = default;
+	~HashFunction() = default;
+
+private:
+	Hash& __hash()
+	{
+		return static_cast< Hash& >( *this );
+	}
+
+	const Hash& __hash() const
+	{
+		return static_cast< const Hash& >( *this );
+	}
 };
 
 } // namespace Pique
@@ -0,0 +1,277 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_HEX_X86 1
+#endif
+
+#include "CpuFeatures.hpp"
+
+namespace Pique
+{
+
+/**
+ * Hexadecimal encoding and decoding into caller provided buffers, without any
+ * allocation. Encoding writes lowercase digits; decoding accepts either case.
+ * Whole vectors are converted by the widest kernel allowed by CpuFeatures:
+ * AVX2 or SSSE3, which translate nibbles to digits and back with byte
+ * shuffles and range compares, or a portable table lookup.
+ */
+class Hex final
+{
+private:
+	typedef void ( *EncodeFunction )( char* hex, const uint8_t* data, size_t length );
+	typedef bool ( *DecodeFunction )( uint8_t* data, const char* hex, size_t length );
+
+	struct DispatchTable
+	{
+		std::atomic< EncodeFunction > mEncode;
+		std::atomic< DecodeFunction > mDecode;
+	};
+
+	static constexpr char HEX_DIGIT[] = "0123456789abcdef";
+
+	/**
+	 * The value of a hexadecimal digit, or a negative value for any other character.
+	 */
+	static int __nibble( char digit )
+	{
+		if ( ( '0' <= digit ) and ( digit <= '9' ) )
+		{
+			return digit - '0';
+		}
+
+		char lowerDigit = char( digit | 0x20 );
+		if ( ( 'a' <= lowerDigit ) and ( lowerDigit <= 'f' ) )
+		{
+			return lowerDigit - 'a' + 10;
+		}
+
+		return -1;
+	}
+
+	static void __encodePortable( char* hex, const uint8_t* data, size_t length )
+	{
+		for ( size_t index( -1 ); ++index < length; )
+		{
+			hex[ 2 * index + 0 ] = HEX_DIGIT[ ( data[ index ] >> 4 ) & 0xF ];
+			hex[ 2 * index + 1 ] = HEX_DIGIT[ ( data[ index ] >> 0 ) & 0xF ];
+		}
+	}
+
+	/**
+	 * Decode {@param length} bytes from 2 * {@param length} digits.
+	 */
+	static bool __decodePortable( uint8_t* data, const char* hex, size_t length )
+	{
+		int invalid = 0;
+		for ( size_t index( -1 ); ++index < length; )
+		{
+			int high = __nibble( hex[ 2 * index + 0 ] );
+			int low = __nibble( hex[ 2 * index + 1 ] );
+			invalid |= high | low;
+			data[ index ] = uint8_t( ( ( high & 0xF ) << 4 ) | ( low & 0xF ) );
+		}
+
+		return 0 <= invalid;
+	}
+
+#if defined( PIQUE_HEX_X86 )
+	/**
+	 * Encode 16 bytes into 32 digits.
+	 */
+	__attribute__(( target( "ssse3" ) ))
+	static void __encode16Ssse3( char* hex, __m128i bytes )
+	{
+		const __m128i digits = _mm_loadu_si128( reinterpret_cast< const __m128i* >( HEX_DIGIT ) );
+		const __m128i lowNibble = _mm_set1_epi8( 0x0F );
+
+		__m128i high = _mm_shuffle_epi8( digits, _mm_and_si128( _mm_srli_epi16( bytes, 4 ), lowNibble ) );
+		__m128i low = _mm_shuffle_epi8( digits, _mm_and_si128( bytes, lowNibble ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( hex ), _mm_unpacklo_epi8( high, low ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( hex + 16 ), _mm_unpackhi_epi8( high, low ) );
+	}
+
+	__attribute__(( target( "ssse3" ) ))
+	static void __encodeSsse3( char* hex, const uint8_t* data, size_t length )
+	{
+		size_t index = 0;
+		for ( ; index + 16 <= length; index += 16 )
+		{
+			__encode16Ssse3( hex + 2 * index, _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + index ) ) );
+		}
+
+		__encodePortable( hex + 2 * index, data + index, length - index );
+	}
+
+	/**
+	 * Map 16 digits to their nibble values.
+	 * @return The mask of the lanes that did not hold a digit is returned.
+	 */
+	__attribute__(( target( "ssse3" ) ))
+	static int __nibbles16Ssse3( __m128i& nibbles, __m128i digits )
+	{
+		__m128i lowerDigits = _mm_or_si128( digits, _mm_set1_epi8( 0x20 ) );
+		__m128i isDecimal = _mm_and_si128( _mm_cmpgt_epi8( digits, _mm_set1_epi8( '0' - 1 ) ), _mm_cmplt_epi8( digits, _mm_set1_epi8( '9' + 1 ) ) );
+		__m128i isLetter = _mm_and_si128( _mm_cmpgt_epi8( lowerDigits, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmplt_epi8( lowerDigits, _mm_set1_epi8( 'f' + 1 ) ) );
+
+		nibbles = _mm_or_si128(
+			_mm_and_si128( isDecimal, _mm_sub_epi8( digits, _mm_set1_epi8( '0' ) ) ),
+			_mm_and_si128( isLetter, _mm_sub_epi8( lowerDigits, _mm_set1_epi8( 'a' - 10 ) ) ) );
+		return 0xFFFF ^ _mm_movemask_epi8( _mm_or_si128( isDecimal, isLetter ) );
+	}
+
+	__attribute__(( target( "ssse3" ) ))
+	static bool __decodeSsse3( uint8_t* data, const char* hex, size_t length )
+	{
+		// Each pair of nibbles becomes high * 16 + low in a 16-bit lane.
+		const __m128i weights = _mm_set1_epi16( 0x0110 );
+
+		int invalid = 0;
+		size_t index = 0;
+		for ( ; index + 16 <= length; index += 16 )
+		{
+			__m128i nibbles[ 2 ];
+			invalid |= __nibbles16Ssse3( nibbles[ 0 ], _mm_loadu_si128( reinterpret_cast< const __m128i* >( hex + 2 * index ) ) );
+			invalid |= __nibbles16Ssse3( nibbles[ 1 ], _mm_loadu_si128( reinterpret_cast< const __m128i* >( hex + 2 * index + 16 ) ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( data + index ), _mm_packus_epi16(
+				_mm_maddubs_epi16( nibbles[ 0 ], weights ), _mm_maddubs_epi16( nibbles[ 1 ], weights ) ) );
+		}
+
+		return __decodePortable( data + index, hex + 2 * index, length - index ) and ( 0 == invalid );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static void __encodeAvx2( char* hex, const uint8_t* data, size_t length )
+	{
+		const __m256i digits = _mm256_broadcastsi128_si256( _mm_loadu_si128( reinterpret_cast< const __m128i* >( HEX_DIGIT ) ) );
+		const __m256i lowNibble = _mm256_set1_epi8( 0x0F );
+
+		size_t index = 0;
+		for ( ; index + 32 <= length; index += 32 )
+		{
+			__m256i bytes = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( data + index ) );
+			__m256i high = _mm256_shuffle_epi8( digits, _mm256_and_si256( _mm256_srli_epi16( bytes, 4 ), lowNibble ) );
+			__m256i low = _mm256_shuffle_epi8( digits, _mm256_and_si256( bytes, lowNibble ) );
+
+			// The unpacks interleave within each 128-bit lane, so the lanes are put back in order.
+			__m256i first = _mm256_unpacklo_epi8( high, low );
+			__m256i second = _mm256_unpackhi_epi8( high, low );
+			_mm256_storeu_si256( reinterpret_cast< __m256i* >( hex + 2 * index ), _mm256_permute2x128_si256( first, second, 0x20 ) );
+			_mm256_storeu_si256( reinterpret_cast< __m256i* >( hex + 2 * index + 32 ), _mm256_permute2x128_si256( first, second, 0x31 ) );
+		}
+
+		__encodeSsse3( hex + 2 * index, data + index, length - index );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static int __nibbles32Avx2( __m256i& nibbles, __m256i digits )
+	{
+		__m256i lowerDigits = _mm256_or_si256( digits, _mm256_set1_epi8( 0x20 ) );
+		__m256i isDecimal = _mm256_and_si256( _mm256_cmpgt_epi8( digits, _mm256_set1_epi8( '0' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( '9' + 1 ), digits ) );
+		__m256i isLetter = _mm256_and_si256( _mm256_cmpgt_epi8( lowerDigits, _mm256_set1_epi8( 'a' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( 'f' + 1 ), lowerDigits ) );
+
+		nibbles = _mm256_or_si256(
+			_mm256_and_si256( isDecimal, _mm256_sub_epi8( digits, _mm256_set1_epi8( '0' ) ) ),
+			_mm256_and_si256( isLetter, _mm256_sub_epi8( lowerDigits, _mm256_set1_epi8( 'a' - 10 ) ) ) );
+		return ~_mm256_movemask_epi8( _mm256_or_si256( isDecimal, isLetter ) );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static bool __decodeAvx2( uint8_t* data, const char* hex, size_t length )
+	{
+		const __m256i weights = _mm256_set1_epi16( 0x0110 );
+
+		int invalid = 0;
+		size_t index = 0;
+		for ( ; index + 32 <= length; index += 32 )
+		{
+			__m256i nibbles[ 2 ];
+			invalid |= __nibbles32Avx2( nibbles[ 0 ], _mm256_loadu_si256( reinterpret_cast< const __m256i* >( hex + 2 * index ) ) );
+			invalid |= __nibbles32Avx2( nibbles[ 1 ], _mm256_loadu_si256( reinterpret_cast< const __m256i* >( hex + 2 * index + 32 ) ) );
+
+			// The pack works within each 128-bit lane, so the quarters are put back in order.
+			__m256i bytes = _mm256_packus_epi16( _mm256_maddubs_epi16( nibbles[ 0 ], weights ), _mm256_maddubs_epi16( nibbles[ 1 ], weights ) );
+			_mm256_storeu_si256( reinterpret_cast< __m256i* >( data + index ), _mm256_permute4x64_epi64( bytes, 0xD8 ) );
+		}
+
+		return __decodeSsse3( data + index, hex + 2 * index, length - index ) and ( 0 == invalid );
+	}
+#endif
+
+	static DispatchTable& __kernels()
+	{
+		static DispatchTable kernels;
+		return kernels;
+	}
+
+	static void __selectKernels()
+	{
+		EncodeFunction encode = __encodePortable;
+		DecodeFunction decode = __decodePortable;
+#if defined( PIQUE_HEX_X86 )
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 ) )
+		{
+			encode = __encodeAvx2;
+			decode = __decodeAvx2;
+		}
+		else if ( CpuFeatures::supports( CpuFeatures::SSSE3 ) )
+		{
+			encode = __encodeSsse3;
+			decode = __decodeSsse3;
+		}
+#endif
+		__kernels().mEncode.store( encode, std::memory_order_relaxed );
+		__kernels().mDecode.store( decode, std::memory_order_relaxed );
+	}
+
+	static DispatchTable& __subscribedKernels()
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		return __kernels();
+	}
+
+public:
+	/**
+	 * Write the lowercase hexadecimal representation of {@param data} to
+	 * {@param hex}. No terminating null character is written.
+	 * @param hex Pointer to a char array of 2 * {@param length} characters.
+	 * @param data Pointer to an array of const bytes.
+	 * @param length Length of {@param data} in bytes.
+	 */
+	static void encode( char* hex, const uint8_t* data, size_t length )
+	{
+		__subscribedKernels().mEncode.load( std::memory_order_relaxed )( hex, data, length );
+	}
+
+	/**
+	 * Decode the hexadecimal digits of {@param hex}, in either case, to bytes.
+	 * @param data Pointer to a byte array of {@param hexLength} / 2 bytes.
+	 * @param hex Pointer to an array of const chars.
+	 * @param hexLength Number of characters in {@param hex}.
+	 * @return True is returned if {@param hexLength} is even and every character
+	 *     is a hexadecimal digit, else false is returned and the content of
+	 *     {@param data} is unspecified.
+	 */
+	static bool decode( uint8_t* data, const char* hex, size_t hexLength )
+	{
+		if ( hexLength & 1 )
+		{
+			return false;
+		}
+
+		return __subscribedKernels().mDecode.load( std::memory_order_relaxed )( data, hex, hexLength / 2 );
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,361 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Define PIQUE_INSTRUMENTATION to count what the hash functions and keys do.
+ * Without it every hook is an empty inline function, and nothing is counted,
+ * timed or stored.
+ */
+#if defined( PIQUE_INSTRUMENTATION )
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#endif
+
+namespace Pique
+{
+
+/**
+ * Opt-in counters of the hot paths of HashFunction and Key, to tell many small
+ * update() calls, contended keys and bulk throughput apart when profiling.
+ *
+ * Every thread counts into a record of its own, with plain relaxed stores that
+ * share no cache line with other threads, so counting costs a few instructions
+ * and no synchronization. snapshot() sums the records of every thread. Records
+ * are never freed: a thread that exits returns its record for reuse by a later
+ * thread, counts and all, so totals never go backwards. Take the difference of
+ * two snapshots to measure an interval.
+ *
+ * HashFunction counts calls to update() and the bytes they absorb, with a
+ * histogram of their sizes, the blocks compressed by update() and digest(),
+ * and the calls to digest() with the time spent in them. Batch digestMessages()
+ * is not counted. Key counts the key buffers it allocates, the keys it copies,
+ * the times a writer waited for another writer and a reader retried a read
+ * that raced a writer.
+ */
+class Instrumentation final
+{
+public:
+	/**
+	 * True if the counters are compiled in.
+	 */
+#if defined( PIQUE_INSTRUMENTATION )
+	static constexpr bool ENABLED = true;
+#else
+	static constexpr bool ENABLED = false;
+#endif
+
+	enum Counter : size_t
+	{
+		HASH_UPDATES,
+		HASH_BYTES_ABSORBED,
+		HASH_BLOCKS_COMPRESSED,
+		HASH_DIGESTS,
+		HASH_DIGEST_NANOSECONDS,
+		KEY_ALLOCATIONS,
+		KEY_COPIES,
+		KEY_WRITE_WAITS,
+		KEY_READ_RETRIES,
+		COUNTER_COUNT
+	};
+
+	/**
+	 * Number of buckets of the update() size histogram. Bucket b counts
+	 * updates of [ 2^b, 2^( b + 1 ) ) bytes, and the last bucket every update
+	 * of at least 2^( UPDATE_SIZE_BUCKETS - 1 ) bytes, 16 MiB.
+	 */
+	static constexpr size_t UPDATE_SIZE_BUCKETS = 25;
+
+	/**
+	 * The totals of every counter at one moment.
+	 */
+	struct Snapshot
+	{
+		/**
+		 * The total of each Counter.
+		 */
+		uint64_t counters[ COUNTER_COUNT ] = { 0 };
+
+		/**
+		 * The number of update() calls in each size bucket.
+		 */
+		uint64_t updateSizes[ UPDATE_SIZE_BUCKETS ] = { 0 };
+
+		/**
+		 * Get the counts made between {@param earlier} and this snapshot.
+		 * @param earlier Constant reference to a snapshot taken before this one.
+		 * @return The difference of the snapshots is returned.
+		 */
+		Snapshot operator-( const Snapshot& earlier ) const
+		{
+			Snapshot difference;
+			for ( size_t index( -1 ); ++index < COUNTER_COUNT; )
+			{
+				difference.counters[ index ] = counters[ index ] - earlier.counters[ index ];
+			}
+
+			for ( size_t index( -1 ); ++index < UPDATE_SIZE_BUCKETS; )
+			{
+				difference.updateSizes[ index ] = updateSizes[ index ] - earlier.updateSizes[ index ];
+			}
+
+			return difference;
+		}
+
+		/**
+		 * Format the snapshot as a JSON object with one member per counter,
+		 * named by counterName(), and the histogram as the array "hash_update_sizes".
+		 * @return The JSON text is returned.
+		 */
+		std::string toJson() const
+		{
+			std::string json( "{" );
+			for ( size_t index( -1 ); ++index < COUNTER_COUNT; )
+			{
+				json += "\"";
+				json += counterName( Counter( index ) );
+				json += "\":";
+				json += std::to_string( counters[ index ] );
+				json += ",";
+			}
+
+			json += "\"hash_update_sizes\":[";
+			for ( size_t index( -1 ); ++index < UPDATE_SIZE_BUCKETS; )
+			{
+				json += ( 0 == index ) ? "" : ",";
+				json += std::to_string( updateSizes[ index ] );
+			}
+
+			return json + "]}";
+		}
+	};
+
+private:
+#if defined( PIQUE_INSTRUMENTATION )
+	/**
+	 * The counters of one thread. Only the owning thread writes them.
+	 */
+	struct alignas( 64 ) ThreadRecord
+	{
+		std::atomic< uint64_t > mCounters[ COUNTER_COUNT ];
+		std::atomic< uint64_t > mUpdateSizes[ UPDATE_SIZE_BUCKETS ];
+		std::atomic< bool > mInUse;
+		ThreadRecord* mNext;
+	};
+
+	struct Registry
+	{
+		std::mutex mMutex;
+		ThreadRecord* mRecords = nullptr;
+	};
+
+	/**
+	 * Claims a record for the lifetime of the thread, returning it to the
+	 * registry for reuse when the thread exits.
+	 */
+	struct ThreadRegistration
+	{
+		ThreadRecord* mRecord;
+
+		ThreadRegistration() :
+			mRecord( __claimRecord() )
+		{
+		}
+
+		~ThreadRegistration()
+		{
+			mRecord->mInUse.store( false, std::memory_order_release );
+		}
+	};
+
+	/**
+	 * The registry and its records are never freed, so threads that exit
+	 * after static destruction still find them.
+	 */
+	static Registry& __registry()
+	{
+		static Registry* registry = new Registry();
+		return *registry;
+	}
+
+	static ThreadRecord* __claimRecord()
+	{
+		Registry& registry = __registry();
+		std::lock_guard< std::mutex > lock( registry.mMutex );
+		for ( ThreadRecord* record = registry.mRecords; nullptr != record; record = record->mNext )
+		{
+			if ( not record->mInUse.load( std::memory_order_relaxed ) )
+			{
+				record->mInUse.store( true, std::memory_order_relaxed );
+				return record;
+			}
+		}
+
+		ThreadRecord* record = new ThreadRecord();
+		for ( size_t index( -1 ); ++index < COUNTER_COUNT; )
+		{
+			record->mCounters[ index ].store( 0, std::memory_order_relaxed );
+		}
+
+		for ( size_t index( -1 ); ++index < UPDATE_SIZE_BUCKETS; )
+		{
+			record->mUpdateSizes[ index ].store( 0, std::memory_order_relaxed );
+		}
+
+		record->mInUse.store( true, std::memory_order_relaxed );
+		record->mNext = registry.mRecords;
+		registry.mRecords = record;
+		return record;
+	}
+
+	static ThreadRecord& __record()
+	{
+		thread_local ThreadRegistration registration;
+		return *registration.mRecord;
+	}
+
+	/**
+	 * Add to a counter of the calling thread without a read-modify-write
+	 * instruction, as no other thread writes it.
+	 */
+	static void __add( std::atomic< uint64_t >& counter, uint64_t amount )
+	{
+		counter.store( counter.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+	}
+#endif
+
+public:
+	/**
+	 * Add {@param amount} to {@param counter} for the calling thread.
+	 */
+	static void count( Counter counter, uint64_t amount = 1 )
+	{
+#if defined( PIQUE_INSTRUMENTATION )
+		__add( __record().mCounters[ counter ], amount );
+#else
+		( void ) counter;
+		( void ) amount;
+#endif
+	}
+
+	/**
+	 * Count a call to update() with {@param length} bytes, of at least one.
+	 */
+	static void countUpdate( uint64_t length )
+	{
+#if defined( PIQUE_INSTRUMENTATION )
+		ThreadRecord& record = __record();
+		__add( record.mCounters[ HASH_UPDATES ], 1 );
+		__add( record.mCounters[ HASH_BYTES_ABSORBED ], length );
+		__add( record.mUpdateSizes[ updateSizeBucket( length ) ], 1 );
+#else
+		( void ) length;
+#endif
+	}
+
+	/**
+	 * Get the histogram bucket of an update() of {@param length} bytes.
+	 * @return The bucket, less than UPDATE_SIZE_BUCKETS, is returned.
+	 */
+	static size_t updateSizeBucket( uint64_t length )
+	{
+		size_t bucket = size_t( 63 - __builtin_clzll( length | 1 ) );
+		return ( bucket < UPDATE_SIZE_BUCKETS ) ? bucket : UPDATE_SIZE_BUCKETS - 1;
+	}
+
+	/**
+	 * Get the name of {@param counter}, as used by Snapshot::toJson().
+	 * @return A lowercase name is returned, or null for COUNTER_COUNT.
+	 */
+	static const char* counterName( Counter counter )
+	{
+		static const char* const COUNTER_NAMES[ COUNTER_COUNT ] = {
+			"hash_updates",
+			"hash_bytes_absorbed",
+			"hash_blocks_compressed",
+			"hash_digests",
+			"hash_digest_nanoseconds",
+			"key_allocations",
+			"key_copies",
+			"key_write_waits",
+			"key_read_retries"
+		};
+
+		return ( counter < COUNTER_COUNT ) ? COUNTER_NAMES[ counter ] : nullptr;
+	}
+
+	/**
+	 * Sum the counters of every thread, running or exited. Counts made
+	 * concurrently may or may not be included.
+	 * @return The totals are returned, all zero if the counters are not compiled in.
+	 */
+	static Snapshot snapshot()
+	{
+		Snapshot totals;
+#if defined( PIQUE_INSTRUMENTATION )
+		Registry& registry = __registry();
+		std::lock_guard< std::mutex > lock( registry.mMutex );
+		for ( const ThreadRecord* record = registry.mRecords; nullptr != record; record = record->mNext )
+		{
+			for ( size_t index( -1 ); ++index < COUNTER_COUNT; )
+			{
+				totals.counters[ index ] += record->mCounters[ index ].load( std::memory_order_relaxed );
+			}
+
+			for ( size_t index( -1 ); ++index < UPDATE_SIZE_BUCKETS; )
+			{
+				totals.updateSizes[ index ] += record->mUpdateSizes[ index ].load( std::memory_order_relaxed );
+			}
+		}
+#endif
+		return totals;
+	}
+
+	/**
+	 * Count a digest() and the nanoseconds from construction to destruction.
+	 */
+	class DigestTimer final
+	{
+#if defined( PIQUE_INSTRUMENTATION )
+	private:
+		std::chrono::steady_clock::time_point mStart;
+
+	public:
+		DigestTimer() :
+			mStart( std::chrono::steady_clock::now() )
+		{
+		}
+
+		~DigestTimer()
+		{
+			ThreadRecord& record = __record();
+			__add( record.mCounters[ HASH_DIGESTS ], 1 );
+			__add( record.mCounters[ HASH_DIGEST_NANOSECONDS ],
+				uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - mStart ).count() ) );
+		}
+#else
+	public:
+		// User provided, so a timer is not an unused variable where it is declared.
+		DigestTimer()
+		{
+		}
+
+		~DigestTimer()
+		{
+		}
+#endif
+
+		DigestTimer( const DigestTimer& ) = delete;
+		DigestTimer& operator=( const DigestTimer& ) = delete;
+	};
+};
+
+} // namespace Pique
@@ -5,84 +5,445 @@
  */
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
-#include <mutex>
-#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <utility>
 
+#include "ConstantTime.hpp"
+#include "Hex.hpp"
+#include "Instrumentation.hpp"
+#include "ReadCopyUpdate.hpp"
+#include "SecureArena.hpp"
+#include "Zeroize.hpp"
+
+/**
+ * Keys of up to this many bytes are held inside the Key itself, without a heap
+ * allocation. Longer keys are held on the heap and shared by copies.
+ */
+#ifndef PIQUE_KEY_INLINE_CAPACITY
+#define PIQUE_KEY_INLINE_CAPACITY 64
+#endif
+
 namespace Pique
 {
 
+class KeyBinding;
+
 /**
  * A class for holding a read-only buffer to a key
  * to be used for cryptograpihc functions.
+ * Keys of up to INLINE_CAPACITY bytes are held inline, longer keys in an
+ * immutable heap snapshot shared by copies, with the key bytes in a buffer
+ * from the SecureArena. Reads take no lock: a sequence counter, odd while a
+ * write is in progress, makes a reader that raced a write retry, and a
+ * replaced heap snapshot is released only after every concurrent reader has
+ * finished with it. Key material is zeroized when it is released.
+ *
+ * Key material that has been copied or bound by a KeyBinding carries a
+ * lifetime, shared by every Key holding the material, which ends once all of
+ * them have been written to or destroyed.
  */
 class Key final
 {
+public:
+	/**
+	 * The length of the longest key, in bytes, held without a heap allocation.
+	 */
+	static constexpr size_t INLINE_CAPACITY = PIQUE_KEY_INLINE_CAPACITY;
+
 private:
+	friend class KeyBinding;
+
 	typedef std::shared_ptr< const uint8_t > SharedKeyBuffer;
+	typedef std::shared_ptr< const void > Lifetime;
 
-	mutable std::shared_mutex mKeyMutex;
-	SharedKeyBuffer mKeyBuffer;
-	size_t mKeyLength;
+	static constexpr size_t INLINE_WORDS = ( INLINE_CAPACITY + 7 ) / 8;
+	static constexpr size_t INLINE_ARRAY_WORDS = ( 0 == INLINE_WORDS ) ? 1 : INLINE_WORDS;
 
-	SharedKeyBuffer
-	__makeKeyBuffer( const uint8_t* data, size_t length )
+	/**
+	 * An immutable heap copy of a key longer than INLINE_CAPACITY.
+	 */
+	struct KeySnapshot
 	{
-		if ( ( nullptr == data ) or ( 0 == length ) )
+		SharedKeyBuffer mKeyBuffer;
+	};
+
+	/**
+	 * The object whose lifetime is that of the key material. It carries no data.
+	 */
+	struct LifetimeToken
+	{
+	};
+
+	/**
+	 * Allocates lifetimes from the SecureArena, or from the heap once the arena
+	 * is exhausted, so copying a key makes no heap allocation. Every block
+	 * starts with a byte recording where it came from.
+	 */
+	template < typename Type >
+	struct LifetimeAllocator
+	{
+		typedef Type value_type;
+
+		static_assert( alignof( Type ) <= SecureArena::MINIMUM_BLOCK_SIZE, "The block header keeps the alignment of the arena" );
+
+		LifetimeAllocator() = default;
+
+		template < typename Other >
+		LifetimeAllocator( const LifetimeAllocator< Other >& )
+		{
+		}
+
+		Type* allocate( size_t count )
 		{
-			mKeyLength = 0;
-			return SharedKeyBuffer( nullptr,
+			size_t length = SecureArena::MINIMUM_BLOCK_SIZE + count * sizeof( Type );
+			uint8_t* block = static_cast< uint8_t* >( SecureArena::allocate( length ) );
+			bool isArenaBlock = nullptr != block;
+			if ( not isArenaBlock )
+			{
+				block = static_cast< uint8_t* >( ::operator new( length ) );
+			}
+
+			block[ 0 ] = isArenaBlock;
+			return reinterpret_cast< Type* >( block + SecureArena::MINIMUM_BLOCK_SIZE );
+		}
+
+		void deallocate( Type* pointer, size_t count )
+		{
+			uint8_t* block = reinterpret_cast< uint8_t* >( pointer ) - SecureArena::MINIMUM_BLOCK_SIZE;
+			if ( 0 != block[ 0 ] )
+			{
+				SecureArena::deallocate( block, SecureArena::MINIMUM_BLOCK_SIZE + count * sizeof( Type ) );
+			}
+			else
+			{
+				::operator delete( block );
+			}
+		}
+
+		template < typename Other >
+		bool operator==( const LifetimeAllocator< Other >& ) const
+		{
+			return true;
+		}
+
+		template < typename Other >
+		bool operator!=( const LifetimeAllocator< Other >& ) const
+		{
+			return false;
+		}
+	};
+
+	/**
+	 * A consistent copy of the key state taken by a reader. The copy of an
+	 * inline key is zeroized with the view.
+	 */
+	struct KeyView
+	{
+		uint64_t mInlineKey[ INLINE_ARRAY_WORDS ] = { 0 };
+		size_t mKeyLength = 0;
+		const KeySnapshot* mSnapshot = nullptr;
+		Lifetime mLifetime;
+
+		~KeyView()
+		{
+			zeroize( mInlineKey, sizeof( mInlineKey ) );
+		}
+
+		const uint8_t* buffer() const
+		{
+			if ( 0 == mKeyLength )
+			{
+				return nullptr;
+			}
+
+			return ( nullptr != mSnapshot ) ? mSnapshot->mKeyBuffer.get() : reinterpret_cast< const uint8_t* >( mInlineKey );
+		}
+	};
+
+	std::atomic< uint64_t > mSequence;
+	std::atomic< size_t > mKeyLength;
+	std::atomic< const KeySnapshot* > mSnapshot;
+	std::atomic< uint64_t > mInlineKey[ INLINE_ARRAY_WORDS ];
+
+	/**
+	 * The lifetime of the key material, null until it is first shared. Outside
+	 * of construction and destruction, it is accessed with the atomic
+	 * shared_ptr functions only, and a writer replaces it while it holds the
+	 * write.
+	 */
+	mutable Lifetime mLifetime;
+
+	/**
+	 * Allocate a buffer of {@param length} bytes from the SecureArena, or from
+	 * the heap once the arena is exhausted. The buffer is zeroized when released.
+	 */
+	static SharedKeyBuffer __allocateKeyBuffer( size_t length )
+	{
+		Instrumentation::count( Instrumentation::KEY_ALLOCATIONS );
+		uint8_t* buffer = static_cast< uint8_t* >( SecureArena::allocate( length ) );
+		if ( nullptr != buffer )
+		{
+			return SharedKeyBuffer( buffer,
 				[ = ]( const uint8_t* pointer )
 				{
+					SecureArena::deallocate( const_cast< uint8_t* >( pointer ), length );
 				} );
 		}
 
-		uint8_t* buffer = new uint8_t[ length ];
-		mKeyLength = length;
-		std::memcpy( buffer, data, length );
-
-		return SharedKeyBuffer( buffer,
+		return SharedKeyBuffer( new uint8_t[ length ],
 			[ = ]( const uint8_t* pointer )
 			{
-				std::memset( const_cast< uint8_t* >( pointer ), 0, length );
+				zeroize( const_cast< uint8_t* >( pointer ), length );
 				delete[] pointer;
 			} );
 	}
 
+	static SharedKeyBuffer __makeKeyBuffer( const uint8_t* data, size_t length )
+	{
+		SharedKeyBuffer keyBuffer = __allocateKeyBuffer( length );
+		std::memcpy( const_cast< uint8_t* >( keyBuffer.get() ), data, length );
+		return keyBuffer;
+	}
+
+	/**
+	 * Begin a write, waiting out any other writer.
+	 * @return The odd sequence number to pass to __unlockWrite() is returned.
+	 */
+	uint64_t __lockWrite()
+	{
+		uint64_t sequence = mSequence.load( std::memory_order_relaxed );
+		while ( ( sequence & 1 ) or not mSequence.compare_exchange_weak( sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed ) )
+		{
+			Instrumentation::count( Instrumentation::KEY_WRITE_WAITS );
+			std::this_thread::yield();
+			sequence = mSequence.load( std::memory_order_relaxed );
+		}
+
+		// Keep the stores of the write from becoming visible before the odd sequence number.
+		std::atomic_thread_fence( std::memory_order_release );
+		return sequence + 1;
+	}
+
+	void __unlockWrite( uint64_t sequence )
+	{
+		mSequence.store( sequence + 1, std::memory_order_release );
+	}
+
+	/**
+	 * Overwrite the key state. Outside of construction and destruction, the
+	 * caller has begun a write.
+	 * @return The replaced snapshot is returned, for the caller to retire.
+	 */
+	const KeySnapshot* __store( const uint64_t* inlineKey, size_t length, const KeySnapshot* snapshot )
+	{
+		mKeyLength.store( length, std::memory_order_relaxed );
+		for ( size_t index( -1 ); ++index < INLINE_WORDS; )
+		{
+			mInlineKey[ index ].store( ( nullptr == inlineKey ) ? 0 : inlineKey[ index ], std::memory_order_relaxed );
+		}
+
+		return mSnapshot.exchange( snapshot, std::memory_order_relaxed );
+	}
+
+	/**
+	 * Take a consistent copy of the key state. A snapshot in {@param view} may
+	 * only be used while the caller is inside a read-side section.
+	 * @param shareLifetime If true, the lifetime of the key material is taken too.
+	 */
+	void __load( KeyView& view, bool shareLifetime = false ) const
+	{
+		while ( true )
+		{
+			uint64_t sequence = mSequence.load( std::memory_order_acquire );
+			if ( sequence & 1 )
+			{
+				Instrumentation::count( Instrumentation::KEY_READ_RETRIES );
+				std::this_thread::yield();
+				continue;
+			}
+
+			view.mKeyLength = mKeyLength.load( std::memory_order_relaxed );
+			view.mSnapshot = mSnapshot.load( std::memory_order_relaxed );
+			if ( nullptr == view.mSnapshot )
+			{
+				for ( size_t index( -1 ); ++index < INLINE_WORDS; )
+				{
+					view.mInlineKey[ index ] = mInlineKey[ index ].load( std::memory_order_relaxed );
+				}
+			}
+
+			if ( shareLifetime )
+			{
+				view.mLifetime = std::atomic_load( &mLifetime );
+			}
+
+			std::atomic_thread_fence( std::memory_order_acquire );
+			if ( sequence == mSequence.load( std::memory_order_relaxed ) )
+			{
+				return;
+			}
+
+			Instrumentation::count( Instrumentation::KEY_READ_RETRIES );
+		}
+	}
+
+	/**
+	 * Take a consistent copy of the key state and the lifetime of its
+	 * material, giving a non-null key a lifetime first if it has none. A
+	 * lifetime installed just after a write took the old one belongs to the
+	 * new material, which the next load then reads.
+	 */
+	void __loadShared( KeyView& view ) const
+	{
+		while ( true )
+		{
+			__load( view, true );
+			if ( ( 0 == view.mKeyLength ) or ( nullptr != view.mLifetime ) )
+			{
+				return;
+			}
+
+			Lifetime expected;
+			std::atomic_compare_exchange_strong( &mLifetime, &expected,
+				Lifetime( std::allocate_shared< LifetimeToken >( LifetimeAllocator< LifetimeToken >() ) ) );
+		}
+	}
+
+	/**
+	 * Take the key state of {@param other}, leaving it null. The snapshot
+	 * changes owner without being freed, so readers of {@param other} need no
+	 * grace period.
+	 */
+	static void __extract( Key& other, KeyView& view )
+	{
+		uint64_t sequence = other.__lockWrite();
+		view.mKeyLength = other.mKeyLength.load( std::memory_order_relaxed );
+		for ( size_t index( -1 ); ++index < INLINE_WORDS; )
+		{
+			view.mInlineKey[ index ] = other.mInlineKey[ index ].load( std::memory_order_relaxed );
+		}
+
+		view.mSnapshot = other.__store( nullptr, 0, nullptr );
+		view.mLifetime = std::atomic_exchange( &other.mLifetime, Lifetime() );
+		other.__unlockWrite( sequence );
+	}
+
+	/**
+	 * Replace the key state with {@param view}, taking ownership of its
+	 * snapshot and lifetime, then free the replaced snapshot once every reader
+	 * that might hold it has moved on. The replaced lifetime is left in
+	 * {@param view}.
+	 */
+	void __publish( KeyView& view )
+	{
+		uint64_t sequence = __lockWrite();
+		const KeySnapshot* previousSnapshot = __store( view.mInlineKey, view.mKeyLength, view.mSnapshot );
+		view.mLifetime = std::atomic_exchange( &mLifetime, std::move( view.mLifetime ) );
+		__unlockWrite( sequence );
+
+		if ( nullptr != previousSnapshot )
+		{
+			ReadCopyUpdate::synchronize();
+			delete previousSnapshot;
+		}
+	}
+
+	/**
+	 * Fill {@param view} with a copy of {@param value}. A null {@param value}
+	 * or a zero {@param length} leaves the view null.
+	 */
+	static void __assign( KeyView& view, const uint8_t* value, size_t length )
+	{
+		if ( ( nullptr == value ) or ( 0 == length ) )
+		{
+			return;
+		}
+
+		view.mKeyLength = length;
+		if ( INLINE_CAPACITY < length )
+		{
+			view.mSnapshot = new KeySnapshot { __makeKeyBuffer( value, length ) };
+		}
+		else
+		{
+			std::memcpy( view.mInlineKey, value, length );
+		}
+	}
+
+	/**
+	 * Call {@param function} with the key buffer and its length, as read()
+	 * does, and take the lifetime of that key material. A null key is not
+	 * passed to {@param function}.
+	 * @param lifetime Reference to receive the lifetime of the key material.
+	 * @param function Callable as function( const uint8_t* buffer, size_t length ),
+	 *     returning true if it accepts the key.
+	 * @return True is returned if the key is non-null and {@param function}
+	 *     accepted it, else false and {@param lifetime} is left unchanged.
+	 */
+	template < typename Function >
+	bool __readShared( std::weak_ptr< const void >& lifetime, Function&& function ) const
+	{
+		ReadCopyUpdate::ReadLock keyReadLock;
+		KeyView view;
+		__loadShared( view );
+		if ( ( 0 == view.mKeyLength ) or not function( view.buffer(), view.mKeyLength ) )
+		{
+			return false;
+		}
+
+		lifetime = view.mLifetime;
+		return true;
+	}
+
 public:
 	/**
 	 * Default construct a null key.
 	 */
 	Key() :
-		mKeyBuffer( __makeKeyBuffer( nullptr, 0 ) )
+		mSequence( 0 ),
+		mKeyLength( 0 ),
+		mSnapshot( nullptr )
 	{
+		__store( nullptr, 0, nullptr );
 	}
 
 	/**
-	 * Copy constructor.
+	 * Copy constructor. The copy shares the lifetime of the key material.
 	 * @param other Constant reference to the Key object to copy.
 	 */
-	Key( const Key& other )
+	Key( const Key& other ) :
+		Key()
 	{
-		std::shared_lock keyReadLock( other.mKeyMutex );
-		mKeyBuffer = other.mKeyBuffer;
-		mKeyLength = other.mKeyLength;
+		Instrumentation::count( Instrumentation::KEY_COPIES );
+		ReadCopyUpdate::ReadLock keyReadLock;
+		KeyView view;
+		other.__loadShared( view );
+		if ( nullptr != view.mSnapshot )
+		{
+			view.mSnapshot = new KeySnapshot( *view.mSnapshot );
+		}
+
+		__store( view.mInlineKey, view.mKeyLength, view.mSnapshot );
+		mLifetime = std::move( view.mLifetime );
 	}
 
 	/**
 	 * Move constructor.
 	 * @param other RValue to a Key object to assign to this new instance.
 	 */
-	Key( Key&& other )
+	Key( Key&& other ) :
+		Key()
 	{
-		std::unique_lock keyWriteLock( other.mKeyMutex );
-		mKeyLength = std::exchange( other.mKeyLength, 0 );
-		mKeyBuffer = std::move( other.mKeyBuffer );
+		KeyView view;
+		__extract( other, view );
+		__store( view.mInlineKey, view.mKeyLength, view.mSnapshot );
+		mLifetime = std::move( view.mLifetime );
 	}
 
 	/**
@@ -92,17 +453,20 @@ public:
 	 * @param length Length of {@param value} in bytes.
 	 */
 	Key( const uint8_t* value, size_t length ) :
-		mKeyBuffer( __makeKeyBuffer( value, length ) )
+		Key()
 	{
+		KeyView view;
+		__assign( view, value, length );
+		__store( view.mInlineKey, view.mKeyLength, view.mSnapshot );
 	}
 
 	/**
-	 * Key destructor.
+	 * Key destructor. An inline key is zeroized, and this Key no longer holds
+	 * the lifetime of its material.
 	 */
 	~Key()
 	{
-		mKeyLength = 0;
-		mKeyBuffer.reset();
+		delete __store( nullptr, 0, nullptr );
 	}
 
 	/**
@@ -110,18 +474,27 @@ public:
 	 */
 	void clear()
 	{
-		std::unique_lock keyWriteLock( mKeyMutex );
-		mKeyBuffer = __makeKeyBuffer( nullptr, 0 );
+		KeyView view;
+		__publish( view );
 	}
 
 	/**
 	 * Get a shared pointer to the const uint8_t buffer holding the key.
+	 * An inline key is copied to a new heap buffer, zeroized on release;
+	 * read() gives access to the key without allocating.
 	 * @return A shared_ptr to the const uint8_t buffer is returned.
 	 */
 	std::shared_ptr< const uint8_t > key() const
 	{
-		std::shared_lock keyReadLock( mKeyMutex );
-		return mKeyBuffer;
+		ReadCopyUpdate::ReadLock keyReadLock;
+		KeyView view;
+		__load( view );
+		if ( nullptr != view.mSnapshot )
+		{
+			return view.mSnapshot->mKeyBuffer;
+		}
+
+		return ( 0 == view.mKeyLength ) ? SharedKeyBuffer() : __makeKeyBuffer( view.buffer(), view.mKeyLength );
 	}
 
 	/**
@@ -130,12 +503,39 @@ public:
 	 */
 	size_t length() const
 	{
-		std::shared_lock keyReadLock( mKeyMutex );
-		return mKeyLength;
+		return mKeyLength.load( std::memory_order_acquire );
+	}
+
+	/**
+	 * Get a number that changes with every write to this Key, so that the key
+	 * is known to be unchanged between two calls returning the same number.
+	 * @return The generation of this Key instance is returned.
+	 */
+	uint64_t generation() const
+	{
+		return mSequence.load( std::memory_order_acquire ) & ~uint64_t( 1 );
 	}
 
 	/**
-	 * Copy assignment operator.
+	 * Call {@param function} with the key buffer and its length, both null or
+	 * zero for a null key. Nothing is locked or allocated; the buffer stays
+	 * valid until {@param function} returns, even if the Key is written
+	 * concurrently. {@param function} must not write to any Key.
+	 * @param function Callable as function( const uint8_t* buffer, size_t length ).
+	 * @return The value returned by {@param function} is returned.
+	 */
+	template < typename Function >
+	auto read( Function&& function ) const
+	{
+		ReadCopyUpdate::ReadLock keyReadLock;
+		KeyView view;
+		__load( view );
+		return function( view.buffer(), view.mKeyLength );
+	}
+
+	/**
+	 * Copy assignment operator. This Key shares the lifetime of the key
+	 * material of {@param other}.
 	 * @param other Constant reference to the Key object to copy.
 	 * @return Reference to this Key instance is returned.
 	 */
@@ -143,9 +543,18 @@ public:
 	{
 		if ( this != &other )
 		{
-			std::shared_lock keyReadLock( other.mKeyMutex );
-			mKeyBuffer = other.mKeyBuffer;
-			mKeyLength = other.mKeyLength;
+			Instrumentation::count( Instrumentation::KEY_COPIES );
+			KeyView view;
+			{
+				ReadCopyUpdate::ReadLock keyReadLock;
+				other.__loadShared( view );
+				if ( nullptr != view.mSnapshot )
+				{
+					view.mSnapshot = new KeySnapshot( *view.mSnapshot );
+				}
+			}
+
+			__publish( view );
 		}
 
 		return *this;
@@ -160,45 +569,33 @@ public:
 	{
 		if ( this != &other )
 		{
-			std::lock( mKeyMutex, other.mKeyMutex );
-			std::lock_guard thisKeyWriteLock( mKeyMutex, std::adopt_lock );
-			std::lock_guard otherKeyWriteLock( other.mKeyMutex, std::adopt_lock );
-			mKeyLength = std::exchange( other.mKeyLength, 0 );
-			mKeyBuffer = std::move( other.mKeyBuffer );
+			KeyView view;
+			__extract( other, view );
+			__publish( view );
 		}
 
 		return *this;
 	}
 
 	/**
-	 * Check that this Key instance is equal to {@param other}.
+	 * Check that this Key instance is equal to {@param other}. Keys of equal
+	 * length are compared in constant time, so the running time reveals the
+	 * key lengths only, never where the contents first differ.
 	 * @param other Constant reference to a Key instance to compare against.
 	 * @return True is returned if this Key instance contains the same content as {@param other}. False is otherwise returned.
 	 */
 	bool operator==( const Key& other ) const
 	{
-		std::scoped_lock keysReadLock( mKeyMutex, other.mKeyMutex );
-		if ( mKeyLength == other.mKeyLength )
+		ReadCopyUpdate::ReadLock keysReadLock;
+		KeyView view[ 2 ];
+		__load( view[ 0 ] );
+		other.__load( view[ 1 ] );
+		if ( view[ 0 ].mKeyLength != view[ 1 ].mKeyLength )
 		{
-			if ( ( nullptr == mKeyBuffer ) or ( nullptr == other.mKeyBuffer ) )
-			{
-				return ( mKeyBuffer == other.mKeyBuffer );
-			}
-
-			const uint8_t* buffer[ 2 ] = {
-				mKeyBuffer.get(), other.mKeyBuffer.get() };
-			for ( size_t index( mKeyLength ); index--; )
-			{
-				if ( buffer[ 0 ][ index ] != buffer[ 1 ][ index ] )
-				{
-					return false;
-				}
-			}
-
-			return true;
+			return false;
 		}
 
-		return false;
+		return ConstantTime::equal( view[ 0 ].buffer(), view[ 1 ].buffer(), view[ 0 ].mKeyLength );
 	}
 
 	/**
@@ -208,28 +605,7 @@ public:
 	 */
 	bool operator!=( const Key& other ) const
 	{
-		std::scoped_lock keysReadLock( mKeyMutex, other.mKeyMutex );
-		if ( mKeyLength == other.mKeyLength )
-		{
-			if ( ( nullptr == mKeyBuffer ) or ( nullptr == other.mKeyBuffer ) )
-			{
-				return not ( mKeyBuffer == other.mKeyBuffer );
-			}
-
-			const uint8_t* buffer[ 2 ] = {
-				mKeyBuffer.get(), other.mKeyBuffer.get() };
-			for ( size_t index( mKeyLength ); index--; )
-			{
-				if ( buffer[ 0 ][ index ] != buffer[ 1 ][ index ] )
-				{
-					return true;
-				}
-			}
-
-			return false;
-		}
-
-		return true;
+		return not ( *this == other );
 	}
 
 	/**
@@ -238,8 +614,7 @@ public:
 	 */
 	operator bool() const
 	{
-		std::shared_lock keyReadLock( mKeyMutex );
-		return not ( ( 0 == mKeyLength ) or ( nullptr == mKeyBuffer ) );
+		return 0 != length();
 	}
 
 	/**
@@ -249,23 +624,71 @@ public:
 	 */
 	operator std::string() const
 	{
-		static const char HEX_DIGIT[] = "0123456789abcdef";
+		return read( []( const uint8_t* buffer, size_t length )
+			{
+				std::string hexString( 2 * length, ' ' );
+				Hex::encode( &hexString[ 0 ], buffer, length );
+				return hexString;
+			} );
+	}
 
-		std::shared_lock keyReadLock( mKeyMutex );
-		if ( ( 0 != mKeyLength ) and ( nullptr != mKeyBuffer ) )
-		{
-			const uint8_t* buffer = mKeyBuffer.get();
-			std::string hexString( 2 * mKeyLength, ' ' );
-			for ( size_t index( -1 ); ++index < mKeyLength; )
+	/**
+	 * Write the hexadecimal representation of the key to {@param hex}, without
+	 * allocating. No terminating null character is written.
+	 * @param hex Pointer to a char array.
+	 * @param hexLength Length of {@param hex} in characters.
+	 * @return The number of characters written, 2 * length(), is returned, or
+	 *     zero if the key is null or {@param hexLength} is too small.
+	 */
+	size_t toHex( char* hex, size_t hexLength ) const
+	{
+		return read( [ = ]( const uint8_t* buffer, size_t length )
 			{
-				hexString[ 2 * index + 0 ] = HEX_DIGIT[ ( buffer[ index ] >> 4 ) & 0xF ];
-				hexString[ 2 * index + 1 ] = HEX_DIGIT[ ( buffer[ index ] >> 0 ) & 0xF ];
-			}
+				if ( ( nullptr == hex ) or ( hexLength < 2 * length ) )
+				{
+					return size_t( 0 );
+				}
+
+				Hex::encode( hex, buffer, length );
+				return 2 * length;
+			} );
+	}
+
+	/**
+	 * Construct a Key from its hexadecimal representation, in either case.
+	 * The key is decoded straight into its own storage.
+	 * @param hex Pointer to an array of const chars.
+	 * @param hexLength Number of characters in {@param hex}.
+	 * @return The decoded Key is returned, or a null Key if {@param hex} is
+	 *     null, empty, of odd length or holds a character that is not a
+	 *     hexadecimal digit.
+	 */
+	static Key fromHex( const char* hex, size_t hexLength )
+	{
+		Key key;
+		if ( ( nullptr == hex ) or ( 0 == hexLength ) or ( hexLength & 1 ) )
+		{
+			return key;
+		}
 
-			return hexString;
+		KeyView view;
+		view.mKeyLength = hexLength / 2;
+		uint8_t* buffer = reinterpret_cast< uint8_t* >( view.mInlineKey );
+		if ( INLINE_CAPACITY < view.mKeyLength )
+		{
+			SharedKeyBuffer keyBuffer = __allocateKeyBuffer( view.mKeyLength );
+			buffer = const_cast< uint8_t* >( keyBuffer.get() );
+			view.mSnapshot = new KeySnapshot { keyBuffer };
+		}
+
+		if ( not Hex::decode( buffer, hex, hexLength ) )
+		{
+			delete view.mSnapshot;
+			return key;
 		}
 
-		return std::string( "" );
+		key.__store( view.mInlineKey, view.mKeyLength, view.mSnapshot );
+		return key;
 	}
 
 	/**
@@ -277,8 +700,9 @@ public:
 	 */
 	void set( const uint8_t* value, size_t length )
 	{
-		std::unique_lock keyWriteLock( mKeyMutex );
-		mKeyBuffer = __makeKeyBuffer( value, length );
+		KeyView view;
+		__assign( view, value, length );
+		__publish( view );
 	}
 };
 
@@ -0,0 +1,90 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Key.hpp"
+
+namespace Pique
+{
+
+/**
+ * Binds state derived from a Key, such as HMAC midstates or a cipher key
+ * schedule, to the key material it was derived from. The binding holds the
+ * lifetime of the material rather than the Key, so the Key may be written to
+ * or destroyed at any time: once every Key sharing the material has been
+ * cleared, set or destroyed, the binding lapses and its owner discards the
+ * derived state.
+ *
+ * Copies of a binding are bound to the same key material. An instance is not
+ * safe for concurrent use.
+ */
+class KeyBinding final
+{
+private:
+	std::weak_ptr< const void > mLifetime;
+	mutable bool mBound;
+
+public:
+	/**
+	 * Default construct an unbound KeyBinding.
+	 */
+	KeyBinding() :
+		mBound( false )
+	{
+	}
+
+	/**
+	 * Derive state from {@param key} and bind to its material, discarding any
+	 * previous binding. {@param function} sees a consistent key even if
+	 * {@param key} is written concurrently.
+	 * @param key Constant reference to the Key to bind to.
+	 * @param function Callable as function( const uint8_t* buffer, size_t length ),
+	 *     returning true if it derived its state from the key. It is not called
+	 *     for a null key and must not write to any Key.
+	 * @return True if {@param key} is non-null and {@param function} returned
+	 *     true, else false is returned and this instance is left unbound.
+	 */
+	template < typename Function >
+	bool bind( const Key& key, Function&& function )
+	{
+		reset();
+		mBound = key.__readShared( mLifetime, function );
+		return mBound;
+	}
+
+	/**
+	 * Unbind this instance from its key material.
+	 */
+	void reset()
+	{
+		mLifetime.reset();
+		mBound = false;
+	}
+
+	/**
+	 * Check that the key material is still held by some Key, calling
+	 * {@param discard} the first time it is found to be gone.
+	 * @param discard Callable as discard(), to zeroize the derived state.
+	 * @return True is returned if this instance is bound, else false.
+	 */
+	template < typename Function >
+	bool isBound( Function&& discard ) const
+	{
+		if ( mBound and mLifetime.expired() )
+		{
+			mBound = false;
+			discard();
+		}
+
+		return mBound;
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,410 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "Key.hpp"
+#include "ReadCopyUpdate.hpp"
+
+namespace Pique
+{
+
+/**
+ * A concurrent map from 64-bit key IDs to Keys, for looking up one of many
+ * tenant keys on every request.
+ *
+ * Key IDs are spread over independent shards, each an open addressing table
+ * with linear probing, published through ReadCopyUpdate. Lookups take no lock
+ * and write no shared memory. Writers to the same shard are serialized by the
+ * shard's mutex, while writers to different shards do not contend.
+ *
+ * Writing the key of a present ID is a rotation: the new Key is published in
+ * place with a single atomic store, and the old Key is destroyed, which
+ * zeroizes it, once every reader that might still see it has finished. New IDs
+ * are also added in place; a shard's table is copied only when it fills up.
+ *
+ * Writes wait for readers to drain, so they must not be made from within
+ * read(), nor from within any other read-side section.
+ */
+class Keyring final
+{
+public:
+	/**
+	 * The number of shards of a default constructed Keyring.
+	 */
+	static constexpr size_t DEFAULT_SHARD_COUNT = 64;
+
+private:
+	static constexpr size_t MINIMUM_TABLE_CAPACITY = 16;
+
+	/**
+	 * A slot is empty while its key is null. The ID is written before the key
+	 * is published, and never changes afterwards.
+	 */
+	struct Slot
+	{
+		std::atomic< uint64_t > mKeyId;
+		std::atomic< Key* > mKey;
+	};
+
+	/**
+	 * A table of a power-of-two number of slots. Erased slots hold the
+	 * tombstone, so that probes continue past them, and are reclaimed when
+	 * the table is next copied.
+	 */
+	struct Table
+	{
+		size_t mMask;
+		size_t mUsedSlots;
+		std::atomic< size_t > mLiveSlots;
+		std::unique_ptr< Slot[] > mSlots;
+
+		explicit Table( size_t capacity ) :
+			mMask( capacity - 1 ),
+			mUsedSlots( 0 ),
+			mLiveSlots( 0 ),
+			mSlots( new Slot[ capacity ] )
+		{
+			for ( size_t index( -1 ); ++index < capacity; )
+			{
+				mSlots[ index ].mKeyId.store( 0, std::memory_order_relaxed );
+				mSlots[ index ].mKey.store( nullptr, std::memory_order_relaxed );
+			}
+		}
+	};
+
+	struct alignas( 64 ) Shard
+	{
+		std::mutex mMutex;
+		std::atomic< Table* > mTable;
+	};
+
+	size_t mShardShift;
+	std::unique_ptr< Shard[] > mShards;
+
+	/**
+	 * The placeholder of an erased key. It is never dereferenced.
+	 */
+	static Key* __tombstone()
+	{
+		static Key tombstone;
+		return &tombstone;
+	}
+
+	/**
+	 * Mix all bits of {@param keyId} into all bits of the result, in constant
+	 * time, so that sequential IDs spread evenly over shards and slots.
+	 */
+	static uint64_t __hash( uint64_t keyId )
+	{
+		keyId ^= keyId >> 33;
+		keyId *= 0xFF51AFD7ED558CCDULL;
+		keyId ^= keyId >> 33;
+		keyId *= 0xC4CEB9FE1A85EC53ULL;
+		keyId ^= keyId >> 33;
+		return keyId;
+	}
+
+	/**
+	 * Shards are picked by the high bits of the hash, and slots by the low.
+	 */
+	Shard& __shard( uint64_t hash ) const
+	{
+		return mShards[ ( 64 == mShardShift ) ? 0 : ( hash >> mShardShift ) ];
+	}
+
+	/**
+	 * Find the slot of {@param keyId} in {@param table}.
+	 * @return The slot of {@param keyId} is returned, or null if it is absent.
+	 */
+	static Slot* __find( const Table& table, uint64_t keyId, uint64_t hash )
+	{
+		for ( size_t index = hash & table.mMask; ; index = ( index + 1 ) & table.mMask )
+		{
+			Slot& slot = table.mSlots[ index ];
+			Key* key = slot.mKey.load( std::memory_order_acquire );
+			if ( nullptr == key )
+			{
+				return nullptr;
+			}
+
+			if ( ( keyId == slot.mKeyId.load( std::memory_order_relaxed ) ) and ( __tombstone() != key ) )
+			{
+				return &slot;
+			}
+		}
+	}
+
+	/**
+	 * Find the key held under {@param keyId}. The caller is inside a read-side
+	 * section, for which the key stays valid.
+	 * @return The key is returned, or null if it is absent.
+	 */
+	const Key* __lookup( uint64_t keyId ) const
+	{
+		uint64_t hash = __hash( keyId );
+		Slot* slot = __find( *__shard( hash ).mTable.load( std::memory_order_acquire ), keyId, hash );
+		if ( nullptr == slot )
+		{
+			return nullptr;
+		}
+
+		// The key may have been erased since it was found.
+		Key* key = slot->mKey.load( std::memory_order_acquire );
+		return ( __tombstone() == key ) ? nullptr : key;
+	}
+
+	/**
+	 * Place {@param key} in the first empty slot of the probe sequence of
+	 * {@param keyId}. The caller has checked that the ID is absent and that
+	 * the table has an empty slot to spare.
+	 */
+	static void __place( Table& table, uint64_t keyId, uint64_t hash, Key* key )
+	{
+		size_t index = hash & table.mMask;
+		while ( nullptr != table.mSlots[ index ].mKey.load( std::memory_order_relaxed ) )
+		{
+			index = ( index + 1 ) & table.mMask;
+		}
+
+		table.mSlots[ index ].mKeyId.store( keyId, std::memory_order_relaxed );
+		table.mSlots[ index ].mKey.store( key, std::memory_order_release );
+		++table.mUsedSlots;
+		table.mLiveSlots.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	/**
+	 * Copy the live keys of {@param table} into a new table with room for at
+	 * least {@param liveSlots} keys at a load factor of at most a quarter.
+	 */
+	static Table* __copy( const Table& table, size_t liveSlots )
+	{
+		size_t capacity = MINIMUM_TABLE_CAPACITY;
+		while ( capacity < 4 * liveSlots )
+		{
+			capacity *= 2;
+		}
+
+		Table* copy = new Table( capacity );
+		for ( size_t index( -1 ); ++index <= table.mMask; )
+		{
+			Key* key = table.mSlots[ index ].mKey.load( std::memory_order_relaxed );
+			if ( ( nullptr != key ) and ( __tombstone() != key ) )
+			{
+				uint64_t keyId = table.mSlots[ index ].mKeyId.load( std::memory_order_relaxed );
+				__place( *copy, keyId, __hash( keyId ), key );
+			}
+		}
+
+		return copy;
+	}
+
+public:
+	/**
+	 * Construct an empty Keyring.
+	 * @param shardCount The number of shards, rounded up to a power of two.
+	 *     More shards let more writers proceed at once.
+	 */
+	explicit Keyring( size_t shardCount = DEFAULT_SHARD_COUNT ) :
+		mShardShift( 64 )
+	{
+		size_t shards = 1;
+		while ( shards < shardCount )
+		{
+			shards *= 2;
+			--mShardShift;
+		}
+
+		mShards.reset( new Shard[ shards ] );
+		for ( size_t index( -1 ); ++index < shards; )
+		{
+			mShards[ index ].mTable.store( new Table( MINIMUM_TABLE_CAPACITY ), std::memory_order_relaxed );
+		}
+	}
+
+	Keyring( const Keyring& ) = delete;
+	Keyring& operator=( const Keyring& ) = delete;
+
+	/**
+	 * Keyring destructor. Every Key is destroyed, which zeroizes it. No other
+	 * thread may be using the Keyring.
+	 */
+	~Keyring()
+	{
+		for ( size_t index( -1 ); ++index < shardCount(); )
+		{
+			Table* table = mShards[ index ].mTable.load( std::memory_order_relaxed );
+			for ( size_t slot( -1 ); ++slot <= table->mMask; )
+			{
+				Key* key = table->mSlots[ slot ].mKey.load( std::memory_order_relaxed );
+				if ( __tombstone() != key )
+				{
+					delete key;
+				}
+			}
+
+			delete table;
+		}
+	}
+
+	/**
+	 * Get the number of shards.
+	 * @return The number of shards is returned.
+	 */
+	size_t shardCount() const
+	{
+		return size_t( 1 ) << ( 64 - mShardShift );
+	}
+
+	/**
+	 * Get the number of keys. The count is exact only while no keys are being
+	 * added or erased.
+	 * @return The number of keys is returned.
+	 */
+	size_t size() const
+	{
+		size_t size = 0;
+		ReadCopyUpdate::ReadLock keyringReadLock;
+		for ( size_t index( -1 ); ++index < shardCount(); )
+		{
+			size += mShards[ index ].mTable.load( std::memory_order_acquire )->mLiveSlots.load( std::memory_order_relaxed );
+		}
+
+		return size;
+	}
+
+	/**
+	 * Check whether a key is held under {@param keyId}.
+	 * @param keyId The ID of the key.
+	 * @return True is returned if the key is present, else false.
+	 */
+	bool contains( uint64_t keyId ) const
+	{
+		ReadCopyUpdate::ReadLock keyringReadLock;
+		return nullptr != __lookup( keyId );
+	}
+
+	/**
+	 * Get a copy of the key held under {@param keyId}.
+	 * @param keyId The ID of the key.
+	 * @return A copy of the key is returned, or a null Key if it is absent.
+	 */
+	Key find( uint64_t keyId ) const
+	{
+		ReadCopyUpdate::ReadLock keyringReadLock;
+		const Key* key = __lookup( keyId );
+		return ( nullptr == key ) ? Key() : Key( *key );
+	}
+
+	/**
+	 * Call {@param function} with the key held under {@param keyId}, without
+	 * copying it. Nothing is locked or allocated; the Key stays valid until
+	 * {@param function} returns, even if it is rotated or erased concurrently.
+	 * {@param function} must not write to any Key or Keyring.
+	 * @param keyId The ID of the key.
+	 * @param function Callable as function( const Key& key ).
+	 * @return True is returned if the key was present and {@param function}
+	 *     was called, else false.
+	 */
+	template < typename Function >
+	bool read( uint64_t keyId, Function&& function ) const
+	{
+		ReadCopyUpdate::ReadLock keyringReadLock;
+		const Key* key = __lookup( keyId );
+		if ( nullptr == key )
+		{
+			return false;
+		}
+
+		function( *key );
+		return true;
+	}
+
+	/**
+	 * Hold {@param key} under {@param keyId}. If a key is already held under
+	 * {@param keyId}, then it is rotated out: readers see either the old or
+	 * the new key, and the old key is zeroized once they have all finished
+	 * with it.
+	 * @param keyId The ID of the key.
+	 * @param key The key to hold.
+	 */
+	void set( uint64_t keyId, Key key )
+	{
+		uint64_t hash = __hash( keyId );
+		Shard& shard = __shard( hash );
+		Key* newKey = new Key( std::move( key ) );
+		Key* retiredKey = nullptr;
+		Table* retiredTable = nullptr;
+		{
+			std::lock_guard< std::mutex > shardLock( shard.mMutex );
+			Table* table = shard.mTable.load( std::memory_order_relaxed );
+			Slot* slot = __find( *table, keyId, hash );
+			if ( nullptr != slot )
+			{
+				retiredKey = slot->mKey.exchange( newKey, std::memory_order_acq_rel );
+			}
+			else
+			{
+				// Keep the load factor at or below a half, tombstones included.
+				if ( 2 * ( table->mUsedSlots + 1 ) > table->mMask + 1 )
+				{
+					retiredTable = table;
+					table = __copy( *table, table->mLiveSlots.load( std::memory_order_relaxed ) + 1 );
+				}
+
+				__place( *table, keyId, hash, newKey );
+				if ( nullptr != retiredTable )
+				{
+					shard.mTable.store( table, std::memory_order_release );
+				}
+			}
+		}
+
+		if ( ( nullptr != retiredKey ) or ( nullptr != retiredTable ) )
+		{
+			ReadCopyUpdate::synchronize();
+			delete retiredKey;
+			delete retiredTable;
+		}
+	}
+
+	/**
+	 * Remove the key held under {@param keyId}. It is zeroized once every
+	 * reader that might still see it has finished with it.
+	 * @param keyId The ID of the key.
+	 * @return True is returned if a key was removed, else false.
+	 */
+	bool erase( uint64_t keyId )
+	{
+		uint64_t hash = __hash( keyId );
+		Shard& shard = __shard( hash );
+		Key* retiredKey = nullptr;
+		{
+			std::lock_guard< std::mutex > shardLock( shard.mMutex );
+			Table* table = shard.mTable.load( std::memory_order_relaxed );
+			Slot* slot = __find( *table, keyId, hash );
+			if ( nullptr == slot )
+			{
+				return false;
+			}
+
+			retiredKey = slot->mKey.exchange( __tombstone(), std::memory_order_acq_rel );
+			table->mLiveSlots.fetch_sub( 1, std::memory_order_relaxed );
+		}
+
+		ReadCopyUpdate::synchronize();
+		delete retiredKey;
+		return true;
+	}
+};
+
+} // namespace Pique
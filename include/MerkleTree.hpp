@@ -0,0 +1,306 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "ConstantTime.hpp"
+#include "HashFunction.hpp"
+#include "ThreadPool.hpp"
+
+namespace Pique
+{
+
+/**
+ * A Merkle tree over a message split into chunks of a fixed size, the last of
+ * which may be shorter, hashed in parallel on a ThreadPool.
+ *
+ * The tree is that of RFC 6962: a leaf is the hash of 0x00 followed by its
+ * chunk, a node is the hash of 0x01 followed by its left and right children,
+ * and a node without a right sibling is carried up to the next level
+ * unchanged. The prefixes keep a leaf from ever being taken for a node. The
+ * root of an empty message is the hash of the empty string.
+ *
+ * Every level of the tree is kept, so that a proof of any chunk may be given
+ * without hashing again. For the default chunk size the levels take a little
+ * over a thousandth of the size of the message.
+ *
+ * Hash is any HashFunction. DigestSize defaults to the digest size of Hash,
+ * and must be given for a Hash of unlimited digest size.
+ */
+template < typename Hash, uint64_t DigestSize = Hash::DIGEST_SIZE >
+class MerkleTree final
+{
+	static_assert( 0 != DigestSize, "DigestSize is required for a hash of unlimited digest size" );
+	static_assert( ( Hash::UNLIMITED_DIGEST_SIZE == Hash::DIGEST_SIZE ) or ( DigestSize == Hash::DIGEST_SIZE ),
+		"DigestSize is required to equal the digest size of a fixed size hash" );
+
+public:
+	/**
+	 * The digest of a leaf or node.
+	 */
+	typedef std::array< uint8_t, DigestSize > Digest;
+
+	/**
+	 * The chunk size of a default constructed tree.
+	 */
+	static constexpr uint64_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	/**
+	 * The proof that a chunk is part of the message with a given root.
+	 */
+	struct Proof
+	{
+		/**
+		 * The index of the chunk.
+		 */
+		uint64_t leafIndex;
+
+		/**
+		 * The number of chunks of the message.
+		 */
+		uint64_t leafCount;
+
+		/**
+		 * The siblings on the path from the leaf to the root, leaf first.
+		 */
+		std::vector< Digest > path;
+	};
+
+private:
+	static constexpr uint8_t LEAF_PREFIX = 0x00;
+	static constexpr uint8_t NODE_PREFIX = 0x01;
+
+	/**
+	 * The least number of message bytes hashed by one parallel task, so that
+	 * queueing costs little next to hashing.
+	 */
+	static constexpr uint64_t MINIMUM_TASK_SIZE = 256 * 1024;
+
+	uint64_t mChunkSize;
+	ThreadPool& mThreadPool;
+	std::vector< std::vector< Digest > > mLevels;
+	Digest mRoot;
+
+	static void __finish( const Hash& hash, Digest& digest )
+	{
+		if constexpr ( Hash::UNLIMITED_DIGEST_SIZE == Hash::DIGEST_SIZE )
+		{
+			hash.digest( digest.data(), DigestSize );
+		}
+		else
+		{
+			hash.digest( *reinterpret_cast< uint8_t ( * )[ DigestSize ] >( digest.data() ) );
+		}
+	}
+
+	/**
+	 * Hash a leaf from {@param leafHash}, a hash that has absorbed the leaf prefix.
+	 */
+	static void __hashLeaf( const Hash& leafHash, const uint8_t* chunk, uint64_t chunkLength, Digest& digest )
+	{
+		Hash hash( leafHash.clone() );
+		hash.update( chunk, chunkLength );
+		__finish( hash, digest );
+	}
+
+	static void __hashNode( const Digest& left, const Digest& right, Digest& digest )
+	{
+		uint8_t node[ 1 + 2 * DigestSize ];
+		node[ 0 ] = NODE_PREFIX;
+		std::memcpy( node + 1, left.data(), DigestSize );
+		std::memcpy( node + 1 + DigestSize, right.data(), DigestSize );
+
+		Hash hash;
+		hash.update( node, sizeof( node ) );
+		__finish( hash, digest );
+	}
+
+	static Hash __leafHash()
+	{
+		Hash leafHash;
+		leafHash.update( &LEAF_PREFIX, 1 );
+		return leafHash;
+	}
+
+public:
+	/**
+	 * Construct the tree of the empty message.
+	 * @param chunkSize The length, in bytes, of every chunk but the last. A
+	 *     chunk size of zero is taken as one.
+	 * @param threadPool The pool to hash on.
+	 */
+	explicit MerkleTree( uint64_t chunkSize = DEFAULT_CHUNK_SIZE, ThreadPool& threadPool = ThreadPool::instance() ) :
+		mChunkSize( std::max< uint64_t >( chunkSize, 1 ) ),
+		mThreadPool( threadPool )
+	{
+		build( nullptr, 0 );
+	}
+
+	/**
+	 * Get the chunk size.
+	 * @return The length of every chunk but the last, in bytes, is returned.
+	 */
+	uint64_t chunkSize() const
+	{
+		return mChunkSize;
+	}
+
+	/**
+	 * Get the number of chunks of the message.
+	 * @return The number of leaves is returned.
+	 */
+	uint64_t leafCount() const
+	{
+		return mLevels.empty() ? 0 : mLevels.front().size();
+	}
+
+	/**
+	 * Get the root of the tree.
+	 * @return Constant reference to the root digest is returned.
+	 */
+	const Digest& root() const
+	{
+		return mRoot;
+	}
+
+	/**
+	 * Build the tree of a message, replacing the previous one. The chunks are
+	 * hashed in parallel, and then every level of nodes in turn.
+	 * @param message Pointer to an array of const bytes.
+	 * @param messageLength Length of the message in bytes.
+	 */
+	void build( const uint8_t* message, uint64_t messageLength )
+	{
+		mLevels.clear();
+		if ( ( nullptr == message ) or ( 0 == messageLength ) )
+		{
+			__finish( Hash(), mRoot );
+			return;
+		}
+
+		const Hash leafHash( __leafHash() );
+		uint64_t leafCount = ( messageLength + mChunkSize - 1 ) / mChunkSize;
+		mLevels.emplace_back( leafCount );
+		std::vector< Digest >& leaves = mLevels.back();
+		mThreadPool.parallelFor( 0, leafCount, std::max< uint64_t >( 1, MINIMUM_TASK_SIZE / mChunkSize ),
+			[ &, message, messageLength ]( uint64_t first, uint64_t last )
+			{
+				for ( uint64_t leaf = first; leaf < last; ++leaf )
+				{
+					uint64_t offset = leaf * mChunkSize;
+					__hashLeaf( leafHash, message + offset, std::min( mChunkSize, messageLength - offset ), leaves[ leaf ] );
+				}
+			} );
+
+		while ( 1 < mLevels.back().size() )
+		{
+			const std::vector< Digest >& children = mLevels.back();
+			std::vector< Digest > parents( ( children.size() + 1 ) / 2 );
+			mThreadPool.parallelFor( 0, parents.size(), std::max< uint64_t >( 1, MINIMUM_TASK_SIZE / ( 2 * DigestSize ) ),
+				[ & ]( uint64_t first, uint64_t last )
+				{
+					for ( uint64_t parent = first; parent < last; ++parent )
+					{
+						if ( 2 * parent + 1 < children.size() )
+						{
+							__hashNode( children[ 2 * parent ], children[ 2 * parent + 1 ], parents[ parent ] );
+						}
+						else
+						{
+							parents[ parent ] = children[ 2 * parent ];
+						}
+					}
+				} );
+
+			mLevels.push_back( std::move( parents ) );
+		}
+
+		mRoot = mLevels.back().front();
+	}
+
+	/**
+	 * Produce the proof that a chunk is part of the message.
+	 * @param leafIndex The index of the chunk.
+	 * @param proof Reference to the proof to fill.
+	 * @return True is returned if the proof was produced, or false if
+	 *     {@param leafIndex} is not the index of a chunk.
+	 */
+	bool prove( uint64_t leafIndex, Proof& proof ) const
+	{
+		if ( leafIndex >= leafCount() )
+		{
+			return false;
+		}
+
+		proof.leafIndex = leafIndex;
+		proof.leafCount = leafCount();
+		proof.path.clear();
+
+		uint64_t index = leafIndex;
+		for ( size_t level( -1 ); ++level + 1 < mLevels.size(); index /= 2 )
+		{
+			uint64_t sibling = index ^ 1;
+			if ( sibling < mLevels[ level ].size() )
+			{
+				proof.path.push_back( mLevels[ level ][ sibling ] );
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Verify that a chunk is part of the message with the given root.
+	 * @param root The root of the message.
+	 * @param chunk Pointer to an array of const bytes.
+	 * @param chunkLength Length of {@param chunk} in bytes.
+	 * @param proof The proof of the chunk, as produced by prove().
+	 * @return True is returned if {@param proof} proves {@param chunk} to be
+	 *     chunk proof.leafIndex of the message with {@param root}, else false.
+	 */
+	static bool verify( const Digest& root, const uint8_t* chunk, uint64_t chunkLength, const Proof& proof )
+	{
+		if ( proof.leafIndex >= proof.leafCount )
+		{
+			return false;
+		}
+
+		Digest digest;
+		__hashLeaf( __leafHash(), chunk, chunkLength, digest );
+
+		size_t pathIndex = 0;
+		uint64_t index = proof.leafIndex;
+		for ( uint64_t width = proof.leafCount; 1 < width; width = ( width + 1 ) / 2, index /= 2 )
+		{
+			if ( ( index & 1 ) or ( index + 1 < width ) )
+			{
+				if ( pathIndex == proof.path.size() )
+				{
+					return false;
+				}
+
+				const Digest& sibling = proof.path[ pathIndex++ ];
+				if ( index & 1 )
+				{
+					__hashNode( sibling, digest, digest );
+				}
+				else
+				{
+					__hashNode( digest, sibling, digest );
+				}
+			}
+		}
+
+		return ( pathIndex == proof.path.size() ) and ConstantTime::equal( root.data(), digest.data(), DigestSize );
+	}
+};
+
+} // namespace Pique
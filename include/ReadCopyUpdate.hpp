@@ -0,0 +1,230 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined( __linux__ )
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PIQUE_RCU_MEMBARRIER 1
+#endif
+
+namespace Pique
+{
+
+/**
+ * A process wide read-copy-update domain. Readers bracket their access to a
+ * published object with a ReadLock, which only writes to a counter owned by
+ * the calling thread, so readers on different cores never share a cache line.
+ * A writer publishes a replacement object, calls synchronize() to wait until
+ * every reader that might still see the old object has left its read-side
+ * section, and then releases the old object.
+ *
+ * Entering a section must be ordered before the reads within it by a full
+ * barrier. Where the kernel supports expedited private membarrier, the writer
+ * issues that barrier on every running thread of the process from within
+ * synchronize(), and readers need only a compiler barrier; elsewhere readers
+ * issue a full fence themselves.
+ *
+ * Read-side sections nest. synchronize() must not be called from within a
+ * read-side section, as it would wait for itself.
+ */
+class ReadCopyUpdate final
+{
+private:
+	/**
+	 * The read-side state of one thread. The sequence is odd while the
+	 * thread is inside a read-side section.
+	 */
+	struct alignas( 64 ) ReaderRecord
+	{
+		std::atomic< uint64_t > mSequence;
+		std::atomic< bool > mInUse;
+		ReaderRecord* mNext;
+		uint64_t mNesting;
+	};
+
+	struct Domain
+	{
+		std::mutex mMutex;
+		ReaderRecord* mReaders = nullptr;
+	};
+
+	/**
+	 * Claims a reader record for the lifetime of the thread, returning it to
+	 * the domain for reuse when the thread exits.
+	 */
+	struct ThreadRegistration
+	{
+		ReaderRecord* mRecord;
+
+		ThreadRegistration() :
+			mRecord( __claimRecord() )
+		{
+		}
+
+		~ThreadRegistration()
+		{
+			mRecord->mInUse.store( false, std::memory_order_release );
+		}
+	};
+
+	/**
+	 * Whether synchronize() issues the barrier of the readers on their behalf.
+	 * It is set when the domain is created, before any read-side section.
+	 */
+	static std::atomic< bool >& __asymmetricBarrier()
+	{
+		static std::atomic< bool > asymmetricBarrier( false );
+		return asymmetricBarrier;
+	}
+
+	static bool __registerMembarrier()
+	{
+#if defined( PIQUE_RCU_MEMBARRIER )
+		long commands = syscall( __NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0 );
+		return ( 0 < commands ) and ( commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED ) and
+			( 0 == syscall( __NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0 ) );
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * Issue a full barrier on every running thread of the process, including
+	 * the caller.
+	 */
+	static void __barrierAllThreads()
+	{
+#if defined( PIQUE_RCU_MEMBARRIER )
+		// Once registered, the expedited command cannot fail.
+		if ( __asymmetricBarrier().load( std::memory_order_relaxed ) )
+		{
+			syscall( __NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0 );
+			return;
+		}
+#endif
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+	}
+
+	/**
+	 * The domain and its records are never freed, so threads that exit
+	 * after static destruction still find them.
+	 */
+	static Domain& __domain()
+	{
+		static Domain* domain = []()
+			{
+				__asymmetricBarrier().store( __registerMembarrier(), std::memory_order_relaxed );
+				return new Domain();
+			}();
+
+		return *domain;
+	}
+
+	static ReaderRecord* __claimRecord()
+	{
+		Domain& domain = __domain();
+		std::lock_guard< std::mutex > lock( domain.mMutex );
+		for ( ReaderRecord* record = domain.mReaders; nullptr != record; record = record->mNext )
+		{
+			if ( not record->mInUse.load( std::memory_order_relaxed ) )
+			{
+				record->mInUse.store( true, std::memory_order_relaxed );
+				record->mNesting = 0;
+				return record;
+			}
+		}
+
+		ReaderRecord* record = new ReaderRecord();
+		record->mSequence.store( 0, std::memory_order_relaxed );
+		record->mInUse.store( true, std::memory_order_relaxed );
+		record->mNext = domain.mReaders;
+		record->mNesting = 0;
+		domain.mReaders = record;
+		return record;
+	}
+
+	static ReaderRecord& __reader()
+	{
+		thread_local ThreadRegistration registration;
+		return *registration.mRecord;
+	}
+
+public:
+	/**
+	 * Enter a read-side section, leaving it again on destruction.
+	 */
+	class ReadLock final
+	{
+	private:
+		ReaderRecord& mReader;
+
+	public:
+		ReadLock() :
+			mReader( __reader() )
+		{
+			if ( 0 == mReader.mNesting++ )
+			{
+				mReader.mSequence.store( mReader.mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+
+				// Pairs with the barrier in synchronize(): either the writer sees this
+				// section, or this section sees the writer's replacement.
+				if ( __asymmetricBarrier().load( std::memory_order_relaxed ) )
+				{
+					std::atomic_signal_fence( std::memory_order_seq_cst );
+				}
+				else
+				{
+					std::atomic_thread_fence( std::memory_order_seq_cst );
+				}
+			}
+		}
+
+		ReadLock( const ReadLock& ) = delete;
+		ReadLock& operator=( const ReadLock& ) = delete;
+
+		~ReadLock()
+		{
+			if ( 0 == --mReader.mNesting )
+			{
+				mReader.mSequence.store( mReader.mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+			}
+		}
+	};
+
+	/**
+	 * Wait until every read-side section that was in progress when this was
+	 * called has ended. Objects unpublished before the call may then be freed.
+	 */
+	static void synchronize()
+	{
+		__barrierAllThreads();
+
+		Domain& domain = __domain();
+		std::lock_guard< std::mutex > lock( domain.mMutex );
+		for ( ReaderRecord* record = domain.mReaders; nullptr != record; record = record->mNext )
+		{
+			uint64_t sequence = record->mSequence.load( std::memory_order_acquire );
+			if ( 0 == ( sequence & 1 ) )
+			{
+				continue;
+			}
+
+			while ( sequence == record->mSequence.load( std::memory_order_acquire ) )
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,819 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_SHA256_X86 1
+#endif
+
+#include "CpuFeatures.hpp"
+#include "HashFunction.hpp"
+#include "Instrumentation.hpp"
+
+namespace Pique
+{
+
+/**
+ * SHA-256 as specified in FIPS 180-4.
+ * Whole blocks are compressed directly from the caller's memory by the fastest
+ * kernel allowed by CpuFeatures: the SHA extensions, a portable round
+ * function fed by an AVX2 message schedule of eight blocks at a time, or the
+ * portable compression function. Batches of independent messages are hashed
+ * sixteen or eight at a time across AVX-512 or AVX2 lanes, see digestMessages().
+ */
+class SHA256 final : public HashFunction< SHA256, 64, 32 >
+{
+private:
+	friend class HashFunction< SHA256, 64, 32 >;
+
+	typedef void ( *CompressFunction )( uint32_t* state, const uint8_t* blocks, uint64_t blockCount );
+	typedef void ( *LaneCompressFunction )( uint32_t* laneState, const uint8_t* const* laneBlocks, uint64_t blockCount );
+	typedef void ( *BatchFunction )( BatchMessage* messages, uint64_t messageCount );
+
+	static constexpr uint32_t INITIAL_STATE[ 8 ] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+	static constexpr uint32_t ROUND_CONSTANT[ 64 ] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
+
+	alignas( 64 ) static constexpr uint8_t ZERO_BLOCK[ BLOCK_SIZE ] = { 0 };
+
+	/**
+	 * Leads a serialized state: "PQ", the algorithm and the format version.
+	 */
+	static constexpr uint32_t STATE_TAG = 0x50510101;
+
+	BlockBuffer< BLOCK_SIZE > mBlockBuffer;
+	uint32_t mState[ 8 ];
+
+	static constexpr uint32_t __rotateRight( uint32_t value, unsigned count )
+	{
+		return ( value >> count ) | ( value << ( 32 - count ) );
+	}
+
+	static constexpr uint32_t __loadBigEndian( const uint8_t* bytes )
+	{
+		return ( uint32_t( bytes[ 0 ] ) << 24 ) | ( uint32_t( bytes[ 1 ] ) << 16 )
+			| ( uint32_t( bytes[ 2 ] ) << 8 ) | ( uint32_t( bytes[ 3 ] ) << 0 );
+	}
+
+	static constexpr void __storeBigEndian( uint8_t* bytes, uint32_t value )
+	{
+		bytes[ 0 ] = uint8_t( value >> 24 );
+		bytes[ 1 ] = uint8_t( value >> 16 );
+		bytes[ 2 ] = uint8_t( value >> 8 );
+		bytes[ 3 ] = uint8_t( value >> 0 );
+	}
+
+	/**
+	 * Apply the 64 rounds to {@param state} given the message schedule with
+	 * the round constants already added. Word t of the schedule is read from
+	 * scheduleWithConstants[ t * stride ].
+	 */
+	static constexpr void __rounds( uint32_t* state, const uint32_t* scheduleWithConstants, uint64_t stride )
+	{
+		uint32_t a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+		uint32_t e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+
+		for ( uint64_t round( 0 ); round < 64; ++round )
+		{
+			uint32_t temporary1 = h
+				+ ( __rotateRight( e, 6 ) ^ __rotateRight( e, 11 ) ^ __rotateRight( e, 25 ) )
+				+ ( ( e & f ) ^ ( ~e & g ) )
+				+ scheduleWithConstants[ round * stride ];
+			uint32_t temporary2 = ( __rotateRight( a, 2 ) ^ __rotateRight( a, 13 ) ^ __rotateRight( a, 22 ) )
+				+ ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + temporary1;
+			d = c;
+			c = b;
+			b = a;
+			a = temporary1 + temporary2;
+		}
+
+		state[ 0 ] += a; state[ 1 ] += b; state[ 2 ] += c; state[ 3 ] += d;
+		state[ 4 ] += e; state[ 5 ] += f; state[ 6 ] += g; state[ 7 ] += h;
+	}
+
+	static constexpr void __compressPortable( uint32_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		uint32_t schedule[ 64 ] = { 0 };
+
+		for ( ; blockCount--; blocks += BLOCK_SIZE )
+		{
+			for ( uint64_t index( 0 ); index < 16; ++index )
+			{
+				schedule[ index ] = __loadBigEndian( blocks + 4 * index );
+			}
+
+			for ( uint64_t index( 16 ); index < 64; ++index )
+			{
+				uint32_t word15 = schedule[ index - 15 ];
+				uint32_t word2 = schedule[ index - 2 ];
+				schedule[ index ] = schedule[ index - 16 ] + schedule[ index - 7 ]
+					+ ( __rotateRight( word15, 7 ) ^ __rotateRight( word15, 18 ) ^ ( word15 >> 3 ) )
+					+ ( __rotateRight( word2, 17 ) ^ __rotateRight( word2, 19 ) ^ ( word2 >> 10 ) );
+			}
+
+			for ( uint64_t index( 0 ); index < 64; ++index )
+			{
+				schedule[ index ] += ROUND_CONSTANT[ index ];
+			}
+
+			__rounds( state, schedule, 1 );
+		}
+	}
+
+#if defined( PIQUE_SHA256_X86 )
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __sigmaAvx2( __m256i word, int rotate0, int rotate1, int shift )
+	{
+		return _mm256_xor_si256(
+			_mm256_xor_si256(
+				_mm256_or_si256( _mm256_srli_epi32( word, rotate0 ), _mm256_slli_epi32( word, 32 - rotate0 ) ),
+				_mm256_or_si256( _mm256_srli_epi32( word, rotate1 ), _mm256_slli_epi32( word, 32 - rotate1 ) ) ),
+			_mm256_srli_epi32( word, shift ) );
+	}
+
+	/**
+	 * Expand the message schedule of eight consecutive blocks at once, one block
+	 * per 32-bit lane, then run the rounds of each block from the transposed
+	 * schedule. The schedule does not depend on the chaining state, so only the
+	 * rounds remain serial.
+	 */
+	__attribute__(( target( "avx2,bmi2" ) ))
+	static void __compressAvx2( uint32_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		alignas( 32 ) uint32_t schedule[ 64 * 8 ];
+		const __m256i byteSwap = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 );
+		const __m256i blockOffset = _mm256_setr_epi32( 0, 16, 32, 48, 64, 80, 96, 112 );
+
+		for ( ; 8 <= blockCount; blockCount -= 8, blocks += 8 * BLOCK_SIZE )
+		{
+			__m256i word[ 64 ];
+			for ( int index( 0 ); index < 16; ++index )
+			{
+				word[ index ] = _mm256_shuffle_epi8( _mm256_i32gather_epi32(
+					reinterpret_cast< const int* >( blocks ) + index, blockOffset, 4 ), byteSwap );
+			}
+
+			for ( int index( 16 ); index < 64; ++index )
+			{
+				word[ index ] = _mm256_add_epi32(
+					_mm256_add_epi32( word[ index - 16 ], word[ index - 7 ] ),
+					_mm256_add_epi32( __sigmaAvx2( word[ index - 15 ], 7, 18, 3 ), __sigmaAvx2( word[ index - 2 ], 17, 19, 10 ) ) );
+			}
+
+			for ( int index( 0 ); index < 64; ++index )
+			{
+				_mm256_store_si256( reinterpret_cast< __m256i* >( schedule + 8 * index ),
+					_mm256_add_epi32( word[ index ], _mm256_set1_epi32( int( ROUND_CONSTANT[ index ] ) ) ) );
+			}
+
+			for ( int lane( 0 ); lane < 8; ++lane )
+			{
+				__rounds( state, schedule + lane, 8 );
+			}
+		}
+
+		__compressPortable( state, blocks, blockCount );
+	}
+
+	__attribute__(( target( "sha,sse4.1" ) ))
+	static __m128i __scheduleShaExtensions( __m128i words0, __m128i words1, __m128i words2, __m128i words3 )
+	{
+		return _mm_sha256msg2_epu32(
+			_mm_add_epi32( _mm_sha256msg1_epu32( words0, words1 ), _mm_alignr_epi8( words3, words2, 4 ) ),
+			words3 );
+	}
+
+	__attribute__(( target( "sha,sse4.1" ) ))
+	static void __roundsShaExtensions( __m128i& abef, __m128i& cdgh, __m128i words, uint64_t group )
+	{
+		__m128i message = _mm_add_epi32( words,
+			_mm_loadu_si128( reinterpret_cast< const __m128i* >( ROUND_CONSTANT + 4 * group ) ) );
+		cdgh = _mm_sha256rnds2_epu32( cdgh, abef, message );
+		abef = _mm_sha256rnds2_epu32( abef, cdgh, _mm_shuffle_epi32( message, 0x0E ) );
+	}
+
+	__attribute__(( target( "sha,sse4.1" ) ))
+	static void __compressShaExtensions( uint32_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		const __m128i byteSwap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+
+		// Rearrange the state into the ABEF/CDGH layout used by SHA256RNDS2.
+		__m128i dcba = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast< const __m128i* >( state + 0 ) ), 0xB1 );
+		__m128i hgfe = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast< const __m128i* >( state + 4 ) ), 0x1B );
+		__m128i abef = _mm_alignr_epi8( dcba, hgfe, 8 );
+		__m128i cdgh = _mm_blend_epi16( hgfe, dcba, 0xF0 );
+
+		for ( ; blockCount--; blocks += BLOCK_SIZE )
+		{
+			const __m128i savedAbef = abef;
+			const __m128i savedCdgh = cdgh;
+
+			__m128i words0 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( blocks + 0 ) ), byteSwap );
+			__m128i words1 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( blocks + 16 ) ), byteSwap );
+			__m128i words2 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( blocks + 32 ) ), byteSwap );
+			__m128i words3 = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( blocks + 48 ) ), byteSwap );
+
+			__roundsShaExtensions( abef, cdgh, words0, 0 );
+			__roundsShaExtensions( abef, cdgh, words1, 1 );
+			__roundsShaExtensions( abef, cdgh, words2, 2 );
+			__roundsShaExtensions( abef, cdgh, words3, 3 );
+
+			for ( uint64_t group( 4 ); group < 16; group += 4 )
+			{
+				words0 = __scheduleShaExtensions( words0, words1, words2, words3 );
+				__roundsShaExtensions( abef, cdgh, words0, group + 0 );
+				words1 = __scheduleShaExtensions( words1, words2, words3, words0 );
+				__roundsShaExtensions( abef, cdgh, words1, group + 1 );
+				words2 = __scheduleShaExtensions( words2, words3, words0, words1 );
+				__roundsShaExtensions( abef, cdgh, words2, group + 2 );
+				words3 = __scheduleShaExtensions( words3, words0, words1, words2 );
+				__roundsShaExtensions( abef, cdgh, words3, group + 3 );
+			}
+
+			abef = _mm_add_epi32( abef, savedAbef );
+			cdgh = _mm_add_epi32( cdgh, savedCdgh );
+		}
+
+		__m128i feba = _mm_shuffle_epi32( abef, 0x1B );
+		__m128i dchg = _mm_shuffle_epi32( cdgh, 0xB1 );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( state + 0 ), _mm_blend_epi16( feba, dchg, 0xF0 ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( state + 4 ), _mm_alignr_epi8( dchg, feba, 8 ) );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __rotateRightAvx2( __m256i word, int count )
+	{
+		return _mm256_or_si256( _mm256_srli_epi32( word, count ), _mm256_slli_epi32( word, 32 - count ) );
+	}
+
+	/**
+	 * Compress {@param blockCount} consecutive blocks for each of eight independent
+	 * states, one state per 32-bit lane. Lanes without blocks are masked out.
+	 * The lane layout is described at __digestMessagesInLanes().
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __compressLanesAvx2( uint32_t* laneState, const uint8_t* const* laneBlocks, uint64_t blockCount )
+	{
+		const uint64_t LANES = 8;
+		const __m256i byteSwap = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 );
+		const uint8_t* base = ZERO_BLOCK;
+
+		// Every lane is gathered relative to the zero block, which masked lanes read forever.
+		alignas( 32 ) int64_t offset[ LANES ];
+		alignas( 32 ) int64_t stride[ LANES ];
+		alignas( 32 ) int32_t active[ LANES ];
+		for ( uint64_t lane( 0 ); lane < LANES; ++lane )
+		{
+			bool isActive = ( nullptr != laneBlocks[ lane ] );
+			offset[ lane ] = isActive ? int64_t( uintptr_t( laneBlocks[ lane ] ) - uintptr_t( base ) ) : 0;
+			stride[ lane ] = isActive ? BLOCK_SIZE : 0;
+			active[ lane ] = isActive ? -1 : 0;
+		}
+
+		__m256i offsetLow = _mm256_load_si256( reinterpret_cast< const __m256i* >( offset + 0 ) );
+		__m256i offsetHigh = _mm256_load_si256( reinterpret_cast< const __m256i* >( offset + 4 ) );
+		const __m256i strideLow = _mm256_load_si256( reinterpret_cast< const __m256i* >( stride + 0 ) );
+		const __m256i strideHigh = _mm256_load_si256( reinterpret_cast< const __m256i* >( stride + 4 ) );
+		const __m256i activeMask = _mm256_load_si256( reinterpret_cast< const __m256i* >( active ) );
+
+		__m256i state[ 8 ];
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			state[ index ] = _mm256_load_si256( reinterpret_cast< const __m256i* >( laneState + index * LANES ) );
+		}
+
+		for ( ; blockCount--; )
+		{
+			__m256i word[ 16 ];
+			for ( int index( 0 ); index < 16; ++index )
+			{
+				const int* wordBase = reinterpret_cast< const int* >( base + 4 * index );
+				word[ index ] = _mm256_shuffle_epi8( _mm256_set_m128i(
+					_mm256_i64gather_epi32( wordBase, offsetHigh, 1 ),
+					_mm256_i64gather_epi32( wordBase, offsetLow, 1 ) ), byteSwap );
+			}
+
+			offsetLow = _mm256_add_epi64( offsetLow, strideLow );
+			offsetHigh = _mm256_add_epi64( offsetHigh, strideHigh );
+
+			__m256i a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+			__m256i e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+
+			for ( int round( 0 ); round < 64; ++round )
+			{
+				if ( 16 <= round )
+				{
+					__m256i word15 = word[ ( round - 15 ) & 15 ];
+					__m256i word2 = word[ ( round - 2 ) & 15 ];
+					word[ round & 15 ] = _mm256_add_epi32(
+						_mm256_add_epi32( word[ round & 15 ], word[ ( round - 7 ) & 15 ] ),
+						_mm256_add_epi32(
+							_mm256_xor_si256( _mm256_xor_si256( __rotateRightAvx2( word15, 7 ), __rotateRightAvx2( word15, 18 ) ), _mm256_srli_epi32( word15, 3 ) ),
+							_mm256_xor_si256( _mm256_xor_si256( __rotateRightAvx2( word2, 17 ), __rotateRightAvx2( word2, 19 ) ), _mm256_srli_epi32( word2, 10 ) ) ) );
+				}
+
+				__m256i temporary1 = _mm256_add_epi32(
+					_mm256_add_epi32( h, _mm256_xor_si256( _mm256_xor_si256( __rotateRightAvx2( e, 6 ), __rotateRightAvx2( e, 11 ) ), __rotateRightAvx2( e, 25 ) ) ),
+					_mm256_add_epi32(
+						_mm256_xor_si256( _mm256_and_si256( e, f ), _mm256_andnot_si256( e, g ) ),
+						_mm256_add_epi32( word[ round & 15 ], _mm256_set1_epi32( int( ROUND_CONSTANT[ round ] ) ) ) ) );
+				__m256i temporary2 = _mm256_add_epi32(
+					_mm256_xor_si256( _mm256_xor_si256( __rotateRightAvx2( a, 2 ), __rotateRightAvx2( a, 13 ) ), __rotateRightAvx2( a, 22 ) ),
+					_mm256_or_si256( _mm256_and_si256( a, b ), _mm256_and_si256( c, _mm256_or_si256( a, b ) ) ) );
+
+				h = g;
+				g = f;
+				f = e;
+				e = _mm256_add_epi32( d, temporary1 );
+				d = c;
+				c = b;
+				b = a;
+				a = _mm256_add_epi32( temporary1, temporary2 );
+			}
+
+			const __m256i working[ 8 ] = { a, b, c, d, e, f, g, h };
+			for ( uint64_t index( 0 ); index < 8; ++index )
+			{
+				state[ index ] = _mm256_blendv_epi8( state[ index ], _mm256_add_epi32( state[ index ], working[ index ] ), activeMask );
+			}
+		}
+
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			_mm256_store_si256( reinterpret_cast< __m256i* >( laneState + index * LANES ), state[ index ] );
+		}
+	}
+
+	/**
+	 * Compress {@param blockCount} consecutive blocks for each of sixteen independent
+	 * states, one state per 32-bit lane. Lanes without blocks are masked out.
+	 * The lane layout is described at __digestMessagesInLanes().
+	 */
+	__attribute__(( target( "avx512f,avx512bw" ) ))
+	static void __compressLanesAvx512( uint32_t* laneState, const uint8_t* const* laneBlocks, uint64_t blockCount )
+	{
+		const uint64_t LANES = 16;
+		const __m512i byteSwap = _mm512_set_epi8(
+			60, 61, 62, 63, 56, 57, 58, 59, 52, 53, 54, 55, 48, 49, 50, 51,
+			44, 45, 46, 47, 40, 41, 42, 43, 36, 37, 38, 39, 32, 33, 34, 35,
+			28, 29, 30, 31, 24, 25, 26, 27, 20, 21, 22, 23, 16, 17, 18, 19,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 );
+		const uint8_t* base = ZERO_BLOCK;
+
+		// Every lane is gathered relative to the zero block, which masked lanes read forever.
+		alignas( 64 ) int64_t offset[ LANES ];
+		alignas( 64 ) int64_t stride[ LANES ];
+		__mmask16 activeMask = 0;
+		for ( uint64_t lane( 0 ); lane < LANES; ++lane )
+		{
+			bool isActive = ( nullptr != laneBlocks[ lane ] );
+			offset[ lane ] = isActive ? int64_t( uintptr_t( laneBlocks[ lane ] ) - uintptr_t( base ) ) : 0;
+			stride[ lane ] = isActive ? BLOCK_SIZE : 0;
+			activeMask |= __mmask16( isActive ? 1 : 0 ) << lane;
+		}
+
+		__m512i offsetLow = _mm512_load_si512( offset + 0 );
+		__m512i offsetHigh = _mm512_load_si512( offset + 8 );
+		const __m512i strideLow = _mm512_load_si512( stride + 0 );
+		const __m512i strideHigh = _mm512_load_si512( stride + 8 );
+
+		__m512i state[ 8 ];
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			state[ index ] = _mm512_load_si512( laneState + index * LANES );
+		}
+
+		for ( ; blockCount--; )
+		{
+			__m512i word[ 16 ];
+			for ( int index( 0 ); index < 16; ++index )
+			{
+				const void* wordBase = base + 4 * index;
+				word[ index ] = _mm512_shuffle_epi8( _mm512_inserti64x4(
+					_mm512_castsi256_si512( _mm512_i64gather_epi32( offsetLow, wordBase, 1 ) ),
+					_mm512_i64gather_epi32( offsetHigh, wordBase, 1 ), 1 ), byteSwap );
+			}
+
+			offsetLow = _mm512_add_epi64( offsetLow, strideLow );
+			offsetHigh = _mm512_add_epi64( offsetHigh, strideHigh );
+
+			__m512i a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+			__m512i e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+
+			for ( int round( 0 ); round < 64; ++round )
+			{
+				if ( 16 <= round )
+				{
+					__m512i word15 = word[ ( round - 15 ) & 15 ];
+					__m512i word2 = word[ ( round - 2 ) & 15 ];
+					// 0x96 selects the three way exclusive or.
+					word[ round & 15 ] = _mm512_add_epi32(
+						_mm512_add_epi32( word[ round & 15 ], word[ ( round - 7 ) & 15 ] ),
+						_mm512_add_epi32(
+							_mm512_ternarylogic_epi32( _mm512_ror_epi32( word15, 7 ), _mm512_ror_epi32( word15, 18 ), _mm512_srli_epi32( word15, 3 ), 0x96 ),
+							_mm512_ternarylogic_epi32( _mm512_ror_epi32( word2, 17 ), _mm512_ror_epi32( word2, 19 ), _mm512_srli_epi32( word2, 10 ), 0x96 ) ) );
+				}
+
+				// 0xCA selects the choose function and 0xE8 the majority function.
+				__m512i temporary1 = _mm512_add_epi32(
+					_mm512_add_epi32( h, _mm512_ternarylogic_epi32( _mm512_ror_epi32( e, 6 ), _mm512_ror_epi32( e, 11 ), _mm512_ror_epi32( e, 25 ), 0x96 ) ),
+					_mm512_add_epi32(
+						_mm512_ternarylogic_epi32( e, f, g, 0xCA ),
+						_mm512_add_epi32( word[ round & 15 ], _mm512_set1_epi32( int( ROUND_CONSTANT[ round ] ) ) ) ) );
+				__m512i temporary2 = _mm512_add_epi32(
+					_mm512_ternarylogic_epi32( _mm512_ror_epi32( a, 2 ), _mm512_ror_epi32( a, 13 ), _mm512_ror_epi32( a, 22 ), 0x96 ),
+					_mm512_ternarylogic_epi32( a, b, c, 0xE8 ) );
+
+				h = g;
+				g = f;
+				f = e;
+				e = _mm512_add_epi32( d, temporary1 );
+				d = c;
+				c = b;
+				b = a;
+				a = _mm512_add_epi32( temporary1, temporary2 );
+			}
+
+			const __m512i working[ 8 ] = { a, b, c, d, e, f, g, h };
+			for ( uint64_t index( 0 ); index < 8; ++index )
+			{
+				state[ index ] = _mm512_mask_add_epi32( state[ index ], activeMask, state[ index ], working[ index ] );
+			}
+		}
+
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			_mm512_store_si512( laneState + index * LANES, state[ index ] );
+		}
+	}
+#endif
+
+	/**
+	 * Digest each message of the batch in turn.
+	 */
+	static void __digestMessagesSerially( BatchMessage* messages, uint64_t messageCount )
+	{
+		HashFunction< SHA256, 64, 32 >::digestMessages( messages, messageCount );
+	}
+
+	/**
+	 * Digest a batch of independent messages, LANES at a time. The lane state is
+	 * transposed, word i of lane l lives at laneState[ i * LANES + l ], and every
+	 * call to LaneCompress advances each lane over a run of consecutive blocks.
+	 * A lane whose message is exhausted is refilled from the batch; once the batch
+	 * runs dry its block pointer is set to null and the kernel masks it out.
+	 */
+	template < uint64_t LANES, LaneCompressFunction LaneCompress >
+	static void __digestMessagesInLanes( BatchMessage* messages, uint64_t messageCount )
+	{
+		struct Lane
+		{
+			BatchMessage* batchMessage;
+			const uint8_t* blocks;
+			uint64_t blockCount;
+			uint64_t paddingBlockCount;
+			uint8_t padding[ 2 * BLOCK_SIZE ];
+		};
+
+		alignas( 64 ) uint32_t laneState[ 8 * LANES ];
+		const uint8_t* laneBlocks[ LANES ];
+		Lane lanes[ LANES ];
+		uint64_t nextMessage = 0;
+		uint64_t activeLaneCount = 0;
+
+		// Load the next message of the batch into {@param lane}, or park the lane.
+		auto loadLane = [ & ]( uint64_t lane )
+		{
+			if ( messageCount == nextMessage )
+			{
+				lanes[ lane ].batchMessage = nullptr;
+				return;
+			}
+
+			Lane& current = lanes[ lane ];
+			current.batchMessage = messages + nextMessage++;
+			const uint8_t* message = current.batchMessage->message;
+			uint64_t messageLength = ( nullptr == message ) ? 0 : current.batchMessage->messageLength;
+			uint64_t wholeBlockCount = messageLength / BLOCK_SIZE;
+			uint64_t remainder = messageLength % BLOCK_SIZE;
+			uint64_t messageBits = messageLength * 8;
+
+			// The trailing bytes and the padding form one or two blocks of their own.
+			current.paddingBlockCount = ( remainder < BLOCK_SIZE - 8 ) ? 1 : 2;
+			std::memset( current.padding, 0, sizeof( current.padding ) );
+			if ( 0 != remainder )
+			{
+				std::memcpy( current.padding, message + wholeBlockCount * BLOCK_SIZE, remainder );
+			}
+
+			current.padding[ remainder ] = 0x80;
+			__storeBigEndian( current.padding + current.paddingBlockCount * BLOCK_SIZE - 8, uint32_t( messageBits >> 32 ) );
+			__storeBigEndian( current.padding + current.paddingBlockCount * BLOCK_SIZE - 4, uint32_t( messageBits ) );
+
+			if ( 0 != wholeBlockCount )
+			{
+				current.blocks = message;
+				current.blockCount = wholeBlockCount;
+			}
+			else
+			{
+				current.blocks = current.padding;
+				current.blockCount = current.paddingBlockCount;
+				current.paddingBlockCount = 0;
+			}
+
+			for ( uint64_t index( 0 ); index < 8; ++index )
+			{
+				laneState[ index * LANES + lane ] = INITIAL_STATE[ index ];
+			}
+
+			++activeLaneCount;
+		};
+
+		for ( uint64_t lane( 0 ); lane < LANES; ++lane )
+		{
+			loadLane( lane );
+		}
+
+		while ( 0 != activeLaneCount )
+		{
+			// Advance every active lane by the shortest run so no lane crosses its run.
+			uint64_t step = UINT64_MAX;
+			for ( uint64_t lane( 0 ); lane < LANES; ++lane )
+			{
+				laneBlocks[ lane ] = nullptr;
+				if ( nullptr != lanes[ lane ].batchMessage )
+				{
+					laneBlocks[ lane ] = lanes[ lane ].blocks;
+					step = std::min( step, lanes[ lane ].blockCount );
+				}
+			}
+
+			LaneCompress( laneState, laneBlocks, step );
+
+			for ( uint64_t lane( 0 ); lane < LANES; ++lane )
+			{
+				Lane& current = lanes[ lane ];
+				if ( nullptr == current.batchMessage )
+				{
+					continue;
+				}
+
+				current.blocks += step * BLOCK_SIZE;
+				current.blockCount -= step;
+				if ( 0 != current.blockCount )
+				{
+					continue;
+				}
+
+				if ( 0 != current.paddingBlockCount )
+				{
+					current.blocks = current.padding;
+					current.blockCount = current.paddingBlockCount;
+					current.paddingBlockCount = 0;
+					continue;
+				}
+
+				for ( uint64_t index( 0 ); index < 8; ++index )
+				{
+					__storeBigEndian( current.batchMessage->messageDigest + 4 * index, laneState[ index * LANES + lane ] );
+				}
+
+				--activeLaneCount;
+				loadLane( lane );
+			}
+		}
+	}
+
+	/**
+	 * The kernels chosen for the enabled processor features.
+	 */
+	struct DispatchTable
+	{
+		std::atomic< CompressFunction > mCompress;
+		std::atomic< BatchFunction > mDigestMessages;
+	};
+
+	static DispatchTable& __dispatchTable()
+	{
+		static DispatchTable dispatchTable;
+		return dispatchTable;
+	}
+
+	static void __selectKernels()
+	{
+		CompressFunction compress = __compressPortable;
+		BatchFunction digestBatch = __digestMessagesSerially;
+#if defined( PIQUE_SHA256_X86 )
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 | CpuFeatures::BMI2 ) )
+		{
+			compress = __compressAvx2;
+			digestBatch = __digestMessagesInLanes< 8, __compressLanesAvx2 >;
+		}
+
+		// A single SHA extension stream outruns eight AVX2 lanes but not sixteen AVX-512 lanes.
+		if ( CpuFeatures::supports( CpuFeatures::SHA | CpuFeatures::SSE4_1 ) )
+		{
+			compress = __compressShaExtensions;
+			digestBatch = __digestMessagesSerially;
+		}
+
+		if ( CpuFeatures::supports( CpuFeatures::AVX512F | CpuFeatures::AVX512BW ) )
+		{
+			digestBatch = __digestMessagesInLanes< 16, __compressLanesAvx512 >;
+		}
+#endif
+		__dispatchTable().mCompress.store( compress, std::memory_order_relaxed );
+		__dispatchTable().mDigestMessages.store( digestBatch, std::memory_order_relaxed );
+	}
+
+	static const DispatchTable& __kernels()
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		return __dispatchTable();
+	}
+
+	/**
+	 * Compress {@param blockCount} blocks with the kernel chosen for the
+	 * enabled processor features.
+	 */
+	static void __compress( uint32_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		Instrumentation::count( Instrumentation::HASH_BLOCKS_COMPRESSED, blockCount );
+		__kernels().mCompress.load( std::memory_order_relaxed )( state, blocks, blockCount );
+	}
+
+	/**
+	 * Pad the message and output the digest without modifying this instance.
+	 */
+	void __digest( uint8_t* messageDigest ) const
+	{
+		uint32_t state[ 8 ];
+		uint8_t blocks[ 2 * BLOCK_SIZE ] = { 0 };
+		uint64_t blockCount = ( mBlockBuffer.bufferLength() < BLOCK_SIZE - 8 ) ? 1 : 2;
+		uint64_t messageBits = mBlockBuffer.messageLength() * 8;
+
+		std::memcpy( state, mState, sizeof( state ) );
+		std::memcpy( blocks, mBlockBuffer.buffer(), mBlockBuffer.bufferLength() );
+		blocks[ mBlockBuffer.bufferLength() ] = 0x80;
+		__storeBigEndian( blocks + blockCount * BLOCK_SIZE - 8, uint32_t( messageBits >> 32 ) );
+		__storeBigEndian( blocks + blockCount * BLOCK_SIZE - 4, uint32_t( messageBits ) );
+
+		__compress( state, blocks, blockCount );
+
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			__storeBigEndian( messageDigest + 4 * index, state[ index ] );
+		}
+	}
+
+	/**
+	 * Hash {@param message} with the portable compression only, so that it
+	 * may be evaluated in a constant expression.
+	 */
+	static constexpr std::array< uint8_t, DIGEST_SIZE > __digestConstant( std::string_view message )
+	{
+		uint32_t state[ 8 ] = { 0 };
+		uint8_t blocks[ 2 * BLOCK_SIZE ] = { 0 };
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			state[ index ] = INITIAL_STATE[ index ];
+		}
+
+		uint64_t offset = 0;
+		for ( ; offset + BLOCK_SIZE <= message.size(); offset += BLOCK_SIZE )
+		{
+			for ( uint64_t index( 0 ); index < BLOCK_SIZE; ++index )
+			{
+				blocks[ index ] = uint8_t( message[ offset + index ] );
+			}
+
+			__compressPortable( state, blocks, 1 );
+		}
+
+		uint64_t tailLength = message.size() - offset;
+		uint64_t blockCount = ( tailLength < BLOCK_SIZE - 8 ) ? 1 : 2;
+		uint64_t messageBits = uint64_t( message.size() ) * 8;
+		for ( uint64_t index( 0 ); index < 2 * BLOCK_SIZE; ++index )
+		{
+			blocks[ index ] = ( index < tailLength ) ? uint8_t( message[ offset + index ] ) : 0;
+		}
+
+		blocks[ tailLength ] = 0x80;
+		__storeBigEndian( blocks + blockCount * BLOCK_SIZE - 8, uint32_t( messageBits >> 32 ) );
+		__storeBigEndian( blocks + blockCount * BLOCK_SIZE - 4, uint32_t( messageBits ) );
+		__compressPortable( state, blocks, blockCount );
+
+		std::array< uint8_t, DIGEST_SIZE > messageDigest = { 0 };
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			__storeBigEndian( messageDigest.data() + 4 * index, state[ index ] );
+		}
+
+		return messageDigest;
+	}
+
+	void __update( const uint8_t* message, uint64_t messageLength )
+	{
+		mBlockBuffer.update( message, messageLength, [ this ]( const uint8_t* blocks, uint64_t blockCount )
+		{
+			__compress( mState, blocks, blockCount );
+		} );
+	}
+
+	void __reset()
+	{
+		std::memcpy( mState, INITIAL_STATE, sizeof( mState ) );
+		mBlockBuffer.reset();
+	}
+
+	uint64_t __serialize( uint8_t* state ) const
+	{
+		__storeBigEndian( state, STATE_TAG );
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			__storeBigEndian( state + 4 + 4 * index, mState[ index ] );
+		}
+
+		return 36 + mBlockBuffer.serialize( state + 36 );
+	}
+
+	bool __deserialize( const uint8_t* state, uint64_t stateSize )
+	{
+		BlockBuffer< BLOCK_SIZE > blockBuffer;
+		if ( ( stateSize < 36 ) or ( STATE_TAG != __loadBigEndian( state ) )
+			or not blockBuffer.deserialize( state + 36, stateSize - 36 ) )
+		{
+			return false;
+		}
+
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			mState[ index ] = __loadBigEndian( state + 4 + 4 * index );
+		}
+
+		mBlockBuffer = blockBuffer;
+		return true;
+	}
+
+public:
+	/**
+	 * Largest length of a serialized state: the tag, the eight state words and
+	 * the block buffer.
+	 */
+	static constexpr uint64_t STATE_SIZE = 36 + BlockBuffer< BLOCK_SIZE >::STATE_SIZE;
+
+	/**
+	 * Construct a SHA-256 instance in its initial state.
+	 */
+	SHA256()
+	{
+		__reset();
+	}
+
+	/**
+	 * Compute the digests of a batch of independent messages without maintaining
+	 * state information. Up to sixteen messages are hashed at once, one per SIMD
+	 * lane, which pays off most for large batches of short messages. Digests are
+	 * identical to those produced by digestMessage().
+	 * @param messages Pointer to an array of messages to digest.
+	 * @param messageCount Number of messages in {@param messages}.
+	 */
+	static void digestMessages( BatchMessage* messages, uint64_t messageCount )
+	{
+		__kernels().mDigestMessages.load( std::memory_order_relaxed )( messages, messageCount );
+	}
+};
+
+} // namespace Pique
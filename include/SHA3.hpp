@@ -0,0 +1,769 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_SHA3_X86 1
+#endif
+
+#include "CpuFeatures.hpp"
+#include "HashFunction.hpp"
+#include "Instrumentation.hpp"
+
+namespace Pique
+{
+
+/**
+ * The Keccak-f[1600] permutation shared by SHA-3 and SHAKE.
+ *
+ * A single state is permuted by a portable kernel using the lane complementing
+ * transform: six lanes are kept complemented during the rounds, which turns
+ * most of the NOT operations of chi into plain AND and OR. Independent states
+ * are permuted four at a time across AVX2 lanes or eight at a time across
+ * AVX-512 lanes, one state per 64-bit lane, as allowed by CpuFeatures.
+ */
+class KeccakPermutation final
+{
+private:
+	template < uint64_t Rate, uint8_t DomainPadding, uint64_t DigestSize >
+	friend class KeccakSponge;
+
+	/**
+	 * Permute several states at once. The states are transposed: word i of
+	 * state l lives at laneState[ i * laneCount + l ].
+	 */
+	typedef void ( *PermuteLanesFunction )( uint64_t* laneState );
+
+	static constexpr uint64_t WIDTH = 200;
+	static constexpr uint64_t LANE_COUNT = 25;
+
+	/**
+	 * The most states permuted by one call to a PermuteLanesFunction.
+	 */
+	static constexpr uint64_t MAXIMUM_LANES = 8;
+
+	static constexpr uint64_t ROUND_CONSTANT[ 24 ] = {
+		0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+		0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+		0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+		0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+		0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+		0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL };
+
+	/**
+	 * The kernel chosen for the enabled processor features and the number of
+	 * states it permutes at once. A null kernel leaves batches to the single
+	 * state kernel.
+	 */
+	struct Kernels
+	{
+		PermuteLanesFunction mPermuteLanes;
+		uint64_t mLaneCount;
+	};
+
+	static uint64_t __rotateLeft( uint64_t value, unsigned count )
+	{
+		return ( value << count ) | ( value >> ( ( 64 - count ) & 63 ) );
+	}
+
+	static uint64_t __loadLittleEndian( const uint8_t* bytes )
+	{
+		uint64_t value = 0;
+		for ( size_t index( 8 ); index--; )
+		{
+			value = ( value << 8 ) | bytes[ index ];
+		}
+
+		return value;
+	}
+
+	static void __storeLittleEndian( uint8_t* bytes, uint64_t value )
+	{
+		for ( size_t index( -1 ); ++index < 8; value >>= 8 )
+		{
+			bytes[ index ] = uint8_t( value );
+		}
+	}
+
+	/**
+	 * Complement the lanes kept complemented by __roundComplemented().
+	 */
+	static void __complementLanes( uint64_t* state )
+	{
+		state[ 1 ] = ~state[ 1 ];
+		state[ 2 ] = ~state[ 2 ];
+		state[ 8 ] = ~state[ 8 ];
+		state[ 12 ] = ~state[ 12 ];
+		state[ 17 ] = ~state[ 17 ];
+		state[ 20 ] = ~state[ 20 ];
+	}
+
+	/**
+	 * One round from {@param a} into {@param e}, both with lanes 1, 2, 8, 12,
+	 * 17 and 20 complemented. Each plane of chi needs a single NOT this way.
+	 */
+	static void __roundComplemented( const uint64_t* a, uint64_t* e, uint64_t roundConstant )
+	{
+		uint64_t c0 = a[ 0 ] ^ a[ 5 ] ^ a[ 10 ] ^ a[ 15 ] ^ a[ 20 ];
+		uint64_t c1 = a[ 1 ] ^ a[ 6 ] ^ a[ 11 ] ^ a[ 16 ] ^ a[ 21 ];
+		uint64_t c2 = a[ 2 ] ^ a[ 7 ] ^ a[ 12 ] ^ a[ 17 ] ^ a[ 22 ];
+		uint64_t c3 = a[ 3 ] ^ a[ 8 ] ^ a[ 13 ] ^ a[ 18 ] ^ a[ 23 ];
+		uint64_t c4 = a[ 4 ] ^ a[ 9 ] ^ a[ 14 ] ^ a[ 19 ] ^ a[ 24 ];
+		uint64_t d0 = c4 ^ __rotateLeft( c1, 1 );
+		uint64_t d1 = c0 ^ __rotateLeft( c2, 1 );
+		uint64_t d2 = c1 ^ __rotateLeft( c3, 1 );
+		uint64_t d3 = c2 ^ __rotateLeft( c4, 1 );
+		uint64_t d4 = c3 ^ __rotateLeft( c0, 1 );
+
+		uint64_t b0 = a[ 0 ] ^ d0;
+		uint64_t b1 = __rotateLeft( a[ 6 ] ^ d1, 44 );
+		uint64_t b2 = __rotateLeft( a[ 12 ] ^ d2, 43 );
+		uint64_t b3 = __rotateLeft( a[ 18 ] ^ d3, 21 );
+		uint64_t b4 = __rotateLeft( a[ 24 ] ^ d4, 14 );
+		e[ 0 ] = b0 ^ ( b1 | b2 ) ^ roundConstant;
+		e[ 1 ] = b1 ^ ( ~b2 | b3 );
+		e[ 2 ] = b2 ^ ( b3 & b4 );
+		e[ 3 ] = b3 ^ ( b4 | b0 );
+		e[ 4 ] = b4 ^ ( b0 & b1 );
+
+		b0 = __rotateLeft( a[ 3 ] ^ d3, 28 );
+		b1 = __rotateLeft( a[ 9 ] ^ d4, 20 );
+		b2 = __rotateLeft( a[ 10 ] ^ d0, 3 );
+		b3 = __rotateLeft( a[ 16 ] ^ d1, 45 );
+		b4 = __rotateLeft( a[ 22 ] ^ d2, 61 );
+		e[ 5 ] = b0 ^ ( b1 | b2 );
+		e[ 6 ] = b1 ^ ( b2 & b3 );
+		e[ 7 ] = b2 ^ ( b3 | ~b4 );
+		e[ 8 ] = b3 ^ ( b4 | b0 );
+		e[ 9 ] = b4 ^ ( b0 & b1 );
+
+		b0 = __rotateLeft( a[ 1 ] ^ d1, 1 );
+		b1 = __rotateLeft( a[ 7 ] ^ d2, 6 );
+		b2 = __rotateLeft( a[ 13 ] ^ d3, 25 );
+		b3 = __rotateLeft( a[ 19 ] ^ d4, 8 );
+		b4 = __rotateLeft( a[ 20 ] ^ d0, 18 );
+		e[ 10 ] = b0 ^ ( b1 | b2 );
+		e[ 11 ] = b1 ^ ( b2 & b3 );
+		e[ 12 ] = b2 ^ ( ~b3 & b4 );
+		e[ 13 ] = ~b3 ^ ( b4 | b0 );
+		e[ 14 ] = b4 ^ ( b0 & b1 );
+
+		b0 = __rotateLeft( a[ 4 ] ^ d4, 27 );
+		b1 = __rotateLeft( a[ 5 ] ^ d0, 36 );
+		b2 = __rotateLeft( a[ 11 ] ^ d1, 10 );
+		b3 = __rotateLeft( a[ 17 ] ^ d2, 15 );
+		b4 = __rotateLeft( a[ 23 ] ^ d3, 56 );
+		e[ 15 ] = b0 ^ ( b1 & b2 );
+		e[ 16 ] = b1 ^ ( b2 | b3 );
+		e[ 17 ] = b2 ^ ( ~b3 | b4 );
+		e[ 18 ] = ~b3 ^ ( b4 & b0 );
+		e[ 19 ] = b4 ^ ( b0 | b1 );
+
+		b0 = __rotateLeft( a[ 2 ] ^ d2, 62 );
+		b1 = __rotateLeft( a[ 8 ] ^ d3, 55 );
+		b2 = __rotateLeft( a[ 14 ] ^ d4, 39 );
+		b3 = __rotateLeft( a[ 15 ] ^ d0, 41 );
+		b4 = __rotateLeft( a[ 21 ] ^ d1, 2 );
+		e[ 20 ] = b0 ^ ( ~b1 & b2 );
+		e[ 21 ] = ~b1 ^ ( b2 | b3 );
+		e[ 22 ] = b2 ^ ( b3 & b4 );
+		e[ 23 ] = b3 ^ ( b4 | b0 );
+		e[ 24 ] = b4 ^ ( b0 & b1 );
+	}
+
+	/**
+	 * Permute one state of 25 words.
+	 */
+	static void __permute( uint64_t* state )
+	{
+		Instrumentation::count( Instrumentation::HASH_BLOCKS_COMPRESSED );
+		uint64_t next[ LANE_COUNT ];
+
+		__complementLanes( state );
+		for ( size_t round( 0 ); round < 24; round += 2 )
+		{
+			__roundComplemented( state, next, ROUND_CONSTANT[ round ] );
+			__roundComplemented( next, state, ROUND_CONSTANT[ round + 1 ] );
+		}
+
+		__complementLanes( state );
+	}
+
+#if defined( PIQUE_SHA3_X86 )
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __rotateLeftAvx2( __m256i word, int count )
+	{
+		return _mm256_or_si256( _mm256_slli_epi64( word, count ), _mm256_srli_epi64( word, 64 - count ) );
+	}
+
+	/**
+	 * Theta's correction of word {@param source} followed by its rotation by rho.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __rhoAvx2( const __m256i* a, const __m256i* d, size_t source, int offset )
+	{
+		return __rotateLeftAvx2( _mm256_xor_si256( a[ source ], d[ source % 5 ] ), offset );
+	}
+
+	/**
+	 * Chi of one plane, from its five words as placed by pi.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __chiAvx2( __m256i* e, __m256i b0, __m256i b1, __m256i b2, __m256i b3, __m256i b4 )
+	{
+		e[ 0 ] = _mm256_xor_si256( b0, _mm256_andnot_si256( b1, b2 ) );
+		e[ 1 ] = _mm256_xor_si256( b1, _mm256_andnot_si256( b2, b3 ) );
+		e[ 2 ] = _mm256_xor_si256( b2, _mm256_andnot_si256( b3, b4 ) );
+		e[ 3 ] = _mm256_xor_si256( b3, _mm256_andnot_si256( b4, b0 ) );
+		e[ 4 ] = _mm256_xor_si256( b4, _mm256_andnot_si256( b0, b1 ) );
+	}
+
+	__attribute__(( target( "avx2" ) ))
+	static void __roundAvx2( const __m256i* a, __m256i* e, uint64_t roundConstant )
+	{
+		__m256i c[ 5 ], d[ 5 ];
+		for ( size_t x( -1 ); ++x < 5; )
+		{
+			c[ x ] = _mm256_xor_si256( _mm256_xor_si256( _mm256_xor_si256( a[ x ], a[ x + 5 ] ), _mm256_xor_si256( a[ x + 10 ], a[ x + 15 ] ) ), a[ x + 20 ] );
+		}
+
+		for ( size_t x( -1 ); ++x < 5; )
+		{
+			d[ x ] = _mm256_xor_si256( c[ ( x + 4 ) % 5 ], __rotateLeftAvx2( c[ ( x + 1 ) % 5 ], 1 ) );
+		}
+
+		__chiAvx2( e, __rhoAvx2( a, d, 0, 0 ), __rhoAvx2( a, d, 6, 44 ), __rhoAvx2( a, d, 12, 43 ), __rhoAvx2( a, d, 18, 21 ), __rhoAvx2( a, d, 24, 14 ) );
+		__chiAvx2( e + 5, __rhoAvx2( a, d, 3, 28 ), __rhoAvx2( a, d, 9, 20 ), __rhoAvx2( a, d, 10, 3 ), __rhoAvx2( a, d, 16, 45 ), __rhoAvx2( a, d, 22, 61 ) );
+		__chiAvx2( e + 10, __rhoAvx2( a, d, 1, 1 ), __rhoAvx2( a, d, 7, 6 ), __rhoAvx2( a, d, 13, 25 ), __rhoAvx2( a, d, 19, 8 ), __rhoAvx2( a, d, 20, 18 ) );
+		__chiAvx2( e + 15, __rhoAvx2( a, d, 4, 27 ), __rhoAvx2( a, d, 5, 36 ), __rhoAvx2( a, d, 11, 10 ), __rhoAvx2( a, d, 17, 15 ), __rhoAvx2( a, d, 23, 56 ) );
+		__chiAvx2( e + 20, __rhoAvx2( a, d, 2, 62 ), __rhoAvx2( a, d, 8, 55 ), __rhoAvx2( a, d, 14, 39 ), __rhoAvx2( a, d, 15, 41 ), __rhoAvx2( a, d, 21, 2 ) );
+		e[ 0 ] = _mm256_xor_si256( e[ 0 ], _mm256_set1_epi64x( static_cast< long long >( roundConstant ) ) );
+	}
+
+	/**
+	 * Permute four states, one per 64-bit lane.
+	 */
+	__attribute__(( target( "avx2" ) ))
+	static void __permuteLanesAvx2( uint64_t* laneState )
+	{
+		__m256i state[ LANE_COUNT ], next[ LANE_COUNT ];
+		for ( size_t index( -1 ); ++index < LANE_COUNT; )
+		{
+			state[ index ] = _mm256_load_si256( reinterpret_cast< const __m256i* >( laneState ) + index );
+		}
+
+		for ( size_t round( 0 ); round < 24; round += 2 )
+		{
+			__roundAvx2( state, next, ROUND_CONSTANT[ round ] );
+			__roundAvx2( next, state, ROUND_CONSTANT[ round + 1 ] );
+		}
+
+		for ( size_t index( -1 ); ++index < LANE_COUNT; )
+		{
+			_mm256_store_si256( reinterpret_cast< __m256i* >( laneState ) + index, state[ index ] );
+		}
+	}
+
+	__attribute__(( target( "avx512f" ) ))
+	static __m512i __rhoAvx512( const __m512i* a, const __m512i* d, size_t source, int offset )
+	{
+		return _mm512_rolv_epi64( _mm512_xor_si512( a[ source ], d[ source % 5 ] ), _mm512_set1_epi64( offset ) );
+	}
+
+	/**
+	 * Chi of one plane, each word b ^ ( ~b1 & b2 ) in a single ternary logic instruction.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __chiAvx512( __m512i* e, __m512i b0, __m512i b1, __m512i b2, __m512i b3, __m512i b4 )
+	{
+		e[ 0 ] = _mm512_ternarylogic_epi64( b0, b1, b2, 0xd2 );
+		e[ 1 ] = _mm512_ternarylogic_epi64( b1, b2, b3, 0xd2 );
+		e[ 2 ] = _mm512_ternarylogic_epi64( b2, b3, b4, 0xd2 );
+		e[ 3 ] = _mm512_ternarylogic_epi64( b3, b4, b0, 0xd2 );
+		e[ 4 ] = _mm512_ternarylogic_epi64( b4, b0, b1, 0xd2 );
+	}
+
+	/**
+	 * As __roundAvx2(), with theta's parities a pair of ternary logic
+	 * instructions and the rotations native.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __roundAvx512( const __m512i* a, __m512i* e, uint64_t roundConstant )
+	{
+		__m512i c[ 5 ], d[ 5 ];
+		for ( size_t x( -1 ); ++x < 5; )
+		{
+			c[ x ] = _mm512_ternarylogic_epi64( _mm512_ternarylogic_epi64( a[ x ], a[ x + 5 ], a[ x + 10 ], 0x96 ), a[ x + 15 ], a[ x + 20 ], 0x96 );
+		}
+
+		for ( size_t x( -1 ); ++x < 5; )
+		{
+			d[ x ] = _mm512_xor_si512( c[ ( x + 4 ) % 5 ], _mm512_rolv_epi64( c[ ( x + 1 ) % 5 ], _mm512_set1_epi64( 1 ) ) );
+		}
+
+		__chiAvx512( e, __rhoAvx512( a, d, 0, 0 ), __rhoAvx512( a, d, 6, 44 ), __rhoAvx512( a, d, 12, 43 ), __rhoAvx512( a, d, 18, 21 ), __rhoAvx512( a, d, 24, 14 ) );
+		__chiAvx512( e + 5, __rhoAvx512( a, d, 3, 28 ), __rhoAvx512( a, d, 9, 20 ), __rhoAvx512( a, d, 10, 3 ), __rhoAvx512( a, d, 16, 45 ), __rhoAvx512( a, d, 22, 61 ) );
+		__chiAvx512( e + 10, __rhoAvx512( a, d, 1, 1 ), __rhoAvx512( a, d, 7, 6 ), __rhoAvx512( a, d, 13, 25 ), __rhoAvx512( a, d, 19, 8 ), __rhoAvx512( a, d, 20, 18 ) );
+		__chiAvx512( e + 15, __rhoAvx512( a, d, 4, 27 ), __rhoAvx512( a, d, 5, 36 ), __rhoAvx512( a, d, 11, 10 ), __rhoAvx512( a, d, 17, 15 ), __rhoAvx512( a, d, 23, 56 ) );
+		__chiAvx512( e + 20, __rhoAvx512( a, d, 2, 62 ), __rhoAvx512( a, d, 8, 55 ), __rhoAvx512( a, d, 14, 39 ), __rhoAvx512( a, d, 15, 41 ), __rhoAvx512( a, d, 21, 2 ) );
+		e[ 0 ] = _mm512_xor_si512( e[ 0 ], _mm512_set1_epi64( static_cast< long long >( roundConstant ) ) );
+	}
+
+	/**
+	 * Permute eight states, one per 64-bit lane.
+	 */
+	__attribute__(( target( "avx512f" ) ))
+	static void __permuteLanesAvx512( uint64_t* laneState )
+	{
+		__m512i state[ LANE_COUNT ], next[ LANE_COUNT ];
+		for ( size_t index( -1 ); ++index < LANE_COUNT; )
+		{
+			state[ index ] = _mm512_load_si512( laneState + 8 * index );
+		}
+
+		for ( size_t round( 0 ); round < 24; round += 2 )
+		{
+			__roundAvx512( state, next, ROUND_CONSTANT[ round ] );
+			__roundAvx512( next, state, ROUND_CONSTANT[ round + 1 ] );
+		}
+
+		for ( size_t index( -1 ); ++index < LANE_COUNT; )
+		{
+			_mm512_store_si512( laneState + 8 * index, state[ index ] );
+		}
+	}
+#endif
+
+	struct DispatchTable
+	{
+		std::atomic< const Kernels* > mKernels;
+	};
+
+	static DispatchTable& __dispatchTable()
+	{
+		static DispatchTable dispatchTable;
+		return dispatchTable;
+	}
+
+	static void __selectKernels()
+	{
+		static const Kernels PORTABLE_KERNELS = { nullptr, 1 };
+		const Kernels* kernels = &PORTABLE_KERNELS;
+#if defined( PIQUE_SHA3_X86 )
+		static const Kernels AVX2_KERNELS = { __permuteLanesAvx2, 4 };
+		static const Kernels AVX512_KERNELS = { __permuteLanesAvx512, 8 };
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 ) )
+		{
+			kernels = &AVX2_KERNELS;
+		}
+
+		if ( CpuFeatures::supports( CpuFeatures::AVX512F ) )
+		{
+			kernels = &AVX512_KERNELS;
+		}
+#endif
+		__dispatchTable().mKernels.store( kernels, std::memory_order_relaxed );
+	}
+
+	/**
+	 * Get the kernel chosen for the enabled processor features. Reading it
+	 * through one pointer keeps the kernel and its lane count in step.
+	 */
+	static const Kernels& __kernels()
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		return *__dispatchTable().mKernels.load( std::memory_order_relaxed );
+	}
+};
+
+/**
+ * A Keccak[ 1600 - 8 * Rate ] sponge, as specified in FIPS 202, that absorbs
+ * the message Rate bytes at a time and pads it with the domain separation bits
+ * DomainPadding followed by the final bit of pad10*1. A DigestSize of zero
+ * makes it an extendable output function.
+ *
+ * Whole blocks of an update() are absorbed straight from the caller's memory.
+ * Batches of independent messages, see digestMessages(), are absorbed and
+ * squeezed up to eight at a time on the SIMD kernels of KeccakPermutation,
+ * which pays off when many short inputs are expanded into long outputs.
+ */
+template < uint64_t Rate, uint8_t DomainPadding, uint64_t DigestSize >
+class KeccakSponge final : public HashFunction< KeccakSponge< Rate, DomainPadding, DigestSize >, Rate, DigestSize >
+{
+	static_assert( ( ( 136 == Rate ) and ( 0x06 == DomainPadding ) and ( 32 == DigestSize ) )
+		or ( ( 72 == Rate ) and ( 0x06 == DomainPadding ) and ( 64 == DigestSize ) )
+		or ( ( 168 == Rate ) and ( 0x1f == DomainPadding ) and ( 0 == DigestSize ) )
+		or ( ( 136 == Rate ) and ( 0x1f == DomainPadding ) and ( 0 == DigestSize ) ),
+		"The parameters must select SHA3-256, SHA3-512, SHAKE128 or SHAKE256" );
+
+private:
+	typedef HashFunction< KeccakSponge< Rate, DomainPadding, DigestSize >, Rate, DigestSize > Base;
+	friend Base;
+
+	static constexpr uint64_t LANE_COUNT = KeccakPermutation::LANE_COUNT;
+	static constexpr uint64_t RATE_LANES = Rate / 8;
+
+	/**
+	 * Leads a serialized state: "PQ", the algorithm and the format version.
+	 */
+	static constexpr uint32_t STATE_TAG =
+		( 32 == DigestSize ) ? 0x50510601
+		: ( 64 == DigestSize ) ? 0x50510701
+		: ( 168 == Rate ) ? 0x50510801
+		: 0x50510901;
+
+	BlockBuffer< Rate > mBlockBuffer;
+	uint64_t mState[ LANE_COUNT ];
+
+	/**
+	 * XOR {@param blockCount} whole blocks into {@param state}, permuting after each.
+	 */
+	static void __absorb( uint64_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		for ( ; blockCount--; blocks += Rate )
+		{
+			for ( size_t index( -1 ); ++index < RATE_LANES; )
+			{
+				state[ index ] ^= KeccakPermutation::__loadLittleEndian( blocks + 8 * index );
+			}
+
+			KeccakPermutation::__permute( state );
+		}
+	}
+
+	/**
+	 * Fill {@param block} with the last {@param length} bytes of a message, which
+	 * are less than a block, followed by the padding.
+	 */
+	static void __padBlock( uint8_t* block, const uint8_t* message, uint64_t length )
+	{
+		std::memset( block, 0, Rate );
+		if ( 0 != length )
+		{
+			std::memcpy( block, message, length );
+		}
+
+		block[ length ] ^= DomainPadding;
+		block[ Rate - 1 ] ^= 0x80;
+	}
+
+	/**
+	 * Absorb the padded tail of the message and squeeze {@param digestSize}
+	 * bytes, all on a copy of the state.
+	 */
+	void __squeeze( uint8_t* messageDigest, uint64_t digestSize ) const
+	{
+		uint64_t state[ LANE_COUNT ];
+		uint8_t block[ Rate ];
+		std::memcpy( state, mState, sizeof( state ) );
+		__padBlock( block, mBlockBuffer.buffer(), mBlockBuffer.bufferLength() );
+		__absorb( state, block, 1 );
+
+		while ( true )
+		{
+			uint64_t length = std::min( Rate, digestSize );
+			for ( size_t index( -1 ); 8 * ++index < length; )
+			{
+				KeccakPermutation::__storeLittleEndian( block + 8 * index, state[ index ] );
+			}
+
+			std::memcpy( messageDigest, block, length );
+			messageDigest += length;
+			digestSize -= length;
+			if ( 0 == digestSize )
+			{
+				break;
+			}
+
+			KeccakPermutation::__permute( state );
+		}
+	}
+
+	void __digest( uint8_t* messageDigest ) const
+	{
+		__squeeze( messageDigest, DigestSize );
+	}
+
+	void __digest( uint8_t* messageDigest, uint64_t digestSize ) const
+	{
+		if ( 0 != digestSize )
+		{
+			__squeeze( messageDigest, digestSize );
+		}
+	}
+
+	void __update( const uint8_t* message, uint64_t messageLength )
+	{
+		mBlockBuffer.update( message, messageLength, [ this ]( const uint8_t* blocks, uint64_t blockCount )
+		{
+			__absorb( mState, blocks, blockCount );
+		} );
+	}
+
+	void __reset()
+	{
+		std::memset( mState, 0, sizeof( mState ) );
+		mBlockBuffer.reset();
+	}
+
+	uint64_t __serialize( uint8_t* state ) const
+	{
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			state[ index ] = uint8_t( STATE_TAG >> ( 24 - 8 * index ) );
+		}
+
+		for ( size_t index( -1 ); ++index < LANE_COUNT; )
+		{
+			KeccakPermutation::__storeLittleEndian( state + 4 + 8 * index, mState[ index ] );
+		}
+
+		return 4 + KeccakPermutation::WIDTH + mBlockBuffer.serialize( state + 4 + KeccakPermutation::WIDTH );
+	}
+
+	bool __deserialize( const uint8_t* state, uint64_t stateSize )
+	{
+		static constexpr uint64_t HEADER_SIZE = 4 + KeccakPermutation::WIDTH;
+		if ( stateSize < HEADER_SIZE )
+		{
+			return false;
+		}
+
+		uint32_t stateTag = 0;
+		for ( size_t index( -1 ); ++index < 4; )
+		{
+			stateTag = ( stateTag << 8 ) | state[ index ];
+		}
+
+		BlockBuffer< Rate > blockBuffer;
+		if ( ( STATE_TAG != stateTag ) or not blockBuffer.deserialize( state + HEADER_SIZE, stateSize - HEADER_SIZE ) )
+		{
+			return false;
+		}
+
+		for ( size_t index( -1 ); ++index < LANE_COUNT; )
+		{
+			mState[ index ] = KeccakPermutation::__loadLittleEndian( state + 4 + 8 * index );
+		}
+
+		mBlockBuffer = blockBuffer;
+		return true;
+	}
+
+	/**
+	 * Digest each message of the batch in turn.
+	 */
+	static void __digestMessagesSerially( typename Base::BatchMessage* messages, uint64_t messageCount, uint64_t digestSize )
+	{
+		for ( uint64_t index( 0 ); index < messageCount; ++index )
+		{
+			KeccakSponge hash;
+			hash.update( messages[ index ].message, messages[ index ].messageLength );
+			hash.__squeeze( messages[ index ].messageDigest, digestSize );
+		}
+	}
+
+	/**
+	 * Digest a batch of independent messages, one per lane of {@param kernels}.
+	 * Every step XORs a block into each lane that is still absorbing, permutes
+	 * all the lanes at once, and copies a block of output from each lane that
+	 * has absorbed its padding. A lane whose output is complete is refilled
+	 * from the batch; once the batch runs dry the lane is parked and permuted
+	 * along with the others to no effect.
+	 */
+	static void __digestMessagesInLanes( typename Base::BatchMessage* messages, uint64_t messageCount, uint64_t digestSize,
+		const KeccakPermutation::Kernels& kernels )
+	{
+		struct Lane
+		{
+			typename Base::BatchMessage* batchMessage;
+			const uint8_t* message;
+			uint64_t messageLength;
+			uint64_t digestOffset;
+			bool padded;
+		};
+
+		const uint64_t laneCount = kernels.mLaneCount;
+		alignas( 64 ) uint64_t laneState[ LANE_COUNT * KeccakPermutation::MAXIMUM_LANES ];
+		alignas( 64 ) uint8_t block[ Rate ];
+		Lane lanes[ KeccakPermutation::MAXIMUM_LANES ];
+		uint64_t nextMessage = 0;
+		uint64_t activeLaneCount = 0;
+
+		// Load the next message of the batch into {@param lane}, or park the lane.
+		auto loadLane = [ & ]( uint64_t lane )
+		{
+			Lane& current = lanes[ lane ];
+			if ( messageCount == nextMessage )
+			{
+				current.batchMessage = nullptr;
+				return;
+			}
+
+			current.batchMessage = messages + nextMessage++;
+			current.message = current.batchMessage->message;
+			current.messageLength = ( nullptr == current.message ) ? 0 : current.batchMessage->messageLength;
+			current.digestOffset = 0;
+			current.padded = false;
+			for ( size_t index( -1 ); ++index < LANE_COUNT; )
+			{
+				laneState[ index * laneCount + lane ] = 0;
+			}
+
+			++activeLaneCount;
+		};
+
+		for ( uint64_t lane( 0 ); lane < laneCount; ++lane )
+		{
+			loadLane( lane );
+		}
+
+		while ( 0 != activeLaneCount )
+		{
+			for ( uint64_t lane( 0 ); lane < laneCount; ++lane )
+			{
+				Lane& current = lanes[ lane ];
+				if ( ( nullptr == current.batchMessage ) or current.padded )
+				{
+					continue;
+				}
+
+				const uint8_t* input = current.message;
+				if ( Rate <= current.messageLength )
+				{
+					current.message += Rate;
+					current.messageLength -= Rate;
+				}
+				else
+				{
+					__padBlock( block, current.message, current.messageLength );
+					input = block;
+					current.padded = true;
+				}
+
+				for ( size_t index( -1 ); ++index < RATE_LANES; )
+				{
+					laneState[ index * laneCount + lane ] ^= KeccakPermutation::__loadLittleEndian( input + 8 * index );
+				}
+			}
+
+			kernels.mPermuteLanes( laneState );
+
+			for ( uint64_t lane( 0 ); lane < laneCount; ++lane )
+			{
+				Lane& current = lanes[ lane ];
+				if ( ( nullptr == current.batchMessage ) or not current.padded )
+				{
+					continue;
+				}
+
+				uint64_t length = std::min( Rate, digestSize - current.digestOffset );
+				for ( size_t index( -1 ); 8 * ++index < length; )
+				{
+					KeccakPermutation::__storeLittleEndian( block + 8 * index, laneState[ index * laneCount + lane ] );
+				}
+
+				std::memcpy( current.batchMessage->messageDigest + current.digestOffset, block, length );
+				current.digestOffset += length;
+				if ( digestSize == current.digestOffset )
+				{
+					--activeLaneCount;
+					loadLane( lane );
+				}
+			}
+		}
+	}
+
+	static void __digestMessages( typename Base::BatchMessage* messages, uint64_t messageCount, uint64_t digestSize )
+	{
+		const KeccakPermutation::Kernels& kernels = KeccakPermutation::__kernels();
+		if ( ( nullptr == kernels.mPermuteLanes ) or ( messageCount < 2 ) )
+		{
+			__digestMessagesSerially( messages, messageCount, digestSize );
+		}
+		else
+		{
+			__digestMessagesInLanes( messages, messageCount, digestSize, kernels );
+		}
+	}
+
+public:
+	/**
+	 * Largest length of a serialized state: the tag, the 25 state words and
+	 * the block buffer.
+	 */
+	static constexpr uint64_t STATE_SIZE = 4 + KeccakPermutation::WIDTH + BlockBuffer< Rate >::STATE_SIZE;
+
+	/**
+	 * Construct an instance in its initial state.
+	 */
+	KeccakSponge()
+	{
+		__reset();
+	}
+
+	/**
+	 * Compute the digests of a batch of independent messages without maintaining
+	 * state information. Up to eight messages are hashed at once, one per SIMD
+	 * lane. Digests are identical to those produced by digestMessage().
+	 * @param messages Pointer to an array of messages to digest.
+	 * @param messageCount Number of messages in {@param messages}.
+	 */
+	template < uint64_t Size = DigestSize, typename std::enable_if< Base::UNLIMITED_DIGEST_SIZE != Size, int >::type = 0 >
+	static void digestMessages( typename Base::BatchMessage* messages, uint64_t messageCount )
+	{
+		__digestMessages( messages, messageCount, DigestSize );
+	}
+
+	/**
+	 * Compute {@param digestSize} bytes of output for each of a batch of
+	 * independent messages without maintaining state information. Up to eight
+	 * messages are absorbed and squeezed at once, one per SIMD lane. Outputs
+	 * are identical to those produced by digestMessage().
+	 * @param messages Pointer to an array of messages, each messageDigest
+	 *     pointing to {@param digestSize} bytes.
+	 * @param messageCount Number of messages in {@param messages}.
+	 * @param digestSize Requested length of every digest, in bytes.
+	 */
+	template < uint64_t Size = DigestSize, typename std::enable_if< Base::UNLIMITED_DIGEST_SIZE == Size, int >::type = 0 >
+	static void digestMessages( typename Base::BatchMessage* messages, uint64_t messageCount, uint64_t digestSize )
+	{
+		if ( 0 != digestSize )
+		{
+			__digestMessages( messages, messageCount, digestSize );
+		}
+	}
+};
+
+/**
+ * SHA3-256: 136-byte blocks and a 32-byte digest.
+ */
+typedef KeccakSponge< 136, 0x06, 32 > SHA3_256;
+
+/**
+ * SHA3-512: 72-byte blocks and a 64-byte digest.
+ */
+typedef KeccakSponge< 72, 0x06, 64 > SHA3_512;
+
+/**
+ * SHAKE128: 168-byte blocks and output of any length.
+ */
+typedef KeccakSponge< 168, 0x1f, 0 > SHAKE128;
+
+/**
+ * SHAKE256: 136-byte blocks and output of any length.
+ */
+typedef KeccakSponge< 136, 0x1f, 0 > SHAKE256;
+
+} // namespace Pique
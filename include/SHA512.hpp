@@ -0,0 +1,395 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define PIQUE_SHA512_X86 1
+#endif
+
+#include "CpuFeatures.hpp"
+#include "HashFunction.hpp"
+#include "Instrumentation.hpp"
+
+namespace Pique
+{
+
+/**
+ * The SHA-512 compression function shared by every member of the SHA-512
+ * family. Whole blocks are compressed by the fastest kernel allowed by
+ * CpuFeatures: a portable round function fed by an AVX2 message schedule of
+ * four blocks at a time, or the portable compression function.
+ */
+class SHA512Compression final
+{
+private:
+	template < uint64_t DigestSize >
+	friend class SHA512Family;
+
+	typedef void ( *CompressFunction )( uint64_t* state, const uint8_t* blocks, uint64_t blockCount );
+
+	static constexpr uint64_t BLOCK_SIZE = 128;
+
+	static constexpr uint64_t ROUND_CONSTANT[ 80 ] = {
+		0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+		0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+		0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+		0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+		0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+		0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+		0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+		0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+		0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+		0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+		0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+		0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+		0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+		0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+		0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+		0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+		0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+		0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+		0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+		0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL };
+
+	static constexpr uint64_t INITIAL_STATE_SHA512[ 8 ] = {
+		0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+		0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL };
+
+	static constexpr uint64_t INITIAL_STATE_SHA384[ 8 ] = {
+		0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+		0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL, 0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL };
+
+	static constexpr uint64_t INITIAL_STATE_SHA512_256[ 8 ] = {
+		0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL, 0x2393b86b6f53b151ULL, 0x963877195940eabdULL,
+		0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL, 0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL };
+
+	static uint64_t __rotateRight( uint64_t value, unsigned count )
+	{
+		return ( value >> count ) | ( value << ( 64 - count ) );
+	}
+
+	static uint64_t __loadBigEndian( const uint8_t* bytes )
+	{
+		uint64_t value = 0;
+		for ( size_t index( 0 ); index < 8; ++index )
+		{
+			value = ( value << 8 ) | bytes[ index ];
+		}
+
+		return value;
+	}
+
+	static void __storeBigEndian( uint8_t* bytes, uint64_t value )
+	{
+		for ( size_t index( 8 ); index--; value >>= 8 )
+		{
+			bytes[ index ] = uint8_t( value );
+		}
+	}
+
+	/**
+	 * Apply the 80 rounds to {@param state} given the message schedule with
+	 * the round constants already added. Word t of the schedule is read from
+	 * scheduleWithConstants[ t * stride ].
+	 */
+	static void __rounds( uint64_t* state, const uint64_t* scheduleWithConstants, uint64_t stride )
+	{
+		uint64_t a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+		uint64_t e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+
+		for ( uint64_t round( 0 ); round < 80; ++round )
+		{
+			uint64_t temporary1 = h
+				+ ( __rotateRight( e, 14 ) ^ __rotateRight( e, 18 ) ^ __rotateRight( e, 41 ) )
+				+ ( ( e & f ) ^ ( ~e & g ) )
+				+ scheduleWithConstants[ round * stride ];
+			uint64_t temporary2 = ( __rotateRight( a, 28 ) ^ __rotateRight( a, 34 ) ^ __rotateRight( a, 39 ) )
+				+ ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + temporary1;
+			d = c;
+			c = b;
+			b = a;
+			a = temporary1 + temporary2;
+		}
+
+		state[ 0 ] += a; state[ 1 ] += b; state[ 2 ] += c; state[ 3 ] += d;
+		state[ 4 ] += e; state[ 5 ] += f; state[ 6 ] += g; state[ 7 ] += h;
+	}
+
+	static void __compressPortable( uint64_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		uint64_t schedule[ 80 ];
+
+		for ( ; blockCount--; blocks += BLOCK_SIZE )
+		{
+			for ( uint64_t index( 0 ); index < 16; ++index )
+			{
+				schedule[ index ] = __loadBigEndian( blocks + 8 * index );
+			}
+
+			for ( uint64_t index( 16 ); index < 80; ++index )
+			{
+				uint64_t word15 = schedule[ index - 15 ];
+				uint64_t word2 = schedule[ index - 2 ];
+				schedule[ index ] = schedule[ index - 16 ] + schedule[ index - 7 ]
+					+ ( __rotateRight( word15, 1 ) ^ __rotateRight( word15, 8 ) ^ ( word15 >> 7 ) )
+					+ ( __rotateRight( word2, 19 ) ^ __rotateRight( word2, 61 ) ^ ( word2 >> 6 ) );
+			}
+
+			for ( uint64_t index( 0 ); index < 80; ++index )
+			{
+				schedule[ index ] += ROUND_CONSTANT[ index ];
+			}
+
+			__rounds( state, schedule, 1 );
+		}
+	}
+
+#if defined( PIQUE_SHA512_X86 )
+	__attribute__(( target( "avx2" ) ))
+	static __m256i __sigmaAvx2( __m256i word, int rotate0, int rotate1, int shift )
+	{
+		return _mm256_xor_si256(
+			_mm256_xor_si256(
+				_mm256_or_si256( _mm256_srli_epi64( word, rotate0 ), _mm256_slli_epi64( word, 64 - rotate0 ) ),
+				_mm256_or_si256( _mm256_srli_epi64( word, rotate1 ), _mm256_slli_epi64( word, 64 - rotate1 ) ) ),
+			_mm256_srli_epi64( word, shift ) );
+	}
+
+	/**
+	 * Expand the message schedule of four consecutive blocks at once, one block
+	 * per 64-bit lane, then run the rounds of each block from the transposed
+	 * schedule. The schedule does not depend on the chaining state, so only the
+	 * rounds remain serial.
+	 */
+	__attribute__(( target( "avx2,bmi2" ) ))
+	static void __compressAvx2( uint64_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		alignas( 32 ) uint64_t schedule[ 80 * 4 ];
+		const __m256i byteSwap = _mm256_set_epi8(
+			8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+			8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 );
+		const __m256i blockOffset = _mm256_setr_epi64x( 0, 16, 32, 48 );
+
+		for ( ; 4 <= blockCount; blockCount -= 4, blocks += 4 * BLOCK_SIZE )
+		{
+			__m256i word[ 80 ];
+			for ( int index( 0 ); index < 16; ++index )
+			{
+				word[ index ] = _mm256_shuffle_epi8( _mm256_i64gather_epi64(
+					reinterpret_cast< const long long* >( blocks ) + index, blockOffset, 8 ), byteSwap );
+			}
+
+			for ( int index( 16 ); index < 80; ++index )
+			{
+				word[ index ] = _mm256_add_epi64(
+					_mm256_add_epi64( word[ index - 16 ], word[ index - 7 ] ),
+					_mm256_add_epi64( __sigmaAvx2( word[ index - 15 ], 1, 8, 7 ), __sigmaAvx2( word[ index - 2 ], 19, 61, 6 ) ) );
+			}
+
+			for ( int index( 0 ); index < 80; ++index )
+			{
+				_mm256_store_si256( reinterpret_cast< __m256i* >( schedule + 4 * index ),
+					_mm256_add_epi64( word[ index ], _mm256_set1_epi64x( static_cast< long long >( ROUND_CONSTANT[ index ] ) ) ) );
+			}
+
+			for ( int lane( 0 ); lane < 4; ++lane )
+			{
+				__rounds( state, schedule + lane, 4 );
+			}
+		}
+
+		__compressPortable( state, blocks, blockCount );
+	}
+#endif
+
+	static std::atomic< CompressFunction >& __dispatchTable()
+	{
+		static std::atomic< CompressFunction > compress;
+		return compress;
+	}
+
+	static void __selectKernels()
+	{
+		CompressFunction compress = __compressPortable;
+#if defined( PIQUE_SHA512_X86 )
+		if ( CpuFeatures::supports( CpuFeatures::AVX2 | CpuFeatures::BMI2 ) )
+		{
+			compress = __compressAvx2;
+		}
+#endif
+		__dispatchTable().store( compress, std::memory_order_relaxed );
+	}
+
+	/**
+	 * Compress {@param blockCount} blocks with the kernel chosen for the
+	 * enabled processor features.
+	 */
+	static void __compress( uint64_t* state, const uint8_t* blocks, uint64_t blockCount )
+	{
+		static const bool subscribed = CpuFeatures::subscribe( __selectKernels );
+		( void ) subscribed;
+		Instrumentation::count( Instrumentation::HASH_BLOCKS_COMPRESSED, blockCount );
+		__dispatchTable().load( std::memory_order_relaxed )( state, blocks, blockCount );
+	}
+};
+
+/**
+ * The SHA-512 family as specified in FIPS 180-4. The digest size selects the
+ * member: 64 bytes for SHA-512, 48 bytes for SHA-384 and 32 bytes for SHA-512/256.
+ * On 64-bit processors without the SHA extensions these outpace SHA-256.
+ */
+template < uint64_t DigestSize >
+class SHA512Family final : public HashFunction< SHA512Family< DigestSize >, 128, DigestSize >
+{
+	static_assert( ( 64 == DigestSize ) or ( 48 == DigestSize ) or ( 32 == DigestSize ),
+		"DigestSize must select SHA-512, SHA-384 or SHA-512/256" );
+
+private:
+	friend class HashFunction< SHA512Family< DigestSize >, 128, DigestSize >;
+
+	static constexpr uint64_t BLOCK_SIZE = SHA512Compression::BLOCK_SIZE;
+
+	static constexpr const uint64_t* INITIAL_STATE =
+		( 64 == DigestSize ) ? SHA512Compression::INITIAL_STATE_SHA512
+		: ( 48 == DigestSize ) ? SHA512Compression::INITIAL_STATE_SHA384
+		: SHA512Compression::INITIAL_STATE_SHA512_256;
+
+	/**
+	 * Leads a serialized state: "PQ", the algorithm and the format version.
+	 */
+	static constexpr uint32_t STATE_TAG =
+		( 64 == DigestSize ) ? 0x50510201
+		: ( 48 == DigestSize ) ? 0x50510301
+		: 0x50510401;
+
+	BlockBuffer< BLOCK_SIZE > mBlockBuffer;
+	uint64_t mState[ 8 ];
+
+	/**
+	 * Pad the message and output the digest without modifying this instance.
+	 */
+	void __digest( uint8_t* messageDigest ) const
+	{
+		uint64_t state[ 8 ];
+		uint8_t blocks[ 2 * BLOCK_SIZE ] = { 0 };
+		uint64_t blockCount = ( mBlockBuffer.bufferLength() < BLOCK_SIZE - 16 ) ? 1 : 2;
+
+		std::memcpy( state, mState, sizeof( state ) );
+		std::memcpy( blocks, mBlockBuffer.buffer(), mBlockBuffer.bufferLength() );
+		blocks[ mBlockBuffer.bufferLength() ] = 0x80;
+		SHA512Compression::__storeBigEndian( blocks + blockCount * BLOCK_SIZE - 16, mBlockBuffer.messageLength() >> 61 );
+		SHA512Compression::__storeBigEndian( blocks + blockCount * BLOCK_SIZE - 8, mBlockBuffer.messageLength() << 3 );
+
+		SHA512Compression::__compress( state, blocks, blockCount );
+
+		uint8_t fullDigest[ sizeof( state ) ];
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			SHA512Compression::__storeBigEndian( fullDigest + 8 * index, state[ index ] );
+		}
+
+		std::memcpy( messageDigest, fullDigest, DigestSize );
+	}
+
+	void __update( const uint8_t* message, uint64_t messageLength )
+	{
+		mBlockBuffer.update( message, messageLength, [ this ]( const uint8_t* blocks, uint64_t blockCount )
+		{
+			SHA512Compression::__compress( mState, blocks, blockCount );
+		} );
+	}
+
+	void __reset()
+	{
+		std::memcpy( mState, INITIAL_STATE, sizeof( mState ) );
+		mBlockBuffer.reset();
+	}
+
+	uint64_t __serialize( uint8_t* state ) const
+	{
+		for ( uint64_t index( 0 ); index < 4; ++index )
+		{
+			state[ index ] = uint8_t( STATE_TAG >> ( 24 - 8 * index ) );
+		}
+
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			SHA512Compression::__storeBigEndian( state + 4 + 8 * index, mState[ index ] );
+		}
+
+		return 68 + mBlockBuffer.serialize( state + 68 );
+	}
+
+	bool __deserialize( const uint8_t* state, uint64_t stateSize )
+	{
+		if ( stateSize < 68 )
+		{
+			return false;
+		}
+
+		uint32_t stateTag = 0;
+		for ( uint64_t index( 0 ); index < 4; ++index )
+		{
+			stateTag = ( stateTag << 8 ) | state[ index ];
+		}
+
+		BlockBuffer< BLOCK_SIZE > blockBuffer;
+		if ( ( STATE_TAG != stateTag ) or not blockBuffer.deserialize( state + 68, stateSize - 68 ) )
+		{
+			return false;
+		}
+
+		for ( uint64_t index( 0 ); index < 8; ++index )
+		{
+			mState[ index ] = SHA512Compression::__loadBigEndian( state + 4 + 8 * index );
+		}
+
+		mBlockBuffer = blockBuffer;
+		return true;
+	}
+
+public:
+	/**
+	 * Largest length of a serialized state: the tag, the eight state words and
+	 * the block buffer.
+	 */
+	static constexpr uint64_t STATE_SIZE = 68 + BlockBuffer< BLOCK_SIZE >::STATE_SIZE;
+
+	/**
+	 * Construct an instance in its initial state.
+	 */
+	SHA512Family()
+	{
+		__reset();
+	}
+};
+
+/**
+ * SHA-512: 128-byte blocks and a 64-byte digest.
+ */
+typedef SHA512Family< 64 > SHA512;
+
+/**
+ * SHA-384: 128-byte blocks and a 48-byte digest.
+ */
+typedef SHA512Family< 48 > SHA384;
+
+/**
+ * SHA-512/256: 128-byte blocks and a 32-byte digest.
+ */
+typedef SHA512Family< 32 > SHA512_256;
+
+} // namespace Pique
@@ -0,0 +1,422 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "Zeroize.hpp"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/mman.h>
+#include <unistd.h>
+#define PIQUE_SECURE_ARENA_MMAP 1
+#endif
+
+/**
+ * The length, in bytes, of every region the arena maps for small blocks.
+ */
+#ifndef PIQUE_SECURE_ARENA_REGION_SIZE
+#define PIQUE_SECURE_ARENA_REGION_SIZE ( 64 * 1024 )
+#endif
+
+/**
+ * The default limit, in bytes, on the memory the arena maps in total.
+ */
+#ifndef PIQUE_SECURE_ARENA_CAPACITY
+#define PIQUE_SECURE_ARENA_CAPACITY ( 1024 * 1024 )
+#endif
+
+namespace Pique
+{
+
+/**
+ * A process wide allocator for key material. Memory is mapped in regions that
+ * are locked into RAM, so it is never written to swap, excluded from core
+ * dumps, and surrounded by inaccessible guard pages, so a linear overrun
+ * faults instead of reaching other data. Locking is done once per region
+ * rather than once per key.
+ *
+ * Blocks of up to MAXIMUM_BLOCK_SIZE bytes are carved from shared regions in
+ * power of two size classes and recycled through free lists. Each thread
+ * caches a few free blocks of every class, so most allocations and frees take
+ * no lock. Larger blocks get a guarded mapping of their own. Every block is
+ * zeroized when it is freed.
+ *
+ * allocate() returns null once the mapped memory would exceed the capacity,
+ * or if the memory cannot be mapped, and callers fall back to the heap. A
+ * region that cannot be locked, because RLIMIT_MEMLOCK is exhausted, is used
+ * anyway and only counted as unlocked in statistics().
+ */
+class SecureArena final
+{
+public:
+	static constexpr size_t MINIMUM_BLOCK_SIZE = 16;
+	static constexpr size_t MAXIMUM_BLOCK_SIZE = 4096;
+	static constexpr size_t REGION_SIZE = PIQUE_SECURE_ARENA_REGION_SIZE;
+
+	static_assert( MAXIMUM_BLOCK_SIZE <= REGION_SIZE, "A region must hold a block of every size class" );
+
+	/**
+	 * The memory mapped by the arena, in bytes.
+	 */
+	struct Statistics
+	{
+		size_t mCapacity;
+		size_t mMappedBytes;
+		size_t mLockedBytes;
+	};
+
+private:
+	static constexpr size_t SIZE_CLASSES = 9;
+	static constexpr size_t CACHE_BATCH = 16;
+
+	static_assert( ( MINIMUM_BLOCK_SIZE << ( SIZE_CLASSES - 1 ) ) == MAXIMUM_BLOCK_SIZE, "Size classes are the powers of two between the minimum and maximum block sizes" );
+
+	struct FreeBlock
+	{
+		FreeBlock* mNext;
+	};
+
+	struct Domain
+	{
+		std::mutex mMutex;
+		FreeBlock* mFreeLists[ SIZE_CLASSES ] = { nullptr };
+		uint8_t* mRegionCursor = nullptr;
+		uint8_t* mRegionEnd = nullptr;
+		size_t mCapacity = PIQUE_SECURE_ARENA_CAPACITY;
+		size_t mMappedBytes = 0;
+		size_t mLockedBytes = 0;
+	};
+
+	/**
+	 * The free blocks cached by one thread. It is trivially destructible, so it
+	 * stays usable by frees that run during thread exit, after the flush.
+	 */
+	struct ThreadCache
+	{
+		FreeBlock* mFreeLists[ SIZE_CLASSES ];
+		size_t mFreeCounts[ SIZE_CLASSES ];
+		bool mFlushed;
+	};
+
+	/**
+	 * Returns the blocks cached by the thread to the domain when it exits.
+	 */
+	struct ThreadCacheFlush
+	{
+		ThreadCache& mCache;
+
+		~ThreadCacheFlush()
+		{
+			std::lock_guard< std::mutex > lock( __domain().mMutex );
+			for ( size_t sizeClass( -1 ); ++sizeClass < SIZE_CLASSES; )
+			{
+				__release( mCache, sizeClass, mCache.mFreeCounts[ sizeClass ] );
+			}
+
+			mCache.mFlushed = true;
+		}
+	};
+
+	/**
+	 * The domain is never freed, so threads that exit after static
+	 * destruction still find it.
+	 */
+	static Domain& __domain()
+	{
+		static Domain* domain = new Domain();
+		return *domain;
+	}
+
+	static ThreadCache& __cache()
+	{
+		thread_local ThreadCache cache = {};
+		thread_local ThreadCacheFlush flush { cache };
+		( void )flush;
+		return cache;
+	}
+
+	static size_t __sizeClass( size_t length )
+	{
+		size_t sizeClass = 0;
+		while ( ( MINIMUM_BLOCK_SIZE << sizeClass ) < length )
+		{
+			++sizeClass;
+		}
+
+		return sizeClass;
+	}
+
+	static size_t __pageSize()
+	{
+#ifdef PIQUE_SECURE_ARENA_MMAP
+		static const size_t pageSize = size_t( sysconf( _SC_PAGESIZE ) );
+		return pageSize;
+#else
+		return 4096;
+#endif
+	}
+
+	static size_t __roundToPages( size_t length )
+	{
+		return ( length + __pageSize() - 1 ) & ~( __pageSize() - 1 );
+	}
+
+	/**
+	 * Map {@param length} bytes, a multiple of the page size, between two guard
+	 * pages. The caller holds the domain mutex.
+	 * @return A pointer to the usable memory is returned, or null if the
+	 *     capacity would be exceeded or the memory cannot be mapped.
+	 */
+	static uint8_t* __map( Domain& domain, size_t length )
+	{
+#ifdef PIQUE_SECURE_ARENA_MMAP
+		if ( domain.mCapacity < domain.mMappedBytes + length )
+		{
+			return nullptr;
+		}
+
+		size_t pageSize = __pageSize();
+		void* mapping = mmap( nullptr, length + 2 * pageSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if ( MAP_FAILED == mapping )
+		{
+			return nullptr;
+		}
+
+		uint8_t* memory = static_cast< uint8_t* >( mapping ) + pageSize;
+		if ( 0 != mprotect( memory, length, PROT_READ | PROT_WRITE ) )
+		{
+			munmap( mapping, length + 2 * pageSize );
+			return nullptr;
+		}
+
+#ifdef MADV_DONTDUMP
+		madvise( memory, length, MADV_DONTDUMP );
+#endif
+
+		domain.mMappedBytes += length;
+		if ( 0 == mlock( memory, length ) )
+		{
+			domain.mLockedBytes += length;
+		}
+
+		return memory;
+#else
+		( void )domain;
+		( void )length;
+		return nullptr;
+#endif
+	}
+
+	/**
+	 * Unmap memory returned by __map(). The caller holds the domain mutex.
+	 */
+	static void __unmap( Domain& domain, uint8_t* memory, size_t length )
+	{
+#ifdef PIQUE_SECURE_ARENA_MMAP
+		if ( 0 == munlock( memory, length ) )
+		{
+			domain.mLockedBytes -= length;
+		}
+
+		domain.mMappedBytes -= length;
+		munmap( memory - __pageSize(), length + 2 * __pageSize() );
+#else
+		( void )domain;
+		( void )memory;
+		( void )length;
+#endif
+	}
+
+	/**
+	 * Take one free block of {@param sizeClass} from the domain, carving a new
+	 * block from the current region when the domain has none. The caller holds
+	 * the domain mutex.
+	 * @return A pointer to the block is returned, or null if no region can be mapped.
+	 */
+	static FreeBlock* __take( Domain& domain, size_t sizeClass )
+	{
+		FreeBlock* block = domain.mFreeLists[ sizeClass ];
+		if ( nullptr != block )
+		{
+			domain.mFreeLists[ sizeClass ] = block->mNext;
+			return block;
+		}
+
+		size_t blockSize = MINIMUM_BLOCK_SIZE << sizeClass;
+		if ( size_t( domain.mRegionEnd - domain.mRegionCursor ) < blockSize )
+		{
+			uint8_t* region = __map( domain, REGION_SIZE );
+			if ( nullptr == region )
+			{
+				return nullptr;
+			}
+
+			// The tail of the previous region is abandoned; it is smaller than one block.
+			domain.mRegionCursor = region;
+			domain.mRegionEnd = region + REGION_SIZE;
+		}
+
+		block = reinterpret_cast< FreeBlock* >( domain.mRegionCursor );
+		domain.mRegionCursor += blockSize;
+		return block;
+	}
+
+	/**
+	 * Move up to CACHE_BATCH free blocks of {@param sizeClass} into {@param cache}.
+	 */
+	static void __refill( ThreadCache& cache, size_t sizeClass )
+	{
+		Domain& domain = __domain();
+		std::lock_guard< std::mutex > lock( domain.mMutex );
+		for ( size_t count( -1 ); ++count < CACHE_BATCH; )
+		{
+			FreeBlock* block = __take( domain, sizeClass );
+			if ( nullptr == block )
+			{
+				return;
+			}
+
+			block->mNext = cache.mFreeLists[ sizeClass ];
+			cache.mFreeLists[ sizeClass ] = block;
+			++cache.mFreeCounts[ sizeClass ];
+		}
+	}
+
+	/**
+	 * Move {@param count} free blocks of {@param sizeClass} from {@param cache}
+	 * to the domain. The caller holds the domain mutex.
+	 */
+	static void __release( ThreadCache& cache, size_t sizeClass, size_t count )
+	{
+		Domain& domain = __domain();
+		while ( count-- and ( nullptr != cache.mFreeLists[ sizeClass ] ) )
+		{
+			FreeBlock* block = cache.mFreeLists[ sizeClass ];
+			cache.mFreeLists[ sizeClass ] = block->mNext;
+			--cache.mFreeCounts[ sizeClass ];
+
+			block->mNext = domain.mFreeLists[ sizeClass ];
+			domain.mFreeLists[ sizeClass ] = block;
+		}
+	}
+
+public:
+	/**
+	 * Allocate {@param length} bytes of locked, non-dumpable memory, aligned
+	 * to MINIMUM_BLOCK_SIZE bytes.
+	 * @param length Length of the block in bytes.
+	 * @return A pointer to the block is returned, or null if {@param length} is
+	 *     zero or the arena cannot provide the memory.
+	 */
+	static void* allocate( size_t length )
+	{
+		if ( 0 == length )
+		{
+			return nullptr;
+		}
+
+		if ( MAXIMUM_BLOCK_SIZE < length )
+		{
+			Domain& domain = __domain();
+			std::lock_guard< std::mutex > lock( domain.mMutex );
+			return __map( domain, __roundToPages( length ) );
+		}
+
+		size_t sizeClass = __sizeClass( length );
+		ThreadCache& cache = __cache();
+		if ( cache.mFlushed )
+		{
+			// Nothing would return a batch loaded into a cache that has been flushed.
+			Domain& domain = __domain();
+			std::lock_guard< std::mutex > lock( domain.mMutex );
+			FreeBlock* block = __take( domain, sizeClass );
+			if ( nullptr != block )
+			{
+				block->mNext = nullptr;
+			}
+
+			return block;
+		}
+
+		if ( nullptr == cache.mFreeLists[ sizeClass ] )
+		{
+			__refill( cache, sizeClass );
+			if ( nullptr == cache.mFreeLists[ sizeClass ] )
+			{
+				return nullptr;
+			}
+		}
+
+		FreeBlock* block = cache.mFreeLists[ sizeClass ];
+		cache.mFreeLists[ sizeClass ] = block->mNext;
+		--cache.mFreeCounts[ sizeClass ];
+		block->mNext = nullptr;
+		return block;
+	}
+
+	/**
+	 * Zeroize and free a block returned by allocate().
+	 * @param pointer Pointer to the block, or null.
+	 * @param length Length of the block in bytes, as passed to allocate().
+	 */
+	static void deallocate( void* pointer, size_t length )
+	{
+		if ( nullptr == pointer )
+		{
+			return;
+		}
+
+		if ( MAXIMUM_BLOCK_SIZE < length )
+		{
+			zeroize( pointer, length );
+			Domain& domain = __domain();
+			std::lock_guard< std::mutex > lock( domain.mMutex );
+			__unmap( domain, static_cast< uint8_t* >( pointer ), __roundToPages( length ) );
+			return;
+		}
+
+		size_t sizeClass = __sizeClass( length );
+		zeroize( pointer, MINIMUM_BLOCK_SIZE << sizeClass );
+
+		ThreadCache& cache = __cache();
+		FreeBlock* block = static_cast< FreeBlock* >( pointer );
+		block->mNext = cache.mFreeLists[ sizeClass ];
+		cache.mFreeLists[ sizeClass ] = block;
+		if ( ( 2 * CACHE_BATCH < ++cache.mFreeCounts[ sizeClass ] ) or cache.mFlushed )
+		{
+			std::lock_guard< std::mutex > lock( __domain().mMutex );
+			__release( cache, sizeClass, cache.mFlushed ? cache.mFreeCounts[ sizeClass ] : CACHE_BATCH );
+		}
+	}
+
+	/**
+	 * Limit the memory the arena maps in total. Memory already mapped is kept,
+	 * so a capacity below it only stops further growth.
+	 * @param capacity The limit in bytes.
+	 */
+	static void setCapacity( size_t capacity )
+	{
+		Domain& domain = __domain();
+		std::lock_guard< std::mutex > lock( domain.mMutex );
+		domain.mCapacity = capacity;
+	}
+
+	/**
+	 * Get the capacity and the memory mapped by the arena.
+	 * @return A Statistics instance is returned.
+	 */
+	static Statistics statistics()
+	{
+		Domain& domain = __domain();
+		std::lock_guard< std::mutex > lock( domain.mMutex );
+		return Statistics { domain.mCapacity, domain.mMappedBytes, domain.mLockedBytes };
+	}
+};
+
+} // namespace Pique
@@ -0,0 +1,322 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Pique
+{
+
+/**
+ * A work-stealing pool of threads for data parallel loops.
+ *
+ * parallelFor() splits its range in halves, queueing the upper half and
+ * splitting the lower half again, until a range is no longer than the grain.
+ * Every worker owns a queue: it takes its newest range first, which keeps its
+ * data in cache, while an idle worker steals the oldest, and so the largest,
+ * range of another. The calling thread works on its own loop until the loop
+ * is done, so a pool without workers runs every loop on the caller.
+ *
+ * Queued ranges are small trivially copyable records, so queueing allocates
+ * nothing once the queues have grown. Loops may nest and may be started from
+ * several threads at once.
+ */
+class ThreadPool final
+{
+private:
+	struct TaskGroup
+	{
+		std::atomic< uint64_t > mPending;
+	};
+
+	/**
+	 * A range of a parallelFor() loop still to be run.
+	 */
+	struct Task
+	{
+		void ( *mRun )( void* context, uint64_t begin, uint64_t end );
+		void* mContext;
+		TaskGroup* mGroup;
+		uint64_t mBegin;
+		uint64_t mEnd;
+		uint64_t mGrain;
+	};
+
+	struct alignas( 64 ) Queue
+	{
+		std::mutex mMutex;
+		std::deque< Task > mTasks;
+	};
+
+	/**
+	 * The queue of the calling thread: its own queue for a worker of the
+	 * pool, else the shared queue of outside threads, the last one.
+	 */
+	struct ThreadIdentity
+	{
+		const ThreadPool* mPool;
+		size_t mQueue;
+	};
+
+	size_t mWorkerCount;
+	std::unique_ptr< Queue[] > mQueues;
+	std::vector< std::thread > mWorkers;
+	std::atomic< uint64_t > mQueuedTasks;
+	std::atomic< size_t > mSleepingWorkers;
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeCondition;
+	bool mStopping;
+
+	static ThreadIdentity& __identity()
+	{
+		thread_local ThreadIdentity identity = { nullptr, 0 };
+		return identity;
+	}
+
+	size_t __queueOfThisThread() const
+	{
+		const ThreadIdentity& identity = __identity();
+		return ( this == identity.mPool ) ? identity.mQueue : mWorkerCount;
+	}
+
+	template < typename Function >
+	static void __invoke( void* context, uint64_t begin, uint64_t end )
+	{
+		( *static_cast< Function* >( context ) )( begin, end );
+	}
+
+	void __push( size_t queue, const Task& task )
+	{
+		{
+			std::lock_guard< std::mutex > queueLock( mQueues[ queue ].mMutex );
+			mQueues[ queue ].mTasks.push_back( task );
+
+			// Pairs with the sleeping worker's check: either it sees the task, or this sees it sleeping.
+			mQueuedTasks.fetch_add( 1, std::memory_order_seq_cst );
+		}
+
+		if ( 0 != mSleepingWorkers.load( std::memory_order_seq_cst ) )
+		{
+			std::lock_guard< std::mutex > sleepLock( mSleepMutex );
+			mWakeCondition.notify_one();
+		}
+	}
+
+	/**
+	 * Take the newest task of {@param queue}, as its owner.
+	 */
+	bool __pop( size_t queue, Task& task )
+	{
+		std::lock_guard< std::mutex > queueLock( mQueues[ queue ].mMutex );
+		if ( mQueues[ queue ].mTasks.empty() )
+		{
+			return false;
+		}
+
+		task = mQueues[ queue ].mTasks.back();
+		mQueues[ queue ].mTasks.pop_back();
+		mQueuedTasks.fetch_sub( 1, std::memory_order_relaxed );
+		return true;
+	}
+
+	/**
+	 * Take the oldest task of any queue but {@param queue}, starting at a
+	 * pseudorandom victim so that thieves spread out.
+	 */
+	bool __steal( size_t queue, Task& task )
+	{
+		thread_local uint64_t random = 0x9E3779B97F4A7C15ULL ^ uint64_t( reinterpret_cast< uintptr_t >( &random ) );
+		random ^= random << 13;
+		random ^= random >> 7;
+		random ^= random << 17;
+
+		size_t queueCount = mWorkerCount + 1;
+		for ( size_t offset( -1 ); ++offset < queueCount; )
+		{
+			size_t victim = ( random + offset ) % queueCount;
+			if ( ( victim == queue ) or ( 0 == mQueuedTasks.load( std::memory_order_relaxed ) ) )
+			{
+				continue;
+			}
+
+			std::lock_guard< std::mutex > queueLock( mQueues[ victim ].mMutex );
+			if ( not mQueues[ victim ].mTasks.empty() )
+			{
+				task = mQueues[ victim ].mTasks.front();
+				mQueues[ victim ].mTasks.pop_front();
+				mQueuedTasks.fetch_sub( 1, std::memory_order_relaxed );
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Run {@param task}, queueing the upper half of its range on {@param queue}
+	 * until what is left is no longer than the grain.
+	 */
+	void __execute( size_t queue, Task task )
+	{
+		while ( task.mEnd - task.mBegin > task.mGrain )
+		{
+			Task upperHalf = task;
+			upperHalf.mBegin = task.mBegin + ( task.mEnd - task.mBegin ) / 2;
+			task.mEnd = upperHalf.mBegin;
+			task.mGroup->mPending.fetch_add( 1, std::memory_order_relaxed );
+			__push( queue, upperHalf );
+		}
+
+		task.mRun( task.mContext, task.mBegin, task.mEnd );
+		task.mGroup->mPending.fetch_sub( 1, std::memory_order_release );
+	}
+
+	/**
+	 * Run tasks until {@param group} is done, own tasks first.
+	 */
+	void __wait( size_t queue, TaskGroup& group )
+	{
+		while ( 0 != group.mPending.load( std::memory_order_acquire ) )
+		{
+			Task task;
+			if ( __pop( queue, task ) or __steal( queue, task ) )
+			{
+				__execute( queue, task );
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void __work( size_t queue )
+	{
+		__identity() = { this, queue };
+		while ( true )
+		{
+			Task task;
+			if ( __pop( queue, task ) or __steal( queue, task ) )
+			{
+				__execute( queue, task );
+				continue;
+			}
+
+			std::unique_lock< std::mutex > sleepLock( mSleepMutex );
+			mSleepingWorkers.fetch_add( 1, std::memory_order_seq_cst );
+			while ( ( not mStopping ) and ( 0 == mQueuedTasks.load( std::memory_order_seq_cst ) ) )
+			{
+				mWakeCondition.wait( sleepLock );
+			}
+
+			mSleepingWorkers.fetch_sub( 1, std::memory_order_relaxed );
+			if ( mStopping )
+			{
+				return;
+			}
+		}
+	}
+
+public:
+	/**
+	 * Start a pool.
+	 * @param workerCount The number of threads to start besides the callers of
+	 *     parallelFor(), which take part in their own loops.
+	 */
+	explicit ThreadPool( size_t workerCount ) :
+		mWorkerCount( workerCount ),
+		mQueues( new Queue[ workerCount + 1 ] ),
+		mQueuedTasks( 0 ),
+		mSleepingWorkers( 0 ),
+		mStopping( false )
+	{
+		mWorkers.reserve( workerCount );
+		for ( size_t index( -1 ); ++index < workerCount; )
+		{
+			mWorkers.emplace_back( &ThreadPool::__work, this, index );
+		}
+	}
+
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator=( const ThreadPool& ) = delete;
+
+	/**
+	 * Stop and join every worker. No loop may be running.
+	 */
+	~ThreadPool()
+	{
+		{
+			std::lock_guard< std::mutex > sleepLock( mSleepMutex );
+			mStopping = true;
+		}
+
+		mWakeCondition.notify_all();
+		for ( std::thread& worker : mWorkers )
+		{
+			worker.join();
+		}
+	}
+
+	/**
+	 * Get the process wide pool, with one worker fewer than there are hardware
+	 * threads, as the caller of a loop makes up the last.
+	 * @return Reference to the shared pool is returned.
+	 */
+	static ThreadPool& instance()
+	{
+		static ThreadPool pool( ( 1 < std::thread::hardware_concurrency() ) ? std::thread::hardware_concurrency() - 1 : 0 );
+		return pool;
+	}
+
+	/**
+	 * Get the number of threads that may run a loop at once.
+	 * @return The number of workers plus one, for the caller, is returned.
+	 */
+	size_t concurrency() const
+	{
+		return mWorkerCount + 1;
+	}
+
+	/**
+	 * Call {@param function} on disjoint ranges that together cover
+	 * [ {@param begin}, {@param end} ), in parallel, and return once every
+	 * call has returned.
+	 * @param begin The first index.
+	 * @param end One past the last index.
+	 * @param grain The longest range to pass to {@param function}, at least one.
+	 * @param function Callable as function( uint64_t first, uint64_t last ),
+	 *     from several threads at once, for the indices first to last - 1.
+	 */
+	template < typename Function >
+	void parallelFor( uint64_t begin, uint64_t end, uint64_t grain, Function&& function )
+	{
+		if ( begin >= end )
+		{
+			return;
+		}
+
+		typedef typename std::remove_reference< Function >::type FunctionType;
+		TaskGroup group;
+		group.mPending.store( 1, std::memory_order_relaxed );
+
+		size_t queue = __queueOfThisThread();
+		__execute( queue, Task { __invoke< FunctionType >, const_cast< void* >( static_cast< const void* >( &function ) ),
+			&group, begin, end, ( 0 == grain ) ? 1 : grain } );
+		__wait( queue, group );
+	}
+};
+
+} // namespace Pique
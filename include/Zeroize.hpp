@@ -0,0 +1,28 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+namespace Pique
+{
+
+/**
+ * Overwrite {@param length} bytes at {@param pointer} with zeros. Unlike a
+ * plain memset, the stores are kept even when the memory is never read again.
+ * @param pointer Pointer to the memory to clear.
+ * @param length Length of the memory in bytes.
+ */
+inline void zeroize( void* pointer, size_t length )
+{
+	std::memset( pointer, 0, length );
+
+	// Keep the compiler from discarding the stores as dead.
+	__asm__ __volatile__( "" : : "r"( pointer ) : "memory" );
+}
+
+} // namespace Pique
@@ -0,0 +1,70 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Replaces the global allocation functions of the test executable to count the
+ * calls made by the current thread. Include from a single translation unit.
+ * The replacements are never inlined: inlined, GCC pairs the malloc() of one
+ * with the free() of another and reports every new and delete expression as
+ * mismatched.
+ */
+namespace AllocationCounter
+{
+
+inline thread_local uint64_t gAllocationCount = 0;
+
+/**
+ * Get the number of allocations made by the calling thread so far.
+ * @return The allocation count is returned.
+ */
+inline uint64_t count()
+{
+	return gAllocationCount;
+}
+
+} // namespace AllocationCounter
+
+__attribute__(( noinline )) void* operator new( size_t size )
+{
+	++AllocationCounter::gAllocationCount;
+	if ( void* pointer = std::malloc( size ? size : 1 ) )
+	{
+		return pointer;
+	}
+
+	throw std::bad_alloc();
+}
+
+__attribute__(( noinline )) void* operator new[]( size_t size )
+{
+	return operator new( size );
+}
+
+__attribute__(( noinline )) void operator delete( void* pointer ) noexcept
+{
+	std::free( pointer );
+}
+
+__attribute__(( noinline )) void operator delete[]( void* pointer ) noexcept
+{
+	std::free( pointer );
+}
+
+__attribute__(( noinline )) void operator delete( void* pointer, size_t ) noexcept
+{
+	std::free( pointer );
+}
+
+__attribute__(( noinline )) void operator delete[]( void* pointer, size_t ) noexcept
+{
+	std::free( pointer );
+}
@@ -0,0 +1,50 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "AESGCM.hpp"
+#include "Key.hpp"
+
+/**
+ * Seal or open a message of state.range( 1 ) bytes in place, with a key of
+ * state.range( 0 ) bytes.
+ */
+template < bool Seal >
+static void BenchAESGCM( benchmark::State& state )
+{
+	std::vector< uint8_t > keyValue( size_t( state.range( 0 ) ), 0x4B );
+	std::vector< uint8_t > message( size_t( state.range( 1 ) ), 0xA5 );
+	static const uint8_t nonce[ Pique::AESGCM::NONCE_SIZE ] = { 0 };
+	static const uint8_t associatedData[ 13 ] = { 0 };
+	Pique::Key key( keyValue.data(), keyValue.size() );
+	Pique::AESGCM aesGcm( key );
+	uint8_t tag[ Pique::AESGCM::TAG_SIZE ];
+	aesGcm.seal( message.data(), tag, message.data(), message.size(), nonce, sizeof( nonce ), associatedData, sizeof( associatedData ) );
+
+	for ( auto _ : state )
+	{
+		if ( Seal )
+		{
+			aesGcm.seal( message.data(), tag, message.data(), message.size(), nonce, sizeof( nonce ), associatedData, sizeof( associatedData ) );
+		}
+		else
+		{
+			// The tag no longer matches once the message has been decrypted once, which costs the same.
+			aesGcm.open( message.data(), message.data(), message.size(), tag, nonce, sizeof( nonce ), associatedData, sizeof( associatedData ) );
+		}
+
+		benchmark::DoNotOptimize( message.data() );
+		benchmark::DoNotOptimize( tag );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK_TEMPLATE( BenchAESGCM, true )->ArgsProduct( { { 16, 32 }, { 64, 1024, 16384, 1 << 20 } } );
+BENCHMARK_TEMPLATE( BenchAESGCM, false )->ArgsProduct( { { 16, 32 }, { 64, 1024, 16384, 1 << 20 } } );
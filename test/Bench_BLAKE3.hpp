@@ -0,0 +1,83 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "BLAKE3.hpp"
+#include "CpuFeatures.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Hash a message of state.range( 1 ) bytes, single threaded, with the kernels
+ * of tier state.range( 0 ).
+ */
+static void BenchBLAKE3Tier( benchmark::State& state )
+{
+	Pique::CpuFeatures::force( uint32_t( state.range( 0 ) ) );
+	std::vector< uint8_t > message( state.range( 1 ), 0xA5 );
+	Pique::ThreadPool threadPool( 0 );
+	uint8_t messageDigest[ 32 ];
+
+	for ( auto _ : state )
+	{
+		Pique::BLAKE3 hash;
+		hash.setThreadPool( threadPool );
+		hash.update( message.data(), message.size() );
+		hash.digest( messageDigest, sizeof( messageDigest ) );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	Pique::CpuFeatures::restore();
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK( BenchBLAKE3Tier )->ArgsProduct( {
+	{ Pique::CpuFeatures::TIER_PORTABLE, Pique::CpuFeatures::TIER_SSE4, Pique::CpuFeatures::TIER_AVX2, Pique::CpuFeatures::TIER_AVX512 },
+	{ 64, 4096, 1 << 20 } } );
+
+/**
+ * Hash a 64 MiB message on a pool of state.range( 0 ) workers besides the
+ * calling thread.
+ */
+static void BenchBLAKE3Parallel( benchmark::State& state )
+{
+	std::vector< uint8_t > message( 64 << 20, 0xA5 );
+	Pique::ThreadPool threadPool( size_t( state.range( 0 ) ) );
+	uint8_t messageDigest[ 32 ];
+
+	for ( auto _ : state )
+	{
+		Pique::BLAKE3 hash;
+		hash.setThreadPool( threadPool );
+		hash.update( message.data(), message.size() );
+		hash.digest( messageDigest, sizeof( messageDigest ) );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK( BenchBLAKE3Parallel )->Arg( 0 )->Arg( 1 )->Arg( 3 )->Arg( 7 )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+/**
+ * Squeeze state.range( 0 ) bytes of extended output from a finished hash.
+ */
+static void BenchBLAKE3ExtendedOutput( benchmark::State& state )
+{
+	std::vector< uint8_t > output( state.range( 0 ) );
+	Pique::BLAKE3 hash;
+	hash.update( output.data(), 100 < output.size() ? 100 : output.size() );
+
+	for ( auto _ : state )
+	{
+		hash.digest( output.data(), output.size() );
+		benchmark::DoNotOptimize( output.data() );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( output.size() ) );
+}
+BENCHMARK( BenchBLAKE3ExtendedOutput )->Arg( 32 )->Arg( 1024 )->Arg( 64 << 10 );
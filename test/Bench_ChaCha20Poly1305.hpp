@@ -0,0 +1,51 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "ChaCha20Poly1305.hpp"
+#include "Key.hpp"
+
+/**
+ * Seal or open a message of state.range( 1 ) bytes in place, with a nonce of
+ * state.range( 0 ) bytes.
+ */
+template < bool Seal >
+static void BenchChaCha20Poly1305( benchmark::State& state )
+{
+	std::vector< uint8_t > keyValue( Pique::ChaCha20Poly1305::KEY_SIZE, 0x4B );
+	std::vector< uint8_t > message( size_t( state.range( 1 ) ), 0xA5 );
+	static const uint8_t nonce[ Pique::ChaCha20Poly1305::EXTENDED_NONCE_SIZE ] = { 0 };
+	const size_t nonceLength = size_t( state.range( 0 ) );
+	static const uint8_t associatedData[ 13 ] = { 0 };
+	Pique::Key key( keyValue.data(), keyValue.size() );
+	Pique::ChaCha20Poly1305 chaCha20Poly1305( key );
+	uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+	chaCha20Poly1305.seal( message.data(), tag, message.data(), message.size(), nonce, nonceLength, associatedData, sizeof( associatedData ) );
+
+	for ( auto _ : state )
+	{
+		if ( Seal )
+		{
+			chaCha20Poly1305.seal( message.data(), tag, message.data(), message.size(), nonce, nonceLength, associatedData, sizeof( associatedData ) );
+		}
+		else
+		{
+			// The tag no longer matches once the message has been decrypted once, which costs the same.
+			chaCha20Poly1305.open( message.data(), message.data(), message.size(), tag, nonce, nonceLength, associatedData, sizeof( associatedData ) );
+		}
+
+		benchmark::DoNotOptimize( message.data() );
+		benchmark::DoNotOptimize( tag );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK_TEMPLATE( BenchChaCha20Poly1305, true )->ArgsProduct( { { 12, 24 }, { 64, 1024, 16384, 1 << 20 } } );
+BENCHMARK_TEMPLATE( BenchChaCha20Poly1305, false )->ArgsProduct( { { 12, 24 }, { 64, 1024, 16384, 1 << 20 } } );
@@ -0,0 +1,128 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "BLAKE3.hpp"
+#include "FileHash.hpp"
+
+#if defined( PIQUE_FILE_HASH_POSIX )
+static const size_t BENCH_FILE_HASH_FILE_SIZE = 256 << 20;
+
+/**
+ * The path of a file of BENCH_FILE_HASH_FILE_SIZE bytes, written on first use
+ * and removed at exit. Reads after the first are served by the page cache, so
+ * these measure the hashing side of the pipeline; point the benchmark at a
+ * file on the device itself, with a dropped cache, to measure its bandwidth.
+ */
+static const char* BenchFileHashPath()
+{
+	static std::string path;
+	if ( path.empty() )
+	{
+		const char* environmentPath = std::getenv( "PIQUE_BENCH_FILE_HASH_PATH" );
+		if ( nullptr != environmentPath )
+		{
+			path = environmentPath;
+			return path.c_str();
+		}
+
+		char temporaryPath[] = "/tmp/PiqueBenchFileHashXXXXXX";
+		int fd = ::mkstemp( temporaryPath );
+		std::vector< uint8_t > block( 1 << 20, 0xA5 );
+		for ( size_t offset( 0 ); offset < BENCH_FILE_HASH_FILE_SIZE; offset += block.size() )
+		{
+			if ( ssize_t( block.size() ) != ::write( fd, block.data(), block.size() ) )
+			{
+				break;
+			}
+		}
+
+		::close( fd );
+		path = temporaryPath;
+		std::atexit( []() { ::unlink( path.c_str() ); } );
+	}
+
+	return path.c_str();
+}
+
+static int64_t BenchFileHashSize( const char* path )
+{
+	struct stat status;
+	return ( 0 == ::stat( path, &status ) ) ? int64_t( status.st_size ) : 0;
+}
+
+/**
+ * The baseline: read() into one buffer and update() from it, in turn.
+ */
+static void BenchFileHashReadLoop( benchmark::State& state )
+{
+	const char* path = BenchFileHashPath();
+	std::vector< uint8_t > buffer( Pique::FileHash::BUFFER_SIZE );
+	uint8_t messageDigest[ 32 ];
+
+	for ( auto _ : state )
+	{
+		Pique::BLAKE3 hash;
+		int fd = ::open( path, O_RDONLY );
+		for ( ssize_t length; 0 < ( length = ::read( fd, buffer.data(), buffer.size() ) ); )
+		{
+			hash.update( buffer.data(), uint64_t( length ) );
+		}
+
+		::close( fd );
+		hash.digest( messageDigest, sizeof( messageDigest ) );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * BenchFileHashSize( path ) );
+}
+BENCHMARK( BenchFileHashReadLoop )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+static void BenchFileHashMapped( benchmark::State& state )
+{
+	const char* path = BenchFileHashPath();
+	uint8_t messageDigest[ 32 ];
+
+	for ( auto _ : state )
+	{
+		Pique::BLAKE3 hash;
+		Pique::FileHash::hashFile( hash, path );
+		hash.digest( messageDigest, sizeof( messageDigest ) );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * BenchFileHashSize( path ) );
+}
+BENCHMARK( BenchFileHashMapped )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+/**
+ * The path taken by pipes and sockets: a reader thread and two buffers.
+ */
+static void BenchFileHashReaderThread( benchmark::State& state )
+{
+	const char* path = BenchFileHashPath();
+	uint8_t messageDigest[ 32 ];
+
+	for ( auto _ : state )
+	{
+		Pique::BLAKE3 hash;
+		int fd = ::open( path, O_RDONLY );
+		Pique::FileHash::__hashRead( hash, fd );
+		::close( fd );
+		hash.digest( messageDigest, sizeof( messageDigest ) );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * BenchFileHashSize( path ) );
+}
+BENCHMARK( BenchFileHashReaderThread )->Unit( benchmark::kMillisecond )->UseRealTime();
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "HMAC.hpp"
+#include "Key.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+/**
+ * MAC a message of state.range( 0 ) bytes, either reusing the cached key
+ * midstates or recomputing them for every message.
+ */
+template < typename Hash, bool Cached >
+static void BenchHMACDigestMessage( benchmark::State& state )
+{
+	std::vector< uint8_t > keyValue( 32, 0x4B );
+	std::vector< uint8_t > message( state.range( 0 ), 0xA5 );
+	Pique::Key key( keyValue.data(), keyValue.size() );
+	Pique::HMAC< Hash > cachedHmac( key );
+	uint8_t messageDigest[ Hash::DIGEST_SIZE ];
+
+	for ( auto _ : state )
+	{
+		if ( Cached )
+		{
+			cachedHmac.digestMessage( messageDigest, message.data(), message.size() );
+		}
+		else
+		{
+			Pique::HMAC< Hash > hmac( key );
+			hmac.digestMessage( messageDigest, message.data(), message.size() );
+		}
+
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK_TEMPLATE( BenchHMACDigestMessage, Pique::SHA256, false )->Arg( 64 )->Arg( 1024 );
+BENCHMARK_TEMPLATE( BenchHMACDigestMessage, Pique::SHA256, true )->Arg( 64 )->Arg( 1024 );
+BENCHMARK_TEMPLATE( BenchHMACDigestMessage, Pique::SHA512, false )->Arg( 64 )->Arg( 1024 );
+BENCHMARK_TEMPLATE( BenchHMACDigestMessage, Pique::SHA512, true )->Arg( 64 )->Arg( 1024 );
@@ -0,0 +1,50 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "BLAKE3.hpp"
+#include "SHA256.hpp"
+#include "SHA3.hpp"
+#include "SHA512.hpp"
+
+/**
+ * Hash one message of state.range( 0 ) bytes from a fresh state to its
+ * digest, so small sizes measure the fixed cost of a hash and large sizes its
+ * throughput. Hashes of unlimited digest size output 32 bytes.
+ */
+template < typename Hash >
+static void BenchHashFunctionThroughput( benchmark::State& state )
+{
+	std::vector< uint8_t > message( size_t( state.range( 0 ) ), 0xA5 );
+	uint8_t messageDigest[ ( Hash::UNLIMITED_DIGEST_SIZE == Hash::DIGEST_SIZE ) ? 32 : Hash::DIGEST_SIZE ];
+
+	for ( auto _ : state )
+	{
+		Hash hash;
+		hash.update( message.data(), message.size() );
+		if constexpr ( Hash::UNLIMITED_DIGEST_SIZE == Hash::DIGEST_SIZE )
+		{
+			hash.digest( messageDigest, sizeof( messageDigest ) );
+		}
+		else
+		{
+			hash.digest( messageDigest );
+		}
+
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 0 ) );
+}
+BENCHMARK_TEMPLATE( BenchHashFunctionThroughput, Pique::SHA256 )->RangeMultiplier( 4 )->Range( 16, 16 << 20 );
+BENCHMARK_TEMPLATE( BenchHashFunctionThroughput, Pique::SHA512 )->RangeMultiplier( 4 )->Range( 16, 16 << 20 );
+BENCHMARK_TEMPLATE( BenchHashFunctionThroughput, Pique::SHA3_256 )->RangeMultiplier( 4 )->Range( 16, 16 << 20 );
+BENCHMARK_TEMPLATE( BenchHashFunctionThroughput, Pique::SHAKE128 )->RangeMultiplier( 4 )->Range( 16, 16 << 20 );
+BENCHMARK_TEMPLATE( BenchHashFunctionThroughput, Pique::BLAKE3 )->RangeMultiplier( 4 )->Range( 16, 16 << 20 );
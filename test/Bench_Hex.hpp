@@ -0,0 +1,76 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "Hex.hpp"
+#include "SHA256.hpp"
+
+/**
+ * Encode state.range( 1 ) bytes with the kernels enabled by the tier state.range( 0 ).
+ */
+static void BenchHexEncode( benchmark::State& state )
+{
+	Pique::CpuFeatures::force( uint32_t( state.range( 0 ) ) );
+	std::vector< uint8_t > data( size_t( state.range( 1 ) ), 0xA5 );
+	std::vector< char > hex( 2 * data.size() );
+
+	for ( auto _ : state )
+	{
+		Pique::Hex::encode( hex.data(), data.data(), data.size() );
+		benchmark::ClobberMemory();
+	}
+
+	Pique::CpuFeatures::restore();
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 1 ) );
+}
+BENCHMARK( BenchHexEncode )->ArgsProduct( {
+	{ Pique::CpuFeatures::TIER_PORTABLE, Pique::CpuFeatures::TIER_SSE4, Pique::CpuFeatures::TIER_AVX2 }, { 32, 4096 } } );
+
+/**
+ * Decode state.range( 1 ) bytes with the kernels enabled by the tier state.range( 0 ).
+ */
+static void BenchHexDecode( benchmark::State& state )
+{
+	Pique::CpuFeatures::force( uint32_t( state.range( 0 ) ) );
+	std::vector< char > hex( 2 * size_t( state.range( 1 ) ), 'c' );
+	std::vector< uint8_t > data( hex.size() / 2 );
+
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( Pique::Hex::decode( data.data(), hex.data(), hex.size() ) );
+		benchmark::ClobberMemory();
+	}
+
+	Pique::CpuFeatures::restore();
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 1 ) );
+}
+BENCHMARK( BenchHexDecode )->ArgsProduct( {
+	{ Pique::CpuFeatures::TIER_PORTABLE, Pique::CpuFeatures::TIER_SSE4, Pique::CpuFeatures::TIER_AVX2 }, { 32, 4096 } } );
+
+/**
+ * Format the SHA-256 digest of a message in hex, as a log line would.
+ */
+static void BenchSHA256HexDigest( benchmark::State& state )
+{
+	static const uint8_t message[ 64 ] = { 0x61 };
+	Pique::SHA256 hash;
+	hash.update( message, sizeof( message ) );
+	char hexDigest[ 2 * Pique::SHA256::DIGEST_SIZE ];
+
+	for ( auto _ : state )
+	{
+		hash.hexDigest( hexDigest );
+		benchmark::DoNotOptimize( hexDigest );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK( BenchSHA256HexDigest );
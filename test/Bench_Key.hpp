@@ -0,0 +1,226 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "Key.hpp"
+
+/**
+ * The read path of Key before it was made lock-free, kept as the baseline of
+ * the contention benchmarks: a shared lock around a shared_ptr and a length.
+ */
+class SharedMutexKey final
+{
+private:
+	mutable std::shared_mutex mKeyMutex;
+	std::shared_ptr< const uint8_t > mKeyBuffer;
+	size_t mKeyLength;
+
+public:
+	SharedMutexKey( const uint8_t* value, size_t length ) :
+		mKeyBuffer( new uint8_t[ length ], std::default_delete< const uint8_t[] >() ),
+		mKeyLength( length )
+	{
+		std::memcpy( const_cast< uint8_t* >( mKeyBuffer.get() ), value, length );
+	}
+
+	std::shared_ptr< const uint8_t > key() const
+	{
+		std::shared_lock keyReadLock( mKeyMutex );
+		return mKeyBuffer;
+	}
+
+	size_t length() const
+	{
+		std::shared_lock keyReadLock( mKeyMutex );
+		return mKeyLength;
+	}
+};
+
+static const uint8_t BENCH_KEY_VALUE[ 32 ] = { 0x4B };
+
+static SharedMutexKey gSharedMutexKey( BENCH_KEY_VALUE, sizeof( BENCH_KEY_VALUE ) );
+static Pique::Key gKey( BENCH_KEY_VALUE, sizeof( BENCH_KEY_VALUE ) );
+
+/**
+ * Every thread reads the length of one shared key.
+ */
+template < typename KeyType, KeyType& SharedKey >
+static void BenchKeyLength( benchmark::State& state )
+{
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( SharedKey.length() );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK_TEMPLATE( BenchKeyLength, SharedMutexKey, gSharedMutexKey )->ThreadRange( 1, 64 )->UseRealTime();
+BENCHMARK_TEMPLATE( BenchKeyLength, Pique::Key, gKey )->ThreadRange( 1, 64 )->UseRealTime();
+
+/**
+ * Every thread fetches the buffer of one shared key through key(), which
+ * still updates the shared_ptr reference count.
+ */
+template < typename KeyType, KeyType& SharedKey >
+static void BenchKeyKey( benchmark::State& state )
+{
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( SharedKey.key() );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK_TEMPLATE( BenchKeyKey, SharedMutexKey, gSharedMutexKey )->ThreadRange( 1, 64 )->UseRealTime();
+BENCHMARK_TEMPLATE( BenchKeyKey, Pique::Key, gKey )->ThreadRange( 1, 64 )->UseRealTime();
+
+/**
+ * Every thread reads the first byte of one shared key through read(), which
+ * touches no shared cache line but the key's own.
+ */
+static void BenchKeyRead( benchmark::State& state )
+{
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( gKey.read( []( const uint8_t* buffer, size_t )
+			{
+				return buffer[ 0 ];
+			} ) );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK( BenchKeyRead )->ThreadRange( 1, 64 )->UseRealTime();
+
+/**
+ * The comparison of Key before it was made constant time: byte by byte,
+ * backwards, returning at the first difference. Equal keys are its worst case.
+ */
+static bool ByteWiseEqual( const uint8_t* left, const uint8_t* right, size_t length )
+{
+	for ( size_t index( length ); index--; )
+	{
+		if ( left[ index ] != right[ index ] )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Compare two equal keys of state.range( 0 ) bytes.
+ */
+static void BenchKeyEqualityByteWise( benchmark::State& state )
+{
+	std::vector< uint8_t > value( size_t( state.range( 0 ) ), 0x4B );
+	Pique::Key key( value.data(), value.size() );
+	Pique::Key equalKey( value.data(), value.size() );
+
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( key.read( [ & ]( const uint8_t* buffer, size_t length )
+			{
+				return equalKey.read( [ & ]( const uint8_t* equalBuffer, size_t )
+					{
+						return ByteWiseEqual( buffer, equalBuffer, length );
+					} );
+			} ) );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 0 ) );
+}
+BENCHMARK( BenchKeyEqualityByteWise )->Arg( 32 )->Arg( 256 )->Arg( 4096 );
+
+static void BenchKeyEquality( benchmark::State& state )
+{
+	std::vector< uint8_t > value( size_t( state.range( 0 ) ), 0x4B );
+	Pique::Key key( value.data(), value.size() );
+	Pique::Key equalKey( value.data(), value.size() );
+
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( key == equalKey );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 0 ) );
+}
+BENCHMARK( BenchKeyEquality )->Arg( 32 )->Arg( 256 )->Arg( 4096 );
+
+/**
+ * Construct and destroy a key of state.range( 0 ) bytes, held inline up to
+ * Key::INLINE_CAPACITY and in the secure arena beyond it.
+ */
+static void BenchKeyConstruct( benchmark::State& state )
+{
+	std::vector< uint8_t > value( size_t( state.range( 0 ) ), 0x4B );
+
+	for ( auto _ : state )
+	{
+		Pique::Key key( value.data(), value.size() );
+		benchmark::DoNotOptimize( key );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK( BenchKeyConstruct )->Arg( 32 )->Arg( 256 )->Arg( 4096 );
+
+/**
+ * Copy construct a key of state.range( 0 ) bytes; keys beyond the inline
+ * capacity share their buffer with the original.
+ */
+static void BenchKeyCopy( benchmark::State& state )
+{
+	std::vector< uint8_t > value( size_t( state.range( 0 ) ), 0x4B );
+	Pique::Key key( value.data(), value.size() );
+
+	for ( auto _ : state )
+	{
+		Pique::Key copy( key );
+		benchmark::DoNotOptimize( copy );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK( BenchKeyCopy )->Arg( 32 )->Arg( 256 )->Arg( 4096 );
+
+static void BenchKeyToHex( benchmark::State& state )
+{
+	std::vector< uint8_t > value( size_t( state.range( 0 ) ), 0x4B );
+	Pique::Key key( value.data(), value.size() );
+	std::vector< char > hex( 2 * value.size() );
+
+	for ( auto _ : state )
+	{
+		benchmark::DoNotOptimize( key.toHex( hex.data(), hex.size() ) );
+		benchmark::ClobberMemory();
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 0 ) );
+}
+BENCHMARK( BenchKeyToHex )->Arg( 32 )->Arg( 256 )->Arg( 4096 );
+
+static void BenchKeyFromHex( benchmark::State& state )
+{
+	std::vector< char > hex( 2 * size_t( state.range( 0 ) ), 'c' );
+
+	for ( auto _ : state )
+	{
+		Pique::Key key = Pique::Key::fromHex( hex.data(), hex.size() );
+		benchmark::DoNotOptimize( key );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 0 ) );
+}
+BENCHMARK( BenchKeyFromHex )->Arg( 32 )->Arg( 256 )->Arg( 4096 );
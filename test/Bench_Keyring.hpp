@@ -0,0 +1,111 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "Key.hpp"
+#include "Keyring.hpp"
+
+/**
+ * The tenant key lookup before Keyring, kept as the baseline: an
+ * unordered_map behind one global mutex.
+ */
+class MutexKeyMap final
+{
+private:
+	std::mutex mMutex;
+	std::unordered_map< uint64_t, Pique::Key > mKeys;
+
+public:
+	template < typename Function >
+	bool read( uint64_t keyId, Function&& function )
+	{
+		std::lock_guard< std::mutex > keysLock( mMutex );
+		auto key = mKeys.find( keyId );
+		if ( mKeys.end() == key )
+		{
+			return false;
+		}
+
+		function( static_cast< const Pique::Key& >( key->second ) );
+		return true;
+	}
+
+	void set( uint64_t keyId, Pique::Key key )
+	{
+		std::lock_guard< std::mutex > keysLock( mMutex );
+		mKeys[ keyId ] = std::move( key );
+	}
+};
+
+static const uint64_t BENCH_KEYRING_SIZE = 100000;
+
+/**
+ * A key map filled with BENCH_KEYRING_SIZE 32 byte keys, shared by every
+ * benchmark thread.
+ */
+template < typename KeyMap >
+static KeyMap& BenchKeyMap()
+{
+	static KeyMap* keyMap = []()
+		{
+			KeyMap* keys = new KeyMap();
+			uint8_t value[ 32 ] = { 0 };
+			for ( uint64_t keyId( 0 ); keyId < BENCH_KEYRING_SIZE; ++keyId )
+			{
+				value[ 0 ] = uint8_t( keyId );
+				keys->set( keyId, Pique::Key( value, sizeof( value ) ) );
+			}
+
+			return keys;
+		}();
+
+	return *keyMap;
+}
+
+/**
+ * Every thread looks up pseudorandom key IDs and reads the first byte of each
+ * key. One in every state.range( 0 ) operations rotates the key instead, or
+ * none if it is zero.
+ */
+template < typename KeyMap >
+static void BenchKeyringLookup( benchmark::State& state )
+{
+	KeyMap& keyMap = BenchKeyMap< KeyMap >();
+	uint64_t rotationInterval = uint64_t( state.range( 0 ) );
+	uint64_t random = 0x9E3779B97F4A7C15ULL * uint64_t( state.thread_index() + 1 );
+	uint64_t operation = 0;
+	uint8_t value[ 32 ] = { 0 };
+
+	for ( auto _ : state )
+	{
+		random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint64_t keyId = ( random >> 32 ) % BENCH_KEYRING_SIZE;
+		if ( ( 0 != rotationInterval ) and ( 0 == ++operation % rotationInterval ) )
+		{
+			value[ 0 ] = uint8_t( keyId );
+			value[ 1 ] = uint8_t( operation );
+			keyMap.set( keyId, Pique::Key( value, sizeof( value ) ) );
+			continue;
+		}
+
+		keyMap.read( keyId, []( const Pique::Key& key )
+			{
+				benchmark::DoNotOptimize( key.read( []( const uint8_t* buffer, size_t )
+					{
+						return buffer[ 0 ];
+					} ) );
+			} );
+	}
+
+	state.SetItemsProcessed( int64_t( state.iterations() ) );
+}
+BENCHMARK_TEMPLATE( BenchKeyringLookup, MutexKeyMap )->Arg( 0 )->Arg( 1000 )->ThreadRange( 1, 8 )->UseRealTime();
+BENCHMARK_TEMPLATE( BenchKeyringLookup, Pique::Keyring )->Arg( 0 )->Arg( 1000 )->ThreadRange( 1, 8 )->UseRealTime();
@@ -0,0 +1,71 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "MerkleTree.hpp"
+#include "SHA256.hpp"
+#include "ThreadPool.hpp"
+
+static const size_t BENCH_MERKLE_TREE_MESSAGE_SIZE = 64 << 20;
+
+/**
+ * The baseline: one sequential SHA-256 over the whole message.
+ */
+static void BenchMerkleTreeSequentialSHA256( benchmark::State& state )
+{
+	std::vector< uint8_t > message( BENCH_MERKLE_TREE_MESSAGE_SIZE, 0xA5 );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+
+	for ( auto _ : state )
+	{
+		Pique::SHA256::digestMessage( messageDigest, message.data(), message.size() );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK( BenchMerkleTreeSequentialSHA256 )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+/**
+ * Build the SHA-256 Merkle tree of the message with 64 KiB chunks, on a pool
+ * of state.range( 0 ) workers besides the calling thread.
+ */
+static void BenchMerkleTreeBuild( benchmark::State& state )
+{
+	std::vector< uint8_t > message( BENCH_MERKLE_TREE_MESSAGE_SIZE, 0xA5 );
+	Pique::ThreadPool threadPool( size_t( state.range( 0 ) ) );
+	Pique::MerkleTree< Pique::SHA256 > tree( Pique::MerkleTree< Pique::SHA256 >::DEFAULT_CHUNK_SIZE, threadPool );
+
+	for ( auto _ : state )
+	{
+		tree.build( message.data(), message.size() );
+		benchmark::DoNotOptimize( tree.root() );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK( BenchMerkleTreeBuild )->Arg( 0 )->Arg( 1 )->Arg( 3 )->Arg( 7 )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+static void BenchMerkleTreeProveAndVerify( benchmark::State& state )
+{
+	std::vector< uint8_t > message( BENCH_MERKLE_TREE_MESSAGE_SIZE, 0xA5 );
+	Pique::ThreadPool threadPool( 0 );
+	Pique::MerkleTree< Pique::SHA256 > tree( Pique::MerkleTree< Pique::SHA256 >::DEFAULT_CHUNK_SIZE, threadPool );
+	tree.build( message.data(), message.size() );
+	Pique::MerkleTree< Pique::SHA256 >::Proof proof;
+
+	for ( auto _ : state )
+	{
+		tree.prove( 123, proof );
+		benchmark::DoNotOptimize( Pique::MerkleTree< Pique::SHA256 >::verify( tree.root(),
+			message.data() + 123 * tree.chunkSize(), tree.chunkSize(), proof ) );
+	}
+}
+BENCHMARK( BenchMerkleTreeProveAndVerify );
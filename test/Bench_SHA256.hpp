@@ -0,0 +1,105 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "SHA256.hpp"
+
+static void BenchSHA256CompressPortable( benchmark::State& state )
+{
+	std::vector< uint8_t > blocks( state.range( 0 ), 0xA5 );
+	uint32_t hashState[ 8 ] = { 0 };
+
+	for ( auto _ : state )
+	{
+		Pique::SHA256::__compressPortable( hashState, blocks.data(), blocks.size() / Pique::SHA256::BLOCK_SIZE );
+		benchmark::DoNotOptimize( hashState );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( blocks.size() ) );
+}
+BENCHMARK( BenchSHA256CompressPortable )->Arg( 16 << 10 )->Arg( 1 << 20 );
+
+/**
+ * Digest 4096 messages of state.range( 0 ) bytes, either one digestMessage()
+ * call at a time or as a single digestMessages() batch.
+ */
+template < bool Batched >
+static void BenchSHA256DigestMessages( benchmark::State& state )
+{
+	const size_t messageCount = 4096;
+	const size_t messageLength = state.range( 0 );
+	std::vector< uint8_t > data( messageCount * messageLength, 0xA5 );
+	std::vector< uint8_t > messageDigests( messageCount * Pique::SHA256::DIGEST_SIZE );
+	std::vector< Pique::SHA256::BatchMessage > messages;
+	for ( size_t index( 0 ); index < messageCount; ++index )
+	{
+		messages.push_back( { data.data() + index * messageLength, messageLength, messageDigests.data() + index * Pique::SHA256::DIGEST_SIZE } );
+	}
+
+	for ( auto _ : state )
+	{
+		if ( Batched )
+		{
+			Pique::SHA256::digestMessages( messages.data(), messages.size() );
+		}
+		else
+		{
+			Pique::SHA256::__digestMessagesSerially( messages.data(), messages.size() );
+		}
+
+		benchmark::DoNotOptimize( messageDigests.data() );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( data.size() ) );
+	state.SetItemsProcessed( int64_t( state.iterations() ) * int64_t( messageCount ) );
+}
+BENCHMARK_TEMPLATE( BenchSHA256DigestMessages, false )->Arg( 64 )->Arg( 256 )->Arg( 1024 )->Arg( 2048 );
+BENCHMARK_TEMPLATE( BenchSHA256DigestMessages, true )->Arg( 64 )->Arg( 256 )->Arg( 1024 )->Arg( 2048 );
+
+/**
+ * Hash a 1 MiB message shaped like a network frame: a 14 byte header, the
+ * payload in 4 KiB pages and a 4 byte trailer, either as one contiguous
+ * update() or as a single segmented update().
+ */
+template < bool Segmented >
+static void BenchSHA256UpdateSegments( benchmark::State& state )
+{
+	const size_t pageSize = 4096;
+	std::vector< uint8_t > data( 14 + 256 * pageSize + 4, 0xA5 );
+	std::vector< Pique::MessageSegment > segments;
+	segments.push_back( { data.data(), 14 } );
+	for ( size_t index( 0 ); index < 256; ++index )
+	{
+		segments.push_back( { data.data() + 14 + index * pageSize, pageSize } );
+	}
+
+	segments.push_back( { data.data() + data.size() - 4, 4 } );
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	for ( auto _ : state )
+	{
+		Pique::SHA256 hash;
+		if ( Segmented )
+		{
+			hash.update( segments.data(), segments.size() );
+		}
+		else
+		{
+			hash.update( data.data(), data.size() );
+		}
+
+		hash.digest( messageDigest );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( data.size() ) );
+}
+BENCHMARK_TEMPLATE( BenchSHA256UpdateSegments, false );
+BENCHMARK_TEMPLATE( BenchSHA256UpdateSegments, true );
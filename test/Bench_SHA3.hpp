@@ -0,0 +1,72 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "SHA3.hpp"
+
+static void BenchSHA3Permute( benchmark::State& state )
+{
+	uint64_t keccakState[ 25 ] = { 0 };
+
+	for ( auto _ : state )
+	{
+		Pique::KeccakPermutation::__permute( keccakState );
+		benchmark::DoNotOptimize( keccakState );
+	}
+}
+BENCHMARK( BenchSHA3Permute );
+
+static void BenchSHA3_256Update( benchmark::State& state )
+{
+	std::vector< uint8_t > message( state.range( 0 ), 0xA5 );
+	uint8_t messageDigest[ Pique::SHA3_256::DIGEST_SIZE ];
+
+	for ( auto _ : state )
+	{
+		Pique::SHA3_256::digestMessage( messageDigest, message.data(), message.size() );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK( BenchSHA3_256Update )->Arg( 64 )->Arg( 4096 )->Arg( 1 << 20 );
+
+/**
+ * Expand 1024 seeds of 34 bytes into state.range( 1 ) bytes of SHAKE128 output
+ * each, the shape of a lattice matrix expansion, as one digestMessages() batch
+ * on tier state.range( 0 ).
+ */
+static void BenchSHA3ShakeBatch( benchmark::State& state )
+{
+	Pique::CpuFeatures::force( uint32_t( state.range( 0 ) ) );
+	const size_t messageCount = 1024;
+	const size_t digestSize = state.range( 1 );
+	std::vector< uint8_t > seeds( messageCount * 34, 0xA5 );
+	std::vector< uint8_t > outputs( messageCount * digestSize );
+	std::vector< Pique::SHAKE128::BatchMessage > messages;
+	for ( size_t index( 0 ); index < messageCount; ++index )
+	{
+		messages.push_back( { seeds.data() + index * 34, 34, outputs.data() + index * digestSize } );
+	}
+
+	for ( auto _ : state )
+	{
+		Pique::SHAKE128::digestMessages( messages.data(), messages.size(), digestSize );
+		benchmark::DoNotOptimize( outputs.data() );
+	}
+
+	Pique::CpuFeatures::restore();
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( outputs.size() ) );
+	state.SetItemsProcessed( int64_t( state.iterations() ) * int64_t( messageCount ) );
+}
+BENCHMARK( BenchSHA3ShakeBatch )->ArgsProduct( {
+	{ Pique::CpuFeatures::TIER_PORTABLE, Pique::CpuFeatures::TIER_AVX2, Pique::CpuFeatures::TIER_AVX512 },
+	{ 168, 840 } } );
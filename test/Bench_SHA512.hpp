@@ -0,0 +1,70 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+static void BenchSHA512CompressPortable( benchmark::State& state )
+{
+	std::vector< uint8_t > blocks( state.range( 0 ), 0xA5 );
+	uint64_t hashState[ 8 ] = { 0 };
+
+	for ( auto _ : state )
+	{
+		Pique::SHA512Compression::__compressPortable( hashState, blocks.data(), blocks.size() / Pique::SHA512::BLOCK_SIZE );
+		benchmark::DoNotOptimize( hashState );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( blocks.size() ) );
+}
+BENCHMARK( BenchSHA512CompressPortable )->Arg( 16 << 10 )->Arg( 1 << 20 );
+
+#if defined( PIQUE_SHA512_X86 )
+static void BenchSHA512CompressAvx2( benchmark::State& state )
+{
+	if ( not Pique::CpuFeatures::supports( Pique::CpuFeatures::AVX2 | Pique::CpuFeatures::BMI2 ) )
+	{
+		state.SkipWithError( "AVX2 is not supported" );
+		return;
+	}
+
+	std::vector< uint8_t > blocks( state.range( 0 ), 0xA5 );
+	uint64_t hashState[ 8 ] = { 0 };
+
+	for ( auto _ : state )
+	{
+		Pique::SHA512Compression::__compressAvx2( hashState, blocks.data(), blocks.size() / Pique::SHA512::BLOCK_SIZE );
+		benchmark::DoNotOptimize( hashState );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( blocks.size() ) );
+}
+BENCHMARK( BenchSHA512CompressAvx2 )->Arg( 16 << 10 )->Arg( 1 << 20 );
+#endif
+
+template < typename Hash >
+static void BenchHashUpdate( benchmark::State& state )
+{
+	std::vector< uint8_t > message( state.range( 0 ), 0xA5 );
+	uint8_t messageDigest[ Hash::DIGEST_SIZE ];
+
+	for ( auto _ : state )
+	{
+		Hash::digestMessage( messageDigest, message.data(), message.size() );
+		benchmark::DoNotOptimize( messageDigest );
+	}
+
+	state.SetBytesProcessed( int64_t( state.iterations() ) * int64_t( message.size() ) );
+}
+BENCHMARK_TEMPLATE( BenchHashUpdate, Pique::SHA512 )->Arg( 64 )->Arg( 16 << 10 )->Arg( 1 << 20 );
+BENCHMARK_TEMPLATE( BenchHashUpdate, Pique::SHA384 )->Arg( 64 )->Arg( 16 << 10 )->Arg( 1 << 20 );
+BENCHMARK_TEMPLATE( BenchHashUpdate, Pique::SHA256 )->Arg( 64 )->Arg( 16 << 10 )->Arg( 1 << 20 );
@@ -0,0 +1,65 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Hex.hpp"
+
+/**
+ * Messages and hexadecimal conversions shared by the tests.
+ */
+namespace TestData
+{
+
+/**
+ * Get a message of {@param length} bytes counting up modulo 251, the input of
+ * the official BLAKE3 test vectors. The prime period keeps blocks, chunks and
+ * lanes of every power of two size distinct.
+ * @param length Length of the message in bytes.
+ * @return The message is returned.
+ */
+inline std::vector< uint8_t > message( size_t length )
+{
+	std::vector< uint8_t > bytes( length );
+	for ( size_t index( -1 ); ++index < length; )
+	{
+		bytes[ index ] = uint8_t( index % 251 );
+	}
+
+	return bytes;
+}
+
+/**
+ * Decode a null terminated hexadecimal string.
+ * @param hex Pointer to a null terminated array of hexadecimal digits.
+ * @return The decoded bytes are returned.
+ */
+inline std::vector< uint8_t > fromHex( const char* hex )
+{
+	std::vector< uint8_t > bytes( std::strlen( hex ) / 2 );
+	Pique::Hex::decode( bytes.data(), hex, std::strlen( hex ) );
+	return bytes;
+}
+
+/**
+ * Encode {@param length} bytes as lowercase hexadecimal.
+ * @param bytes Pointer to an array of const bytes.
+ * @param length Length of {@param bytes} in bytes.
+ * @return The hexadecimal string is returned.
+ */
+inline std::string toHex( const uint8_t* bytes, size_t length )
+{
+	std::string hex( 2 * length, '#' );
+	Pique::Hex::encode( &hex[ 0 ], bytes, length );
+	return hex;
+}
+
+} // namespace TestData
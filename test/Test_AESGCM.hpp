@@ -0,0 +1,341 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "AESGCM.hpp"
+#include "CpuFeatures.hpp"
+#include "Key.hpp"
+#include "Keyring.hpp"
+#include "TestData.hpp"
+
+struct AESGCMTestVector
+{
+	const char* key;
+	const char* nonce;
+	const char* associatedData;
+	const char* plaintext;
+	const char* ciphertext;
+	const char* tag;
+};
+
+/**
+ * Test cases 1 to 8 and 13 to 16 of the GCM specification of McGrew and Viega.
+ */
+static const AESGCMTestVector AES_GCM_TEST_VECTORS[] = {
+	{ "00000000000000000000000000000000", "000000000000000000000000", "", "", "",
+		"58e2fccefa7e3061367f1d57a4e7455a" },
+	{ "00000000000000000000000000000000", "000000000000000000000000", "",
+		"00000000000000000000000000000000",
+		"0388dace60b6a392f328c2b971b2fe78",
+		"ab6e47d42cec13bdf53a67b21257bddf" },
+	{ "feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+		"4d5c2af327cd64a62cf35abd2ba6fab4" },
+	{ "feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+		"5bc94fbc3221a5db94fae95ae7121a47" },
+	{ "feffe9928665731c6d6a8f9467308308", "cafebabefacedbad", "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c742373806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+		"3612d2e79e3b0785561be14aaca2fccb" },
+	{ "feffe9928665731c6d6a8f9467308308",
+		"9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca701e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+		"619cc5aefffe0bfa462af43c1699d050" },
+	{ "000000000000000000000000000000000000000000000000", "000000000000000000000000", "", "", "",
+		"cd33b28ac773f74ba00ed1f312572435" },
+	{ "000000000000000000000000000000000000000000000000", "000000000000000000000000", "",
+		"00000000000000000000000000000000",
+		"98e7247c07f0fe411c267e4384b0f600",
+		"2ff58d80033927ab8ef4d4587514f0fb" },
+	{ "0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000", "", "", "",
+		"530f8afbc74536b9a963b4f1c4cb738b" },
+	{ "0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000", "",
+		"00000000000000000000000000000000",
+		"cea7403d4d606b6e074ec5d3baf39d18",
+		"d0d1c8a799996bf0265b98b5d48ab919" },
+	{ "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+		"522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad",
+		"b094dac5d93471bdec1a502270e3cc6c" },
+	{ "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+		"76fc6ece0f4e1768cddf8853bb2d551b" },
+};
+
+static const uint32_t AES_GCM_TIERS[] = {
+	Pique::CpuFeatures::TIER_PORTABLE,
+	Pique::CpuFeatures::TIER_SSE4 | Pique::CpuFeatures::AES | Pique::CpuFeatures::PCLMULQDQ,
+	Pique::CpuFeatures::ALL_FEATURES,
+};
+
+TEST( TestAESGCM, SealAndOpenShallMatchTheSpecificationVectorsOnEveryTier )
+{
+	for ( uint32_t tier : AES_GCM_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( const AESGCMTestVector& vector : AES_GCM_TEST_VECTORS )
+		{
+			std::vector< uint8_t > keyValue = TestData::fromHex( vector.key );
+			std::vector< uint8_t > nonce = TestData::fromHex( vector.nonce );
+			std::vector< uint8_t > associatedData = TestData::fromHex( vector.associatedData );
+			std::vector< uint8_t > plaintext = TestData::fromHex( vector.plaintext );
+			Pique::Key key( keyValue.data(), keyValue.size() );
+			Pique::AESGCM aesGcm( key );
+			ASSERT_TRUE( bool( aesGcm ) );
+
+			std::vector< uint8_t > ciphertext( plaintext.size() );
+			uint8_t tag[ Pique::AESGCM::TAG_SIZE ];
+			ASSERT_TRUE( aesGcm.seal( ciphertext.data(), tag, plaintext.data(), plaintext.size(), nonce.data(), nonce.size(),
+				associatedData.data(), associatedData.size() ) );
+			ASSERT_EQ( vector.ciphertext, TestData::toHex( ciphertext.data(), ciphertext.size() ) ) << std::hex << tier << " " << vector.tag;
+			ASSERT_EQ( vector.tag, TestData::toHex( tag, sizeof( tag ) ) ) << std::hex << tier;
+
+			// Open in place.
+			ASSERT_TRUE( aesGcm.open( ciphertext.data(), ciphertext.data(), ciphertext.size(), tag, nonce.data(), nonce.size(),
+				associatedData.data(), associatedData.size() ) ) << std::hex << tier << " " << vector.tag;
+			ASSERT_EQ( plaintext, ciphertext );
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestAESGCM, EveryKernelShallAgreeForEveryLengthInPlace )
+{
+	static const uint8_t keyValue[ 32 ] = { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81 };
+	static const uint8_t nonce[ Pique::AESGCM::NONCE_SIZE ] = { 0xca, 0xfe, 0xba, 0xbe };
+
+	std::vector< size_t > lengths;
+	for ( size_t length( -1 ); ++length < 300; )
+	{
+		lengths.push_back( length );
+	}
+
+	lengths.insert( lengths.end(), { size_t( 4096 + 17 ), size_t( 65536 + 5 ) } );
+	std::vector< uint8_t > associatedData = TestData::message( 77 );
+
+	for ( size_t keyLength : { size_t( 16 ), size_t( 32 ) } )
+	{
+		Pique::Key key( keyValue, keyLength );
+		for ( size_t length : lengths )
+		{
+			std::vector< uint8_t > message = TestData::message( length );
+			std::vector< uint8_t > expectedCiphertext;
+			std::string expectedTag;
+
+			for ( uint32_t tier : AES_GCM_TIERS )
+			{
+				Pique::CpuFeatures::force( tier );
+				Pique::AESGCM aesGcm( key );
+				std::vector< uint8_t > buffer( message );
+				uint8_t tag[ Pique::AESGCM::TAG_SIZE ];
+				ASSERT_TRUE( aesGcm.seal( buffer.data(), tag, buffer.data(), length, nonce, sizeof( nonce ),
+					associatedData.data(), length % associatedData.size() ) );
+
+				if ( Pique::CpuFeatures::TIER_PORTABLE == tier )
+				{
+					expectedCiphertext = buffer;
+					expectedTag = TestData::toHex( tag, sizeof( tag ) );
+				}
+
+				ASSERT_EQ( expectedCiphertext, buffer ) << std::hex << tier << std::dec << " " << keyLength << " " << length;
+				ASSERT_EQ( expectedTag, TestData::toHex( tag, sizeof( tag ) ) ) << std::hex << tier << std::dec << " " << keyLength << " " << length;
+
+				ASSERT_TRUE( aesGcm.open( buffer.data(), buffer.data(), length, tag, nonce, sizeof( nonce ),
+					associatedData.data(), length % associatedData.size() ) ) << std::hex << tier << std::dec << " " << length;
+				ASSERT_EQ( message, buffer );
+			}
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestAESGCM, TheCounterShallWrapWithinItsLast32BitsInEveryKernel )
+{
+	static const uint8_t keyValue[ 16 ] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::AESGCM aesGcm( key );
+	std::vector< uint8_t > message = TestData::message( 40 * 16 );
+	std::string expectedOutput;
+
+	for ( uint32_t tier : AES_GCM_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( auto crypt : { &Pique::AESGCM::DispatchTable::mSeal, &Pique::AESGCM::DispatchTable::mOpen } )
+		{
+			uint8_t counterBlock[ 16 ] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 };
+			uint64_t hash[ 2 ] = { 0, 0 };
+			std::vector< uint8_t > output( message.size() );
+			( Pique::AESGCM::__kernels().*crypt ).load()( aesGcm.mSchedule, output.data(), message.data(), 40, counterBlock, hash );
+
+			// The counter wraps to 0x18 and the nonce bytes before it are untouched.
+			static const uint8_t expectedCounterBlock[ 16 ] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xFF, 0, 0, 0, 0x18 };
+			ASSERT_EQ( 0, std::memcmp( expectedCounterBlock, counterBlock, sizeof( counterBlock ) ) ) << std::hex << tier;
+
+			// The key stream is the same whichever way it is used, with the ciphertext hashed on the way out or in.
+			std::string outputHex = TestData::toHex( output.data(), output.size() );
+			expectedOutput = expectedOutput.empty() ? outputHex : expectedOutput;
+			ASSERT_EQ( expectedOutput, outputHex ) << std::hex << tier;
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestAESGCM, OpenShallRejectAnyTamperingAndZeroizeThePlaintext )
+{
+	static const uint8_t keyValue[ 16 ] = { 0xfe, 0xff, 0xe9, 0x92 };
+	static const uint8_t nonce[ Pique::AESGCM::NONCE_SIZE ] = { 1, 2, 3 };
+	static const uint8_t associatedData[] = { 'h', 'e', 'a', 'd', 'e', 'r' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::AESGCM aesGcm( key );
+	std::vector< uint8_t > message = TestData::message( 200 );
+	std::vector< uint8_t > ciphertext( message.size() );
+	uint8_t tag[ Pique::AESGCM::TAG_SIZE ];
+	ASSERT_TRUE( aesGcm.seal( ciphertext.data(), tag, message.data(), message.size(), nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+
+	std::vector< uint8_t > plaintext( message.size(), 0xEE );
+	std::vector< uint8_t > zeros( message.size(), 0 );
+
+	std::vector< uint8_t > tamperedCiphertext( ciphertext );
+	tamperedCiphertext[ 150 ] ^= 0x01;
+	ASSERT_FALSE( aesGcm.open( plaintext.data(), tamperedCiphertext.data(), message.size(), tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	uint8_t tamperedTag[ Pique::AESGCM::TAG_SIZE ];
+	std::memcpy( tamperedTag, tag, sizeof( tag ) );
+	tamperedTag[ 15 ] ^= 0x80;
+	std::fill( plaintext.begin(), plaintext.end(), 0xEE );
+	ASSERT_FALSE( aesGcm.open( plaintext.data(), ciphertext.data(), message.size(), tamperedTag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	std::fill( plaintext.begin(), plaintext.end(), 0xEE );
+	ASSERT_FALSE( aesGcm.open( plaintext.data(), ciphertext.data(), message.size(), tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) - 1 ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	static const uint8_t otherNonce[ Pique::AESGCM::NONCE_SIZE ] = { 1, 2, 4 };
+	std::fill( plaintext.begin(), plaintext.end(), 0xEE );
+	ASSERT_FALSE( aesGcm.open( plaintext.data(), ciphertext.data(), message.size(), tag, otherNonce, sizeof( otherNonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	// A truncated message fails too, and the untampered message still opens.
+	ASSERT_FALSE( aesGcm.open( plaintext.data(), ciphertext.data(), message.size() - 1, tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_TRUE( aesGcm.open( plaintext.data(), ciphertext.data(), message.size(), tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( message, plaintext );
+}
+
+TEST( TestAESGCM, InvalidKeysAndArgumentsShallFailWithoutWriting )
+{
+	static const uint8_t keyValue[ 33 ] = { 0 };
+	static const uint8_t nonce[ Pique::AESGCM::NONCE_SIZE ] = { 0 };
+
+	uint8_t message[ 16 ] = { 0x5A };
+	uint8_t output[ 16 ] = { 0 };
+	uint8_t tag[ Pique::AESGCM::TAG_SIZE ] = { 0 };
+	static const uint8_t zeros[ 16 ] = { 0 };
+
+	Pique::AESGCM aesGcm;
+	ASSERT_FALSE( bool( aesGcm ) );
+	ASSERT_FALSE( aesGcm.seal( output, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+
+	for ( size_t keyLength : { size_t( 0 ), size_t( 15 ), size_t( 17 ), size_t( 31 ), size_t( 33 ) } )
+	{
+		Pique::Key key( keyValue, keyLength );
+		ASSERT_FALSE( aesGcm.setKey( key ) ) << keyLength;
+		ASSERT_FALSE( bool( aesGcm ) ) << keyLength;
+	}
+
+	for ( size_t keyLength : { size_t( 16 ), size_t( 24 ), size_t( 32 ) } )
+	{
+		Pique::Key key( keyValue, keyLength );
+		ASSERT_TRUE( aesGcm.setKey( key ) ) << keyLength;
+	}
+
+	Pique::Key key( keyValue, 16 );
+	ASSERT_TRUE( aesGcm.setKey( key ) );
+	ASSERT_FALSE( aesGcm.seal( output, tag, message, sizeof( message ), nonce, 0 ) );
+	ASSERT_FALSE( aesGcm.seal( output, tag, message, sizeof( message ), nullptr, sizeof( nonce ) ) );
+	ASSERT_FALSE( aesGcm.seal( output, tag, message, Pique::AESGCM::MAXIMUM_MESSAGE_SIZE + 1, nonce, sizeof( nonce ) ) );
+	ASSERT_FALSE( aesGcm.seal( output, tag, message, sizeof( message ), nonce, sizeof( nonce ), nullptr, 1 ) );
+	ASSERT_EQ( 0, std::memcmp( zeros, output, sizeof( output ) ) );
+	ASSERT_EQ( 0, std::memcmp( zeros, tag, sizeof( tag ) ) );
+
+	// An empty message needs no buffers.
+	ASSERT_TRUE( aesGcm.seal( nullptr, tag, nullptr, 0, nonce, sizeof( nonce ) ) );
+	ASSERT_TRUE( aesGcm.open( nullptr, nullptr, 0, tag, nonce, sizeof( nonce ) ) );
+
+	aesGcm.clear();
+	ASSERT_FALSE( bool( aesGcm ) );
+	ASSERT_FALSE( aesGcm.seal( output, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+}
+
+TEST( TestAESGCM, TheScheduleShallBeDiscardedWhenTheBoundKeyIsWritten )
+{
+	static const uint8_t keyValue[ 16 ] = { 1, 2, 3, 4 };
+	static const uint8_t nonce[ Pique::AESGCM::NONCE_SIZE ] = { 0 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::Key copyKey( key );
+	Pique::AESGCM aesGcm( key );
+	uint8_t ciphertext[ sizeof( message ) ];
+	uint8_t tag[ Pique::AESGCM::TAG_SIZE ];
+
+	copyKey.clear();
+	ASSERT_TRUE( aesGcm.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+
+	key.set( keyValue, sizeof( keyValue ) );
+	ASSERT_FALSE( aesGcm.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+	static const Pique::AESGCM::Schedule zeroSchedule = {};
+	ASSERT_EQ( 0, std::memcmp( &zeroSchedule, &aesGcm.mSchedule, sizeof( zeroSchedule ) ) );
+
+	ASSERT_TRUE( aesGcm.setKey( key ) );
+	ASSERT_TRUE( aesGcm.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+}
+
+TEST( TestAESGCM, TheScheduleShallBeDiscardedWhenTheKeyringRotatesTheBoundKey )
+{
+	static const uint8_t keyValue[ 16 ] = { 1, 2, 3, 4 };
+	static const uint8_t nonce[ Pique::AESGCM::NONCE_SIZE ] = { 0 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Keyring keyring;
+	Pique::AESGCM aesGcm;
+	uint8_t ciphertext[ sizeof( message ) ];
+	uint8_t tag[ Pique::AESGCM::TAG_SIZE ];
+
+	keyring.set( 1, Pique::Key( keyValue, sizeof( keyValue ) ) );
+	ASSERT_TRUE( keyring.read( 1, [ &aesGcm ]( const Pique::Key& key ) { aesGcm.setKey( key ); } ) );
+	ASSERT_TRUE( aesGcm.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+
+	// The rotated Key is destroyed, and with it the only holder of the material.
+	keyring.set( 1, Pique::Key( keyValue, sizeof( keyValue ) ) );
+	ASSERT_FALSE( aesGcm.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+	ASSERT_FALSE( aesGcm );
+}
@@ -0,0 +1,131 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "AnyHashFunction.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+TEST( TestAnyHashFunction, ConstructorShallReportTheSizesOfTheWrappedHash )
+{
+	Pique::AnyHashFunction sha256( ( Pique::SHA256() ) );
+	Pique::AnyHashFunction sha384( ( Pique::SHA384() ) );
+
+	ASSERT_EQ( Pique::SHA256::BLOCK_SIZE, sha256.blockSize() );
+	ASSERT_EQ( Pique::SHA256::DIGEST_SIZE, sha256.digestSize() );
+	ASSERT_EQ( Pique::SHA384::BLOCK_SIZE, sha384.blockSize() );
+	ASSERT_EQ( Pique::SHA384::DIGEST_SIZE, sha384.digestSize() );
+}
+
+TEST( TestAnyHashFunction, DigestShallMatchTheWrappedHash )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::SHA512::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::AnyHashFunction hash( ( Pique::SHA512() ) );
+	uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+	hash.update( message, sizeof( message ) );
+
+	ASSERT_EQ( Pique::SHA512::DIGEST_SIZE, hash.digest( messageDigest, sizeof( messageDigest ) ) );
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestAnyHashFunction, DigestShallTruncateAFixedSizeDigestAndNeverWritePastIt )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::AnyHashFunction hash( ( Pique::SHA256() ) );
+	hash.update( message, sizeof( message ) );
+
+	uint8_t shortDigest[ 10 ];
+	ASSERT_EQ( sizeof( shortDigest ), hash.digest( shortDigest, sizeof( shortDigest ) ) );
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, shortDigest, sizeof( shortDigest ) ) );
+
+	std::vector< uint8_t > longDigest( 2 * Pique::SHA256::DIGEST_SIZE, 0xEE );
+	ASSERT_EQ( Pique::SHA256::DIGEST_SIZE, hash.digest( longDigest.data(), longDigest.size() ) );
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, longDigest.data(), Pique::SHA256::DIGEST_SIZE ) );
+	ASSERT_EQ( 0xEE, longDigest[ Pique::SHA256::DIGEST_SIZE ] );
+}
+
+TEST( TestAnyHashFunction, CopyConstructorShallDuplicateTheStateOfTheWrappedHash )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::AnyHashFunction hash( ( Pique::SHA256() ) );
+	hash.update( message, 1 );
+
+	Pique::AnyHashFunction copy( hash );
+	hash.update( message, 1 );
+	copy.update( message + 1, sizeof( message ) - 1 );
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	copy.digest( messageDigest, sizeof( messageDigest ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestAnyHashFunction, ResetShallReturnTheWrappedHashToTheInitialState )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::AnyHashFunction hash( ( Pique::SHA256() ) );
+	hash.update( message, sizeof( message ) );
+	hash.reset();
+	hash.update( message, sizeof( message ) );
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	hash.digest( messageDigest, sizeof( messageDigest ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestAnyHashFunction, SegmentedUpdateShallMatchTheWrappedHash )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA384::DIGEST_SIZE ];
+	Pique::SHA384::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::MessageSegment segments[] = { { message, 1 }, { message + 1, 2 } };
+	Pique::AnyHashFunction hash( ( Pique::SHA384() ) );
+	hash.update( segments, 2 );
+
+	uint8_t messageDigest[ Pique::SHA384::DIGEST_SIZE ];
+	hash.digest( messageDigest, sizeof( messageDigest ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+
+#if defined( PIQUE_HASH_FUNCTION_IOVEC )
+	struct iovec vectors[ 2 ];
+	for ( size_t index( 0 ); index < 2; ++index )
+	{
+		vectors[ index ].iov_base = const_cast< uint8_t* >( segments[ index ].message );
+		vectors[ index ].iov_len = segments[ index ].messageLength;
+	}
+
+	hash.reset();
+	hash.update( vectors, 2 );
+	hash.digest( messageDigest, sizeof( messageDigest ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+#endif
+}
@@ -0,0 +1,204 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AsyncHash.hpp"
+#include "BLAKE3.hpp"
+#include "SHA256.hpp"
+#include "TestData.hpp"
+
+/**
+ * Counts the completions of asynchronous operations, and records the thread
+ * and pending bytes of the pool of each.
+ */
+class AsyncHashCompletions final
+{
+private:
+	std::mutex mMutex;
+	std::condition_variable mCompleted;
+	size_t mCount = 0;
+
+public:
+	const Pique::AsyncHashPool* mPool = nullptr;
+	std::thread::id mLastThread;
+	uint64_t mMaximumPendingBytes = 0;
+
+	static void complete( void* context )
+	{
+		AsyncHashCompletions* completions = static_cast< AsyncHashCompletions* >( context );
+		std::lock_guard< std::mutex > lock( completions->mMutex );
+		completions->mLastThread = std::this_thread::get_id();
+		if ( nullptr != completions->mPool )
+		{
+			completions->mMaximumPendingBytes = std::max( completions->mMaximumPendingBytes, completions->mPool->pendingBytes() );
+		}
+
+		++completions->mCount;
+		completions->mCompleted.notify_all();
+	}
+
+	size_t count()
+	{
+		std::lock_guard< std::mutex > lock( mMutex );
+		return mCount;
+	}
+
+	void wait( size_t count )
+	{
+		std::unique_lock< std::mutex > lock( mMutex );
+		mCompleted.wait( lock, [ & ]() { return count <= mCount; } );
+	}
+};
+
+TEST( TestAsyncHash, ShortUpdatesShallRunInlineAndLongOnesOnThePool )
+{
+	Pique::AsyncHashPool pool( 2 );
+	Pique::AsyncHash< Pique::SHA256 > asyncHash( pool, 1024 );
+	std::vector< uint8_t > message = TestData::message( 5000 );
+	AsyncHashCompletions completions;
+
+	asyncHash.update( message.data(), 1000, AsyncHashCompletions::complete, &completions );
+	ASSERT_EQ( 1, completions.count() );
+	ASSERT_EQ( std::this_thread::get_id(), completions.mLastThread );
+
+	asyncHash.update( message.data() + 1000, 4000, AsyncHashCompletions::complete, &completions );
+	completions.wait( 2 );
+	ASSERT_NE( std::this_thread::get_id(), completions.mLastThread );
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	asyncHash.digest( messageDigest, AsyncHashCompletions::complete, &completions );
+	completions.wait( 3 );
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message.data(), message.size() );
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestAsyncHash, OperationsShallRunInTheOrderTheyWereStarted )
+{
+	Pique::AsyncHashPool pool( 4 );
+	std::vector< uint8_t > message = TestData::message( 1 << 20 );
+	for ( uint64_t inlineThreshold : { uint64_t( 0 ), uint64_t( 100 ), uint64_t( 1 ) << 30 } )
+	{
+		Pique::AsyncHash< Pique::BLAKE3 > asyncHash( pool, inlineThreshold );
+		AsyncHashCompletions completions;
+
+		// Short updates queue behind long ones without overtaking them, and digests see every update before them.
+		size_t operations = 0;
+		uint8_t messageDigests[ 2 ][ 40 ];
+		for ( size_t offset( 0 ), step( 1 ); offset < message.size(); offset += step, step = step * 5 % 65537 )
+		{
+			asyncHash.update( message.data() + offset, std::min( step, message.size() - offset ), AsyncHashCompletions::complete, &completions );
+			++operations;
+			if ( 0 == operations % 50 )
+			{
+				asyncHash.digest( messageDigests[ 0 ], sizeof( messageDigests[ 0 ] ), nullptr, nullptr );
+			}
+		}
+
+		asyncHash.digest( messageDigests[ 1 ], sizeof( messageDigests[ 1 ] ), AsyncHashCompletions::complete, &completions );
+		completions.wait( operations + 1 );
+
+		uint8_t expectedDigest[ sizeof( messageDigests[ 1 ] ) ];
+		Pique::BLAKE3::digestMessage( expectedDigest, sizeof( expectedDigest ), message.data(), message.size() );
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigests[ 1 ], sizeof( expectedDigest ) ) ) << inlineThreshold;
+	}
+}
+
+TEST( TestAsyncHash, ThePoolShallHoldBackUpdatesBeyondItsLimit )
+{
+	const uint64_t maximumPendingBytes = 1 << 20;
+	Pique::AsyncHashPool pool( 3, maximumPendingBytes );
+	std::vector< uint8_t > message = TestData::message( 3 << 20 );
+	AsyncHashCompletions completions;
+	completions.mPool = &pool;
+
+	// Many streams at once, each with every update outstanding; one update is longer than the limit.
+	std::vector< std::unique_ptr< Pique::AsyncHash< Pique::SHA256 > > > asyncHashes;
+	std::vector< std::vector< uint8_t > > messageDigests( 16, std::vector< uint8_t >( Pique::SHA256::DIGEST_SIZE ) );
+	for ( size_t stream( -1 ); ++stream < messageDigests.size(); )
+	{
+		asyncHashes.emplace_back( new Pique::AsyncHash< Pique::SHA256 >( pool, 4096 ) );
+		size_t length = ( 0 == stream ) ? message.size() : ( stream * 40000 );
+		asyncHashes.back()->update( message.data(), length / 2, AsyncHashCompletions::complete, &completions );
+		asyncHashes.back()->update( message.data() + length / 2, length - length / 2, AsyncHashCompletions::complete, &completions );
+		asyncHashes.back()->digest( messageDigests[ stream ].data(), AsyncHashCompletions::complete, &completions );
+	}
+
+	completions.wait( 3 * messageDigests.size() );
+	// The update longer than the limit was admitted alone.
+	ASSERT_LT( maximumPendingBytes, completions.mMaximumPendingBytes );
+	ASSERT_LE( completions.mMaximumPendingBytes, message.size() - message.size() / 2 );
+	for ( size_t stream( -1 ); ++stream < messageDigests.size(); )
+	{
+		size_t length = ( 0 == stream ) ? message.size() : ( stream * 40000 );
+		uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+		Pique::SHA256::digestMessage( expectedDigest, message.data(), length );
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigests[ stream ].data(), sizeof( expectedDigest ) ) ) << stream;
+	}
+
+	ASSERT_EQ( 0, pool.pendingBytes() );
+}
+
+/**
+ * A stream that frees itself from the completion of its digest.
+ */
+struct AsyncHashSelfDestroyingStream
+{
+	Pique::AsyncHash< Pique::SHA256 > mAsyncHash;
+	uint8_t mMessageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	uint8_t* mResult;
+	AsyncHashCompletions* mCompletions;
+
+	AsyncHashSelfDestroyingStream( Pique::AsyncHashPool& pool, uint8_t* result, AsyncHashCompletions* completions ) :
+		mAsyncHash( pool, 256 ),
+		mResult( result ),
+		mCompletions( completions )
+	{
+	}
+
+	static void finish( void* context )
+	{
+		AsyncHashSelfDestroyingStream* stream = static_cast< AsyncHashSelfDestroyingStream* >( context );
+		std::memcpy( stream->mResult, stream->mMessageDigest, sizeof( stream->mMessageDigest ) );
+		AsyncHashCompletions* completions = stream->mCompletions;
+		delete stream;
+		AsyncHashCompletions::complete( completions );
+	}
+};
+
+TEST( TestAsyncHash, TheLastCompletionShallBeFreeToDestroyTheHasher )
+{
+	Pique::AsyncHashPool pool( 2 );
+	std::vector< uint8_t > message = TestData::message( 100000 );
+	uint8_t results[ 8 ][ Pique::SHA256::DIGEST_SIZE ];
+	AsyncHashCompletions completions;
+
+	for ( size_t stream( -1 ); ++stream < 8; )
+	{
+		AsyncHashSelfDestroyingStream* selfDestroyingStream = new AsyncHashSelfDestroyingStream( pool, results[ stream ], &completions );
+		selfDestroyingStream->mAsyncHash.update( message.data(), message.size() - stream, nullptr, nullptr );
+		selfDestroyingStream->mAsyncHash.digest( selfDestroyingStream->mMessageDigest, AsyncHashSelfDestroyingStream::finish, selfDestroyingStream );
+	}
+
+	completions.wait( 8 );
+	for ( size_t stream( -1 ); ++stream < 8; )
+	{
+		uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+		Pique::SHA256::digestMessage( expectedDigest, message.data(), message.size() - stream );
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, results[ stream ], sizeof( expectedDigest ) ) ) << stream;
+	}
+}
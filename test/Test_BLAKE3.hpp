@@ -0,0 +1,471 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BLAKE3.hpp"
+#include "CpuFeatures.hpp"
+#include "Key.hpp"
+#include "TestData.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * The test vectors published with the BLAKE3 reference implementation: the
+ * message is the byte sequence 0, 1, ..., 250, 0, 1, ... of the given length.
+ */
+struct BLAKE3TestVector
+{
+	size_t messageLength;
+	const char* hash;
+	const char* keyedHash;
+	const char* deriveKey;
+};
+
+static const char BLAKE3_TEST_KEY[] = "whats the Elvish word for friend";
+static const char BLAKE3_TEST_CONTEXT[] = "BLAKE3 2019-12-27 16:29:52 test vectors context";
+
+static const BLAKE3TestVector BLAKE3_TEST_VECTORS[] = {
+	{ 0,
+		"af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
+		"92b2b75604ed3c761f9d6f62392c8a9227ad0ea3f09573e783f1498a4ed60d26",
+		"2cc39783c223154fea8dfb7c1b1660f2ac2dcbd1c1de8277b0b0dd39b7e50d7d" },
+	{ 1,
+		"2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213",
+		"6d7878dfff2f485635d39013278ae14f1454b8c0a3a2d34bc1ab38228a80c95b",
+		"b3e2e340a117a499c6cf2398a19ee0d29cca2bb7404c73063382693bf66cb06c" },
+	{ 63,
+		"e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b",
+		"bb1eb5d4afa793c1ebdd9fb08def6c36d10096986ae0cfe148cd101170ce37ae",
+		"b6451e30b953c206e34644c6803724e9d2725e0893039cfc49584f991f451af3" },
+	{ 64,
+		"4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98",
+		"ba8ced36f327700d213f120b1a207a3b8c04330528586f414d09f2f7d9ccb7e6",
+		"a5c4a7053fa86b64746d4bb688d06ad1f02a18fce9afd3e818fefaa7126bf73e" },
+	{ 65,
+		"de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee",
+		"c0a4edefa2d2accb9277c371ac12fcdbb52988a86edc54f0716e1591b4326e72",
+		"51fd05c3c1cfbc8ed67d139ad76f5cf8236cd2acd26627a30c104dfd9d3ff8a8" },
+	{ 1023,
+		"10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11",
+		"c951ecdf03288d0fcc96ee3413563d8a6d3589547f2c2fb36d9786470f1b9d6e",
+		"74a16c1c3d44368a86e1ca6df64be6a2f64cce8f09220787450722d85725dea5" },
+	{ 1024,
+		"42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7",
+		"75c46f6f3d9eb4f55ecaaee480db732e6c2105546f1e675003687c31719c7ba4",
+		"7356cd7720d5b66b6d0697eb3177d9f8d73a4a5c5e968896eb6a689684302706" },
+	{ 1025,
+		"d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444",
+		"357dc55de0c7e382c900fd6e320acc04146be01db6a8ce7210b7189bd664ea69",
+		"effaa245f065fbf82ac186839a249707c3bddf6d3fdda22d1b95a3c970379bcb" },
+	{ 2048,
+		"e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a",
+		"879cf1fa2ea0e79126cb1063617a05b6ad9d0b696d0d757cf053439f60a99dd1",
+		"7b2945cb4fef70885cc5d78a87bf6f6207dd901ff239201351ffac04e1088a23" },
+	{ 2049,
+		"5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030",
+		"9f29700902f7c86e514ddc4df1e3049f258b2472b6dd5267f61bf13983b78dd5",
+		"2ea477c5515cc3dd606512ee72bb3e0e758cfae7232826f35fb98ca1bcbdf273" },
+	{ 3072,
+		"b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2",
+		"044a0e7b172a312dc02a4c9a818c036ffa2776368d7f528268d2e6b5df191770",
+		"050df97f8c2ead654d9bb3ab8c9178edcd902a32f8495949feadcc1e0480c46b" },
+	{ 3073,
+		"7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3",
+		"68dede9bef00ba89e43f31a6825f4cf433389fedae75c04ee9f0cf16a427c95a",
+		"72613c9ec9ff7e40f8f5c173784c532ad852e827dba2bf85b2ab4b76f7079081" },
+	{ 4096,
+		"015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969",
+		"befc660aea2f1718884cd8deb9902811d332f4fc4a38cf7c7300d597a081bfc0",
+		"1e0d7f3db8c414c97c6307cbda6cd27ac3b030949da8e23be1a1a924ad2f25b9" },
+	{ 4097,
+		"9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995",
+		"00df940cd36bb9fa7cbbc3556744e0dbc8191401afe70520ba292ee3ca80abbc",
+		"aca51029626b55fda7117b42a7c211f8c6e9ba4fe5b7a8ca922f34299500ead8" },
+	{ 5120,
+		"9cadc15fed8b5d854562b26a9536d9707cadeda9b143978f319ab34230535833",
+		"2c493e48e9b9bf31e0553a22b23503c0a3388f035cece68eb438d22fa1943e20",
+		"7a7acac8a02adcf3038d74cdd1d34527de8a0fcc0ee3399d1262397ce5817f60" },
+	{ 5121,
+		"628bd2cb2004694adaab7bbd778a25df25c47b9d4155a55f8fbd79f2fe154cff",
+		"6ccf1c34753e7a044db80798ecd0782a8f76f33563accaddbfbb2e0ea4b2d024",
+		"b07f01e518e702f7ccb44a267e9e112d403a7b3f4883a47ffbed4b48339b3c34" },
+	{ 6144,
+		"3e2e5b74e048f3add6d21faab3f83aa44d3b2278afb83b80b3c35164ebeca205",
+		"3d6b6d21281d0ade5b2b016ae4034c5dec10ca7e475f90f76eac7138e9bc8f1d",
+		"2a95beae63ddce523762355cf4b9c1d8f131465780a391286a5d01abb5683a15" },
+	{ 6145,
+		"f1323a8631446cc50536a9f705ee5cb619424d46887f3c376c695b70e0f0507f",
+		"9ac301e9e39e45e3250a7e3b3df701aa0fb6889fbd80eeecf28dbc6300fbc539",
+		"379bcc61d0051dd489f686c13de00d5b14c505245103dc040d9e4dd1facab8e5" },
+	{ 7168,
+		"61da957ec2499a95d6b8023e2b0e604ec7f6b50e80a9678b89d2628e99ada77a",
+		"b42835e40e9d4a7f42ad8cc04f85a963a76e18198377ed84adddeaecacc6f3fc",
+		"11c37a112765370c94a51415d0d651190c288566e295d505defdad895dae2237" },
+	{ 7169,
+		"a003fc7a51754a9b3c7fae0367ab3d782dccf28855a03d435f8cfe74605e7817",
+		"ed9b1a922c046fdb3d423ae34e143b05ca1bf28b710432857bf738bcedbfa511",
+		"554b0a5efea9ef183f2f9b931b7497995d9eb26f5c5c6dad2b97d62fc5ac31d9" },
+	{ 8192,
+		"aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63",
+		"dc9637c8845a770b4cbf76b8daec0eebf7dc2eac11498517f08d44c8fc00d58a",
+		"ad01d7ae4ad059b0d33baa3c01319dcf8088094d0359e5fd45d6aeaa8b2d0c3d" },
+	{ 8193,
+		"bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b",
+		"954a2a75420c8d6547e3ba5b98d963e6fa6491addc8c023189cc519821b4a1f5",
+		"af1e0346e389b17c23200270a64aa4e1ead98c61695d917de7d5b00491c9b0f1" },
+	{ 16384,
+		"f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4",
+		"9e9fc4eb7cf081ea7c47d1807790ed211bfec56aa25bb7037784c13c4b707b0d",
+		"160e18b5878cd0df1c3af85eb25a0db5344d43a6fbd7a8ef4ed98d0714c3f7e1" },
+	{ 31744,
+		"62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47",
+		"efa53b389ab67c593dba624d898d0f7353ab99e4ac9d42302ee64cbf9939a419",
+		"39772aef80e0ebe60596361e45b061e8f417429d529171b6764468c22928e28e" },
+	{ 102400,
+		"bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085",
+		"1c35d1a5811083fd7119f5d5d1ba027b4d01c0c6c49fb6ff2cf75393ea5db4a7",
+		"4652cff7a3f385a6103b5c260fc1593e13c778dbe608efb092fe7ee69df6e9c6" },
+};
+
+static const uint32_t BLAKE3_TIERS[] = {
+	Pique::CpuFeatures::TIER_PORTABLE,
+	Pique::CpuFeatures::TIER_SSE4,
+	Pique::CpuFeatures::TIER_AVX2,
+	Pique::CpuFeatures::TIER_AVX512,
+};
+
+static std::string BLAKE3HexDigest( const Pique::BLAKE3& hash, size_t digestSize = 32 )
+{
+	std::vector< uint8_t > messageDigest( digestSize );
+	hash.digest( messageDigest.data(), digestSize );
+	return TestData::toHex( messageDigest.data(), digestSize );
+}
+
+static Pique::Key BLAKE3TestKey()
+{
+	return Pique::Key( reinterpret_cast< const uint8_t* >( BLAKE3_TEST_KEY ), Pique::BLAKE3::KEY_SIZE );
+}
+
+TEST( TestBLAKE3, DigestShallMatchTheReferenceVectorsInEveryModeOnEveryTier )
+{
+	const Pique::Key key = BLAKE3TestKey();
+	for ( uint32_t tier : BLAKE3_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( const BLAKE3TestVector& vector : BLAKE3_TEST_VECTORS )
+		{
+			std::vector< uint8_t > message = TestData::message( vector.messageLength );
+
+			Pique::BLAKE3 hash;
+			hash.update( message.data(), message.size() );
+			ASSERT_EQ( vector.hash, BLAKE3HexDigest( hash ) ) << std::hex << tier << std::dec << " " << vector.messageLength;
+
+			Pique::BLAKE3 keyedHash;
+			ASSERT_TRUE( keyedHash.setKey( key ) );
+			keyedHash.update( message.data(), message.size() );
+			ASSERT_EQ( vector.keyedHash, BLAKE3HexDigest( keyedHash ) ) << std::hex << tier << std::dec << " " << vector.messageLength;
+
+			Pique::BLAKE3 deriveKeyHash;
+			deriveKeyHash.setDeriveKeyContext( BLAKE3_TEST_CONTEXT );
+			deriveKeyHash.update( message.data(), message.size() );
+			ASSERT_EQ( vector.deriveKey, BLAKE3HexDigest( deriveKeyHash ) ) << std::hex << tier << std::dec << " " << vector.messageLength;
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestBLAKE3, DigestShallExtendTheOutputToAnyLength )
+{
+	static const char expectedHash[] =
+		"d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444f4c4a22b4b399155358a994e52bf255d"
+		"e60035742ec71bd08ac275a1b51cc6bfe332b0ef84b409108cda080e6269ed4b3e2c3f7d722aa4cdc98d16deb554e562"
+		"7be8f955c98e1d5f9565a9194cad0c4285f93700062d9595adb992ae68ff12800ab67a";
+	static const char expectedKeyedHash[] =
+		"68dede9bef00ba89e43f31a6825f4cf433389fedae75c04ee9f0cf16a427c95a96d6da3fe985054d3478865be9a09225"
+		"0839a697bbda74e279e8a9e69f0025e4cfddd6cfb434b1cd9543aaf97c635d1b451a4386041e4bb100f5e45407cbbc24"
+		"fa53ea2de3536ccb329e4eb9466ec37093a42cf62b82903c696a93a50b702c80f3c3c5";
+
+	std::vector< uint8_t > message = TestData::message( 3073 );
+	Pique::BLAKE3 hash;
+	hash.update( message.data(), 1025 );
+	ASSERT_EQ( expectedHash, BLAKE3HexDigest( hash, 131 ) );
+
+	Pique::BLAKE3 keyedHash;
+	ASSERT_TRUE( keyedHash.setKey( BLAKE3TestKey() ) );
+	keyedHash.update( message.data(), message.size() );
+	ASSERT_EQ( expectedKeyedHash, BLAKE3HexDigest( keyedHash, 131 ) );
+
+	// A shorter digest is a prefix of a longer one.
+	for ( size_t digestSize( 0 ); ++digestSize <= 131; )
+	{
+		ASSERT_EQ( std::string( expectedHash, 2 * digestSize ), BLAKE3HexDigest( hash, digestSize ) );
+	}
+}
+
+TEST( TestBLAKE3, DeriveKeyShallReturnTheDigestOfTheKeyMaterialAsAKey )
+{
+	const BLAKE3TestVector& vector = BLAKE3_TEST_VECTORS[ 7 ];
+	ASSERT_EQ( 1025, vector.messageLength );
+	std::vector< uint8_t > keyMaterial = TestData::message( vector.messageLength );
+
+	Pique::Key derivedKey = Pique::BLAKE3::deriveKey( BLAKE3_TEST_CONTEXT, Pique::Key( keyMaterial.data(), keyMaterial.size() ) );
+	char hex[ 64 ];
+	ASSERT_EQ( 32, derivedKey.length() );
+	ASSERT_EQ( 64, derivedKey.toHex( hex, sizeof( hex ) ) );
+	ASSERT_EQ( std::string( vector.deriveKey ), std::string( hex, sizeof( hex ) ) );
+
+	Pique::BLAKE3 deriveKeyHash;
+	deriveKeyHash.setDeriveKeyContext( BLAKE3_TEST_CONTEXT );
+	deriveKeyHash.update( keyMaterial.data(), keyMaterial.size() );
+	std::vector< char > longHex( 2 * 100 );
+	Pique::Key longDerivedKey = Pique::BLAKE3::deriveKey( BLAKE3_TEST_CONTEXT, Pique::Key( keyMaterial.data(), keyMaterial.size() ), 100 );
+	ASSERT_EQ( 200, longDerivedKey.toHex( longHex.data(), longHex.size() ) );
+	ASSERT_EQ( BLAKE3HexDigest( deriveKeyHash, 100 ), std::string( longHex.data(), longHex.size() ) );
+
+	ASSERT_EQ( 0, Pique::BLAKE3::deriveKey( BLAKE3_TEST_CONTEXT, Pique::Key() ).length() );
+	ASSERT_EQ( 0, Pique::BLAKE3::deriveKey( BLAKE3_TEST_CONTEXT, Pique::Key( keyMaterial.data(), 1 ), 0 ).length() );
+}
+
+TEST( TestBLAKE3, SetKeyShallRejectKeysOfTheWrongLength )
+{
+	std::vector< uint8_t > message = TestData::message( 100 );
+	Pique::BLAKE3 hash;
+	hash.update( message.data(), message.size() );
+	std::string expectedDigest = BLAKE3HexDigest( hash );
+
+	ASSERT_FALSE( hash.setKey( Pique::Key() ) );
+	ASSERT_FALSE( hash.setKey( Pique::Key( reinterpret_cast< const uint8_t* >( BLAKE3_TEST_KEY ), 31 ) ) );
+	ASSERT_FALSE( hash.setKey( Pique::Key( message.data(), 33 ) ) );
+	ASSERT_EQ( expectedDigest, BLAKE3HexDigest( hash ) );
+}
+
+TEST( TestBLAKE3, UpdateShallProduceTheSameDigestRegardlessOfHowTheMessageIsSplit )
+{
+	std::vector< uint8_t > message = TestData::message( 40 * 1024 + 17 );
+	Pique::BLAKE3 wholeHash;
+	wholeHash.update( message.data(), message.size() );
+	std::string expectedDigest = BLAKE3HexDigest( wholeHash );
+
+	for ( size_t split : { size_t( 1 ), size_t( 63 ), size_t( 64 ), size_t( 65 ), size_t( 1000 ), size_t( 1024 ), size_t( 1025 ),
+		size_t( 3 * 1024 ), size_t( 5 * 1024 + 3 ), size_t( 16 * 1024 ), size_t( 17 * 1024 - 1 ) } )
+	{
+		Pique::BLAKE3 hash;
+		for ( size_t offset( 0 ); offset < message.size(); offset += split )
+		{
+			hash.update( message.data() + offset, std::min( split, message.size() - offset ) );
+		}
+
+		ASSERT_EQ( expectedDigest, BLAKE3HexDigest( hash ) ) << split;
+	}
+}
+
+TEST( TestBLAKE3, LargeUpdatesShallProduceTheSameDigestOnAnyThreadPool )
+{
+	std::vector< uint8_t > message = TestData::message( 3 * Pique::BLAKE3::PARALLEL_MINIMUM_SIZE + 5000 );
+	Pique::ThreadPool sequentialPool( 0 );
+	Pique::BLAKE3 sequentialHash;
+	sequentialHash.setThreadPool( sequentialPool );
+	sequentialHash.update( message.data(), message.size() );
+	std::string expectedDigest = BLAKE3HexDigest( sequentialHash );
+
+	Pique::ThreadPool threadPool( 3 );
+	Pique::BLAKE3 hash;
+	hash.setThreadPool( threadPool );
+	hash.update( message.data(), message.size() );
+	ASSERT_EQ( expectedDigest, BLAKE3HexDigest( hash ) );
+
+	// A head that is not a whole subtree moves every later subtree off its natural boundary.
+	hash.reset();
+	hash.update( message.data(), 3000 );
+	hash.update( message.data() + 3000, message.size() - 3000 );
+	ASSERT_EQ( expectedDigest, BLAKE3HexDigest( hash ) );
+
+	Pique::BLAKE3 keyedHash;
+	ASSERT_TRUE( keyedHash.setKey( BLAKE3TestKey() ) );
+	keyedHash.setThreadPool( threadPool );
+	keyedHash.update( message.data(), message.size() );
+	sequentialHash.setKey( BLAKE3TestKey() );
+	sequentialHash.update( message.data(), message.size() );
+	ASSERT_EQ( BLAKE3HexDigest( sequentialHash ), BLAKE3HexDigest( keyedHash ) );
+}
+
+TEST( TestBLAKE3, DigestShallNotModifyTheStateAndResetShallKeepTheMode )
+{
+	const BLAKE3TestVector& vector = BLAKE3_TEST_VECTORS[ 10 ];
+	std::vector< uint8_t > message = TestData::message( vector.messageLength );
+
+	Pique::BLAKE3 keyedHash;
+	ASSERT_TRUE( keyedHash.setKey( BLAKE3TestKey() ) );
+	keyedHash.update( message.data(), 1500 );
+	BLAKE3HexDigest( keyedHash, 200 );
+	keyedHash.update( message.data() + 1500, message.size() - 1500 );
+	ASSERT_EQ( vector.keyedHash, BLAKE3HexDigest( keyedHash ) );
+
+	keyedHash.reset();
+	keyedHash.update( message.data(), message.size() );
+	ASSERT_EQ( vector.keyedHash, BLAKE3HexDigest( keyedHash ) );
+
+	Pique::BLAKE3 clonedHash( keyedHash.clone() );
+	ASSERT_EQ( vector.keyedHash, BLAKE3HexDigest( clonedHash ) );
+}
+
+TEST( TestBLAKE3, DeserializeShallResumeTheSerializedMidstate )
+{
+	const BLAKE3TestVector& vector = BLAKE3_TEST_VECTORS[ 22 ];
+	std::vector< uint8_t > message = TestData::message( vector.messageLength );
+
+	for ( size_t split( 0 ); split <= message.size(); split += 509 )
+	{
+		Pique::BLAKE3 hash;
+		ASSERT_TRUE( hash.setKey( BLAKE3TestKey() ) );
+		hash.update( message.data(), split );
+
+		uint8_t state[ Pique::BLAKE3::STATE_SIZE ];
+		uint64_t stateSize = hash.serialize( state, sizeof( state ) );
+		ASSERT_NE( 0, stateSize );
+
+		Pique::BLAKE3 resumedHash;
+		ASSERT_TRUE( resumedHash.deserialize( state, stateSize ) );
+		resumedHash.update( message.data() + split, message.size() - split );
+		ASSERT_EQ( vector.keyedHash, BLAKE3HexDigest( resumedHash ) ) << split;
+	}
+}
+
+TEST( TestBLAKE3, DeserializeShallRejectMalformedStates )
+{
+	std::vector< uint8_t > message = TestData::message( 2048 );
+	Pique::BLAKE3 hash;
+	hash.update( message.data(), message.size() );
+
+	uint8_t state[ Pique::BLAKE3::STATE_SIZE ];
+	ASSERT_EQ( 0, hash.serialize( state, Pique::BLAKE3::STATE_SIZE - 1 ) );
+	uint64_t stateSize = hash.serialize( state, sizeof( state ) );
+	ASSERT_LT( 0, stateSize );
+
+	Pique::BLAKE3 untouchedHash;
+	std::string expectedDigest = BLAKE3HexDigest( untouchedHash );
+	ASSERT_FALSE( untouchedHash.deserialize( nullptr, stateSize ) );
+	ASSERT_FALSE( untouchedHash.deserialize( state, stateSize - 1 ) );
+	ASSERT_FALSE( untouchedHash.deserialize( state, stateSize + 1 ) );
+	ASSERT_FALSE( untouchedHash.deserialize( state, 10 ) );
+
+	std::vector< uint8_t > alteredState( state, state + stateSize );
+	alteredState[ 3 ] ^= 0x01;
+	ASSERT_FALSE( untouchedHash.deserialize( alteredState.data(), stateSize ) );
+
+	// Flags of another mode, and a stack deeper than any tree.
+	alteredState.assign( state, state + stateSize );
+	alteredState[ 4 ] = 0x01;
+	ASSERT_FALSE( untouchedHash.deserialize( alteredState.data(), stateSize ) );
+	alteredState.assign( state, state + stateSize );
+	alteredState[ 4 + 1 + 32 + 8 + 32 + 1 ] = 56;
+	ASSERT_FALSE( untouchedHash.deserialize( alteredState.data(), stateSize ) );
+
+	// A state of the mode and key of the serialized one, with the chunk and stack shaped as given.
+	auto forgeState = [ & ]( uint64_t chunkCounter, uint8_t blocksCompressed, uint8_t stackLength, uint8_t blockLength )
+	{
+		std::vector< uint8_t > forgedState( state, state + 4 + 1 + 32 );
+		for ( size_t index( -1 ); ++index < 8; )
+		{
+			forgedState.push_back( uint8_t( chunkCounter >> ( 8 * index ) ) );
+		}
+
+		forgedState.insert( forgedState.end(), 32, 0x5A );
+		forgedState.push_back( blocksCompressed );
+		forgedState.push_back( stackLength );
+		forgedState.insert( forgedState.end(), stackLength * 32, 0x5A );
+		forgedState.push_back( blockLength );
+		forgedState.insert( forgedState.end(), blockLength, 0x5A );
+		return forgedState;
+	};
+
+	Pique::BLAKE3 forgedHash;
+	for ( const std::vector< uint8_t >& forgedState : { forgeState( 0, 0, 0, 0 ), forgeState( 0, 1, 0, 36 ), forgeState( 2, 0, 2, 0 ),
+		forgeState( 3, 15, 2, 64 ), forgeState( ( uint64_t( 1 ) << 54 ) - 1, 0, 55, 0 ) } )
+	{
+		ASSERT_TRUE( forgedHash.deserialize( forgedState.data(), forgedState.size() ) );
+		forgedHash.update( message.data(), message.size() );
+		BLAKE3HexDigest( forgedHash );
+	}
+
+	// Stacks that do not match the chunk counter, which the next update() would merge out of bounds.
+	for ( const std::vector< uint8_t >& forgedState : { forgeState( 0, 1, 1, 36 ), forgeState( 0, 0, 1, 0 ), forgeState( 2, 0, 1, 0 ),
+		forgeState( 2, 0, 3, 0 ), forgeState( 3, 1, 3, 1 ), forgeState( 3, 1, 1, 1 ), forgeState( ( uint64_t( 1 ) << 60 ) - 1, 1, 55, 1 ),
+		forgeState( uint64_t( 1 ) << 54, 0, 2, 0 ), forgeState( uint64_t( 1 ) << 54, 1, 1, 1 ) } )
+	{
+		ASSERT_FALSE( untouchedHash.deserialize( forgedState.data(), forgedState.size() ) );
+	}
+
+	// Chunks whose last block was compressed, which is only done once the chunk is finished.
+	for ( const std::vector< uint8_t >& forgedState : { forgeState( 0, 1, 0, 0 ), forgeState( 2, 15, 1, 0 ), forgeState( 0, 16, 0, 1 ) } )
+	{
+		ASSERT_FALSE( untouchedHash.deserialize( forgedState.data(), forgedState.size() ) );
+	}
+
+	ASSERT_EQ( expectedDigest, BLAKE3HexDigest( untouchedHash ) );
+}
+
+static constexpr std::array< char, 8193 > BLAKE3ConstantMessage()
+{
+	std::array< char, 8193 > message = { 0 };
+	for ( size_t index( -1 ); ++index < message.size(); )
+	{
+		message[ index ] = char( index % 251 );
+	}
+
+	return message;
+}
+
+static constexpr std::array< char, 8193 > BLAKE3_CONSTANT_MESSAGE = BLAKE3ConstantMessage();
+
+/**
+ * Compare the extended digest of the first Length bytes of
+ * BLAKE3_CONSTANT_MESSAGE, computed at compile time, with that of update().
+ */
+template < size_t Length >
+static void BLAKE3ExpectConstantDigest()
+{
+	constexpr std::array< uint8_t, 131 > constantDigest =
+		Pique::BLAKE3::digestMessage< 131 >( std::string_view( BLAKE3_CONSTANT_MESSAGE.data(), Length ) );
+	std::string constantHexDigest = TestData::toHex( constantDigest.data(), constantDigest.size() );
+
+	std::vector< uint8_t > message = TestData::message( Length );
+	Pique::BLAKE3 hash;
+	hash.update( message.data(), message.size() );
+	ASSERT_EQ( BLAKE3HexDigest( hash, constantDigest.size() ), constantHexDigest ) << Length;
+}
+
+template < size_t... Lengths >
+static void BLAKE3ExpectConstantDigests()
+{
+	( BLAKE3ExpectConstantDigest< Lengths >(), ... );
+}
+
+TEST( TestBLAKE3, DigestMessageShallEvaluateAStringLiteralAtCompileTime )
+{
+	constexpr std::array< uint8_t, 32 > emptyDigest = Pique::BLAKE3::digestMessage( "" );
+	static_assert( ( 0xaf == emptyDigest[ 0 ] ) and ( 0x62 == emptyDigest[ 31 ] ), "BLAKE3 of the empty message" );
+
+	// The lengths of the reference vectors: chunks of the tree, complete and partial, at several depths.
+	BLAKE3ExpectConstantDigests< 0, 1, 63, 64, 65, 1023, 1024, 1025, 2048, 2049, 3072, 3073, 4096, 4097,
+		5120, 5121, 6144, 6145, 7168, 7169, 8192, 8193 >();
+
+	// A message that is not a constant is hashed at run time.
+	std::vector< uint8_t > message = TestData::message( 5000 );
+	std::array< uint8_t, 64 > messageDigest = Pique::BLAKE3::digestMessage< 64 >(
+		std::string_view( reinterpret_cast< const char* >( message.data() ), message.size() ) );
+	Pique::BLAKE3 hash;
+	hash.update( message.data(), message.size() );
+	ASSERT_EQ( BLAKE3HexDigest( hash, messageDigest.size() ), TestData::toHex( messageDigest.data(), messageDigest.size() ) );
+}
@@ -0,0 +1,297 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ChaCha20Poly1305.hpp"
+#include "CpuFeatures.hpp"
+#include "Key.hpp"
+#include "TestData.hpp"
+
+struct ChaCha20Poly1305TestVector
+{
+	const char* key;
+	const char* nonce;
+	const char* associatedData;
+	const char* plaintext;
+	const char* ciphertext;
+	const char* tag;
+};
+
+/**
+ * The AEAD vector of RFC 8439 section 2.8.2 and the XChaCha20-Poly1305 vector
+ * of draft-irtf-cfrg-xchacha appendix A.3.1, which share their plaintext.
+ */
+static const ChaCha20Poly1305TestVector CHACHA20_POLY1305_TEST_VECTORS[] = {
+	{ "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f",
+		"070000004041424344454647",
+		"50515253c0c1c2c3c4c5c6c7",
+		"4c616469657320616e642047656e746c656d656e206f662074686520636c617373206f66202739393a204966204920636f756c64206f6666657220796f75206f6e6c79206f6e652074697020666f7220746865206675747572652c2073756e73637265656e20776f756c642062652069742e",
+		"d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b3692ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc3ff4def08e4b7a9de576d26586cec64b6116",
+		"1ae10b594f09e26a7e902ecbd0600691" },
+	{ "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f",
+		"404142434445464748494a4b4c4d4e4f5051525354555657",
+		"50515253c0c1c2c3c4c5c6c7",
+		"4c616469657320616e642047656e746c656d656e206f662074686520636c617373206f66202739393a204966204920636f756c64206f6666657220796f75206f6e6c79206f6e652074697020666f7220746865206675747572652c2073756e73637265656e20776f756c642062652069742e",
+		"bd6d179d3e83d43b9576579493c0e939572a1700252bfaccbed2902c21396cbb731c7f1b0b4aa6440bf3a82f4eda7e39ae64c6708c54c216cb96b72e1213b4522f8c9ba40db5d945b11b69b982c1bb9e3f3fac2bc369488f76b2383565d3fff921f9664c97637da9768812f615c68b13b52e",
+		"c0875924c1c7987947deafd8780acf49" },
+};
+
+static const uint32_t CHACHA20_POLY1305_TIERS[] = {
+	Pique::CpuFeatures::TIER_PORTABLE,
+	Pique::CpuFeatures::TIER_AVX2,
+	Pique::CpuFeatures::ALL_FEATURES,
+};
+
+TEST( TestChaCha20Poly1305, SealAndOpenShallMatchTheSpecificationVectorsOnEveryTier )
+{
+	for ( uint32_t tier : CHACHA20_POLY1305_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( const ChaCha20Poly1305TestVector& vector : CHACHA20_POLY1305_TEST_VECTORS )
+		{
+			std::vector< uint8_t > keyValue = TestData::fromHex( vector.key );
+			std::vector< uint8_t > nonce = TestData::fromHex( vector.nonce );
+			std::vector< uint8_t > associatedData = TestData::fromHex( vector.associatedData );
+			std::vector< uint8_t > plaintext = TestData::fromHex( vector.plaintext );
+			Pique::Key key( keyValue.data(), keyValue.size() );
+			Pique::ChaCha20Poly1305 chaCha20Poly1305( key );
+			ASSERT_TRUE( bool( chaCha20Poly1305 ) );
+
+			std::vector< uint8_t > ciphertext( plaintext.size() );
+			uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+			ASSERT_TRUE( chaCha20Poly1305.seal( ciphertext.data(), tag, plaintext.data(), plaintext.size(), nonce.data(), nonce.size(),
+				associatedData.data(), associatedData.size() ) );
+			ASSERT_EQ( vector.ciphertext, TestData::toHex( ciphertext.data(), ciphertext.size() ) ) << std::hex << tier << " " << vector.tag;
+			ASSERT_EQ( vector.tag, TestData::toHex( tag, sizeof( tag ) ) ) << std::hex << tier;
+
+			// Open in place.
+			ASSERT_TRUE( chaCha20Poly1305.open( ciphertext.data(), ciphertext.data(), ciphertext.size(), tag, nonce.data(), nonce.size(),
+				associatedData.data(), associatedData.size() ) ) << std::hex << tier << " " << vector.tag;
+			ASSERT_EQ( plaintext, ciphertext );
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestChaCha20Poly1305, HChaCha20ShallMatchTheDraftVector )
+{
+	// draft-irtf-cfrg-xchacha section 2.2.1.
+	std::vector< uint8_t > keyValue = TestData::fromHex( "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f" );
+	std::vector< uint8_t > nonce = TestData::fromHex( "000000090000004a0000000031415927" );
+	uint32_t keyWords[ 8 ];
+	for ( size_t index( -1 ); ++index < 8; )
+	{
+		keyWords[ index ] = Pique::ChaCha20Poly1305::__loadLittleEndian( keyValue.data() + 4 * index );
+	}
+
+	uint32_t subkey[ 8 ];
+	Pique::ChaCha20Poly1305::__hChaCha20( subkey, keyWords, nonce.data() );
+	uint8_t subkeyBytes[ 32 ];
+	for ( size_t index( -1 ); ++index < 8; )
+	{
+		Pique::ChaCha20Poly1305::__storeLittleEndian( subkeyBytes + 4 * index, subkey[ index ] );
+	}
+
+	ASSERT_EQ( "82413b4227b27bfed30e42508a877d73a0f9e4d58a74a853c12ec41326d3ecdc", TestData::toHex( subkeyBytes, sizeof( subkeyBytes ) ) );
+}
+
+TEST( TestChaCha20Poly1305, EveryKernelShallAgreeForEveryLengthInPlace )
+{
+	static const uint8_t keyValue[ Pique::ChaCha20Poly1305::KEY_SIZE ] = { 0x1c, 0x92, 0x40, 0xa5, 0xeb, 0x55, 0xd3, 0x8a, 0xf3, 0x33 };
+	static const uint8_t nonce[ Pique::ChaCha20Poly1305::EXTENDED_NONCE_SIZE ] = { 0xca, 0xfe, 0xba, 0xbe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9 };
+
+	// Lengths up to 300 cover every short message and Poly1305 group; the
+	// longer ones end in partial vector passes and cross chunks.
+	std::vector< size_t > lengths;
+	for ( size_t length( -1 ); ++length < 300; )
+	{
+		lengths.push_back( length );
+	}
+
+	lengths.insert( lengths.end(), { size_t( 1000 ), size_t( 4096 ), size_t( 4096 + 17 ), size_t( 4096 + 700 ), size_t( 65536 + 5 ) } );
+	std::vector< uint8_t > associatedData = TestData::message( 301 );
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+
+	for ( size_t nonceLength : { Pique::ChaCha20Poly1305::NONCE_SIZE, Pique::ChaCha20Poly1305::EXTENDED_NONCE_SIZE } )
+	{
+		for ( size_t length : lengths )
+		{
+			std::vector< uint8_t > message = TestData::message( length );
+			std::vector< uint8_t > expectedCiphertext;
+			std::string expectedTag;
+
+			for ( uint32_t tier : CHACHA20_POLY1305_TIERS )
+			{
+				Pique::CpuFeatures::force( tier );
+				Pique::ChaCha20Poly1305 chaCha20Poly1305( key );
+				std::vector< uint8_t > buffer( message );
+				uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+				ASSERT_TRUE( chaCha20Poly1305.seal( buffer.data(), tag, buffer.data(), length, nonce, nonceLength,
+					associatedData.data(), length % associatedData.size() ) );
+
+				if ( Pique::CpuFeatures::TIER_PORTABLE == tier )
+				{
+					expectedCiphertext = buffer;
+					expectedTag = TestData::toHex( tag, sizeof( tag ) );
+				}
+
+				ASSERT_EQ( expectedCiphertext, buffer ) << std::hex << tier << std::dec << " " << nonceLength << " " << length;
+				ASSERT_EQ( expectedTag, TestData::toHex( tag, sizeof( tag ) ) ) << std::hex << tier << std::dec << " " << nonceLength << " " << length;
+
+				ASSERT_TRUE( chaCha20Poly1305.open( buffer.data(), buffer.data(), length, tag, nonce, nonceLength,
+					associatedData.data(), length % associatedData.size() ) ) << std::hex << tier << std::dec << " " << length;
+				ASSERT_EQ( message, buffer );
+			}
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestChaCha20Poly1305, OpenShallRejectAnyTamperingAndZeroizeThePlaintext )
+{
+	static const uint8_t keyValue[ Pique::ChaCha20Poly1305::KEY_SIZE ] = { 0x80, 0x81, 0x82 };
+	static const uint8_t nonce[ Pique::ChaCha20Poly1305::NONCE_SIZE ] = { 1, 2, 3 };
+	static const uint8_t associatedData[] = { 'h', 'e', 'a', 'd', 'e', 'r' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::ChaCha20Poly1305 chaCha20Poly1305( key );
+	std::vector< uint8_t > message = TestData::message( 600 );
+	std::vector< uint8_t > ciphertext( message.size() );
+	uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+	ASSERT_TRUE( chaCha20Poly1305.seal( ciphertext.data(), tag, message.data(), message.size(), nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+
+	std::vector< uint8_t > plaintext( message.size(), 0xEE );
+	std::vector< uint8_t > zeros( message.size(), 0 );
+
+	std::vector< uint8_t > tamperedCiphertext( ciphertext );
+	tamperedCiphertext[ 450 ] ^= 0x01;
+	ASSERT_FALSE( chaCha20Poly1305.open( plaintext.data(), tamperedCiphertext.data(), message.size(), tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	uint8_t tamperedTag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+	std::memcpy( tamperedTag, tag, sizeof( tag ) );
+	tamperedTag[ 15 ] ^= 0x80;
+	std::fill( plaintext.begin(), plaintext.end(), 0xEE );
+	ASSERT_FALSE( chaCha20Poly1305.open( plaintext.data(), ciphertext.data(), message.size(), tamperedTag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	std::fill( plaintext.begin(), plaintext.end(), 0xEE );
+	ASSERT_FALSE( chaCha20Poly1305.open( plaintext.data(), ciphertext.data(), message.size(), tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) - 1 ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	static const uint8_t otherNonce[ Pique::ChaCha20Poly1305::NONCE_SIZE ] = { 1, 2, 4 };
+	std::fill( plaintext.begin(), plaintext.end(), 0xEE );
+	ASSERT_FALSE( chaCha20Poly1305.open( plaintext.data(), ciphertext.data(), message.size(), tag, otherNonce, sizeof( otherNonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( zeros, plaintext );
+
+	// A truncated message fails too, and the untampered message still opens.
+	ASSERT_FALSE( chaCha20Poly1305.open( plaintext.data(), ciphertext.data(), message.size() - 1, tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_TRUE( chaCha20Poly1305.open( plaintext.data(), ciphertext.data(), message.size(), tag, nonce, sizeof( nonce ),
+		associatedData, sizeof( associatedData ) ) );
+	ASSERT_EQ( message, plaintext );
+}
+
+TEST( TestChaCha20Poly1305, InvalidKeysAndArgumentsShallFailWithoutWriting )
+{
+	static const uint8_t keyValue[ 33 ] = { 0 };
+	static const uint8_t nonce[ Pique::ChaCha20Poly1305::EXTENDED_NONCE_SIZE ] = { 0 };
+
+	uint8_t message[ 16 ] = { 0x5A };
+	uint8_t output[ 16 ] = { 0 };
+	uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ] = { 0 };
+	static const uint8_t zeros[ 16 ] = { 0 };
+
+	Pique::ChaCha20Poly1305 chaCha20Poly1305;
+	ASSERT_FALSE( bool( chaCha20Poly1305 ) );
+	ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, message, sizeof( message ), nonce, Pique::ChaCha20Poly1305::NONCE_SIZE ) );
+
+	for ( size_t keyLength : { size_t( 0 ), size_t( 16 ), size_t( 31 ), size_t( 33 ) } )
+	{
+		Pique::Key key( keyValue, keyLength );
+		ASSERT_FALSE( chaCha20Poly1305.setKey( key ) ) << keyLength;
+		ASSERT_FALSE( bool( chaCha20Poly1305 ) ) << keyLength;
+	}
+
+	Pique::Key key( keyValue, Pique::ChaCha20Poly1305::KEY_SIZE );
+	ASSERT_TRUE( chaCha20Poly1305.setKey( key ) );
+	for ( size_t nonceLength : { size_t( 0 ), size_t( 8 ), size_t( 16 ), size_t( 23 ) } )
+	{
+		ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, message, sizeof( message ), nonce, nonceLength ) ) << nonceLength;
+	}
+
+	ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, message, sizeof( message ), nullptr, Pique::ChaCha20Poly1305::NONCE_SIZE ) );
+	ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, message, Pique::ChaCha20Poly1305::MAXIMUM_MESSAGE_SIZE + 1,
+		nonce, Pique::ChaCha20Poly1305::NONCE_SIZE ) );
+	ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, nullptr, sizeof( message ), nonce, Pique::ChaCha20Poly1305::NONCE_SIZE ) );
+	ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, message, sizeof( message ), nonce, Pique::ChaCha20Poly1305::NONCE_SIZE, nullptr, 1 ) );
+	ASSERT_EQ( 0, std::memcmp( zeros, output, sizeof( output ) ) );
+	ASSERT_EQ( 0, std::memcmp( zeros, tag, sizeof( tag ) ) );
+
+	// An empty message needs no buffers.
+	ASSERT_TRUE( chaCha20Poly1305.seal( nullptr, tag, nullptr, 0, nonce, Pique::ChaCha20Poly1305::EXTENDED_NONCE_SIZE ) );
+	ASSERT_TRUE( chaCha20Poly1305.open( nullptr, nullptr, 0, tag, nonce, Pique::ChaCha20Poly1305::EXTENDED_NONCE_SIZE ) );
+
+	chaCha20Poly1305.clear();
+	ASSERT_FALSE( bool( chaCha20Poly1305 ) );
+	ASSERT_FALSE( chaCha20Poly1305.seal( output, tag, message, sizeof( message ), nonce, Pique::ChaCha20Poly1305::NONCE_SIZE ) );
+}
+
+TEST( TestChaCha20Poly1305, TheKeyCopyShallBeDiscardedWhenTheBoundKeyIsWritten )
+{
+	static const uint8_t keyValue[ Pique::ChaCha20Poly1305::KEY_SIZE ] = { 1, 2, 3, 4 };
+	static const uint8_t nonce[ Pique::ChaCha20Poly1305::NONCE_SIZE ] = { 0 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::Key copyKey( key );
+	Pique::ChaCha20Poly1305 chaCha20Poly1305( key );
+	uint8_t ciphertext[ sizeof( message ) ];
+	uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+
+	copyKey.clear();
+	ASSERT_TRUE( chaCha20Poly1305.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+
+	key.set( keyValue, sizeof( keyValue ) );
+	ASSERT_FALSE( chaCha20Poly1305.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+	static const uint32_t zeroKeyWords[ 8 ] = { 0 };
+	ASSERT_EQ( 0, std::memcmp( zeroKeyWords, chaCha20Poly1305.mKeyWords, sizeof( zeroKeyWords ) ) );
+
+	ASSERT_TRUE( chaCha20Poly1305.setKey( key ) );
+	ASSERT_TRUE( chaCha20Poly1305.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+}
+
+TEST( TestChaCha20Poly1305, TheKeyCopyShallBeDiscardedWhenTheBoundKeyIsDestroyed )
+{
+	static const uint8_t keyValue[ Pique::ChaCha20Poly1305::KEY_SIZE ] = { 1, 2, 3, 4 };
+	static const uint8_t nonce[ Pique::ChaCha20Poly1305::NONCE_SIZE ] = { 0 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	std::unique_ptr< Pique::Key > key( new Pique::Key( keyValue, sizeof( keyValue ) ) );
+	Pique::ChaCha20Poly1305 chaCha20Poly1305( *key );
+	uint8_t ciphertext[ sizeof( message ) ];
+	uint8_t tag[ Pique::ChaCha20Poly1305::TAG_SIZE ];
+	ASSERT_TRUE( chaCha20Poly1305.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) ) );
+
+	key.reset();
+	ASSERT_FALSE( chaCha20Poly1305.open( ciphertext, ciphertext, sizeof( message ), tag, nonce, sizeof( nonce ) ) );
+	static const uint32_t zeroKeyWords[ 8 ] = { 0 };
+	ASSERT_EQ( 0, std::memcmp( zeroKeyWords, chaCha20Poly1305.mKeyWords, sizeof( zeroKeyWords ) ) );
+}
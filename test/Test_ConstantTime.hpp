@@ -0,0 +1,173 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "ConstantTime.hpp"
+#include "CpuFeatures.hpp"
+#include "Key.hpp"
+
+/**
+ * A dudect style leakage test: time {@param compare} on inputs of two classes,
+ * picked in a pseudorandom order, and return Welch's t statistic of the two
+ * timing distributions. Samples above the 90th percentile are cropped, as
+ * they are dominated by interrupts. An absolute t above 10 is overwhelming
+ * evidence that the timing depends on the class.
+ * @param compare Callable as compare( bool secondClass ), returning the result to keep.
+ */
+template < typename Compare >
+static double WelchTOfComparisonTimings( Compare compare )
+{
+	static const size_t SAMPLES = 20000;
+	static const size_t CALLS_PER_SAMPLE = 8;
+
+	std::vector< double > timings[ 2 ];
+	std::vector< uint8_t > classes( SAMPLES );
+	uint64_t random = 0x9E3779B97F4A7C15ULL;
+	for ( size_t index( -1 ); ++index < SAMPLES; )
+	{
+		random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+		classes[ index ] = uint8_t( random >> 63 );
+	}
+
+	volatile bool sink = false;
+	std::vector< double > samples( SAMPLES );
+	for ( size_t index( -1 ); ++index < SAMPLES; )
+	{
+		auto start = std::chrono::steady_clock::now();
+		for ( size_t call( -1 ); ++call < CALLS_PER_SAMPLE; )
+		{
+			sink = compare( 0 != classes[ index ] );
+		}
+
+		samples[ index ] = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count();
+	}
+
+	( void ) sink;
+
+	std::vector< double > sorted( samples );
+	std::nth_element( sorted.begin(), sorted.begin() + SAMPLES * 9 / 10, sorted.end() );
+	double crop = sorted[ SAMPLES * 9 / 10 ];
+	for ( size_t index( -1 ); ++index < SAMPLES; )
+	{
+		if ( samples[ index ] <= crop )
+		{
+			timings[ classes[ index ] ].push_back( samples[ index ] );
+		}
+	}
+
+	double mean[ 2 ] = { 0, 0 };
+	double variance[ 2 ] = { 0, 0 };
+	for ( size_t set( -1 ); ++set < 2; )
+	{
+		for ( double timing : timings[ set ] )
+		{
+			mean[ set ] += timing;
+		}
+
+		mean[ set ] /= double( timings[ set ].size() );
+		for ( double timing : timings[ set ] )
+		{
+			variance[ set ] += ( timing - mean[ set ] ) * ( timing - mean[ set ] );
+		}
+
+		variance[ set ] /= double( timings[ set ].size() - 1 );
+	}
+
+	return ( mean[ 0 ] - mean[ 1 ] ) / std::sqrt( variance[ 0 ] / double( timings[ 0 ].size() ) + variance[ 1 ] / double( timings[ 1 ].size() ) + 1e-12 );
+}
+
+TEST( TestConstantTime, EqualShallDetectADifferenceInAnyByteOnEveryTier )
+{
+	static const uint32_t TIERS[] = {
+		Pique::CpuFeatures::TIER_PORTABLE,
+		Pique::CpuFeatures::TIER_SSE4,
+		Pique::CpuFeatures::TIER_AVX2,
+	};
+
+	std::vector< uint8_t > left( 200 );
+	std::vector< uint8_t > right( 200 );
+	for ( size_t index( -1 ); ++index < left.size(); )
+	{
+		left[ index ] = right[ index ] = uint8_t( index * 31 + 7 );
+	}
+
+	for ( uint32_t tier : TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( size_t length( -1 ); ++length < left.size(); )
+		{
+			ASSERT_TRUE( Pique::ConstantTime::equal( left.data(), right.data(), length ) ) << std::hex << tier << std::dec << " " << length;
+			for ( size_t index( -1 ); ++index < length; )
+			{
+				for ( uint8_t flip : { uint8_t( 0x01 ), uint8_t( 0x80 ) } )
+				{
+					right[ index ] ^= flip;
+					ASSERT_FALSE( Pique::ConstantTime::equal( left.data(), right.data(), length ) ) << std::hex << tier << std::dec << " " << length << " " << index;
+					right[ index ] ^= flip;
+				}
+			}
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestConstantTime, TheLeakageTestShallDetectAComparisonThatExitsEarly )
+{
+	std::vector< uint8_t > left( 4096, 0x5A );
+	std::vector< uint8_t > equalRight( left );
+	std::vector< uint8_t > differentRight( left );
+	differentRight[ 0 ] ^= 1;
+
+	double t = WelchTOfComparisonTimings( [ & ]( bool different )
+		{
+			const uint8_t* right = different ? differentRight.data() : equalRight.data();
+			for ( size_t index( -1 ); ++index < left.size(); )
+			{
+				if ( left[ index ] != right[ index ] )
+				{
+					return false;
+				}
+			}
+
+			return true;
+		} );
+
+	ASSERT_LT( 10.0, std::fabs( t ) );
+}
+
+TEST( TestConstantTime, KeyComparisonTimingShallNotDependOnWhereTheKeysDiffer )
+{
+	std::vector< uint8_t > value( 4096, 0x5A );
+	Pique::Key key( value.data(), value.size() );
+	Pique::Key equalKey( value.data(), value.size() );
+	value[ 0 ] ^= 1;
+	Pique::Key differentKey( value.data(), value.size() );
+
+	// A leak shows in every attempt, while a burst of noise on a busy machine does not.
+	double t = 0;
+	for ( size_t attempt( -1 ); ++attempt < 3; )
+	{
+		t = WelchTOfComparisonTimings( [ & ]( bool different )
+			{
+				return key == ( different ? differentKey : equalKey );
+			} );
+
+		if ( 10.0 > std::fabs( t ) )
+		{
+			break;
+		}
+	}
+
+	ASSERT_GT( 10.0, std::fabs( t ) );
+}
@@ -0,0 +1,134 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+TEST( TestCpuFeatures, ParseShallCombineTierAndFeatureNames )
+{
+	uint32_t features = 0;
+
+	ASSERT_TRUE( Pique::CpuFeatures::parse( "portable", features ) );
+	ASSERT_EQ( Pique::CpuFeatures::TIER_PORTABLE, features );
+
+	ASSERT_TRUE( Pique::CpuFeatures::parse( "sse4,sha", features ) );
+	ASSERT_EQ( Pique::CpuFeatures::TIER_SSE4 | Pique::CpuFeatures::SHA, features );
+
+	ASSERT_TRUE( Pique::CpuFeatures::parse( "avx512,aes,vaes", features ) );
+	ASSERT_EQ( Pique::CpuFeatures::TIER_AVX512 | Pique::CpuFeatures::AES | Pique::CpuFeatures::VAES, features );
+
+	ASSERT_TRUE( Pique::CpuFeatures::parse( "native", features ) );
+	ASSERT_EQ( Pique::CpuFeatures::ALL_FEATURES, features );
+}
+
+TEST( TestCpuFeatures, ParseShallRejectUnknownNamesAndLeaveTheFeaturesUntouched )
+{
+	uint32_t features = Pique::CpuFeatures::SHA;
+
+	ASSERT_FALSE( Pique::CpuFeatures::parse( "avx3", features ) );
+	ASSERT_FALSE( Pique::CpuFeatures::parse( "sse4,", features ) );
+	ASSERT_FALSE( Pique::CpuFeatures::parse( "", features ) );
+	ASSERT_FALSE( Pique::CpuFeatures::parse( "avx2x", features ) );
+	ASSERT_EQ( Pique::CpuFeatures::SHA, features );
+}
+
+TEST( TestCpuFeatures, TiersShallBeOrdered )
+{
+	ASSERT_EQ( Pique::CpuFeatures::TIER_SSE4, Pique::CpuFeatures::TIER_SSE4 & Pique::CpuFeatures::TIER_AVX2 );
+	ASSERT_EQ( Pique::CpuFeatures::TIER_AVX2, Pique::CpuFeatures::TIER_AVX2 & Pique::CpuFeatures::TIER_AVX512 );
+	ASSERT_EQ( 0, Pique::CpuFeatures::TIER_AVX512 & Pique::CpuFeatures::SHA );
+}
+
+#if defined( PIQUE_CPU_FEATURES_X86 )
+TEST( TestCpuFeatures, DetectedShallAgreeWithTheCompiler )
+{
+	__builtin_cpu_init();
+	uint32_t detected = Pique::CpuFeatures::detected();
+
+	ASSERT_EQ( bool( __builtin_cpu_supports( "sse4.1" ) ), 0 != ( detected & Pique::CpuFeatures::SSE4_1 ) );
+	ASSERT_EQ( bool( __builtin_cpu_supports( "avx2" ) ), 0 != ( detected & Pique::CpuFeatures::AVX2 ) );
+	ASSERT_EQ( bool( __builtin_cpu_supports( "bmi2" ) ), 0 != ( detected & Pique::CpuFeatures::BMI2 ) );
+	ASSERT_EQ( bool( __builtin_cpu_supports( "avx512f" ) ), 0 != ( detected & Pique::CpuFeatures::AVX512F ) );
+	ASSERT_EQ( bool( __builtin_cpu_supports( "aes" ) ), 0 != ( detected & Pique::CpuFeatures::AES ) );
+}
+#endif
+
+TEST( TestCpuFeatures, ForceShallRestrictTheEnabledFeaturesAndRestoreShallUndoIt )
+{
+	uint32_t enabled = Pique::CpuFeatures::enabled();
+
+	Pique::CpuFeatures::force( Pique::CpuFeatures::TIER_PORTABLE );
+	ASSERT_EQ( 0, Pique::CpuFeatures::enabled() );
+	ASSERT_TRUE( Pique::CpuFeatures::supports( 0 ) );
+	ASSERT_EQ( &Pique::SHA256::__compressPortable, Pique::SHA256::__kernels().mCompress.load() );
+	ASSERT_EQ( &Pique::SHA256::__digestMessagesSerially, Pique::SHA256::__kernels().mDigestMessages.load() );
+
+	Pique::CpuFeatures::force( Pique::CpuFeatures::ALL_FEATURES );
+	ASSERT_EQ( Pique::CpuFeatures::detected(), Pique::CpuFeatures::enabled() );
+
+	Pique::CpuFeatures::restore();
+	ASSERT_EQ( enabled, Pique::CpuFeatures::enabled() );
+}
+
+TEST( TestCpuFeatures, EveryTierShallProduceTheSameDigests )
+{
+	static const uint32_t TIERS[] = {
+		Pique::CpuFeatures::TIER_PORTABLE,
+		Pique::CpuFeatures::TIER_SSE4,
+		Pique::CpuFeatures::TIER_SSE4 | Pique::CpuFeatures::SHA,
+		Pique::CpuFeatures::TIER_AVX2,
+		Pique::CpuFeatures::TIER_AVX2 | Pique::CpuFeatures::SHA,
+		Pique::CpuFeatures::TIER_AVX512,
+		Pique::CpuFeatures::ALL_FEATURES,
+	};
+
+	std::vector< uint8_t > message( 1000 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index * 13 + 5 );
+	}
+
+	uint8_t expectedDigest256[ Pique::SHA256::DIGEST_SIZE ];
+	uint8_t expectedDigest512[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::CpuFeatures::force( Pique::CpuFeatures::TIER_PORTABLE );
+	Pique::SHA256::digestMessage( expectedDigest256, message.data(), message.size() );
+	Pique::SHA512::digestMessage( expectedDigest512, message.data(), message.size() );
+
+	for ( uint32_t tier : TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+
+		uint8_t messageDigest256[ Pique::SHA256::DIGEST_SIZE ];
+		uint8_t messageDigest512[ Pique::SHA512::DIGEST_SIZE ];
+		Pique::SHA256::digestMessage( messageDigest256, message.data(), message.size() );
+		Pique::SHA512::digestMessage( messageDigest512, message.data(), message.size() );
+
+		uint8_t batchDigests[ 20 ][ Pique::SHA256::DIGEST_SIZE ];
+		Pique::SHA256::BatchMessage messages[ 20 ];
+		for ( size_t index( 0 ); index < 20; ++index )
+		{
+			messages[ index ] = { message.data(), message.size(), batchDigests[ index ] };
+		}
+
+		Pique::SHA256::digestMessages( messages, 20 );
+
+		EXPECT_EQ( 0, std::memcmp( expectedDigest256, messageDigest256, sizeof( messageDigest256 ) ) ) << std::hex << tier;
+		EXPECT_EQ( 0, std::memcmp( expectedDigest512, messageDigest512, sizeof( messageDigest512 ) ) ) << std::hex << tier;
+		for ( size_t index( 0 ); index < 20; ++index )
+		{
+			EXPECT_EQ( 0, std::memcmp( expectedDigest256, batchDigests[ index ], sizeof( messageDigest256 ) ) ) << std::hex << tier;
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
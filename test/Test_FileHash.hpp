@@ -0,0 +1,181 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AnyHashFunction.hpp"
+#include "BLAKE3.hpp"
+#include "FileHash.hpp"
+#include "SHA256.hpp"
+#include "TestData.hpp"
+
+#if defined( PIQUE_FILE_HASH_POSIX )
+/**
+ * A temporary file, removed when it goes out of scope.
+ */
+class FileHashTemporaryFile final
+{
+private:
+	std::string mPath;
+	int mFd;
+
+public:
+	FileHashTemporaryFile()
+	{
+		char path[] = "/tmp/PiqueFileHashXXXXXX";
+		mFd = ::mkstemp( path );
+		mPath = path;
+	}
+
+	~FileHashTemporaryFile()
+	{
+		::close( mFd );
+		::unlink( mPath.c_str() );
+	}
+
+	int fd() const
+	{
+		return mFd;
+	}
+
+	const char* path() const
+	{
+		return mPath.c_str();
+	}
+
+	bool write( const std::vector< uint8_t >& contents ) const
+	{
+		return ( 0 == ::ftruncate( mFd, 0 ) )
+			and ( ssize_t( contents.size() ) == ::pwrite( mFd, contents.data(), contents.size(), 0 ) );
+	}
+};
+
+static std::string FileHashHexDigest( const Pique::SHA256& hash )
+{
+	char hexMessageDigest[ 2 * Pique::SHA256::DIGEST_SIZE ];
+	hash.hexDigest( hexMessageDigest );
+	return std::string( hexMessageDigest, sizeof( hexMessageDigest ) );
+}
+
+static std::string FileHashHexDigest( const std::vector< uint8_t >& contents )
+{
+	Pique::SHA256 hash;
+	hash.update( contents.data(), contents.size() );
+	return FileHashHexDigest( hash );
+}
+
+TEST( TestFileHash, HashFileShallDigestTheWholeFile )
+{
+	FileHashTemporaryFile file;
+	ASSERT_LE( 0, file.fd() );
+	for ( size_t length : { size_t( 0 ), size_t( 1 ), size_t( 4095 ), size_t( 4097 ), Pique::FileHash::BUFFER_SIZE + 3 } )
+	{
+		std::vector< uint8_t > contents = TestData::message( length );
+		ASSERT_TRUE( file.write( contents ) );
+
+		Pique::SHA256 hash;
+		ASSERT_TRUE( Pique::FileHash::hashFile( hash, file.path() ) ) << length;
+		ASSERT_EQ( FileHashHexDigest( contents ), FileHashHexDigest( hash ) ) << length;
+	}
+
+	// The file is appended to whatever the hash has absorbed, for any kind of hash.
+	std::vector< uint8_t > contents = TestData::message( 100000 );
+	ASSERT_TRUE( file.write( contents ) );
+	Pique::AnyHashFunction hash( Pique::BLAKE3{} );
+	hash.update( contents.data(), 10 );
+	ASSERT_TRUE( Pique::FileHash::hashFile( hash, file.path() ) );
+
+	Pique::BLAKE3 expectedHash;
+	expectedHash.update( contents.data(), 10 );
+	expectedHash.update( contents.data(), contents.size() );
+	uint8_t expectedDigest[ 64 ];
+	uint8_t messageDigest[ 64 ];
+	expectedHash.digest( expectedDigest, sizeof( expectedDigest ) );
+	ASSERT_EQ( sizeof( messageDigest ), hash.digest( messageDigest, sizeof( messageDigest ) ) );
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestFileHash, HashFdShallHashFromTheCurrentOffsetAcrossMapWindows )
+{
+	// A sparse file whose last bytes straddle the boundary of the first two windows.
+	FileHashTemporaryFile file;
+	ASSERT_LE( 0, file.fd() );
+	std::vector< uint8_t > tail = TestData::message( 9000 );
+	const off_t tailOffset = off_t( Pique::FileHash::MAP_WINDOW_SIZE ) - 4001;
+	ASSERT_EQ( ssize_t( tail.size() ), ::pwrite( file.fd(), tail.data(), tail.size(), tailOffset ) );
+
+	ASSERT_EQ( tailOffset + 17, ::lseek( file.fd(), tailOffset + 17, SEEK_SET ) );
+	Pique::SHA256 hash;
+	ASSERT_TRUE( Pique::FileHash::hashFd( hash, file.fd() ) );
+	ASSERT_EQ( FileHashHexDigest( std::vector< uint8_t >( tail.begin() + 17, tail.end() ) ), FileHashHexDigest( hash ) );
+	ASSERT_EQ( tailOffset + off_t( tail.size() ), ::lseek( file.fd(), 0, SEEK_CUR ) );
+
+	// At the end of the file there is nothing left to hash.
+	ASSERT_TRUE( Pique::FileHash::hashFd( hash, file.fd() ) );
+	ASSERT_EQ( FileHashHexDigest( std::vector< uint8_t >( tail.begin() + 17, tail.end() ) ), FileHashHexDigest( hash ) );
+}
+
+TEST( TestFileHash, HashFdShallReadPipesThroughTheReaderThread )
+{
+	for ( size_t length : { size_t( 1000 ), Pique::FileHash::BUFFER_SIZE, 3 * Pique::FileHash::BUFFER_SIZE + 777 } )
+	{
+		std::vector< uint8_t > contents = TestData::message( length );
+		int fds[ 2 ];
+		ASSERT_EQ( 0, ::pipe( fds ) );
+
+		// Irregular writes, so reads return short and a buffer fills over several of them.
+		std::thread writer( [ & ]()
+			{
+				for ( size_t offset( 0 ), step( 1 ); offset < contents.size(); step = step * 7 % 100003 )
+				{
+					ssize_t written = ::write( fds[ 1 ], contents.data() + offset, std::min( step, contents.size() - offset ) );
+					if ( written <= 0 )
+					{
+						break;
+					}
+
+					offset += size_t( written );
+				}
+
+				::close( fds[ 1 ] );
+			} );
+
+		Pique::SHA256 hash;
+		bool hashed = Pique::FileHash::hashFd( hash, fds[ 0 ] );
+		writer.join();
+		::close( fds[ 0 ] );
+		ASSERT_TRUE( hashed ) << length;
+		ASSERT_EQ( FileHashHexDigest( contents ), FileHashHexDigest( hash ) ) << length;
+	}
+}
+
+TEST( TestFileHash, FailuresShallLeaveTheHashUntouched )
+{
+	std::vector< uint8_t > contents = TestData::message( 100 );
+	Pique::SHA256 hash;
+	hash.update( contents.data(), contents.size() );
+	std::string expectedDigest = FileHashHexDigest( hash );
+
+	ASSERT_FALSE( Pique::FileHash::hashFd( hash, -1 ) );
+	ASSERT_FALSE( Pique::FileHash::hashFile( hash, nullptr ) );
+	ASSERT_FALSE( Pique::FileHash::hashFile( hash, "/nonexistent/PiqueFileHash" ) );
+
+	// A directory opens but cannot be read.
+	ASSERT_FALSE( Pique::FileHash::hashFile( hash, "/tmp" ) );
+	ASSERT_EQ( expectedDigest, FileHashHexDigest( hash ) );
+
+	// A device is read to its end like a pipe.
+	ASSERT_TRUE( Pique::FileHash::hashFile( hash, "/dev/null" ) );
+	ASSERT_EQ( expectedDigest, FileHashHexDigest( hash ) );
+}
+#endif
@@ -0,0 +1,331 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "HMAC.hpp"
+#include "Key.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+template < typename Hash >
+static void ExpectRfc4231Digest( const Pique::Key& key, const uint8_t* message, uint64_t messageLength, const uint8_t* expectedDigest )
+{
+	Pique::HMAC< Hash > hmac( key );
+	uint8_t messageDigest[ Hash::DIGEST_SIZE ];
+
+	ASSERT_TRUE( hmac.digestMessage( messageDigest, message, messageLength ) );
+	EXPECT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Hash::DIGEST_SIZE ) );
+
+	ASSERT_TRUE( hmac.update( message, messageLength / 2 ) );
+	ASSERT_TRUE( hmac.update( message + messageLength / 2, messageLength - messageLength / 2 ) );
+	ASSERT_TRUE( hmac.digest( messageDigest ) );
+	EXPECT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Hash::DIGEST_SIZE ) );
+}
+
+static void ExpectRfc4231Digests( const uint8_t* keyValue, size_t keyLength, const uint8_t* message, uint64_t messageLength,
+	const uint8_t* expectedSHA256, const uint8_t* expectedSHA384, const uint8_t* expectedSHA512 )
+{
+	Pique::Key key( keyValue, keyLength );
+	ExpectRfc4231Digest< Pique::SHA256 >( key, message, messageLength, expectedSHA256 );
+	ExpectRfc4231Digest< Pique::SHA384 >( key, message, messageLength, expectedSHA384 );
+	ExpectRfc4231Digest< Pique::SHA512 >( key, message, messageLength, expectedSHA512 );
+}
+
+TEST( TestHMAC, DigestMessageShallProduceTheRfc4231DigestsOfTestCase1 )
+{
+	static const uint8_t key[] = {
+		0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+		0x0b, 0x0b, 0x0b, 0x0b };
+	static const char message[] = "Hi There";
+	static const uint8_t expectedSHA256[] = {
+		0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c, 0xa8, 0xaf, 0xce, 0xaf, 0x0b, 0xf1, 0x2b,
+		0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7, 0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7 };
+	static const uint8_t expectedSHA384[] = {
+		0xaf, 0xd0, 0x39, 0x44, 0xd8, 0x48, 0x95, 0x62, 0x6b, 0x08, 0x25, 0xf4, 0xab, 0x46, 0x90, 0x7f,
+		0x15, 0xf9, 0xda, 0xdb, 0xe4, 0x10, 0x1e, 0xc6, 0x82, 0xaa, 0x03, 0x4c, 0x7c, 0xeb, 0xc5, 0x9c,
+		0xfa, 0xea, 0x9e, 0xa9, 0x07, 0x6e, 0xde, 0x7f, 0x4a, 0xf1, 0x52, 0xe8, 0xb2, 0xfa, 0x9c, 0xb6 };
+	static const uint8_t expectedSHA512[] = {
+		0x87, 0xaa, 0x7c, 0xde, 0xa5, 0xef, 0x61, 0x9d, 0x4f, 0xf0, 0xb4, 0x24, 0x1a, 0x1d, 0x6c, 0xb0,
+		0x23, 0x79, 0xf4, 0xe2, 0xce, 0x4e, 0xc2, 0x78, 0x7a, 0xd0, 0xb3, 0x05, 0x45, 0xe1, 0x7c, 0xde,
+		0xda, 0xa8, 0x33, 0xb7, 0xd6, 0xb8, 0xa7, 0x02, 0x03, 0x8b, 0x27, 0x4e, 0xae, 0xa3, 0xf4, 0xe4,
+		0xbe, 0x9d, 0x91, 0x4e, 0xeb, 0x61, 0xf1, 0x70, 0x2e, 0x69, 0x6c, 0x20, 0x3a, 0x12, 0x68, 0x54 };
+
+	ExpectRfc4231Digests( key, sizeof( key ), reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1, expectedSHA256, expectedSHA384, expectedSHA512 );
+}
+
+TEST( TestHMAC, DigestMessageShallProduceTheRfc4231DigestsOfTestCase2 )
+{
+	static const uint8_t key[] = {
+		0x4a, 0x65, 0x66, 0x65 };
+	static const char message[] = "what do ya want for nothing?";
+	static const uint8_t expectedSHA256[] = {
+		0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+		0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+	static const uint8_t expectedSHA384[] = {
+		0xaf, 0x45, 0xd2, 0xe3, 0x76, 0x48, 0x40, 0x31, 0x61, 0x7f, 0x78, 0xd2, 0xb5, 0x8a, 0x6b, 0x1b,
+		0x9c, 0x7e, 0xf4, 0x64, 0xf5, 0xa0, 0x1b, 0x47, 0xe4, 0x2e, 0xc3, 0x73, 0x63, 0x22, 0x44, 0x5e,
+		0x8e, 0x22, 0x40, 0xca, 0x5e, 0x69, 0xe2, 0xc7, 0x8b, 0x32, 0x39, 0xec, 0xfa, 0xb2, 0x16, 0x49 };
+	static const uint8_t expectedSHA512[] = {
+		0x16, 0x4b, 0x7a, 0x7b, 0xfc, 0xf8, 0x19, 0xe2, 0xe3, 0x95, 0xfb, 0xe7, 0x3b, 0x56, 0xe0, 0xa3,
+		0x87, 0xbd, 0x64, 0x22, 0x2e, 0x83, 0x1f, 0xd6, 0x10, 0x27, 0x0c, 0xd7, 0xea, 0x25, 0x05, 0x54,
+		0x97, 0x58, 0xbf, 0x75, 0xc0, 0x5a, 0x99, 0x4a, 0x6d, 0x03, 0x4f, 0x65, 0xf8, 0xf0, 0xe6, 0xfd,
+		0xca, 0xea, 0xb1, 0xa3, 0x4d, 0x4a, 0x6b, 0x4b, 0x63, 0x6e, 0x07, 0x0a, 0x38, 0xbc, 0xe7, 0x37 };
+
+	ExpectRfc4231Digests( key, sizeof( key ), reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1, expectedSHA256, expectedSHA384, expectedSHA512 );
+}
+
+TEST( TestHMAC, DigestMessageShallProduceTheRfc4231DigestsOfTestCase3 )
+{
+	static const uint8_t key[] = {
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa };
+	static const uint8_t message[] = {
+		0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+		0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+		0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+		0xdd, 0xdd };
+	static const uint8_t expectedSHA256[] = {
+		0x77, 0x3e, 0xa9, 0x1e, 0x36, 0x80, 0x0e, 0x46, 0x85, 0x4d, 0xb8, 0xeb, 0xd0, 0x91, 0x81, 0xa7,
+		0x29, 0x59, 0x09, 0x8b, 0x3e, 0xf8, 0xc1, 0x22, 0xd9, 0x63, 0x55, 0x14, 0xce, 0xd5, 0x65, 0xfe };
+	static const uint8_t expectedSHA384[] = {
+		0x88, 0x06, 0x26, 0x08, 0xd3, 0xe6, 0xad, 0x8a, 0x0a, 0xa2, 0xac, 0xe0, 0x14, 0xc8, 0xa8, 0x6f,
+		0x0a, 0xa6, 0x35, 0xd9, 0x47, 0xac, 0x9f, 0xeb, 0xe8, 0x3e, 0xf4, 0xe5, 0x59, 0x66, 0x14, 0x4b,
+		0x2a, 0x5a, 0xb3, 0x9d, 0xc1, 0x38, 0x14, 0xb9, 0x4e, 0x3a, 0xb6, 0xe1, 0x01, 0xa3, 0x4f, 0x27 };
+	static const uint8_t expectedSHA512[] = {
+		0xfa, 0x73, 0xb0, 0x08, 0x9d, 0x56, 0xa2, 0x84, 0xef, 0xb0, 0xf0, 0x75, 0x6c, 0x89, 0x0b, 0xe9,
+		0xb1, 0xb5, 0xdb, 0xdd, 0x8e, 0xe8, 0x1a, 0x36, 0x55, 0xf8, 0x3e, 0x33, 0xb2, 0x27, 0x9d, 0x39,
+		0xbf, 0x3e, 0x84, 0x82, 0x79, 0xa7, 0x22, 0xc8, 0x06, 0xb4, 0x85, 0xa4, 0x7e, 0x67, 0xc8, 0x07,
+		0xb9, 0x46, 0xa3, 0x37, 0xbe, 0xe8, 0x94, 0x26, 0x74, 0x27, 0x88, 0x59, 0xe1, 0x32, 0x92, 0xfb };
+
+	ExpectRfc4231Digests( key, sizeof( key ), message, sizeof( message ), expectedSHA256, expectedSHA384, expectedSHA512 );
+}
+
+TEST( TestHMAC, DigestMessageShallProduceTheRfc4231DigestsOfTestCase4 )
+{
+	static const uint8_t key[] = {
+		0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+		0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19 };
+	static const uint8_t message[] = {
+		0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd,
+		0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd,
+		0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd, 0xcd,
+		0xcd, 0xcd };
+	static const uint8_t expectedSHA256[] = {
+		0x82, 0x55, 0x8a, 0x38, 0x9a, 0x44, 0x3c, 0x0e, 0xa4, 0xcc, 0x81, 0x98, 0x99, 0xf2, 0x08, 0x3a,
+		0x85, 0xf0, 0xfa, 0xa3, 0xe5, 0x78, 0xf8, 0x07, 0x7a, 0x2e, 0x3f, 0xf4, 0x67, 0x29, 0x66, 0x5b };
+	static const uint8_t expectedSHA384[] = {
+		0x3e, 0x8a, 0x69, 0xb7, 0x78, 0x3c, 0x25, 0x85, 0x19, 0x33, 0xab, 0x62, 0x90, 0xaf, 0x6c, 0xa7,
+		0x7a, 0x99, 0x81, 0x48, 0x08, 0x50, 0x00, 0x9c, 0xc5, 0x57, 0x7c, 0x6e, 0x1f, 0x57, 0x3b, 0x4e,
+		0x68, 0x01, 0xdd, 0x23, 0xc4, 0xa7, 0xd6, 0x79, 0xcc, 0xf8, 0xa3, 0x86, 0xc6, 0x74, 0xcf, 0xfb };
+	static const uint8_t expectedSHA512[] = {
+		0xb0, 0xba, 0x46, 0x56, 0x37, 0x45, 0x8c, 0x69, 0x90, 0xe5, 0xa8, 0xc5, 0xf6, 0x1d, 0x4a, 0xf7,
+		0xe5, 0x76, 0xd9, 0x7f, 0xf9, 0x4b, 0x87, 0x2d, 0xe7, 0x6f, 0x80, 0x50, 0x36, 0x1e, 0xe3, 0xdb,
+		0xa9, 0x1c, 0xa5, 0xc1, 0x1a, 0xa2, 0x5e, 0xb4, 0xd6, 0x79, 0x27, 0x5c, 0xc5, 0x78, 0x80, 0x63,
+		0xa5, 0xf1, 0x97, 0x41, 0x12, 0x0c, 0x4f, 0x2d, 0xe2, 0xad, 0xeb, 0xeb, 0x10, 0xa2, 0x98, 0xdd };
+
+	ExpectRfc4231Digests( key, sizeof( key ), message, sizeof( message ), expectedSHA256, expectedSHA384, expectedSHA512 );
+}
+
+TEST( TestHMAC, DigestMessageShallProduceTheRfc4231DigestsOfTestCase6 )
+{
+	static const uint8_t key[] = {
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa };
+	static const char message[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+	static const uint8_t expectedSHA256[] = {
+		0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f,
+		0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14, 0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54 };
+	static const uint8_t expectedSHA384[] = {
+		0x4e, 0xce, 0x08, 0x44, 0x85, 0x81, 0x3e, 0x90, 0x88, 0xd2, 0xc6, 0x3a, 0x04, 0x1b, 0xc5, 0xb4,
+		0x4f, 0x9e, 0xf1, 0x01, 0x2a, 0x2b, 0x58, 0x8f, 0x3c, 0xd1, 0x1f, 0x05, 0x03, 0x3a, 0xc4, 0xc6,
+		0x0c, 0x2e, 0xf6, 0xab, 0x40, 0x30, 0xfe, 0x82, 0x96, 0x24, 0x8d, 0xf1, 0x63, 0xf4, 0x49, 0x52 };
+	static const uint8_t expectedSHA512[] = {
+		0x80, 0xb2, 0x42, 0x63, 0xc7, 0xc1, 0xa3, 0xeb, 0xb7, 0x14, 0x93, 0xc1, 0xdd, 0x7b, 0xe8, 0xb4,
+		0x9b, 0x46, 0xd1, 0xf4, 0x1b, 0x4a, 0xee, 0xc1, 0x12, 0x1b, 0x01, 0x37, 0x83, 0xf8, 0xf3, 0x52,
+		0x6b, 0x56, 0xd0, 0x37, 0xe0, 0x5f, 0x25, 0x98, 0xbd, 0x0f, 0xd2, 0x21, 0x5d, 0x6a, 0x1e, 0x52,
+		0x95, 0xe6, 0x4f, 0x73, 0xf6, 0x3f, 0x0a, 0xec, 0x8b, 0x91, 0x5a, 0x98, 0x5d, 0x78, 0x65, 0x98 };
+
+	ExpectRfc4231Digests( key, sizeof( key ), reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1, expectedSHA256, expectedSHA384, expectedSHA512 );
+}
+
+TEST( TestHMAC, DigestMessageShallProduceTheRfc4231DigestsOfTestCase7 )
+{
+	static const uint8_t key[] = {
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		0xaa, 0xaa, 0xaa };
+	static const char message[] = "This is a test using a larger than block-size key and a larger than block-size data. The key needs to be hashed before being used by the HMAC algorithm.";
+	static const uint8_t expectedSHA256[] = {
+		0x9b, 0x09, 0xff, 0xa7, 0x1b, 0x94, 0x2f, 0xcb, 0x27, 0x63, 0x5f, 0xbc, 0xd5, 0xb0, 0xe9, 0x44,
+		0xbf, 0xdc, 0x63, 0x64, 0x4f, 0x07, 0x13, 0x93, 0x8a, 0x7f, 0x51, 0x53, 0x5c, 0x3a, 0x35, 0xe2 };
+	static const uint8_t expectedSHA384[] = {
+		0x66, 0x17, 0x17, 0x8e, 0x94, 0x1f, 0x02, 0x0d, 0x35, 0x1e, 0x2f, 0x25, 0x4e, 0x8f, 0xd3, 0x2c,
+		0x60, 0x24, 0x20, 0xfe, 0xb0, 0xb8, 0xfb, 0x9a, 0xdc, 0xce, 0xbb, 0x82, 0x46, 0x1e, 0x99, 0xc5,
+		0xa6, 0x78, 0xcc, 0x31, 0xe7, 0x99, 0x17, 0x6d, 0x38, 0x60, 0xe6, 0x11, 0x0c, 0x46, 0x52, 0x3e };
+	static const uint8_t expectedSHA512[] = {
+		0xe3, 0x7b, 0x6a, 0x77, 0x5d, 0xc8, 0x7d, 0xba, 0xa4, 0xdf, 0xa9, 0xf9, 0x6e, 0x5e, 0x3f, 0xfd,
+		0xde, 0xbd, 0x71, 0xf8, 0x86, 0x72, 0x89, 0x86, 0x5d, 0xf5, 0xa3, 0x2d, 0x20, 0xcd, 0xc9, 0x44,
+		0xb6, 0x02, 0x2c, 0xac, 0x3c, 0x49, 0x82, 0xb1, 0x0d, 0x5e, 0xeb, 0x55, 0xc3, 0xe4, 0xde, 0x15,
+		0x13, 0x46, 0x76, 0xfb, 0x6d, 0xe0, 0x44, 0x60, 0x65, 0xc9, 0x74, 0x40, 0xfa, 0x8c, 0x6a, 0x58 };
+
+	ExpectRfc4231Digests( key, sizeof( key ), reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1, expectedSHA256, expectedSHA384, expectedSHA512 );
+}
+
+TEST( TestHMAC, SetKeyShallFailForANullKey )
+{
+	Pique::Key key;
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+
+	ASSERT_FALSE( hmac );
+	ASSERT_FALSE( hmac.update( messageDigest, sizeof( messageDigest ) ) );
+	ASSERT_FALSE( hmac.digest( messageDigest ) );
+	ASSERT_FALSE( hmac.digestMessage( messageDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestHMAC, ResetShallKeepTheKeyAndDiscardTheMessage )
+{
+	static const uint8_t keyValue[] = { 1, 2, 3, 4 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	ASSERT_TRUE( hmac.digestMessage( expectedDigest, message, sizeof( message ) ) );
+
+	hmac.update( keyValue, sizeof( keyValue ) );
+	hmac.reset();
+	hmac.update( message, sizeof( message ) );
+	ASSERT_TRUE( hmac.digest( messageDigest ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestHMAC, ClearingTheKeyShallZeroizeTheMidstates )
+{
+	static const uint8_t keyValue[] = { 1, 2, 3, 4 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+
+	// Midstates are compared through their serialized form, which has no padding.
+	uint8_t initialState[ Pique::SHA256::STATE_SIZE ];
+	uint8_t state[ Pique::SHA256::STATE_SIZE ];
+	uint64_t stateSize = Pique::SHA256().serialize( initialState, sizeof( initialState ) );
+
+	ASSERT_TRUE( hmac );
+	ASSERT_EQ( stateSize, hmac.mInnerPad.serialize( state, sizeof( state ) ) );
+	ASSERT_NE( 0, std::memcmp( initialState, state, stateSize ) );
+
+	key.clear();
+
+	ASSERT_FALSE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+	ASSERT_FALSE( hmac );
+
+	for ( const Pique::SHA256* midstate : { &hmac.mInnerPad, &hmac.mOuterPad, &hmac.mInner } )
+	{
+		ASSERT_EQ( stateSize, midstate->serialize( state, sizeof( state ) ) );
+		ASSERT_EQ( 0, std::memcmp( initialState, state, stateSize ) );
+	}
+}
+
+TEST( TestHMAC, TheMidstatesShallLiveAsLongAsAnyKeySharingTheMaterial )
+{
+	static const uint8_t keyValue[] = { 1, 2, 3, 4 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::Key copyKey( key );
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+
+	key.clear();
+	ASSERT_TRUE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+
+	copyKey.set( message, sizeof( message ) );
+	ASSERT_FALSE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+}
+
+TEST( TestHMAC, TheMidstatesShallBeDiscardedWhenTheBoundKeyIsDestroyed )
+{
+	static const uint8_t keyValue[] = { 1, 2, 3, 4 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	std::unique_ptr< Pique::Key > key( new Pique::Key( keyValue, sizeof( keyValue ) ) );
+	Pique::HMAC< Pique::SHA256 > hmac( *key );
+	Pique::HMAC< Pique::SHA256 > copyHmac( hmac );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	ASSERT_TRUE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+
+	key.reset();
+	ASSERT_FALSE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+	ASSERT_FALSE( copyHmac.update( message, sizeof( message ) ) );
+	ASSERT_FALSE( copyHmac );
+}
+
+TEST( TestHMAC, TheMidstatesShallBeDiscardedWhenTheBoundKeyIsWritten )
+{
+	static const uint8_t keyValue[] = { 1, 2, 3, 4 };
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::Key copyKey( key );
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+
+	copyKey.clear();
+	ASSERT_TRUE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+
+	key.set( keyValue, sizeof( keyValue ) );
+	ASSERT_FALSE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+
+	ASSERT_TRUE( hmac.setKey( key ) );
+	ASSERT_TRUE( hmac.digestMessage( messageDigest, message, sizeof( message ) ) );
+}
+
+TEST( TestHMAC, DigestMessageShallNotAllocate )
+{
+	static const uint8_t keyValue[] = { 1, 2, 3, 4 };
+
+	std::vector< uint8_t > message( 64, 0x5A );
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+
+	uint64_t allocationCount = AllocationCounter::count();
+	for ( size_t index( -1 ); ++index < 100; )
+	{
+		hmac.digestMessage( messageDigest, message.data(), message.size() );
+		hmac.update( message.data(), message.size() );
+		hmac.digest( messageDigest );
+		hmac.reset();
+	}
+
+	ASSERT_EQ( allocationCount, AllocationCounter::count() );
+}
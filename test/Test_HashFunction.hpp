@@ -0,0 +1,181 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <type_traits>
+#include <vector>
+
+#include "HashFunction.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+/**
+ * A toy extendable output function: every output byte is the running sum of
+ * the message bytes plus the output index.
+ */
+class TestExtendableOutputFunction final : public Pique::HashFunction< TestExtendableOutputFunction, 4, 0 >
+{
+private:
+	friend class Pique::HashFunction< TestExtendableOutputFunction, 4, 0 >;
+
+	uint8_t mSum = 0;
+
+	void __update( const uint8_t* message, uint64_t messageLength )
+	{
+		for ( uint64_t index( 0 ); index < messageLength; ++index )
+		{
+			mSum += message[ index ];
+		}
+	}
+
+	void __digest( uint8_t* messageDigest, uint64_t digestSize ) const
+	{
+		for ( uint64_t index( 0 ); index < digestSize; ++index )
+		{
+			messageDigest[ index ] = uint8_t( mSum + index );
+		}
+	}
+
+	void __reset()
+	{
+		mSum = 0;
+	}
+};
+
+TEST( TestHashFunction, HashFunctionsShallNotBePolymorphic )
+{
+	ASSERT_FALSE( std::is_polymorphic< Pique::SHA256 >::value );
+	ASSERT_FALSE( std::is_polymorphic< Pique::SHA512 >::value );
+	ASSERT_FALSE( std::is_polymorphic< TestExtendableOutputFunction >::value );
+}
+
+TEST( TestHashFunction, ConstantsShallReflectTheTemplateParameters )
+{
+	static_assert( 64 == Pique::SHA256::BLOCK_SIZE, "SHA-256 block size" );
+	static_assert( 32 == Pique::SHA256::DIGEST_SIZE, "SHA-256 digest size" );
+	static_assert( 128 == Pique::SHA384::BLOCK_SIZE, "SHA-384 block size" );
+	static_assert( 48 == Pique::SHA384::DIGEST_SIZE, "SHA-384 digest size" );
+	static_assert( TestExtendableOutputFunction::UNLIMITED_DIGEST_SIZE == TestExtendableOutputFunction::DIGEST_SIZE, "XOF digest size" );
+
+	ASSERT_EQ( 0, Pique::SHA256::UNLIMITED_DIGEST_SIZE );
+}
+
+TEST( TestHashFunction, DigestShallProduceTheRequestedLengthForAnExtendableOutputFunction )
+{
+	static const uint8_t message[] = { 1, 2, 3 };
+
+	uint8_t messageDigest[ 9 ] = { 0 };
+	TestExtendableOutputFunction hash;
+	hash.update( message, sizeof( message ) );
+	hash.digest( messageDigest, 8 );
+
+	for ( uint64_t index( 0 ); index < 8; ++index )
+	{
+		ASSERT_EQ( uint8_t( 6 + index ), messageDigest[ index ] );
+	}
+
+	ASSERT_EQ( 0, messageDigest[ 8 ] );
+}
+
+TEST( TestHashFunction, DigestMessageShallProduceTheRequestedLengthForAnExtendableOutputFunction )
+{
+	static const uint8_t message[] = { 1, 2, 3 };
+
+	uint8_t expectedDigest[ 5 ];
+	TestExtendableOutputFunction hash;
+	hash.update( message, sizeof( message ) );
+	hash.digest( expectedDigest, sizeof( expectedDigest ) );
+
+	uint8_t messageDigest[ 5 ];
+	TestExtendableOutputFunction::digestMessage( messageDigest, sizeof( messageDigest ), message, sizeof( message ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) );
+}
+
+TEST( TestHashFunction, UpdateShallIgnoreANullMessage )
+{
+	TestExtendableOutputFunction hash;
+	hash.update( static_cast< const uint8_t* >( nullptr ), 128 );
+
+	uint8_t messageDigest[ 1 ];
+	hash.digest( messageDigest, sizeof( messageDigest ) );
+
+	ASSERT_EQ( 0, messageDigest[ 0 ] );
+}
+
+TEST( TestBlockBuffer, UpdateShallCompressWholeBlocksFromTheCallersMemory )
+{
+	struct CompressCall
+	{
+		const uint8_t* blocks;
+		uint64_t blockCount;
+		uint8_t firstByte;
+	};
+
+	std::vector< uint8_t > message( 10 * 64 + 30 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index );
+	}
+
+	Pique::BlockBuffer< 64 > blockBuffer;
+	std::vector< CompressCall > calls;
+	auto compress = [ &calls ]( const uint8_t* blocks, uint64_t blockCount )
+	{
+		calls.push_back( { blocks, blockCount, blocks[ 0 ] } );
+	};
+
+	blockBuffer.update( message.data(), 10, compress );
+	ASSERT_TRUE( calls.empty() );
+	ASSERT_EQ( 10, blockBuffer.bufferLength() );
+
+	blockBuffer.update( message.data() + 10, message.size() - 10, compress );
+	ASSERT_EQ( 2, calls.size() );
+
+	// The head completes the buffered block, the rest is compressed in place.
+	ASSERT_EQ( blockBuffer.buffer(), calls[ 0 ].blocks );
+	ASSERT_EQ( 1, calls[ 0 ].blockCount );
+	ASSERT_EQ( 0, calls[ 0 ].firstByte );
+	ASSERT_EQ( message.data() + 64, calls[ 1 ].blocks );
+	ASSERT_EQ( 9, calls[ 1 ].blockCount );
+
+	ASSERT_EQ( 30, blockBuffer.bufferLength() );
+	ASSERT_EQ( message.size(), blockBuffer.messageLength() );
+	ASSERT_EQ( 0, std::memcmp( message.data() + 10 * 64, blockBuffer.buffer(), 30 ) );
+}
+
+TEST( TestBlockBuffer, UpdateShallCompressAlignedMessagesWithoutBuffering )
+{
+	std::vector< uint8_t > message( 4 * 128, 0x5A );
+
+	Pique::BlockBuffer< 128 > blockBuffer;
+	uint64_t compressCount = 0;
+	blockBuffer.update( message.data(), message.size(), [ & ]( const uint8_t* blocks, uint64_t blockCount )
+	{
+		ASSERT_EQ( message.data(), blocks );
+		ASSERT_EQ( 4, blockCount );
+		++compressCount;
+	} );
+
+	ASSERT_EQ( 1, compressCount );
+	ASSERT_EQ( 0, blockBuffer.bufferLength() );
+	ASSERT_EQ( 0, reinterpret_cast< uintptr_t >( blockBuffer.buffer() ) % 64 );
+}
+
+TEST( TestBlockBuffer, ResetShallDiscardTheBufferAndMessageLength )
+{
+	static const uint8_t message[] = { 1, 2, 3 };
+
+	Pique::BlockBuffer< 64 > blockBuffer;
+	blockBuffer.update( message, sizeof( message ), []( const uint8_t*, uint64_t ) {} );
+	blockBuffer.reset();
+
+	ASSERT_EQ( 0, blockBuffer.bufferLength() );
+	ASSERT_EQ( 0, blockBuffer.messageLength() );
+}
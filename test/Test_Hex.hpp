@@ -0,0 +1,146 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "CpuFeatures.hpp"
+#include "Hex.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+static const uint32_t HEX_TIERS[] = {
+	Pique::CpuFeatures::TIER_PORTABLE,
+	Pique::CpuFeatures::TIER_SSE4,
+	Pique::CpuFeatures::TIER_AVX2,
+};
+
+TEST( TestHex, EncodeShallWriteLowercaseDigitsOnEveryTier )
+{
+	std::vector< uint8_t > data( 200 );
+	std::string expectedHex;
+	for ( size_t index( -1 ); ++index < data.size(); )
+	{
+		data[ index ] = uint8_t( index * 29 + 3 );
+		char digits[ 3 ];
+		std::snprintf( digits, sizeof( digits ), "%02x", data[ index ] );
+		expectedHex += digits;
+	}
+
+	for ( uint32_t tier : HEX_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( size_t length( -1 ); ++length < data.size(); )
+		{
+			std::string hex( 2 * length + 1, '#' );
+			Pique::Hex::encode( &hex[ 0 ], data.data(), length );
+
+			ASSERT_EQ( expectedHex.substr( 0, 2 * length ), hex.substr( 0, 2 * length ) ) << std::hex << tier << std::dec << " " << length;
+			ASSERT_EQ( '#', hex[ 2 * length ] );
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestHex, DecodeShallAcceptEitherCaseOnEveryTier )
+{
+	std::vector< uint8_t > data( 200 );
+	std::string lowerHex;
+	std::string upperHex;
+	for ( size_t index( -1 ); ++index < data.size(); )
+	{
+		data[ index ] = uint8_t( index * 29 + 3 );
+		char digits[ 3 ];
+		std::snprintf( digits, sizeof( digits ), "%02x", data[ index ] );
+		lowerHex += digits;
+		std::snprintf( digits, sizeof( digits ), "%02X", data[ index ] );
+		upperHex += digits;
+	}
+
+	for ( uint32_t tier : HEX_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( size_t length( -1 ); ++length < data.size(); )
+		{
+			for ( const std::string* hex : { &lowerHex, &upperHex } )
+			{
+				std::vector< uint8_t > decoded( length + 1, 0xEE );
+
+				ASSERT_TRUE( Pique::Hex::decode( decoded.data(), hex->data(), 2 * length ) ) << std::hex << tier << std::dec << " " << length;
+				ASSERT_EQ( 0, std::memcmp( data.data(), decoded.data(), length ) ) << std::hex << tier << std::dec << " " << length;
+				ASSERT_EQ( 0xEE, decoded[ length ] );
+			}
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestHex, DecodeShallRejectAnOddLengthAndEveryNonDigitInAnyPositionOnEveryTier )
+{
+	std::string hex( 2 * 100, 'a' );
+	std::vector< uint8_t > decoded( 100 );
+
+	std::vector< char > nonDigits;
+	for ( int character( -1 ); ++character < 256; )
+	{
+		bool isDigit = ( ( '0' <= character ) and ( character <= '9' ) ) or ( ( 'a' <= character ) and ( character <= 'f' ) ) or ( ( 'A' <= character ) and ( character <= 'F' ) );
+		if ( not isDigit )
+		{
+			nonDigits.push_back( char( character ) );
+		}
+	}
+
+	for ( uint32_t tier : HEX_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		ASSERT_FALSE( Pique::Hex::decode( decoded.data(), hex.data(), 3 ) );
+
+		for ( size_t index( -1 ); ++index < hex.size(); )
+		{
+			for ( char nonDigit : nonDigits )
+			{
+				hex[ index ] = nonDigit;
+				ASSERT_FALSE( Pique::Hex::decode( decoded.data(), hex.data(), hex.size() ) ) << std::hex << tier << std::dec << " " << index << " " << int( nonDigit );
+			}
+
+			hex[ index ] = 'a';
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestHex, HexDigestShallProduceTheNistDigestsWithoutAllocating )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+	static const char expectedSHA256[] = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	static const char expectedSHA512[] =
+		"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+		"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f";
+
+	Pique::SHA256 sha256;
+	Pique::SHA512 sha512;
+	char hexDigest256[ 2 * Pique::SHA256::DIGEST_SIZE ];
+	char hexDigest512[ 2 * Pique::SHA512::DIGEST_SIZE ];
+
+	uint64_t allocationCount = AllocationCounter::count();
+	sha256.update( message, sizeof( message ) );
+	sha256.hexDigest( hexDigest256 );
+	sha512.update( message, sizeof( message ) );
+	sha512.hexDigest( hexDigest512 );
+	ASSERT_EQ( allocationCount, AllocationCounter::count() );
+
+	ASSERT_EQ( 0, std::memcmp( expectedSHA256, hexDigest256, sizeof( hexDigest256 ) ) );
+	ASSERT_EQ( 0, std::memcmp( expectedSHA512, hexDigest512, sizeof( hexDigest512 ) ) );
+}
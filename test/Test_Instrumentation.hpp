@@ -0,0 +1,116 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Instrumentation.hpp"
+#include "Key.hpp"
+#include "SHA256.hpp"
+#include "SHA3.hpp"
+
+#if defined( PIQUE_INSTRUMENTATION )
+TEST( TestInstrumentation, HashFunctionShallCountUpdatesBlocksAndDigests )
+{
+	std::vector< uint8_t > message( 1000, 0xA5 );
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::Instrumentation::Snapshot before = Pique::Instrumentation::snapshot();
+
+	Pique::SHA256 hash;
+	hash.update( message.data(), 3 );
+	hash.update( message.data(), 64 );
+	hash.update( message.data(), 1000 );
+	hash.update( message.data(), 0 );
+	hash.digest( messageDigest );
+	Pique::Instrumentation::Snapshot counts = Pique::Instrumentation::snapshot() - before;
+
+	// 1067 bytes fill 16 blocks, and the 43 left over pad to one more.
+	ASSERT_EQ( 3, counts.counters[ Pique::Instrumentation::HASH_UPDATES ] );
+	ASSERT_EQ( 1067, counts.counters[ Pique::Instrumentation::HASH_BYTES_ABSORBED ] );
+	ASSERT_EQ( 17, counts.counters[ Pique::Instrumentation::HASH_BLOCKS_COMPRESSED ] );
+	ASSERT_EQ( 1, counts.counters[ Pique::Instrumentation::HASH_DIGESTS ] );
+	ASSERT_LT( 0, counts.counters[ Pique::Instrumentation::HASH_DIGEST_NANOSECONDS ] );
+	for ( size_t index( -1 ); ++index < Pique::Instrumentation::UPDATE_SIZE_BUCKETS; )
+	{
+		ASSERT_EQ( ( ( 1 == index ) or ( 6 == index ) or ( 9 == index ) ) ? 1 : 0, counts.updateSizes[ index ] ) << index;
+	}
+
+	// A sponge counts one block per permutation, squeezing included.
+	before = Pique::Instrumentation::snapshot();
+	uint8_t output[ 200 ];
+	Pique::SHAKE128::digestMessage( output, sizeof( output ), message.data(), 200 );
+	counts = Pique::Instrumentation::snapshot() - before;
+	ASSERT_EQ( 3, counts.counters[ Pique::Instrumentation::HASH_BLOCKS_COMPRESSED ] );
+}
+
+TEST( TestInstrumentation, SnapshotShallIncludeThreadsThatHaveExited )
+{
+	std::vector< uint8_t > message( 1 << 25, 0xA5 );
+	Pique::Instrumentation::Snapshot before = Pique::Instrumentation::snapshot();
+
+	std::thread hasher( [ & ]()
+		{
+			Pique::SHA256 hash;
+			hash.update( message.data(), message.size() );
+		} );
+	hasher.join();
+
+	Pique::Instrumentation::Snapshot counts = Pique::Instrumentation::snapshot() - before;
+	ASSERT_EQ( message.size(), counts.counters[ Pique::Instrumentation::HASH_BYTES_ABSORBED ] );
+	ASSERT_EQ( message.size() / 64, counts.counters[ Pique::Instrumentation::HASH_BLOCKS_COMPRESSED ] );
+	ASSERT_EQ( 1, counts.updateSizes[ Pique::Instrumentation::UPDATE_SIZE_BUCKETS - 1 ] );
+}
+
+TEST( TestInstrumentation, KeyShallCountAllocationsAndCopies )
+{
+	std::vector< uint8_t > value( 2 * Pique::Key::INLINE_CAPACITY, 0x4B );
+	Pique::Instrumentation::Snapshot before = Pique::Instrumentation::snapshot();
+
+	Pique::Key inlineKey( value.data(), Pique::Key::INLINE_CAPACITY );
+	Pique::Key heapKey( value.data(), value.size() );
+	Pique::Key copy( heapKey );
+	copy = inlineKey;
+	Pique::Instrumentation::Snapshot counts = Pique::Instrumentation::snapshot() - before;
+
+	// Copies of a heap key share its buffer.
+	ASSERT_EQ( 1, counts.counters[ Pique::Instrumentation::KEY_ALLOCATIONS ] );
+	ASSERT_EQ( 2, counts.counters[ Pique::Instrumentation::KEY_COPIES ] );
+	ASSERT_EQ( 0, counts.counters[ Pique::Instrumentation::KEY_WRITE_WAITS ] );
+	ASSERT_EQ( 0, counts.counters[ Pique::Instrumentation::KEY_READ_RETRIES ] );
+
+	// The buffer of an inline key is made on demand.
+	ASSERT_NE( nullptr, inlineKey.key() );
+	ASSERT_EQ( 2, ( Pique::Instrumentation::snapshot() - before ).counters[ Pique::Instrumentation::KEY_ALLOCATIONS ] );
+}
+
+TEST( TestInstrumentation, ToJsonShallNameEveryCounter )
+{
+	Pique::Instrumentation::Snapshot snapshot;
+	snapshot.counters[ Pique::Instrumentation::KEY_COPIES ] = 7;
+	snapshot.updateSizes[ 0 ] = 2;
+	snapshot.updateSizes[ Pique::Instrumentation::UPDATE_SIZE_BUCKETS - 1 ] = 3;
+
+	ASSERT_EQ( std::string( "{\"hash_updates\":0,\"hash_bytes_absorbed\":0,\"hash_blocks_compressed\":0,"
+		"\"hash_digests\":0,\"hash_digest_nanoseconds\":0,\"key_allocations\":0,\"key_copies\":7,"
+		"\"key_write_waits\":0,\"key_read_retries\":0,"
+		"\"hash_update_sizes\":[2,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3]}" ), snapshot.toJson() );
+	ASSERT_EQ( nullptr, Pique::Instrumentation::counterName( Pique::Instrumentation::COUNTER_COUNT ) );
+}
+#endif
+
+TEST( TestInstrumentation, UpdateSizeBucketShallBeTheBinaryLogarithm )
+{
+	ASSERT_EQ( 0, Pique::Instrumentation::updateSizeBucket( 1 ) );
+	ASSERT_EQ( 1, Pique::Instrumentation::updateSizeBucket( 2 ) );
+	ASSERT_EQ( 1, Pique::Instrumentation::updateSizeBucket( 3 ) );
+	ASSERT_EQ( 10, Pique::Instrumentation::updateSizeBucket( 1024 ) );
+	ASSERT_EQ( Pique::Instrumentation::UPDATE_SIZE_BUCKETS - 1, Pique::Instrumentation::updateSizeBucket( 16 << 20 ) );
+	ASSERT_EQ( Pique::Instrumentation::UPDATE_SIZE_BUCKETS - 1, Pique::Instrumentation::updateSizeBucket( uint64_t( -1 ) ) );
+}
@@ -5,35 +5,44 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cstdint>
 #include <cstring>
 #include <gtest/gtest.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
+#include "AllocationCounter.hpp"
 #include "Key.hpp"
 
 TEST( TestKey, DefaultConstructorShallProduceANullKeyWithZeroLength )
 {
 	Pique::Key nullKey;
 
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
 }
 
 TEST( TestKey, AssignmentConstructorShallProduceANullKeyIfValueEqualsNullptrAndLengthEqualsZero )
 {
 	Pique::Key nullValueZeroLength( nullptr, 0 );
 
-	ASSERT_EQ( nullptr, nullValueZeroLength.mKeyBuffer );
-	ASSERT_EQ( 0, nullValueZeroLength.mKeyLength );
+	ASSERT_EQ( nullptr, nullValueZeroLength.key() );
+	ASSERT_EQ( 0, nullValueZeroLength.length() );
 }
 
 TEST( TestKey, AssignmentConstructorShallProduceANullKeyIfValueEqualsNullptrAndLengthDoesNotEqualZero )
 {
 	Pique::Key nullValueNonZeroLength( nullptr, 128 );
 
-	ASSERT_EQ( nullptr, nullValueNonZeroLength.mKeyBuffer );
-	ASSERT_EQ( 0, nullValueNonZeroLength.mKeyLength );
+	ASSERT_EQ( nullptr, nullValueNonZeroLength.key() );
+	ASSERT_EQ( 0, nullValueNonZeroLength.length() );
 }
 
 TEST( TestKey, AssignmentConstructorShallProduceANullKeyIfValueDoesNotEqualNullptrAndLengthEqualsZero )
@@ -42,8 +51,8 @@ TEST( TestKey, AssignmentConstructorShallProduceANullKeyIfValueDoesNotEqualNullp
 
 	Pique::Key nonNullValueZeroLength( nonNullValue, 0 );
 
-	ASSERT_EQ( nullptr, nonNullValueZeroLength.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullValueZeroLength.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullValueZeroLength.key() );
+	ASSERT_EQ( 0, nonNullValueZeroLength.length() );
 }
 
 TEST( TestKey, AssignmentConstructorShallProduceANonNullKeyIfValueDoesNotEqualNullptrAndLengthDoesNotEqualZero )
@@ -53,11 +62,11 @@ TEST( TestKey, AssignmentConstructorShallProduceANonNullKeyIfValueDoesNotEqualNu
 
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
-	ASSERT_EQ( nonNullKey.mKeyLength, nonNullValueLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullValue, nonNullKey.mKeyBuffer.get(), nonNullValueLength ) );
+	ASSERT_EQ( nonNullKey.length(), nonNullValueLength );
+	ASSERT_EQ( 0, std::memcmp( nonNullValue, nonNullKey.key().get(), nonNullValueLength ) );
 }
 
 TEST( TestKey, CopyConstructorShallProduceANullKeyIfOtherIsANullKey )
@@ -65,8 +74,8 @@ TEST( TestKey, CopyConstructorShallProduceANullKeyIfOtherIsANullKey )
 	Pique::Key nullKey;
 	Pique::Key copyNullKey( nullKey );
 
-	ASSERT_EQ( nullptr, copyNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, copyNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, copyNullKey.key() );
+	ASSERT_EQ( 0, copyNullKey.length() );
 }
 
 TEST( TestKey, CopyConstructorShallProduceANonNullKeyIfOtherIsANonNullKey )
@@ -77,28 +86,28 @@ TEST( TestKey, CopyConstructorShallProduceANonNullKeyIfOtherIsANonNullKey )
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 	Pique::Key copyNonNullKey( nonNullKey );
 
-	ASSERT_NE( nullptr, copyNonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, copyNonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, copyNonNullKey.key() );
+	ASSERT_NE( 0, copyNonNullKey.length() );
 
-	ASSERT_EQ( nonNullKey.mKeyLength, copyNonNullKey.mKeyLength );
-	ASSERT_EQ( nonNullKey.mKeyBuffer, copyNonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, std::memcmp( nonNullKey.mKeyBuffer.get(), copyNonNullKey.mKeyBuffer.get(), copyNonNullKey.mKeyLength ) );
+	ASSERT_EQ( nonNullKey.length(), copyNonNullKey.length() );
+	ASSERT_TRUE( nonNullKey == copyNonNullKey );
+	ASSERT_EQ( 0, std::memcmp( nonNullKey.key().get(), copyNonNullKey.key().get(), copyNonNullKey.length() ) );
 }
 
 TEST( TestKey, MoveConstructorShallProduceANullKeyIfOtherIsANullKeyAndOtherShallBeNullAfterward )
 {
 	Pique::Key nullKey;
 
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
 
 	Pique::Key moveNullKey( std::move( nullKey ) );
 
-	ASSERT_EQ( nullptr, moveNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, moveNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, moveNullKey.key() );
+	ASSERT_EQ( 0, moveNullKey.length() );
 
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
 }
 
 TEST( TestKey, MoveConstructorShallProduceANonNullKeyIfOtherIsANonNullKeyAndOtherShallBeNullAfterward )
@@ -108,18 +117,18 @@ TEST( TestKey, MoveConstructorShallProduceANonNullKeyIfOtherIsANonNullKeyAndOthe
 
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	Pique::Key moveNonNullKey( std::move( nonNullKey ) );
 
-	ASSERT_NE( nullptr, moveNonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, moveNonNullKey.mKeyLength );
-	ASSERT_EQ( nonNullValueLength, moveNonNullKey.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullValue, moveNonNullKey.mKeyBuffer.get(), nonNullValueLength ) );
+	ASSERT_NE( nullptr, moveNonNullKey.key() );
+	ASSERT_NE( 0, moveNonNullKey.length() );
+	ASSERT_EQ( nonNullValueLength, moveNonNullKey.length() );
+	ASSERT_EQ( 0, std::memcmp( nonNullValue, moveNonNullKey.key().get(), nonNullValueLength ) );
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, ClearShallSetTheKeyAsNull )
@@ -129,13 +138,13 @@ TEST( TestKey, ClearShallSetTheKeyAsNull )
 
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nonNullKey.clear();
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, KeyShallReturnANullSharedPtrIfKeyIsNull )
@@ -181,13 +190,13 @@ TEST( TestKey, CopyAssignmentOperatorShallSetKeyToNullIfOtherIsANullKey )
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 	Pique::Key nullKey;
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nonNullKey = nullKey;
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, CopyAssignmentOperatorShallSetNullKeyToNonNullIfOtherIsANonNullKey )
@@ -198,16 +207,16 @@ TEST( TestKey, CopyAssignmentOperatorShallSetNullKeyToNonNullIfOtherIsANonNullKe
 	Pique::Key nullKey;
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
 
 	nullKey = nonNullKey;
 
-	ASSERT_NE( nullptr, nullKey.mKeyBuffer );
-	ASSERT_NE( 0, nullKey.mKeyLength );
-	ASSERT_EQ( nonNullKey.mKeyLength, nullKey.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nullKey.mKeyBuffer.get(), nonNullKey.mKeyBuffer.get(), nullKey.mKeyLength ) );
-	ASSERT_EQ( nullKey.mKeyBuffer, nonNullKey.mKeyBuffer );
+	ASSERT_NE( nullptr, nullKey.key() );
+	ASSERT_NE( 0, nullKey.length() );
+	ASSERT_EQ( nonNullKey.length(), nullKey.length() );
+	ASSERT_EQ( 0, std::memcmp( nullKey.key().get(), nonNullKey.key().get(), nullKey.length() ) );
+	ASSERT_TRUE( nullKey == nonNullKey );
 }
 
 TEST( TestKey, CopyAssignmentOperatorShallSetNonNullKeyToNonNullIfOtherIsANonNullKey )
@@ -221,13 +230,13 @@ TEST( TestKey, CopyAssignmentOperatorShallSetNonNullKeyToNonNullIfOtherIsANonNul
 	Pique::Key nonNullKeyA( nonNullValueA, nonNullValueALength );
 	Pique::Key nonNullKeyB( nonNullValueB, nonNullValueBLength );
 
-	ASSERT_NE( nonNullKeyA.mKeyBuffer, nonNullKeyB.mKeyBuffer );
+	ASSERT_FALSE( nonNullKeyA == nonNullKeyB );
 
 	nonNullKeyA = nonNullKeyB;
 
-	ASSERT_EQ( nonNullKeyA.mKeyLength, nonNullKeyB.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullKeyA.mKeyBuffer.get(), nonNullKeyB.mKeyBuffer.get(), nonNullKeyA.mKeyLength ) );
-	ASSERT_EQ( nonNullKeyA.mKeyBuffer, nonNullKeyB.mKeyBuffer );
+	ASSERT_EQ( nonNullKeyA.length(), nonNullKeyB.length() );
+	ASSERT_EQ( 0, std::memcmp( nonNullKeyA.key().get(), nonNullKeyB.key().get(), nonNullKeyA.length() ) );
+	ASSERT_TRUE( nonNullKeyA == nonNullKeyB );
 }
 
 TEST( TestKey, MoveAssignmentShallSetNonNullKeyToNullIfOtherIsANullKeyAndOtherShallBeANullKeyAfterward )
@@ -238,15 +247,15 @@ TEST( TestKey, MoveAssignmentShallSetNonNullKeyToNullIfOtherIsANullKeyAndOtherSh
 	Pique::Key nullKey;
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nonNullKey = std::move( nullKey );
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
 }
 
 TEST( TestKey, MoveAssignmentShallSetNullKeyToNonNullIfOtherIsANonNullKeyAndOtherShallBeANullKeyAfterward )
@@ -257,20 +266,20 @@ TEST( TestKey, MoveAssignmentShallSetNullKeyToNonNullIfOtherIsANonNullKeyAndOthe
 	Pique::Key nullKey;
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nullKey = std::move( nonNullKey );
 
-	ASSERT_NE( nullptr, nullKey.mKeyBuffer );
-	ASSERT_NE( 0, nullKey.mKeyLength );
-	ASSERT_EQ( nonNullValueLength, nullKey.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullValue, nullKey.mKeyBuffer.get(), nonNullValueLength ) );
+	ASSERT_NE( nullptr, nullKey.key() );
+	ASSERT_NE( 0, nullKey.length() );
+	ASSERT_EQ( nonNullValueLength, nullKey.length() );
+	ASSERT_EQ( 0, std::memcmp( nonNullValue, nullKey.key().get(), nonNullValueLength ) );
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, MoveAssignmentShallSetNonNullKeyToNonNullIfOtherIsANonNullKeyAndOtherShallBeANullKeyAfterward )
@@ -284,20 +293,20 @@ TEST( TestKey, MoveAssignmentShallSetNonNullKeyToNonNullIfOtherIsANonNullKeyAndO
 	Pique::Key nonNullKeyA( nonNullValueA, nonNullValueALength );
 	Pique::Key nonNullKeyB( nonNullValueB, nonNullValueBLength );
 
-	ASSERT_NE( nullptr, nonNullKeyA.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKeyA.mKeyLength );
-	ASSERT_NE( nullptr, nonNullKeyB.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKeyB.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKeyA.key() );
+	ASSERT_NE( 0, nonNullKeyA.length() );
+	ASSERT_NE( nullptr, nonNullKeyB.key() );
+	ASSERT_NE( 0, nonNullKeyB.length() );
 
 	nonNullKeyA = std::move( nonNullKeyB );
 
-	ASSERT_NE( nullptr, nonNullKeyA.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKeyA.mKeyLength );
-	ASSERT_EQ( nonNullValueBLength, nonNullKeyA.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullValueB, nonNullKeyA.mKeyBuffer.get(), nonNullValueBLength ) );
+	ASSERT_NE( nullptr, nonNullKeyA.key() );
+	ASSERT_NE( 0, nonNullKeyA.length() );
+	ASSERT_EQ( nonNullValueBLength, nonNullKeyA.length() );
+	ASSERT_EQ( 0, std::memcmp( nonNullValueB, nonNullKeyA.key().get(), nonNullValueBLength ) );
 
-	ASSERT_EQ( nullptr, nonNullKeyB.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKeyB.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKeyB.key() );
+	ASSERT_EQ( 0, nonNullKeyB.length() );
 }
 
 TEST( TestKey, EqualityOperatorShallReturnFalseIfKeyLengthsAreNotEqual )
@@ -306,9 +315,9 @@ TEST( TestKey, EqualityOperatorShallReturnFalseIfKeyLengthsAreNotEqual )
 	static const size_t nonNullValueLength = sizeof( nonNullValue ) / sizeof( *nonNullValue );
 
 	Pique::Key nonNullKeyA( nonNullValue, nonNullValueLength );
-	Pique::Key nonNullKeyB( nonNullValue, nonNullValueLength );
+	Pique::Key nonNullKeyB( nonNullValue, nonNullValueLength - 1 );
 
-	nonNullKeyB.mKeyLength = nonNullKeyA.mKeyLength + 1;
+	ASSERT_NE( nonNullKeyA.length(), nonNullKeyB.length() );
 
 	ASSERT_FALSE( nonNullKeyA == nonNullKeyB );
 }
@@ -335,7 +344,7 @@ TEST( TestKey, EqualityOperatorShallReturnFalseIfBothKeysAreOfEqualLengthAndDiff
 	Pique::Key nonNullKeyA( nonNullValueA, nonNullValueALength );
 	Pique::Key nonNullKeyB( nonNullValueB, nonNullValueBLength );
 
-	ASSERT_EQ( nonNullKeyA.mKeyLength, nonNullKeyB.mKeyLength );
+	ASSERT_EQ( nonNullKeyA.length(), nonNullKeyB.length() );
 	ASSERT_FALSE( nonNullKeyA == nonNullKeyB );
 }
 
@@ -347,8 +356,8 @@ TEST( TestKey, EqualityOperatorShallReturnTrueIfBothKeysAreOfEqualLengthAndEqual
 	Pique::Key nonNullKeyA( nonNullValue, nonNullValueLength );
 	Pique::Key nonNullKeyB( nonNullValue, nonNullValueLength );
 
-	ASSERT_EQ( nonNullKeyA.mKeyLength, nonNullKeyB.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullKeyA.mKeyBuffer.get(), nonNullKeyB.mKeyBuffer.get(), nonNullValueLength ) );
+	ASSERT_EQ( nonNullKeyA.length(), nonNullKeyB.length() );
+	ASSERT_EQ( 0, std::memcmp( nonNullKeyA.key().get(), nonNullKeyB.key().get(), nonNullValueLength ) );
 	ASSERT_TRUE( nonNullKeyA == nonNullKeyB );
 }
 
@@ -360,7 +369,7 @@ TEST( TestKey, InequalityOperatorShallReturnTrueIfKeyLengthsAreNotEqual )
 	Pique::Key nullKey;
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullKey.mKeyLength, nonNullKey.mKeyLength );
+	ASSERT_NE( nullKey.length(), nonNullKey.length() );
 	ASSERT_TRUE( nullKey != nonNullKey );
 }
 
@@ -386,8 +395,8 @@ TEST( TestKey, InequalityOperatorShallReturnTrueIfBothKeysAreOfEqualLengthAndDif
 	Pique::Key nonNullKeyA( nonNullValueA, nonNullValueALength );
 	Pique::Key nonNullKeyB( nonNullValueB, nonNullValueBLength );
 
-	ASSERT_EQ( nonNullKeyA.mKeyLength, nonNullKeyB.mKeyLength );
-	ASSERT_NE( 0, std::memcmp( nonNullKeyA.mKeyBuffer.get(), nonNullKeyB.mKeyBuffer.get(), nonNullKeyA.mKeyLength ) );
+	ASSERT_EQ( nonNullKeyA.length(), nonNullKeyB.length() );
+	ASSERT_NE( 0, std::memcmp( nonNullKeyA.key().get(), nonNullKeyB.key().get(), nonNullKeyA.length() ) );
 	ASSERT_TRUE( nonNullKeyA != nonNullKeyB );
 }
 
@@ -399,8 +408,8 @@ TEST( TestKey, InequalityOperatorShallReturnFalseIfBothKeysAreOfEqualLengthAndEq
 	Pique::Key nonNullKeyA( nonNullValue, nonNullValueLength );
 	Pique::Key nonNullKeyB( nonNullValue, nonNullValueLength );
 
-	ASSERT_EQ( nonNullKeyA.mKeyLength, nonNullKeyB.mKeyLength );
-	ASSERT_EQ( 0, std::memcmp( nonNullKeyA.mKeyBuffer.get(), nonNullKeyB.mKeyBuffer.get(), nonNullKeyA.mKeyLength ) );
+	ASSERT_EQ( nonNullKeyA.length(), nonNullKeyB.length() );
+	ASSERT_EQ( 0, std::memcmp( nonNullKeyA.key().get(), nonNullKeyB.key().get(), nonNullKeyA.length() ) );
 	ASSERT_FALSE( nonNullKeyA != nonNullKeyB );
 }
 
@@ -450,13 +459,13 @@ TEST( TestKey, SetShallSetTheKeyToNullIfValueIsNullAndLengthIsZero )
 
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nonNullKey.set( nullptr, 0 );
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, SetShallSetTheKeyToNullIfValueIsNullAndLengthIsNonZero )
@@ -466,13 +475,13 @@ TEST( TestKey, SetShallSetTheKeyToNullIfValueIsNullAndLengthIsNonZero )
 
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nonNullKey.set( nullptr, 128 );
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, SetShallSetTheKeyToNullIfLengthIsZeroAndValueIsNonNull )
@@ -482,13 +491,13 @@ TEST( TestKey, SetShallSetTheKeyToNullIfLengthIsZeroAndValueIsNonNull )
 
 	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_NE( 0, nonNullKey.mKeyLength );
+	ASSERT_NE( nullptr, nonNullKey.key() );
+	ASSERT_NE( 0, nonNullKey.length() );
 
 	nonNullKey.set( nonNullValue, 0 );
 
-	ASSERT_EQ( nullptr, nonNullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nonNullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nonNullKey.key() );
+	ASSERT_EQ( 0, nonNullKey.length() );
 }
 
 TEST( TestKey, SetShallSetTheKeyToNonNullIfValueIsNonNullAndLengthIsNonZero )
@@ -498,13 +507,254 @@ TEST( TestKey, SetShallSetTheKeyToNonNullIfValueIsNonNullAndLengthIsNonZero )
 
 	Pique::Key nullKey;
 
-	ASSERT_EQ( nullptr, nullKey.mKeyBuffer );
-	ASSERT_EQ( 0, nullKey.mKeyLength );
+	ASSERT_EQ( nullptr, nullKey.key() );
+	ASSERT_EQ( 0, nullKey.length() );
 
 	nullKey.set( nonNullValue, nonNullValueLength );
 
-	ASSERT_NE( nullptr, nullKey.mKeyBuffer );
-	ASSERT_NE( 0, nullKey.mKeyLength );
-	ASSERT_EQ( nullKey.mKeyLength, nonNullValueLength );
-	ASSERT_EQ( 0, std::memcmp( nullKey.mKeyBuffer.get(), nonNullValue, nonNullValueLength ) );
+	ASSERT_NE( nullptr, nullKey.key() );
+	ASSERT_NE( 0, nullKey.length() );
+	ASSERT_EQ( nullKey.length(), nonNullValueLength );
+	ASSERT_EQ( 0, std::memcmp( nullKey.key().get(), nonNullValue, nonNullValueLength ) );
+}
+
+TEST( TestKey, ReadShallPassTheKeyBufferAndLength )
+{
+	static const uint8_t nonNullValue[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+	static const size_t nonNullValueLength = sizeof( nonNullValue ) / sizeof( *nonNullValue );
+
+	Pique::Key nullKey;
+	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
+
+	ASSERT_TRUE( nullKey.read( []( const uint8_t* buffer, size_t length )
+		{
+			return ( nullptr == buffer ) and ( 0 == length );
+		} ) );
+
+	ASSERT_TRUE( nonNullKey.read( []( const uint8_t* buffer, size_t length )
+		{
+			return ( nonNullValueLength == length ) and ( 0 == std::memcmp( nonNullValue, buffer, length ) );
+		} ) );
+}
+
+TEST( TestKey, ReadersShallAlwaysSeeAConsistentKeyWhileItIsRewritten )
+{
+	// Every value written is its length repeated, so a torn read is detectable.
+	static const size_t MAXIMUM_LENGTH = 96;
+
+	std::vector< uint8_t > value( MAXIMUM_LENGTH );
+	Pique::Key key;
+	std::atomic< bool > done( false );
+	std::atomic< uint64_t > inconsistentReads( 0 );
+
+	std::vector< std::thread > readers;
+	for ( size_t reader( -1 ); ++reader < 4; )
+	{
+		readers.emplace_back( [ & ]()
+			{
+				while ( not done.load() )
+				{
+					bool consistent = key.read( []( const uint8_t* buffer, size_t length )
+						{
+							for ( size_t index( -1 ); ++index < length; )
+							{
+								if ( buffer[ index ] != length )
+								{
+									return false;
+								}
+							}
+
+							return true;
+						} );
+
+					std::shared_ptr< const uint8_t > buffer = key.key();
+					if ( not consistent or ( ( nullptr != buffer ) and ( 0 == buffer.get()[ 0 ] ) ) )
+					{
+						++inconsistentReads;
+					}
+				}
+			} );
+	}
+
+	for ( size_t write( -1 ); ++write < 2000; )
+	{
+		size_t length = 1 + write % MAXIMUM_LENGTH;
+		std::fill( value.begin(), value.begin() + length, uint8_t( length ) );
+		if ( 0 == write % 7 )
+		{
+			key.clear();
+		}
+		else
+		{
+			key.set( value.data(), length );
+		}
+	}
+
+	done.store( true );
+	for ( std::thread& reader : readers )
+	{
+		reader.join();
+	}
+
+	ASSERT_EQ( 0, inconsistentReads.load() );
+}
+
+TEST( TestKey, KeysWithinTheInlineCapacityShallNotAllocate )
+{
+	std::vector< uint8_t > value( Pique::Key::INLINE_CAPACITY, 0xA5 );
+	Pique::Key warmUp( value.data(), value.size() );
+	Pique::Key warmUpCopy( warmUp );
+	ASSERT_TRUE( warmUp == warmUpCopy );
+
+	uint64_t allocationCount = AllocationCounter::count();
+	for ( size_t length : { size_t( 1 ), size_t( 17 ), value.size() } )
+	{
+		Pique::Key key( value.data(), length );
+		Pique::Key copyKey( key );
+		Pique::Key moveKey( std::move( copyKey ) );
+		copyKey = moveKey;
+		moveKey = std::move( copyKey );
+		key.set( value.data(), length );
+		ASSERT_TRUE( key == moveKey );
+		ASSERT_EQ( length, key.read( []( const uint8_t*, size_t keyLength ) { return keyLength; } ) );
+		key.clear();
+	}
+
+	ASSERT_EQ( allocationCount, AllocationCounter::count() );
+}
+
+TEST( TestKey, KeysBeyondTheInlineCapacityShallShareTheirBufferBetweenCopies )
+{
+	std::vector< uint8_t > value( Pique::Key::INLINE_CAPACITY + 1, 0xA5 );
+
+	Pique::Key key( value.data(), value.size() );
+	Pique::Key copyKey( key );
+
+	ASSERT_EQ( value.size(), copyKey.length() );
+	ASSERT_EQ( key.key(), copyKey.key() );
+	ASSERT_EQ( 0, std::memcmp( value.data(), copyKey.key().get(), value.size() ) );
+}
+
+TEST( TestKey, ClearAndDestructionShallZeroizeTheInlineKey )
+{
+	std::vector< uint8_t > value( Pique::Key::INLINE_CAPACITY, 0xA5 );
+	alignas( Pique::Key ) uint8_t storage[ sizeof( Pique::Key ) ];
+
+	Pique::Key key( value.data(), value.size() );
+	key.clear();
+	for ( const std::atomic< uint64_t >& word : key.mInlineKey )
+	{
+		ASSERT_EQ( 0, word.load() );
+	}
+
+	// The storage outlives the Key, so it is inspected as bytes for any word of the key left behind.
+	Pique::Key* placedKey = new ( storage ) Pique::Key( value.data(), value.size() );
+	placedKey->~Key();
+	for ( size_t offset( -1 ); ++offset <= sizeof( storage ) - sizeof( uint64_t ); )
+	{
+		ASSERT_NE( 0, std::memcmp( storage + offset, value.data(), sizeof( uint64_t ) ) );
+	}
+}
+
+TEST( TestKey, CopiesShallShareTheLifetimeOfTheKeyMaterialUntilItIsWritten )
+{
+	static const uint8_t nonNullValue[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+	static const size_t nonNullValueLength = sizeof( nonNullValue ) / sizeof( *nonNullValue );
+
+	Pique::Key key( nonNullValue, nonNullValueLength );
+	ASSERT_EQ( nullptr, key.mLifetime );
+
+	Pique::Key copyKey( key );
+	Pique::Key assignedKey;
+	assignedKey = copyKey;
+	ASSERT_NE( nullptr, key.mLifetime );
+	ASSERT_EQ( key.mLifetime, copyKey.mLifetime );
+	ASSERT_EQ( key.mLifetime, assignedKey.mLifetime );
+
+	std::weak_ptr< const void > lifetime = key.mLifetime;
+	Pique::Key moveKey( std::move( key ) );
+	ASSERT_EQ( nullptr, key.mLifetime );
+	ASSERT_EQ( lifetime.lock(), moveKey.mLifetime );
+
+	moveKey.set( nonNullValue, nonNullValueLength );
+	copyKey.clear();
+	ASSERT_EQ( nullptr, moveKey.mLifetime );
+	ASSERT_FALSE( lifetime.expired() );
+
+	assignedKey = Pique::Key();
+	ASSERT_TRUE( lifetime.expired() );
+}
+
+TEST( TestKey, GenerationShallChangeOnEveryWrite )
+{
+	static const uint8_t nonNullValue[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+	static const size_t nonNullValueLength = sizeof( nonNullValue ) / sizeof( *nonNullValue );
+
+	Pique::Key key( nonNullValue, nonNullValueLength );
+	Pique::Key otherKey;
+
+	uint64_t generation = key.generation();
+	ASSERT_EQ( generation, key.generation() );
+
+	key.set( nonNullValue, nonNullValueLength );
+	ASSERT_NE( generation, key.generation() );
+
+	generation = key.generation();
+	key = otherKey;
+	ASSERT_NE( generation, key.generation() );
+
+	generation = key.generation();
+	key.clear();
+	ASSERT_NE( generation, key.generation() );
+}
+
+TEST( TestKey, ToHexShallWriteTheHexadecimalRepresentationWithoutAllocating )
+{
+	static const uint8_t nonNullValue[] = { 0x00, 0x01, 0x02, 0x03, 0xAB, 0xCD, 0xEF, 0x07 };
+	static const size_t nonNullValueLength = sizeof( nonNullValue ) / sizeof( *nonNullValue );
+
+	Pique::Key nullKey;
+	Pique::Key nonNullKey( nonNullValue, nonNullValueLength );
+	char hex[ 2 * nonNullValueLength ];
+
+	uint64_t allocationCount = AllocationCounter::count();
+	ASSERT_EQ( 0, nullKey.toHex( hex, sizeof( hex ) ) );
+	ASSERT_EQ( 0, nonNullKey.toHex( hex, sizeof( hex ) - 1 ) );
+	ASSERT_EQ( sizeof( hex ), nonNullKey.toHex( hex, sizeof( hex ) ) );
+	ASSERT_EQ( allocationCount, AllocationCounter::count() );
+
+	ASSERT_EQ( 0, std::memcmp( "00010203abcdef07", hex, sizeof( hex ) ) );
+}
+
+TEST( TestKey, FromHexShallDecodeKeysOfAnyLengthInEitherCase )
+{
+	for ( size_t length : { size_t( 1 ), size_t( 32 ), Pique::Key::INLINE_CAPACITY, Pique::Key::INLINE_CAPACITY + 1, size_t( 300 ) } )
+	{
+		std::vector< uint8_t > value( length );
+		for ( size_t index( -1 ); ++index < length; )
+		{
+			value[ index ] = uint8_t( index * 7 + 1 );
+		}
+
+		Pique::Key key( value.data(), value.size() );
+		std::string hex( key );
+		for ( char& digit : hex )
+		{
+			digit = char( std::toupper( digit ) );
+		}
+
+		ASSERT_TRUE( key == Pique::Key::fromHex( hex.data(), hex.size() ) ) << length;
+	}
+}
+
+TEST( TestKey, FromHexShallProduceANullKeyForInvalidInput )
+{
+	ASSERT_FALSE( Pique::Key::fromHex( nullptr, 4 ) );
+	ASSERT_FALSE( Pique::Key::fromHex( "", 0 ) );
+	ASSERT_FALSE( Pique::Key::fromHex( "abc", 3 ) );
+	ASSERT_FALSE( Pique::Key::fromHex( "abcg", 4 ) );
+
+	std::string longHex( 2 * ( Pique::Key::INLINE_CAPACITY + 1 ), '0' );
+	longHex.back() = 'x';
+	ASSERT_FALSE( Pique::Key::fromHex( longHex.data(), longHex.size() ) );
 }
@@ -0,0 +1,210 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "Key.hpp"
+#include "Keyring.hpp"
+
+/**
+ * The key material of {@param keyId} at rotation {@param generation}.
+ * Every byte encodes both, so that a torn key is detected.
+ */
+static Pique::Key KeyringTestKey( uint64_t keyId, uint8_t generation, size_t length = 32 )
+{
+	std::vector< uint8_t > value( length );
+	for ( size_t index( -1 ); ++index < length; )
+	{
+		value[ index ] = uint8_t( keyId * 131 + generation * 7 + index );
+	}
+
+	return Pique::Key( value.data(), value.size() );
+}
+
+TEST( TestKeyring, TheShardCountShallBeRoundedUpToAPowerOfTwo )
+{
+	ASSERT_EQ( Pique::Keyring::DEFAULT_SHARD_COUNT, Pique::Keyring().shardCount() );
+	ASSERT_EQ( 1, Pique::Keyring( 0 ).shardCount() );
+	ASSERT_EQ( 1, Pique::Keyring( 1 ).shardCount() );
+	ASSERT_EQ( 8, Pique::Keyring( 5 ).shardCount() );
+}
+
+TEST( TestKeyring, FindShallReturnTheKeySetUnderAnId )
+{
+	for ( size_t shardCount : { size_t( 1 ), Pique::Keyring::DEFAULT_SHARD_COUNT } )
+	{
+		Pique::Keyring keyring( shardCount );
+		for ( uint64_t keyId( 0 ); keyId < 5000; ++keyId )
+		{
+			keyring.set( keyId, KeyringTestKey( keyId, 0, 1 + keyId % 100 ) );
+		}
+
+		ASSERT_EQ( 5000, keyring.size() );
+		for ( uint64_t keyId( 0 ); keyId < 5000; ++keyId )
+		{
+			ASSERT_TRUE( keyring.contains( keyId ) );
+			ASSERT_TRUE( KeyringTestKey( keyId, 0, 1 + keyId % 100 ) == keyring.find( keyId ) ) << keyId;
+		}
+
+		ASSERT_FALSE( keyring.contains( 5000 ) );
+		ASSERT_FALSE( keyring.find( 5000 ) );
+		ASSERT_FALSE( keyring.read( 5000, []( const Pique::Key& ) {} ) );
+	}
+}
+
+TEST( TestKeyring, SetShallRotateTheKeyOfAPresentId )
+{
+	Pique::Keyring keyring;
+	keyring.set( 7, KeyringTestKey( 7, 0 ) );
+	keyring.set( 7, KeyringTestKey( 7, 1 ) );
+
+	ASSERT_EQ( 1, keyring.size() );
+	ASSERT_TRUE( KeyringTestKey( 7, 1 ) == keyring.find( 7 ) );
+}
+
+TEST( TestKeyring, EraseShallRemoveOnlyTheGivenId )
+{
+	Pique::Keyring keyring( 1 );
+	for ( uint64_t keyId( 0 ); keyId < 100; ++keyId )
+	{
+		keyring.set( keyId, KeyringTestKey( keyId, 0 ) );
+	}
+
+	for ( uint64_t keyId( 0 ); keyId < 100; keyId += 2 )
+	{
+		ASSERT_TRUE( keyring.erase( keyId ) );
+	}
+
+	ASSERT_FALSE( keyring.erase( 0 ) );
+	ASSERT_EQ( 50, keyring.size() );
+	for ( uint64_t keyId( 0 ); keyId < 100; ++keyId )
+	{
+		ASSERT_EQ( 1 == keyId % 2, keyring.contains( keyId ) ) << keyId;
+	}
+
+	// Erased IDs may be set again, and the tombstones they leave are reclaimed as the table is copied.
+	for ( size_t round( -1 ); ++round < 50; )
+	{
+		keyring.set( 0, KeyringTestKey( 0, uint8_t( round ) ) );
+		ASSERT_TRUE( keyring.erase( 0 ) );
+	}
+
+	keyring.set( 0, KeyringTestKey( 0, 1 ) );
+	ASSERT_TRUE( KeyringTestKey( 0, 1 ) == keyring.find( 0 ) );
+	ASSERT_EQ( 51, keyring.size() );
+}
+
+TEST( TestKeyring, ARotatedKeyShallStayValidUntilItsReadersFinish )
+{
+	Pique::Keyring keyring;
+	keyring.set( 1, KeyringTestKey( 1, 0, 100 ) );
+
+	std::atomic< bool > readerEntered( false );
+	std::atomic< bool > readerExited( false );
+	std::atomic< bool > keyIntact( false );
+	std::thread reader( [ & ]()
+		{
+			keyring.read( 1, [ & ]( const Pique::Key& key )
+				{
+					readerEntered.store( true );
+					std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+					keyIntact.store( KeyringTestKey( 1, 0, 100 ) == key );
+				} );
+
+			readerExited.store( true );
+		} );
+
+	while ( not readerEntered.load() )
+	{
+		std::this_thread::yield();
+	}
+
+	keyring.set( 1, KeyringTestKey( 1, 1, 100 ) );
+	ASSERT_TRUE( readerExited.load() );
+	ASSERT_TRUE( keyIntact.load() );
+	ASSERT_TRUE( KeyringTestKey( 1, 1, 100 ) == keyring.find( 1 ) );
+	reader.join();
+}
+
+TEST( TestKeyring, ReadersShallSeeWholeKeysWhileKeysAreRotatedAddedAndErased )
+{
+	static const uint64_t KEY_COUNT = 256;
+
+	Pique::Keyring keyring( 4 );
+	for ( uint64_t keyId( 0 ); keyId < KEY_COUNT; ++keyId )
+	{
+		keyring.set( keyId, KeyringTestKey( keyId, 0, 80 ) );
+	}
+
+	std::atomic< bool > stop( false );
+	std::atomic< size_t > tornKeys( 0 );
+	std::vector< std::thread > readers;
+	for ( size_t thread( -1 ); ++thread < 3; )
+	{
+		readers.emplace_back( [ & ]()
+			{
+				for ( uint64_t keyId( 0 ); not stop.load( std::memory_order_relaxed ); keyId = ( keyId + 1 ) % ( 2 * KEY_COUNT ) )
+				{
+					keyring.read( keyId, [ & ]( const Pique::Key& key )
+						{
+							key.read( [ & ]( const uint8_t* buffer, size_t length )
+								{
+									uint8_t generation = uint8_t( ( buffer[ 0 ] - keyId * 131 ) * 183 );
+									std::vector< uint8_t > expected( length );
+									for ( size_t index( -1 ); ++index < length; )
+									{
+										expected[ index ] = uint8_t( keyId * 131 + generation * 7 + index );
+									}
+
+									if ( ( 80 != length ) or ( 0 != std::memcmp( expected.data(), buffer, length ) ) )
+									{
+										tornKeys.fetch_add( 1 );
+									}
+								} );
+						} );
+
+					// Let the writer run on machines with fewer cores than threads.
+					std::this_thread::yield();
+				}
+			} );
+	}
+
+	for ( size_t round( 0 ); round < 20; ++round )
+	{
+		for ( uint64_t keyId( 0 ); keyId < KEY_COUNT; ++keyId )
+		{
+			keyring.set( keyId, KeyringTestKey( keyId, uint8_t( round + 1 ), 80 ) );
+		}
+
+		for ( uint64_t keyId( KEY_COUNT ); keyId < 2 * KEY_COUNT; ++keyId )
+		{
+			if ( round % 2 )
+			{
+				keyring.erase( keyId );
+			}
+			else
+			{
+				keyring.set( keyId, KeyringTestKey( keyId, 0, 80 ) );
+			}
+		}
+	}
+
+	stop.store( true );
+	for ( std::thread& reader : readers )
+	{
+		reader.join();
+	}
+
+	ASSERT_EQ( 0, tornKeys.load() );
+	ASSERT_EQ( KEY_COUNT, keyring.size() );
+}
@@ -0,0 +1,190 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "MerkleTree.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+#include "TestData.hpp"
+#include "ThreadPool.hpp"
+
+typedef Pique::MerkleTree< Pique::SHA256 > SHA256MerkleTree;
+
+/**
+ * The Merkle tree hash of RFC 6962, section 2.1, as written there: the
+ * leaves are split at the largest power of two below their number.
+ */
+static SHA256MerkleTree::Digest ReferenceMerkleTreeHash( const uint8_t* message, uint64_t messageLength, uint64_t chunkSize )
+{
+	SHA256MerkleTree::Digest digest;
+	Pique::SHA256 hash;
+	if ( messageLength <= chunkSize )
+	{
+		uint8_t prefix = 0x00;
+		hash.update( &prefix, 1 );
+		hash.update( message, messageLength );
+		hash.digest( *reinterpret_cast< uint8_t ( * )[ 32 ] >( digest.data() ) );
+		return digest;
+	}
+
+	uint64_t leafCount = ( messageLength + chunkSize - 1 ) / chunkSize;
+	uint64_t split = 1;
+	while ( 2 * split < leafCount )
+	{
+		split *= 2;
+	}
+
+	SHA256MerkleTree::Digest left = ReferenceMerkleTreeHash( message, split * chunkSize, chunkSize );
+	SHA256MerkleTree::Digest right = ReferenceMerkleTreeHash( message + split * chunkSize, messageLength - split * chunkSize, chunkSize );
+	uint8_t prefix = 0x01;
+	hash.update( &prefix, 1 );
+	hash.update( left.data(), left.size() );
+	hash.update( right.data(), right.size() );
+	hash.digest( *reinterpret_cast< uint8_t ( * )[ 32 ] >( digest.data() ) );
+	return digest;
+}
+
+TEST( TestMerkleTree, TheRootOfAnEmptyMessageShallBeTheHashOfTheEmptyString )
+{
+	uint8_t emptyDigest[ 32 ];
+	Pique::SHA256::digestMessage( emptyDigest, nullptr, 0 );
+
+	SHA256MerkleTree tree;
+	ASSERT_EQ( 0, tree.leafCount() );
+	ASSERT_EQ( 0, std::memcmp( emptyDigest, tree.root().data(), 32 ) );
+
+	SHA256MerkleTree::Proof proof;
+	ASSERT_FALSE( tree.prove( 0, proof ) );
+}
+
+TEST( TestMerkleTree, TheRootShallMatchRfc6962ForAnyNumberOfChunksAndThreads )
+{
+	static const uint64_t CHUNK_SIZE = 64;
+	std::vector< uint8_t > message = TestData::message( 40 * CHUNK_SIZE );
+
+	for ( size_t workerCount : { size_t( 0 ), size_t( 3 ) } )
+	{
+		Pique::ThreadPool threadPool( workerCount );
+		SHA256MerkleTree tree( CHUNK_SIZE, threadPool );
+		for ( uint64_t length : { uint64_t( 1 ), CHUNK_SIZE - 1, CHUNK_SIZE, CHUNK_SIZE + 1, 2 * CHUNK_SIZE, 3 * CHUNK_SIZE - 5,
+			5 * CHUNK_SIZE, 7 * CHUNK_SIZE + 1, 16 * CHUNK_SIZE, 17 * CHUNK_SIZE, 40 * CHUNK_SIZE } )
+		{
+			tree.build( message.data(), length );
+			ASSERT_EQ( ( length + CHUNK_SIZE - 1 ) / CHUNK_SIZE, tree.leafCount() );
+			ASSERT_TRUE( ReferenceMerkleTreeHash( message.data(), length, CHUNK_SIZE ) == tree.root() ) << workerCount << " " << length;
+		}
+
+		// Enough chunks for the leaves to be split over several tasks.
+		std::vector< uint8_t > largeMessage = TestData::message( 2 * SHA256MerkleTree::MINIMUM_TASK_SIZE + 3 );
+		SHA256MerkleTree largeTree( 1000, threadPool );
+		largeTree.build( largeMessage.data(), largeMessage.size() );
+		ASSERT_TRUE( ReferenceMerkleTreeHash( largeMessage.data(), largeMessage.size(), 1000 ) == largeTree.root() ) << workerCount;
+	}
+}
+
+TEST( TestMerkleTree, EveryChunkShallBeProvenAndVerified )
+{
+	static const uint64_t CHUNK_SIZE = 100;
+	std::vector< uint8_t > message = TestData::message( 23 * CHUNK_SIZE + 17 );
+	Pique::ThreadPool threadPool( 2 );
+	SHA256MerkleTree tree( CHUNK_SIZE, threadPool );
+
+	for ( uint64_t leafCount( 0 ); ++leafCount <= 24; )
+	{
+		uint64_t length = std::min< uint64_t >( leafCount * CHUNK_SIZE, message.size() );
+		tree.build( message.data(), length );
+		for ( uint64_t leaf( 0 ); leaf < leafCount; ++leaf )
+		{
+			SHA256MerkleTree::Proof proof;
+			ASSERT_TRUE( tree.prove( leaf, proof ) );
+			ASSERT_EQ( leaf, proof.leafIndex );
+			ASSERT_EQ( leafCount, proof.leafCount );
+
+			const uint8_t* chunk = message.data() + leaf * CHUNK_SIZE;
+			uint64_t chunkLength = std::min( CHUNK_SIZE, length - leaf * CHUNK_SIZE );
+			ASSERT_TRUE( SHA256MerkleTree::verify( tree.root(), chunk, chunkLength, proof ) ) << leafCount << " " << leaf;
+		}
+
+		SHA256MerkleTree::Proof proof;
+		ASSERT_FALSE( tree.prove( leafCount, proof ) );
+	}
+}
+
+TEST( TestMerkleTree, VerifyShallRejectAlteredChunksProofsAndRoots )
+{
+	static const uint64_t CHUNK_SIZE = 32;
+	std::vector< uint8_t > message = TestData::message( 11 * CHUNK_SIZE );
+	Pique::ThreadPool threadPool( 0 );
+	SHA256MerkleTree tree( CHUNK_SIZE, threadPool );
+	tree.build( message.data(), message.size() );
+
+	SHA256MerkleTree::Proof proof;
+	ASSERT_TRUE( tree.prove( 5, proof ) );
+	const uint8_t* chunk = message.data() + 5 * CHUNK_SIZE;
+	ASSERT_TRUE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE, proof ) );
+
+	std::vector< uint8_t > alteredChunk( chunk, chunk + CHUNK_SIZE );
+	alteredChunk[ 3 ] ^= 1;
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), alteredChunk.data(), CHUNK_SIZE, proof ) );
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE - 1, proof ) );
+
+	SHA256MerkleTree::Digest alteredRoot = tree.root();
+	alteredRoot[ 31 ] ^= 1;
+	ASSERT_FALSE( SHA256MerkleTree::verify( alteredRoot, chunk, CHUNK_SIZE, proof ) );
+
+	for ( size_t step( -1 ); ++step < proof.path.size(); )
+	{
+		SHA256MerkleTree::Proof alteredProof( proof );
+		alteredProof.path[ step ][ 0 ] ^= 1;
+		ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE, alteredProof ) );
+	}
+
+	SHA256MerkleTree::Proof movedProof( proof );
+	movedProof.leafIndex = 4;
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE, movedProof ) );
+	movedProof.leafIndex = 11;
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE, movedProof ) );
+
+	SHA256MerkleTree::Proof shortProof( proof );
+	shortProof.path.pop_back();
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE, shortProof ) );
+
+	SHA256MerkleTree::Proof longProof( proof );
+	longProof.path.push_back( proof.path.back() );
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), chunk, CHUNK_SIZE, longProof ) );
+
+	// A leaf can never be passed off as a node: the chunk under node 0..1 is not part of the message.
+	ASSERT_TRUE( tree.prove( 0, proof ) );
+	std::vector< uint8_t > nodeChunk( 2 * 32 );
+	std::memcpy( nodeChunk.data(), tree.mLevels[ 0 ][ 0 ].data(), 32 );
+	std::memcpy( nodeChunk.data() + 32, tree.mLevels[ 0 ][ 1 ].data(), 32 );
+	SHA256MerkleTree::Proof nodeProof;
+	nodeProof.leafIndex = 0;
+	nodeProof.leafCount = 6;
+	nodeProof.path.assign( proof.path.begin() + 1, proof.path.end() );
+	ASSERT_FALSE( SHA256MerkleTree::verify( tree.root(), nodeChunk.data(), nodeChunk.size(), nodeProof ) );
+}
+
+TEST( TestMerkleTree, AnyHashFunctionShallServeAsLeafAndNodeHash )
+{
+	std::vector< uint8_t > message = TestData::message( 1000 );
+	Pique::ThreadPool threadPool( 1 );
+	Pique::MerkleTree< Pique::SHA512 > tree( 128, threadPool );
+	tree.build( message.data(), message.size() );
+	ASSERT_EQ( 8, tree.leafCount() );
+	ASSERT_EQ( 64, tree.root().size() );
+
+	Pique::MerkleTree< Pique::SHA512 >::Proof proof;
+	ASSERT_TRUE( tree.prove( 7, proof ) );
+	ASSERT_EQ( 3, proof.path.size() );
+	ASSERT_TRUE( Pique::MerkleTree< Pique::SHA512 >::verify( tree.root(), message.data() + 7 * 128, 1000 - 7 * 128, proof ) );
+}
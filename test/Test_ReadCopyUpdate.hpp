@@ -0,0 +1,67 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "ReadCopyUpdate.hpp"
+
+TEST( TestReadCopyUpdate, ReadLocksShallNest )
+{
+	{
+		Pique::ReadCopyUpdate::ReadLock outerReadLock;
+		Pique::ReadCopyUpdate::ReadLock innerReadLock;
+		ASSERT_EQ( 2, Pique::ReadCopyUpdate::__reader().mNesting );
+		ASSERT_EQ( 1, Pique::ReadCopyUpdate::__reader().mSequence.load() & 1 );
+	}
+
+	ASSERT_EQ( 0, Pique::ReadCopyUpdate::__reader().mNesting );
+	ASSERT_EQ( 0, Pique::ReadCopyUpdate::__reader().mSequence.load() & 1 );
+}
+
+TEST( TestReadCopyUpdate, SynchronizeShallWaitForReadersThatEnteredBeforeIt )
+{
+	std::atomic< bool > readerEntered( false );
+	std::atomic< bool > readerExited( false );
+
+	std::thread reader( [ & ]()
+		{
+			Pique::ReadCopyUpdate::ReadLock readLock;
+			readerEntered.store( true );
+			std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+			readerExited.store( true );
+		} );
+
+	while ( not readerEntered.load() )
+	{
+		std::this_thread::yield();
+	}
+
+	Pique::ReadCopyUpdate::synchronize();
+	ASSERT_TRUE( readerExited.load() );
+	reader.join();
+}
+
+TEST( TestReadCopyUpdate, SynchronizeShallNotWaitForIdleThreads )
+{
+	std::thread idleThread( []()
+		{
+			Pique::ReadCopyUpdate::ReadLock readLock;
+		} );
+	idleThread.join();
+
+	// The exited thread's record is idle and may be claimed again.
+	Pique::ReadCopyUpdate::synchronize();
+
+	std::thread nextThread( []()
+		{
+			Pique::ReadCopyUpdate::ReadLock readLock;
+		} );
+	nextThread.join();
+}
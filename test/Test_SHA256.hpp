@@ -0,0 +1,485 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "Instrumentation.hpp"
+#include "SHA256.hpp"
+#include "SHA512.hpp"
+
+TEST( TestSHA256, DigestMessageShallProduceTheNistDigestOfTheEmptyMessage )
+{
+	static const uint8_t expectedDigest[] = {
+		0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+		0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+		0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+		0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 };
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( messageDigest, nullptr, 0 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, DigestMessageShallProduceTheNistDigestOfAbc )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+	static const uint8_t expectedDigest[] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( messageDigest, message, sizeof( message ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, DigestMessageShallProduceTheNistDigestOfThe448BitMessage )
+{
+	static const char message[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	static const uint8_t expectedDigest[] = {
+		0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 };
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( messageDigest, reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, DigestMessageShallProduceTheNistDigestOfThe896BitMessage )
+{
+	static const char message[] = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+		"ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+	static const uint8_t expectedDigest[] = {
+		0xcf, 0x5b, 0x16, 0xa7, 0x78, 0xaf, 0x83, 0x80,
+		0x03, 0x6c, 0xe5, 0x9e, 0x7b, 0x04, 0x92, 0x37,
+		0x0b, 0x24, 0x9b, 0x11, 0xe8, 0xf0, 0x7a, 0x51,
+		0xaf, 0xac, 0x45, 0x03, 0x7a, 0xfe, 0xe9, 0xd1 };
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( messageDigest, reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, UpdateShallProduceTheNistDigestOfOneMillionRepetitionsOfA )
+{
+	static const uint8_t expectedDigest[] = {
+		0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+		0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+		0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+		0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0 };
+
+	// Feed an odd sized chunk so that the partial block buffering is exercised.
+	std::vector< uint8_t > chunk( 1000, 'a' );
+	Pique::SHA256 hash;
+	for ( size_t index( 0 ); index < 1000; ++index )
+	{
+		hash.update( chunk.data(), chunk.size() );
+	}
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, DigestShallNotModifyTheStateOfTheHash )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::SHA256 hash;
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	hash.update( message, 1 );
+	hash.digest( messageDigest );
+	hash.update( message + 1, sizeof( message ) - 1 );
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, ResetShallReturnTheHashToTheInitialState )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::SHA256 hash;
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	hash.update( message, sizeof( message ) );
+	hash.update( message, sizeof( message ) );
+	hash.reset();
+	hash.update( message, sizeof( message ) );
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA256, UpdateShallProduceTheSameDigestRegardlessOfHowTheMessageIsSplit )
+{
+	std::vector< uint8_t > message( 1031 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index * 131 + 7 );
+	}
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message.data(), message.size() );
+
+	for ( size_t split( 0 ); split <= message.size(); split += 13 )
+	{
+		Pique::SHA256 hash;
+		uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+		hash.update( message.data(), split );
+		hash.update( message.data() + split, message.size() - split );
+		hash.digest( messageDigest );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+	}
+}
+
+TEST( TestSHA256, SegmentedUpdateShallProduceTheSameDigestAsTheConcatenatedMessage )
+{
+	std::vector< uint8_t > message( 3 * 4096 + 100 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index * 71 + 3 );
+	}
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message.data(), message.size() );
+
+	// A header, a payload split across pages, an empty segment and a trailer.
+	const uint8_t* data = message.data();
+	Pique::MessageSegment segments[] = {
+		{ data, 14 },
+		{ data + 14, 4096 - 14 },
+		{ data + 4096, 4096 },
+		{ data + 8192, 0 },
+		{ nullptr, 0 },
+		{ data + 8192, 4096 + 96 },
+		{ data + 12384, 4 },
+	};
+
+	Pique::SHA256 hash;
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	hash.update( segments, sizeof( segments ) / sizeof( segments[ 0 ] ) );
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+
+#if defined( PIQUE_HASH_FUNCTION_IOVEC )
+	struct iovec vectors[ sizeof( segments ) / sizeof( segments[ 0 ] ) ];
+	for ( size_t index( 0 ); index < sizeof( segments ) / sizeof( segments[ 0 ] ); ++index )
+	{
+		vectors[ index ].iov_base = const_cast< uint8_t* >( segments[ index ].message );
+		vectors[ index ].iov_len = segments[ index ].messageLength;
+	}
+
+	hash.reset();
+	hash.update( vectors, sizeof( vectors ) / sizeof( vectors[ 0 ] ) );
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+#endif
+}
+
+#if defined( PIQUE_SHA256_X86 )
+TEST( TestSHA256, AcceleratedCompressionKernelsShallMatchThePortableCompression )
+{
+	typedef void ( *CompressFunction )( uint32_t*, const uint8_t*, uint64_t );
+
+	std::vector< uint8_t > blocks( 19 * Pique::SHA256::BLOCK_SIZE );
+	for ( size_t index( 0 ); index < blocks.size(); ++index )
+	{
+		blocks[ index ] = uint8_t( index * 29 + 3 );
+	}
+
+	std::vector< CompressFunction > kernels;
+	if ( Pique::CpuFeatures::supports( Pique::CpuFeatures::SHA | Pique::CpuFeatures::SSE4_1 ) )
+	{
+		kernels.push_back( Pique::SHA256::__compressShaExtensions );
+	}
+
+	if ( Pique::CpuFeatures::supports( Pique::CpuFeatures::AVX2 | Pique::CpuFeatures::BMI2 ) )
+	{
+		kernels.push_back( Pique::SHA256::__compressAvx2 );
+	}
+
+	for ( CompressFunction kernel : kernels )
+	{
+		for ( uint64_t blockCount( 0 ); blockCount <= 19; ++blockCount )
+		{
+			uint32_t expectedState[ 8 ];
+			uint32_t state[ 8 ];
+			std::memcpy( expectedState, Pique::SHA256::INITIAL_STATE, sizeof( expectedState ) );
+			std::memcpy( state, Pique::SHA256::INITIAL_STATE, sizeof( state ) );
+
+			Pique::SHA256::__compressPortable( expectedState, blocks.data(), blockCount );
+			kernel( state, blocks.data(), blockCount );
+
+			ASSERT_EQ( 0, std::memcmp( expectedState, state, sizeof( state ) ) );
+		}
+	}
+}
+#endif
+
+TEST( TestSHA256, DigestMessagesShallProduceTheSameDigestsAsDigestMessageForMessagesOfUnevenLength )
+{
+	std::vector< uint8_t > data( 4096 );
+	for ( size_t index( 0 ); index < data.size(); ++index )
+	{
+		data[ index ] = uint8_t( index * 37 + 11 );
+	}
+
+	// Lengths cover the empty message, both padding layouts and whole blocks.
+	std::vector< Pique::SHA256::BatchMessage > messages;
+	std::vector< uint8_t > messageDigests( 53 * Pique::SHA256::DIGEST_SIZE );
+	for ( size_t index( 0 ); index < 53; ++index )
+	{
+		uint64_t messageLength = ( index * index * 29 ) % 1200;
+		messages.push_back( { data.data() + index, messageLength, messageDigests.data() + index * Pique::SHA256::DIGEST_SIZE } );
+	}
+
+	Pique::SHA256::digestMessages( messages.data(), messages.size() );
+
+	for ( const Pique::SHA256::BatchMessage& message : messages )
+	{
+		uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+		Pique::SHA256::digestMessage( expectedDigest, message.message, message.messageLength );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, message.messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+	}
+}
+
+#if defined( PIQUE_SHA256_X86 )
+TEST( TestSHA256, LaneKernelsShallProduceTheSameDigestsAsDigestMessage )
+{
+	typedef void ( *BatchFunction )( Pique::SHA256::BatchMessage*, uint64_t );
+
+	std::vector< uint8_t > data( 4096 );
+	for ( size_t index( 0 ); index < data.size(); ++index )
+	{
+		data[ index ] = uint8_t( index * 37 + 11 );
+	}
+
+	std::vector< BatchFunction > batchFunctions;
+	if ( Pique::CpuFeatures::supports( Pique::CpuFeatures::AVX2 ) )
+	{
+		batchFunctions.push_back( Pique::SHA256::__digestMessagesInLanes< 8, Pique::SHA256::__compressLanesAvx2 > );
+	}
+
+	if ( Pique::CpuFeatures::supports( Pique::CpuFeatures::AVX512F | Pique::CpuFeatures::AVX512BW ) )
+	{
+		batchFunctions.push_back( Pique::SHA256::__digestMessagesInLanes< 16, Pique::SHA256::__compressLanesAvx512 > );
+	}
+
+	for ( BatchFunction batchFunction : batchFunctions )
+	{
+		// Fewer messages than lanes, then enough messages for lanes to be refilled.
+		for ( size_t messageCount : { 3, 41 } )
+		{
+			std::vector< Pique::SHA256::BatchMessage > messages;
+			std::vector< uint8_t > messageDigests( messageCount * Pique::SHA256::DIGEST_SIZE );
+			for ( size_t index( 0 ); index < messageCount; ++index )
+			{
+				uint64_t messageLength = ( index * 389 ) % 2100;
+				messages.push_back( { data.data() + index, messageLength, messageDigests.data() + index * Pique::SHA256::DIGEST_SIZE } );
+			}
+
+			batchFunction( messages.data(), messages.size() );
+
+			for ( const Pique::SHA256::BatchMessage& message : messages )
+			{
+				uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+				Pique::SHA256::digestMessage( expectedDigest, message.message, message.messageLength );
+
+				ASSERT_EQ( 0, std::memcmp( expectedDigest, message.messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+			}
+		}
+	}
+}
+#endif
+
+TEST( TestSHA256, CloneShallContinueFromTheMidstateOfTheSharedPrefix )
+{
+	static const char prefix[] = "POST /upload HTTP/1.1\r\nHost: example.com\r\nContent-Type: application/octet-stream\r\n\r\n";
+	static const char* suffixes[] = { "", "a", "payload", "a longer payload that spans the rest of the block and more than one block beyond it" };
+
+	Pique::SHA256 prefixHash;
+	prefixHash.update( reinterpret_cast< const uint8_t* >( prefix ), sizeof( prefix ) - 1 );
+
+	for ( const char* suffix : suffixes )
+	{
+		std::string message = std::string( prefix ) + suffix;
+		uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+		Pique::SHA256::digestMessage( expectedDigest, reinterpret_cast< const uint8_t* >( message.data() ), message.size() );
+
+		Pique::SHA256 hash = prefixHash.clone();
+		uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+		hash.update( reinterpret_cast< const uint8_t* >( suffix ), std::strlen( suffix ) );
+		hash.digest( messageDigest );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+	}
+}
+
+TEST( TestSHA256, DeserializeShallResumeTheSerializedMidstate )
+{
+	std::vector< uint8_t > message( 300 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index * 17 + 1 );
+	}
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, message.data(), message.size() );
+
+	for ( size_t split( 0 ); split <= message.size(); split += 7 )
+	{
+		Pique::SHA256 hash;
+		hash.update( message.data(), split );
+
+		uint8_t state[ Pique::SHA256::STATE_SIZE ];
+		uint64_t stateSize = hash.serialize( state, sizeof( state ) );
+		ASSERT_EQ( 44 + split % Pique::SHA256::BLOCK_SIZE, stateSize );
+
+		Pique::SHA256 resumedHash;
+		ASSERT_TRUE( resumedHash.deserialize( state, stateSize ) );
+
+		uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+		resumedHash.update( message.data() + split, message.size() - split );
+		resumedHash.digest( messageDigest );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+	}
+}
+
+TEST( TestSHA256, DeserializeShallRejectMalformedStates )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	Pique::SHA256 hash;
+	hash.update( message, sizeof( message ) );
+
+	uint8_t state[ Pique::SHA256::STATE_SIZE ];
+	ASSERT_EQ( 0, hash.serialize( state, Pique::SHA256::STATE_SIZE - 1 ) );
+	ASSERT_EQ( 0, hash.serialize( nullptr, Pique::SHA256::STATE_SIZE ) );
+	uint64_t stateSize = hash.serialize( state, sizeof( state ) );
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256 untouchedHash;
+	untouchedHash.digest( expectedDigest );
+
+	ASSERT_FALSE( untouchedHash.deserialize( nullptr, stateSize ) );
+	ASSERT_FALSE( untouchedHash.deserialize( state, stateSize - 1 ) );
+	ASSERT_FALSE( untouchedHash.deserialize( state, stateSize + 1 ) );
+	ASSERT_FALSE( untouchedHash.deserialize( state, 10 ) );
+
+	Pique::SHA384 otherHash;
+	ASSERT_FALSE( otherHash.deserialize( state, stateSize ) );
+
+	state[ 3 ] ^= 0x01;
+	ASSERT_FALSE( untouchedHash.deserialize( state, stateSize ) );
+
+	uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+	untouchedHash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA256::DIGEST_SIZE ) );
+}
+
+static constexpr std::array< char, 200 > SHA256ConstantMessage()
+{
+	std::array< char, 200 > message = { 0 };
+	for ( size_t index( -1 ); ++index < message.size(); )
+	{
+		message[ index ] = char( index * 7 );
+	}
+
+	return message;
+}
+
+static constexpr std::array< char, 200 > SHA256_CONSTANT_MESSAGE = SHA256ConstantMessage();
+
+/**
+ * The digest of the first Length bytes of SHA256_CONSTANT_MESSAGE, computed
+ * at compile time.
+ */
+template < size_t Length >
+static std::array< uint8_t, Pique::SHA256::DIGEST_SIZE > SHA256ConstantDigest()
+{
+	constexpr std::array< uint8_t, Pique::SHA256::DIGEST_SIZE > constantDigest =
+		Pique::SHA256::digestMessage( std::string_view( SHA256_CONSTANT_MESSAGE.data(), Length ) );
+	return constantDigest;
+}
+
+template < size_t... Lengths >
+static void SHA256ExpectConstantDigests()
+{
+	const std::array< uint8_t, Pique::SHA256::DIGEST_SIZE > constantDigests[] = { SHA256ConstantDigest< Lengths >()... };
+	const size_t lengths[] = { Lengths... };
+
+	for ( size_t index( -1 ); ++index < sizeof...( Lengths ); )
+	{
+		uint8_t messageDigest[ Pique::SHA256::DIGEST_SIZE ];
+		Pique::SHA256::digestMessage( messageDigest, reinterpret_cast< const uint8_t* >( SHA256_CONSTANT_MESSAGE.data() ), lengths[ index ] );
+		ASSERT_EQ( 0, std::memcmp( messageDigest, constantDigests[ index ].data(), sizeof( messageDigest ) ) ) << lengths[ index ];
+	}
+}
+
+TEST( TestSHA256, DigestMessageShallEvaluateAStringLiteralAtCompileTime )
+{
+	constexpr std::array< uint8_t, Pique::SHA256::DIGEST_SIZE > abcDigest = Pique::SHA256::digestMessage( "abc" );
+	static_assert( ( 0xba == abcDigest[ 0 ] ) and ( 0x78 == abcDigest[ 1 ] ) and ( 0xad == abcDigest[ 31 ] ), "SHA-256 of abc" );
+	static_assert( 0x55 == Pique::SHA256::digestMessage( "" )[ 31 ], "SHA-256 of the empty message" );
+
+	// Digest bytes serve as template arguments and case labels.
+	ASSERT_EQ( 0xba, ( std::integral_constant< uint8_t, Pique::SHA256::digestMessage( "abc" )[ 0 ] >::value ) );
+	switch ( Pique::SHA256::digestMessage( std::string( "abc" ) )[ 1 ] )
+	{
+	case Pique::SHA256::digestMessage( "abc" )[ 1 ]:
+		break;
+
+	default:
+		FAIL();
+	}
+
+	// The lengths either side of the one and two block paddings.
+	SHA256ExpectConstantDigests< 0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 127, 128, 199 >();
+}
+
+#if defined( PIQUE_INSTRUMENTATION ) && defined( PIQUE_HASH_FUNCTION_CONSTANT_EVALUATED )
+TEST( TestSHA256, DigestMessageShallHashAMessageThatIsNotAConstantWithTheRuntimeKernels )
+{
+	std::string message( 1000, 'a' );
+	Pique::Instrumentation::Snapshot before = Pique::Instrumentation::snapshot();
+	std::array< uint8_t, Pique::SHA256::DIGEST_SIZE > messageDigest = Pique::SHA256::digestMessage( message );
+	Pique::Instrumentation::Snapshot counts = Pique::Instrumentation::snapshot() - before;
+
+	uint8_t expectedDigest[ Pique::SHA256::DIGEST_SIZE ];
+	Pique::SHA256::digestMessage( expectedDigest, reinterpret_cast< const uint8_t* >( message.data() ), message.size() );
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest.data(), sizeof( expectedDigest ) ) );
+	ASSERT_EQ( 1, counts.counters[ Pique::Instrumentation::HASH_UPDATES ] );
+}
+#endif
@@ -0,0 +1,279 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "SHA3.hpp"
+#include "TestData.hpp"
+
+/**
+ * The digests of four messages: the empty message, "abc", 200 bytes of 0xa3
+ * as in the NIST examples, and the bytes 0, 1, ..., 250, 0, 1, ... of length
+ * 1000. The SHAKE outputs are the first 64 bytes.
+ */
+struct SHA3TestVector
+{
+	uint64_t algorithm;
+	const char* emptyDigest;
+	const char* abcDigest;
+	const char* repeatedDigest;
+	const char* countingDigest;
+};
+
+static const SHA3TestVector SHA3_TEST_VECTORS[] = {
+	{ 32,
+		"a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a",
+		"3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532",
+		"79f38adec5c20307a98ef76e8324afbfd46cfd81b22e3973c65fa1bd9de31787",
+		"48e66a01861d0eadaacdb7a6ae7db6b9ac79242ecced4154a9fbb33c4e3cc571" },
+	{ 64,
+		"a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1f5f94c11e3e9402c3ac558"
+		"f500199d95b6d3e301758586281dcd26",
+		"b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e10e116e9192af3c91a7ec57647e39340"
+		"57340b4cf408d5a56592f8274eec53f0",
+		"e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca81b7c13c30adf52a3659584739a2df46b"
+		"e589c51ca1a4a8416df6545a1ce8ba00",
+		"b8030d306ae990bc794bfb3a6100f67851889d6c272257afac7d1077a18660d6ea8d0da5d2299c3ebaa0d34baf62cc58"
+		"ac1fd4476506cf512a4897bb083a6fc4" },
+};
+
+static const SHA3TestVector SHAKE_TEST_VECTORS[] = {
+	{ 128,
+		"7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef263cb1eea988004b93103cfb0aeefd2a68"
+		"6e01fa4a58e8a3639ca8a1e3f9ae57e2",
+		"5881092dd818bf5cf8a3ddb793fbcba74097d5c526a6d35f97b83351940f2cc844c50af32acd3f2cdd066568706f509b"
+		"c1bdde58295dae3f891a9a0fca578378",
+		"131ab8d2b594946b9c81333f9bb6e0ce75c3b93104fa3469d3917457385da037cf232ef7164a6d1eb448c8908186ad85"
+		"2d3f85a5cf28da1ab6fe343817197846",
+		"a72440f7f5aa7c14c8e0187420611da7e2ba62f5bb2e88a91b9c9448cac30078cc321c13735bc6799f955dea38f17135"
+		"5b3ebccc9a09639b92f0f2f91ba0d6d4" },
+	{ 256,
+		"46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762fd75dc4ddd8c0f200cb05019d67b592f6"
+		"fc821c49479ab48640292eacb3b7c4be",
+		"483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa"
+		"9f8726e462a12a4feb06bd8801e751e4",
+		"cd8a920ed141aa0407a22d59288652e9d9f1a7ee0c1e7c1ca699424da84a904d2d700caae7396ece96604440577da4f3"
+		"aa22aeb8857f961c4cd8e06f0ae6610b",
+		"34833f03ed88bb5f083ce590c7ae5af93ede33e11f53c70e47916c7044746acbdca19a73ff13905e91f8dc25ce6e41ae"
+		"59fe75441bd548dda9114aca1da71802" },
+};
+
+static const uint32_t SHA3_TIERS[] = {
+	Pique::CpuFeatures::TIER_PORTABLE,
+	Pique::CpuFeatures::TIER_AVX2,
+	Pique::CpuFeatures::TIER_AVX512,
+};
+
+static std::vector< std::vector< uint8_t > > SHA3TestMessages()
+{
+	std::vector< std::vector< uint8_t > > messages( 4 );
+	messages[ 1 ] = { 'a', 'b', 'c' };
+	messages[ 2 ].assign( 200, 0xa3 );
+	messages[ 3 ] = TestData::message( 1000 );
+
+	return messages;
+}
+
+template < typename Hash >
+static std::string SHA3HexDigest( const std::vector< uint8_t >& message )
+{
+	uint8_t messageDigest[ Hash::DIGEST_SIZE ];
+	Hash::digestMessage( messageDigest, message.data(), message.size() );
+	return TestData::toHex( messageDigest, sizeof( messageDigest ) );
+}
+
+template < typename Hash >
+static std::string SHAKEHexDigest( const std::vector< uint8_t >& message, size_t digestSize )
+{
+	std::vector< uint8_t > messageDigest( digestSize );
+	Hash::digestMessage( messageDigest.data(), digestSize, message.data(), message.size() );
+	return TestData::toHex( messageDigest.data(), digestSize );
+}
+
+TEST( TestSHA3, DigestMessageShallProduceTheReferenceDigests )
+{
+	std::vector< std::vector< uint8_t > > messages = SHA3TestMessages();
+	for ( const SHA3TestVector& vector : SHA3_TEST_VECTORS )
+	{
+		const char* expectedDigests[] = { vector.emptyDigest, vector.abcDigest, vector.repeatedDigest, vector.countingDigest };
+		for ( size_t index( -1 ); ++index < messages.size(); )
+		{
+			std::string messageDigest = ( 32 == vector.algorithm )
+				? SHA3HexDigest< Pique::SHA3_256 >( messages[ index ] )
+				: SHA3HexDigest< Pique::SHA3_512 >( messages[ index ] );
+			ASSERT_EQ( expectedDigests[ index ], messageDigest ) << vector.algorithm << " " << index;
+		}
+	}
+
+	for ( const SHA3TestVector& vector : SHAKE_TEST_VECTORS )
+	{
+		const char* expectedDigests[] = { vector.emptyDigest, vector.abcDigest, vector.repeatedDigest, vector.countingDigest };
+		for ( size_t index( -1 ); ++index < messages.size(); )
+		{
+			std::string messageDigest = ( 128 == vector.algorithm )
+				? SHAKEHexDigest< Pique::SHAKE128 >( messages[ index ], 64 )
+				: SHAKEHexDigest< Pique::SHAKE256 >( messages[ index ], 64 );
+			ASSERT_EQ( expectedDigests[ index ], messageDigest ) << vector.algorithm << " " << index;
+		}
+	}
+}
+
+TEST( TestSHA3, ShakeShallSqueezeOutputAcrossSeveralBlocks )
+{
+	static const char expectedShake128[] =
+		"a72440f7f5aa7c14c8e0187420611da7e2ba62f5bb2e88a91b9c9448cac30078cc321c13735bc6799f955dea38f17135"
+		"5b3ebccc9a09639b92f0f2f91ba0d6d415d366c872dcfa18d715bb12041115850d1096489070d2febf2ffd986f53de7d"
+		"b306585567056f53553d68f789766711d9a0585dda15ff0b8ade8f6de3131ffa5bec44a58bc041e1818b713e0d6613ab"
+		"401da4772b05cac9ba879bff4d97e68a84716528a4b9fb7e7ad47fbb929819bd47dea3f407a8d14285e2ab4f96a07f13"
+		"312d73f25c0b28a4c2a35d14aaf86a5063205f626ad69e95eaf287d48c6928af0e43acc93dc91edf7eb472aa9cab1ead"
+		"68dcf8eb0ecc5178f37a3ff6d6408ec8de1d54fe35209237a8cb0df23a944822bbfc8c9617bd7aabc9a20d4e3b876c34"
+		"5b768a9f29c195d8ca3e826b1591bc637a6edfa641e0aece3b5ea039dec7adfe89e43736cd9a5beafc29cc93c5774ed2"
+		"def4af1b819e7b42d8dc74952aa0c3f070369c1a55e9df308c892b0d67587a7c6a16fca5b5f017af0f6c5185201f7298"
+		"827dcb896d707fd7baf0caa87c4a56e1";
+	static const char expectedShake256[] =
+		"34833f03ed88bb5f083ce590c7ae5af93ede33e11f53c70e47916c7044746acbdca19a73ff13905e91f8dc25ce6e41ae"
+		"59fe75441bd548dda9114aca1da7180231fc22b353327cd25e00749aa277ae0fb1103ffd454d17ae8334090a8f3fb2a5"
+		"6df10ec63f46c91ef1d877d559b5a57b4ba9abbe4a38ef7fece7abff861c8d8554b87fd45dc83f6e41c0e2b4dc62718e"
+		"0d4c20d619494947308d652f47c6db1c79d2e805989f71cfa0e79ebe54006cb264db8d31562676c89ae69c8096688764"
+		"b7aa6860d89cd4034f525349661911cad72e9a924e5573ab73cd2df07f46bbfe646961dd8f9cf076176ad6b1ac6822ac"
+		"6384e969edd9de60d116abf05f0baba3c79ce276461698b7eca119fe073c6bdad4492c1d44c3eb5c7da93d8323d0f494"
+		"8d66aa50b27e78840e0637358e830c9953c9c3231422480bd8552ba555a74465d887fb16cd599efe2d3ec69950615499"
+		"ddf8dd2a4b4fbd8fad875c7c7ea2a1d40097b8b57c857329d797f5bda6f05f04a3e2a13df69efdca19625a2cfc4de2a1"
+		"ab2d07aa5abbc8e2a90c8249d5584e31";
+
+	std::vector< uint8_t > message = SHA3TestMessages()[ 3 ];
+	ASSERT_EQ( expectedShake128, SHAKEHexDigest< Pique::SHAKE128 >( message, 400 ) );
+	ASSERT_EQ( expectedShake256, SHAKEHexDigest< Pique::SHAKE256 >( message, 400 ) );
+
+	// A shorter output is a prefix of a longer one, and digest() leaves the state untouched.
+	Pique::SHAKE128 hash;
+	hash.update( message.data(), message.size() );
+	for ( size_t digestSize( 0 ); digestSize <= 400; digestSize += 7 )
+	{
+		std::vector< uint8_t > messageDigest( digestSize );
+		hash.digest( messageDigest.data(), digestSize );
+		ASSERT_EQ( std::string( expectedShake128, 2 * digestSize ), TestData::toHex( messageDigest.data(), digestSize ) );
+	}
+}
+
+TEST( TestSHA3, UpdateShallProduceTheSameDigestRegardlessOfHowTheMessageIsSplit )
+{
+	std::vector< uint8_t > message = SHA3TestMessages()[ 3 ];
+	uint8_t expectedDigest[ Pique::SHA3_512::DIGEST_SIZE ];
+	uint8_t expectedOutput[ 300 ];
+	Pique::SHA3_512::digestMessage( expectedDigest, message.data(), message.size() );
+	Pique::SHAKE128::digestMessage( expectedOutput, sizeof( expectedOutput ), message.data(), message.size() );
+
+	for ( size_t split : { size_t( 1 ), size_t( 71 ), size_t( 72 ), size_t( 73 ), size_t( 167 ), size_t( 168 ), size_t( 169 ), size_t( 500 ) } )
+	{
+		Pique::SHA3_512 hash;
+		Pique::SHAKE128 shake;
+		for ( size_t offset( 0 ); offset < message.size(); offset += split )
+		{
+			hash.update( message.data() + offset, std::min( split, message.size() - offset ) );
+			shake.update( message.data() + offset, std::min( split, message.size() - offset ) );
+		}
+
+		uint8_t messageDigest[ Pique::SHA3_512::DIGEST_SIZE ];
+		uint8_t output[ sizeof( expectedOutput ) ];
+		hash.digest( messageDigest );
+		shake.digest( output, sizeof( output ) );
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, sizeof( messageDigest ) ) ) << split;
+		ASSERT_EQ( 0, std::memcmp( expectedOutput, output, sizeof( output ) ) ) << split;
+	}
+}
+
+TEST( TestSHA3, DigestMessagesShallMatchDigestMessageOnEveryTier )
+{
+	std::vector< uint8_t > data( 2000 );
+	for ( size_t index( -1 ); ++index < data.size(); )
+	{
+		data[ index ] = uint8_t( index * 7 + 3 );
+	}
+
+	for ( uint32_t tier : SHA3_TIERS )
+	{
+		Pique::CpuFeatures::force( tier );
+		for ( size_t messageCount : { size_t( 1 ), size_t( 3 ), size_t( 8 ), size_t( 13 ), size_t( 29 ) } )
+		{
+			// Lengths on either side of the rates, and a null message, so the lanes finish at different steps.
+			std::vector< uint64_t > lengths;
+			for ( size_t index( -1 ); ++index < messageCount; )
+			{
+				lengths.push_back( ( index * 397 ) % 900 );
+			}
+
+			for ( uint64_t digestSize : { uint64_t( 1 ), uint64_t( 32 ), uint64_t( 167 ), uint64_t( 168 ), uint64_t( 169 ), uint64_t( 600 ) } )
+			{
+				std::vector< Pique::SHAKE128::BatchMessage > messages( messageCount );
+				std::vector< uint8_t > messageDigests( messageCount * digestSize );
+				std::vector< uint8_t > expectedDigests( messageCount * digestSize );
+				for ( size_t index( -1 ); ++index < messageCount; )
+				{
+					const uint8_t* message = ( 2 == index ) ? nullptr : data.data() + index;
+					messages[ index ] = { message, lengths[ index ], messageDigests.data() + index * digestSize };
+					Pique::SHAKE128::digestMessage( expectedDigests.data() + index * digestSize, digestSize, message, lengths[ index ] );
+				}
+
+				Pique::SHAKE128::digestMessages( messages.data(), messageCount, digestSize );
+				ASSERT_TRUE( expectedDigests == messageDigests ) << std::hex << tier << std::dec << " " << messageCount << " " << digestSize;
+			}
+
+			std::vector< Pique::SHA3_256::BatchMessage > messages( messageCount );
+			std::vector< uint8_t > messageDigests( messageCount * Pique::SHA3_256::DIGEST_SIZE );
+			for ( size_t index( -1 ); ++index < messageCount; )
+			{
+				messages[ index ] = { data.data() + index, lengths[ index ] + 5, messageDigests.data() + index * Pique::SHA3_256::DIGEST_SIZE };
+			}
+
+			Pique::SHA3_256::digestMessages( messages.data(), messageCount );
+			for ( size_t index( -1 ); ++index < messageCount; )
+			{
+				uint8_t expectedDigest[ Pique::SHA3_256::DIGEST_SIZE ];
+				Pique::SHA3_256::digestMessage( expectedDigest, data.data() + index, lengths[ index ] + 5 );
+				ASSERT_EQ( 0, std::memcmp( expectedDigest, messages[ index ].messageDigest, sizeof( expectedDigest ) ) )
+					<< std::hex << tier << std::dec << " " << messageCount << " " << index;
+			}
+		}
+	}
+
+	Pique::CpuFeatures::restore();
+}
+
+TEST( TestSHA3, DeserializeShallResumeTheSerializedMidstate )
+{
+	std::vector< uint8_t > message = SHA3TestMessages()[ 3 ];
+	uint8_t expectedOutput[ 200 ];
+	Pique::SHAKE256::digestMessage( expectedOutput, sizeof( expectedOutput ), message.data(), message.size() );
+
+	for ( size_t split( 0 ); split <= message.size(); split += 67 )
+	{
+		Pique::SHAKE256 hash;
+		hash.update( message.data(), split );
+		uint8_t state[ Pique::SHAKE256::STATE_SIZE ];
+		uint64_t stateSize = hash.serialize( state, sizeof( state ) );
+		ASSERT_NE( 0, stateSize );
+
+		Pique::SHAKE256 resumedHash;
+		ASSERT_TRUE( resumedHash.deserialize( state, stateSize ) );
+		resumedHash.update( message.data() + split, message.size() - split );
+		uint8_t output[ sizeof( expectedOutput ) ];
+		resumedHash.digest( output, sizeof( output ) );
+		ASSERT_EQ( 0, std::memcmp( expectedOutput, output, sizeof( output ) ) ) << split;
+
+		// SHA3-256 has the same rate, so only the tag tells the states apart.
+		Pique::SHA3_256 otherHash;
+		ASSERT_FALSE( otherHash.deserialize( state, stateSize ) );
+		ASSERT_FALSE( resumedHash.deserialize( state, stateSize - 1 ) );
+	}
+}
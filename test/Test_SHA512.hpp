@@ -0,0 +1,371 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "SHA512.hpp"
+
+TEST( TestSHA512, DigestMessageShallProduceTheNistDigestOfTheEmptyMessage )
+{
+	static const uint8_t expectedDigest[] = {
+		0xcf, 0x83, 0xe1, 0x35, 0x7e, 0xef, 0xb8, 0xbd,
+		0xf1, 0x54, 0x28, 0x50, 0xd6, 0x6d, 0x80, 0x07,
+		0xd6, 0x20, 0xe4, 0x05, 0x0b, 0x57, 0x15, 0xdc,
+		0x83, 0xf4, 0xa9, 0x21, 0xd3, 0x6c, 0xe9, 0xce,
+		0x47, 0xd0, 0xd1, 0x3c, 0x5d, 0x85, 0xf2, 0xb0,
+		0xff, 0x83, 0x18, 0xd2, 0x87, 0x7e, 0xec, 0x2f,
+		0x63, 0xb9, 0x31, 0xbd, 0x47, 0x41, 0x7a, 0x81,
+		0xa5, 0x38, 0x32, 0x7a, 0xf9, 0x27, 0xda, 0x3e };
+
+	uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::SHA512::digestMessage( messageDigest, nullptr, 0 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512, DigestMessageShallProduceTheNistDigestOfAbc )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+	static const uint8_t expectedDigest[] = {
+		0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba,
+		0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+		0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2,
+		0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+		0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8,
+		0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+		0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e,
+		0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f };
+
+	uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::SHA512::digestMessage( messageDigest, message, sizeof( message ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512, DigestMessageShallProduceTheNistDigestOfThe896BitMessage )
+{
+	static const char message[] = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+		"ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+	static const uint8_t expectedDigest[] = {
+		0x8e, 0x95, 0x9b, 0x75, 0xda, 0xe3, 0x13, 0xda,
+		0x8c, 0xf4, 0xf7, 0x28, 0x14, 0xfc, 0x14, 0x3f,
+		0x8f, 0x77, 0x79, 0xc6, 0xeb, 0x9f, 0x7f, 0xa1,
+		0x72, 0x99, 0xae, 0xad, 0xb6, 0x88, 0x90, 0x18,
+		0x50, 0x1d, 0x28, 0x9e, 0x49, 0x00, 0xf7, 0xe4,
+		0x33, 0x1b, 0x99, 0xde, 0xc4, 0xb5, 0x43, 0x3a,
+		0xc7, 0xd3, 0x29, 0xee, 0xb6, 0xdd, 0x26, 0x54,
+		0x5e, 0x96, 0xe5, 0x5b, 0x87, 0x4b, 0xe9, 0x09 };
+
+	uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::SHA512::digestMessage( messageDigest, reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512, UpdateShallProduceTheNistDigestOfOneMillionRepetitionsOfA )
+{
+	static const uint8_t expectedDigest[] = {
+		0xe7, 0x18, 0x48, 0x3d, 0x0c, 0xe7, 0x69, 0x64,
+		0x4e, 0x2e, 0x42, 0xc7, 0xbc, 0x15, 0xb4, 0x63,
+		0x8e, 0x1f, 0x98, 0xb1, 0x3b, 0x20, 0x44, 0x28,
+		0x56, 0x32, 0xa8, 0x03, 0xaf, 0xa9, 0x73, 0xeb,
+		0xde, 0x0f, 0xf2, 0x44, 0x87, 0x7e, 0xa6, 0x0a,
+		0x4c, 0xb0, 0x43, 0x2c, 0xe5, 0x77, 0xc3, 0x1b,
+		0xeb, 0x00, 0x9c, 0x5c, 0x2c, 0x49, 0xaa, 0x2e,
+		0x4e, 0xad, 0xb2, 0x17, 0xad, 0x8c, 0xc0, 0x9b };
+
+	// Feed an odd sized chunk so that the partial block buffering is exercised.
+	std::vector< uint8_t > chunk( 1000, 'a' );
+	Pique::SHA512 hash;
+	for ( size_t index( 0 ); index < 1000; ++index )
+	{
+		hash.update( chunk.data(), chunk.size() );
+	}
+
+	uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA384, DigestMessageShallProduceTheNistDigestOfTheEmptyMessage )
+{
+	static const uint8_t expectedDigest[] = {
+		0x38, 0xb0, 0x60, 0xa7, 0x51, 0xac, 0x96, 0x38,
+		0x4c, 0xd9, 0x32, 0x7e, 0xb1, 0xb1, 0xe3, 0x6a,
+		0x21, 0xfd, 0xb7, 0x11, 0x14, 0xbe, 0x07, 0x43,
+		0x4c, 0x0c, 0xc7, 0xbf, 0x63, 0xf6, 0xe1, 0xda,
+		0x27, 0x4e, 0xde, 0xbf, 0xe7, 0x6f, 0x65, 0xfb,
+		0xd5, 0x1a, 0xd2, 0xf1, 0x48, 0x98, 0xb9, 0x5b };
+
+	uint8_t messageDigest[ Pique::SHA384::DIGEST_SIZE ];
+	Pique::SHA384::digestMessage( messageDigest, nullptr, 0 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA384::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA384, DigestMessageShallProduceTheNistDigestOfAbc )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+	static const uint8_t expectedDigest[] = {
+		0xcb, 0x00, 0x75, 0x3f, 0x45, 0xa3, 0x5e, 0x8b,
+		0xb5, 0xa0, 0x3d, 0x69, 0x9a, 0xc6, 0x50, 0x07,
+		0x27, 0x2c, 0x32, 0xab, 0x0e, 0xde, 0xd1, 0x63,
+		0x1a, 0x8b, 0x60, 0x5a, 0x43, 0xff, 0x5b, 0xed,
+		0x80, 0x86, 0x07, 0x2b, 0xa1, 0xe7, 0xcc, 0x23,
+		0x58, 0xba, 0xec, 0xa1, 0x34, 0xc8, 0x25, 0xa7 };
+
+	uint8_t messageDigest[ Pique::SHA384::DIGEST_SIZE ];
+	Pique::SHA384::digestMessage( messageDigest, message, sizeof( message ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA384::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA384, DigestMessageShallProduceTheNistDigestOfThe896BitMessage )
+{
+	static const char message[] = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+		"ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+	static const uint8_t expectedDigest[] = {
+		0x09, 0x33, 0x0c, 0x33, 0xf7, 0x11, 0x47, 0xe8,
+		0x3d, 0x19, 0x2f, 0xc7, 0x82, 0xcd, 0x1b, 0x47,
+		0x53, 0x11, 0x1b, 0x17, 0x3b, 0x3b, 0x05, 0xd2,
+		0x2f, 0xa0, 0x80, 0x86, 0xe3, 0xb0, 0xf7, 0x12,
+		0xfc, 0xc7, 0xc7, 0x1a, 0x55, 0x7e, 0x2d, 0xb9,
+		0x66, 0xc3, 0xe9, 0xfa, 0x91, 0x74, 0x60, 0x39 };
+
+	uint8_t messageDigest[ Pique::SHA384::DIGEST_SIZE ];
+	Pique::SHA384::digestMessage( messageDigest, reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA384::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA384, UpdateShallProduceTheNistDigestOfOneMillionRepetitionsOfA )
+{
+	static const uint8_t expectedDigest[] = {
+		0x9d, 0x0e, 0x18, 0x09, 0x71, 0x64, 0x74, 0xcb,
+		0x08, 0x6e, 0x83, 0x4e, 0x31, 0x0a, 0x4a, 0x1c,
+		0xed, 0x14, 0x9e, 0x9c, 0x00, 0xf2, 0x48, 0x52,
+		0x79, 0x72, 0xce, 0xc5, 0x70, 0x4c, 0x2a, 0x5b,
+		0x07, 0xb8, 0xb3, 0xdc, 0x38, 0xec, 0xc4, 0xeb,
+		0xae, 0x97, 0xdd, 0xd8, 0x7f, 0x3d, 0x89, 0x85 };
+
+	// Feed an odd sized chunk so that the partial block buffering is exercised.
+	std::vector< uint8_t > chunk( 1000, 'a' );
+	Pique::SHA384 hash;
+	for ( size_t index( 0 ); index < 1000; ++index )
+	{
+		hash.update( chunk.data(), chunk.size() );
+	}
+
+	uint8_t messageDigest[ Pique::SHA384::DIGEST_SIZE ];
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA384::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512_256, DigestMessageShallProduceTheNistDigestOfTheEmptyMessage )
+{
+	static const uint8_t expectedDigest[] = {
+		0xc6, 0x72, 0xb8, 0xd1, 0xef, 0x56, 0xed, 0x28,
+		0xab, 0x87, 0xc3, 0x62, 0x2c, 0x51, 0x14, 0x06,
+		0x9b, 0xdd, 0x3a, 0xd7, 0xb8, 0xf9, 0x73, 0x74,
+		0x98, 0xd0, 0xc0, 0x1e, 0xce, 0xf0, 0x96, 0x7a };
+
+	uint8_t messageDigest[ Pique::SHA512_256::DIGEST_SIZE ];
+	Pique::SHA512_256::digestMessage( messageDigest, nullptr, 0 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512_256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512_256, DigestMessageShallProduceTheNistDigestOfAbc )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+	static const uint8_t expectedDigest[] = {
+		0x53, 0x04, 0x8e, 0x26, 0x81, 0x94, 0x1e, 0xf9,
+		0x9b, 0x2e, 0x29, 0xb7, 0x6b, 0x4c, 0x7d, 0xab,
+		0xe4, 0xc2, 0xd0, 0xc6, 0x34, 0xfc, 0x6d, 0x46,
+		0xe0, 0xe2, 0xf1, 0x31, 0x07, 0xe7, 0xaf, 0x23 };
+
+	uint8_t messageDigest[ Pique::SHA512_256::DIGEST_SIZE ];
+	Pique::SHA512_256::digestMessage( messageDigest, message, sizeof( message ) );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512_256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512_256, DigestMessageShallProduceTheNistDigestOfThe896BitMessage )
+{
+	static const char message[] = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+		"ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+	static const uint8_t expectedDigest[] = {
+		0x39, 0x28, 0xe1, 0x84, 0xfb, 0x86, 0x90, 0xf8,
+		0x40, 0xda, 0x39, 0x88, 0x12, 0x1d, 0x31, 0xbe,
+		0x65, 0xcb, 0x9d, 0x3e, 0xf8, 0x3e, 0xe6, 0x14,
+		0x6f, 0xea, 0xc8, 0x61, 0xe1, 0x9b, 0x56, 0x3a };
+
+	uint8_t messageDigest[ Pique::SHA512_256::DIGEST_SIZE ];
+	Pique::SHA512_256::digestMessage( messageDigest, reinterpret_cast< const uint8_t* >( message ), sizeof( message ) - 1 );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512_256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512_256, UpdateShallProduceTheNistDigestOfOneMillionRepetitionsOfA )
+{
+	static const uint8_t expectedDigest[] = {
+		0x9a, 0x59, 0xa0, 0x52, 0x93, 0x01, 0x87, 0xa9,
+		0x70, 0x38, 0xca, 0xe6, 0x92, 0xf3, 0x07, 0x08,
+		0xaa, 0x64, 0x91, 0x92, 0x3e, 0xf5, 0x19, 0x43,
+		0x94, 0xdc, 0x68, 0xd5, 0x6c, 0x74, 0xfb, 0x21 };
+
+	// Feed an odd sized chunk so that the partial block buffering is exercised.
+	std::vector< uint8_t > chunk( 1000, 'a' );
+	Pique::SHA512_256 hash;
+	for ( size_t index( 0 ); index < 1000; ++index )
+	{
+		hash.update( chunk.data(), chunk.size() );
+	}
+
+	uint8_t messageDigest[ Pique::SHA512_256::DIGEST_SIZE ];
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512_256::DIGEST_SIZE ) );
+}
+
+TEST( TestSHA512, UpdateShallProduceTheSameDigestRegardlessOfHowTheMessageIsSplit )
+{
+	std::vector< uint8_t > message( 2063 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index * 131 + 7 );
+	}
+
+	uint8_t expectedDigest[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::SHA512::digestMessage( expectedDigest, message.data(), message.size() );
+
+	for ( size_t split( 0 ); split <= message.size(); split += 17 )
+	{
+		Pique::SHA512 hash;
+		uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+		hash.update( message.data(), split );
+		hash.update( message.data() + split, message.size() - split );
+		hash.digest( messageDigest );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512::DIGEST_SIZE ) );
+	}
+}
+
+TEST( TestSHA512, ResetShallReturnTheHashToTheInitialState )
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+
+	uint8_t expectedDigest[ Pique::SHA512::DIGEST_SIZE ];
+	Pique::SHA512::digestMessage( expectedDigest, message, sizeof( message ) );
+
+	Pique::SHA512 hash;
+	uint8_t messageDigest[ Pique::SHA512::DIGEST_SIZE ];
+	hash.update( message, sizeof( message ) );
+	hash.reset();
+	hash.update( message, sizeof( message ) );
+	hash.digest( messageDigest );
+
+	ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA512::DIGEST_SIZE ) );
+}
+
+#if defined( PIQUE_SHA512_X86 )
+TEST( TestSHA512, Avx2CompressionKernelShallMatchThePortableCompression )
+{
+	if ( not Pique::CpuFeatures::supports( Pique::CpuFeatures::AVX2 | Pique::CpuFeatures::BMI2 ) )
+	{
+		GTEST_SKIP();
+	}
+
+	std::vector< uint8_t > blocks( 11 * Pique::SHA512::BLOCK_SIZE );
+	for ( size_t index( 0 ); index < blocks.size(); ++index )
+	{
+		blocks[ index ] = uint8_t( index * 29 + 3 );
+	}
+
+	for ( uint64_t blockCount( 0 ); blockCount <= 11; ++blockCount )
+	{
+		uint64_t expectedState[ 8 ];
+		uint64_t state[ 8 ];
+		std::memcpy( expectedState, Pique::SHA512Compression::INITIAL_STATE_SHA512, sizeof( expectedState ) );
+		std::memcpy( state, Pique::SHA512Compression::INITIAL_STATE_SHA512, sizeof( state ) );
+
+		Pique::SHA512Compression::__compressPortable( expectedState, blocks.data(), blockCount );
+		Pique::SHA512Compression::__compressAvx2( state, blocks.data(), blockCount );
+
+		ASSERT_EQ( 0, std::memcmp( expectedState, state, sizeof( state ) ) );
+	}
+}
+#endif
+
+TEST( TestSHA384, DigestMessagesShallProduceTheSameDigestsAsDigestMessage )
+{
+	std::vector< uint8_t > data( 1024 );
+	for ( size_t index( 0 ); index < data.size(); ++index )
+	{
+		data[ index ] = uint8_t( index * 37 + 11 );
+	}
+
+	std::vector< Pique::SHA384::BatchMessage > messages;
+	std::vector< uint8_t > messageDigests( 9 * Pique::SHA384::DIGEST_SIZE );
+	for ( size_t index( 0 ); index < 9; ++index )
+	{
+		messages.push_back( { data.data() + index, index * 111, messageDigests.data() + index * Pique::SHA384::DIGEST_SIZE } );
+	}
+
+	Pique::SHA384::digestMessages( messages.data(), messages.size() );
+
+	for ( const Pique::SHA384::BatchMessage& message : messages )
+	{
+		uint8_t expectedDigest[ Pique::SHA384::DIGEST_SIZE ];
+		Pique::SHA384::digestMessage( expectedDigest, message.message, message.messageLength );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, message.messageDigest, Pique::SHA384::DIGEST_SIZE ) );
+	}
+}
+
+TEST( TestSHA512, DeserializeShallResumeTheSerializedMidstateOfEveryFamilyMember )
+{
+	std::vector< uint8_t > message( 700 );
+	for ( size_t index( 0 ); index < message.size(); ++index )
+	{
+		message[ index ] = uint8_t( index * 41 + 9 );
+	}
+
+	uint8_t expectedDigest[ Pique::SHA384::DIGEST_SIZE ];
+	Pique::SHA384::digestMessage( expectedDigest, message.data(), message.size() );
+
+	for ( size_t split( 0 ); split <= message.size(); split += 37 )
+	{
+		Pique::SHA384 hash;
+		hash.update( message.data(), split );
+
+		uint8_t state[ Pique::SHA384::STATE_SIZE ];
+		uint64_t stateSize = hash.serialize( state, sizeof( state ) );
+		ASSERT_EQ( 76 + split % Pique::SHA384::BLOCK_SIZE, stateSize );
+
+		// The family members share a state layout but must not accept each other's states.
+		Pique::SHA512 otherHash;
+		Pique::SHA512_256 otherTruncatedHash;
+		ASSERT_FALSE( otherHash.deserialize( state, stateSize ) );
+		ASSERT_FALSE( otherTruncatedHash.deserialize( state, stateSize ) );
+
+		Pique::SHA384 resumedHash;
+		ASSERT_TRUE( resumedHash.deserialize( state, stateSize ) );
+
+		uint8_t messageDigest[ Pique::SHA384::DIGEST_SIZE ];
+		resumedHash.update( message.data() + split, message.size() - split );
+		resumedHash.digest( messageDigest );
+
+		ASSERT_EQ( 0, std::memcmp( expectedDigest, messageDigest, Pique::SHA384::DIGEST_SIZE ) );
+	}
+}
@@ -0,0 +1,210 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Key.hpp"
+#include "SecureArena.hpp"
+
+TEST( TestSecureArena, AllocateShallReturnNullForAZeroLength )
+{
+	ASSERT_EQ( nullptr, Pique::SecureArena::allocate( 0 ) );
+}
+
+TEST( TestSecureArena, AllocateShallReturnAlignedWritableBlocksOfEverySizeClass )
+{
+	for ( size_t length : { size_t( 1 ), size_t( 16 ), size_t( 17 ), size_t( 65 ), size_t( 1000 ), Pique::SecureArena::MAXIMUM_BLOCK_SIZE, Pique::SecureArena::MAXIMUM_BLOCK_SIZE + 1, size_t( 20000 ) } )
+	{
+		uint8_t* block = static_cast< uint8_t* >( Pique::SecureArena::allocate( length ) );
+
+		ASSERT_NE( nullptr, block );
+		ASSERT_EQ( 0, reinterpret_cast< uintptr_t >( block ) % Pique::SecureArena::MINIMUM_BLOCK_SIZE );
+
+		std::memset( block, 0xA5, length );
+		Pique::SecureArena::deallocate( block, length );
+	}
+}
+
+TEST( TestSecureArena, AllocatedBlocksShallNotOverlap )
+{
+	std::vector< uint8_t* > blocks;
+	for ( size_t index( -1 ); ++index < 100; )
+	{
+		blocks.push_back( static_cast< uint8_t* >( Pique::SecureArena::allocate( 48 ) ) );
+		ASSERT_NE( nullptr, blocks.back() );
+		std::memset( blocks.back(), int( index ), 48 );
+	}
+
+	for ( size_t index( -1 ); ++index < blocks.size(); )
+	{
+		for ( size_t offset( -1 ); ++offset < 48; )
+		{
+			ASSERT_EQ( uint8_t( index ), blocks[ index ][ offset ] );
+		}
+
+		Pique::SecureArena::deallocate( blocks[ index ], 48 );
+	}
+}
+
+TEST( TestSecureArena, DeallocateShallZeroizeTheBlock )
+{
+	uint8_t* block = static_cast< uint8_t* >( Pique::SecureArena::allocate( 128 ) );
+	ASSERT_NE( nullptr, block );
+	std::memset( block, 0xA5, 128 );
+
+	Pique::SecureArena::deallocate( block, 128 );
+
+	// The first word of a free block links it into a free list.
+	for ( size_t offset( sizeof( void* ) - 1 ); ++offset < 128; )
+	{
+		ASSERT_EQ( 0, block[ offset ] );
+	}
+
+	uint8_t* reusedBlock = static_cast< uint8_t* >( Pique::SecureArena::allocate( 128 ) );
+	ASSERT_EQ( block, reusedBlock );
+	for ( size_t offset( -1 ); ++offset < 128; )
+	{
+		ASSERT_EQ( 0, reusedBlock[ offset ] );
+	}
+
+	Pique::SecureArena::deallocate( reusedBlock, 128 );
+}
+
+TEST( TestSecureArena, BlocksAllocatedByAnotherThreadShallBeReusedOnceFreed )
+{
+	std::vector< void* > blocks;
+	std::thread( [ & ]()
+		{
+			for ( size_t index( -1 ); ++index < 100; )
+			{
+				blocks.push_back( Pique::SecureArena::allocate( 32 ) );
+			}
+		} ).join();
+
+	size_t mappedBytes = Pique::SecureArena::statistics().mMappedBytes;
+	for ( void* block : blocks )
+	{
+		Pique::SecureArena::deallocate( block, 32 );
+	}
+
+	for ( size_t index( -1 ); ++index < 100; )
+	{
+		blocks[ index ] = Pique::SecureArena::allocate( 32 );
+	}
+
+	ASSERT_EQ( mappedBytes, Pique::SecureArena::statistics().mMappedBytes );
+	for ( void* block : blocks )
+	{
+		Pique::SecureArena::deallocate( block, 32 );
+	}
+}
+
+TEST( TestSecureArena, AllocateShallTakeOneBlockFromTheDomainOnceTheThreadCacheIsFlushed )
+{
+	// Counts the blocks of 32 bytes the domain can hand out without mapping a region.
+	auto available = []()
+	{
+		Pique::SecureArena::Domain& domain = Pique::SecureArena::__domain();
+		std::lock_guard< std::mutex > lock( domain.mMutex );
+		size_t sizeClass = Pique::SecureArena::__sizeClass( 32 );
+		size_t blocks = size_t( domain.mRegionEnd - domain.mRegionCursor ) / ( Pique::SecureArena::MINIMUM_BLOCK_SIZE << sizeClass );
+		for ( Pique::SecureArena::FreeBlock* block = domain.mFreeLists[ sizeClass ]; nullptr != block; block = block->mNext )
+		{
+			++blocks;
+		}
+
+		return blocks;
+	};
+
+	// Destroyed after the cache of the thread is flushed, as it is constructed before the cache.
+	struct AllocateAtExit
+	{
+		void** mBlock;
+
+		~AllocateAtExit()
+		{
+			*mBlock = Pique::SecureArena::allocate( 32 );
+		}
+	};
+
+	void* block = Pique::SecureArena::allocate( 32 );
+	Pique::SecureArena::deallocate( block, 32 );
+	block = nullptr;
+
+	size_t availableBefore = available();
+	std::thread( [ & ]()
+		{
+			thread_local AllocateAtExit allocateAtExit { &block };
+			( void )allocateAtExit;
+			Pique::SecureArena::deallocate( Pique::SecureArena::allocate( 32 ), 32 );
+		} ).join();
+
+	ASSERT_NE( nullptr, block );
+	ASSERT_EQ( availableBefore - 1, available() );
+
+	Pique::SecureArena::deallocate( block, 32 );
+}
+
+TEST( TestSecureArena, AllocateShallReturnNullOnceTheCapacityIsReached )
+{
+	Pique::SecureArena::Statistics statistics = Pique::SecureArena::statistics();
+	size_t largeLength = 4 * Pique::SecureArena::REGION_SIZE;
+
+	Pique::SecureArena::setCapacity( statistics.mMappedBytes + largeLength - 1 );
+	ASSERT_EQ( nullptr, Pique::SecureArena::allocate( largeLength ) );
+
+	Pique::SecureArena::setCapacity( statistics.mMappedBytes + largeLength );
+	void* block = Pique::SecureArena::allocate( largeLength );
+	ASSERT_NE( nullptr, block );
+	ASSERT_EQ( statistics.mMappedBytes + largeLength, Pique::SecureArena::statistics().mMappedBytes );
+
+	Pique::SecureArena::deallocate( block, largeLength );
+	ASSERT_EQ( statistics.mMappedBytes, Pique::SecureArena::statistics().mMappedBytes );
+
+	Pique::SecureArena::setCapacity( statistics.mCapacity );
+}
+
+TEST( TestSecureArena, KeysBeyondTheInlineCapacityShallFallBackToTheHeapOnceTheArenaIsFull )
+{
+	std::vector< uint8_t > value( Pique::Key::INLINE_CAPACITY + 1, 0xA5 );
+	Pique::SecureArena::Statistics statistics = Pique::SecureArena::statistics();
+
+	Pique::SecureArena::setCapacity( 0 );
+	std::vector< Pique::Key > keys;
+	for ( size_t index( -1 ); ++index < 1000; )
+	{
+		keys.emplace_back( value.data(), value.size() );
+	}
+
+	Pique::SecureArena::setCapacity( statistics.mCapacity );
+
+	for ( const Pique::Key& key : keys )
+	{
+		ASSERT_EQ( value.size(), key.length() );
+		ASSERT_EQ( 0, std::memcmp( value.data(), key.key().get(), value.size() ) );
+	}
+}
+
+TEST( TestSecureArena, WritingPastALargeBlockShallFault )
+{
+	size_t length = 2 * size_t( sysconf( _SC_PAGESIZE ) );
+
+	ASSERT_DEATH(
+		{
+			uint8_t* volatile block = static_cast< uint8_t* >( Pique::SecureArena::allocate( length ) );
+			if ( nullptr != block )
+			{
+				block[ length ] = 1;
+			}
+		}, "" );
+}
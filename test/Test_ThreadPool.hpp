@@ -0,0 +1,113 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+TEST( TestThreadPool, ParallelForShallVisitEveryIndexExactlyOnce )
+{
+	for ( size_t workerCount : { size_t( 0 ), size_t( 1 ), size_t( 4 ) } )
+	{
+		Pique::ThreadPool threadPool( workerCount );
+		ASSERT_EQ( workerCount + 1, threadPool.concurrency() );
+
+		for ( uint64_t grain : { uint64_t( 0 ), uint64_t( 1 ), uint64_t( 7 ), uint64_t( 5000 ) } )
+		{
+			std::vector< std::atomic< uint32_t > > visits( 1000 );
+			std::atomic< uint64_t > longestRange( 0 );
+			threadPool.parallelFor( 3, visits.size(), grain, [ & ]( uint64_t first, uint64_t last )
+				{
+					uint64_t range = last - first;
+					uint64_t longest = longestRange.load();
+					while ( ( range > longest ) and not longestRange.compare_exchange_weak( longest, range ) )
+					{
+					}
+
+					for ( uint64_t index = first; index < last; ++index )
+					{
+						visits[ index ].fetch_add( 1 );
+					}
+				} );
+
+			for ( size_t index( -1 ); ++index < visits.size(); )
+			{
+				ASSERT_EQ( ( 3 <= index ) ? 1 : 0, visits[ index ].load() ) << workerCount << " " << grain << " " << index;
+			}
+
+			ASSERT_GE( std::max< uint64_t >( grain, 1 ), longestRange.load() );
+		}
+	}
+}
+
+TEST( TestThreadPool, AnEmptyRangeShallNotCallTheFunction )
+{
+	Pique::ThreadPool threadPool( 2 );
+	bool called = false;
+	threadPool.parallelFor( 5, 5, 1, [ & ]( uint64_t, uint64_t ) { called = true; } );
+	threadPool.parallelFor( 6, 5, 1, [ & ]( uint64_t, uint64_t ) { called = true; } );
+	ASSERT_FALSE( called );
+}
+
+TEST( TestThreadPool, WorkersShallShareTheLoop )
+{
+	Pique::ThreadPool threadPool( 3 );
+	std::mutex threadsMutex;
+	std::set< std::thread::id > threads;
+	threadPool.parallelFor( 0, 64, 1, [ & ]( uint64_t, uint64_t )
+		{
+			{
+				std::lock_guard< std::mutex > threadsLock( threadsMutex );
+				threads.insert( std::this_thread::get_id() );
+			}
+
+			std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+		} );
+
+	ASSERT_LT( 1, threads.size() );
+}
+
+TEST( TestThreadPool, LoopsShallNestAndRunFromSeveralThreadsAtOnce )
+{
+	Pique::ThreadPool threadPool( 3 );
+	std::atomic< uint64_t > sum( 0 );
+	std::vector< std::thread > callers;
+	for ( size_t caller( -1 ); ++caller < 4; )
+	{
+		callers.emplace_back( [ & ]()
+			{
+				threadPool.parallelFor( 0, 16, 1, [ & ]( uint64_t first, uint64_t last )
+					{
+						for ( uint64_t outer = first; outer < last; ++outer )
+						{
+							threadPool.parallelFor( 0, 100, 3, [ & ]( uint64_t innerFirst, uint64_t innerLast )
+								{
+									for ( uint64_t inner = innerFirst; inner < innerLast; ++inner )
+									{
+										sum.fetch_add( inner );
+									}
+								} );
+						}
+					} );
+			} );
+	}
+
+	for ( std::thread& caller : callers )
+	{
+		caller.join();
+	}
+
+	ASSERT_EQ( 4 * 16 * 4950, sum.load() );
+}
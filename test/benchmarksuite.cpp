@@ -0,0 +1,24 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+#include <benchmark/benchmark.h>
+
+#define private public
+
+#include "Bench_AESGCM.hpp"
+#include "Bench_BLAKE3.hpp"
+#include "Bench_ChaCha20Poly1305.hpp"
+#include "Bench_FileHash.hpp"
+#include "Bench_HashFunction.hpp"
+#include "Bench_Hex.hpp"
+#include "Bench_HMAC.hpp"
+#include "Bench_Key.hpp"
+#include "Bench_Keyring.hpp"
+#include "Bench_MerkleTree.hpp"
+#include "Bench_SHA256.hpp"
+#include "Bench_SHA3.hpp"
+#include "Bench_SHA512.hpp"
+
+BENCHMARK_MAIN();
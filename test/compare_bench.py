@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+#
+# Copyright ©2021. Brent Weichel. All Rights Reserved.
+# Permission to use, copy, modify, and/or distribute this software, in whole
+# or part by any means, without express prior written agreement is prohibited.
+#
+"""Compare two PiqueCryptoBench JSON runs and flag regressions.
+
+Produce a run with the bench_json target, or directly with
+    PiqueCryptoBench --benchmark_out=run.json --benchmark_out_format=json
+
+then compare a baseline run against a candidate run:
+    compare_bench.py baseline.json candidate.json [--threshold 0.10]
+
+A benchmark regresses when its time per iteration grows by more than the
+threshold. When the runs were made with --benchmark_repetitions, the median of
+the repetitions is compared. The exit status is 1 if any benchmark regressed,
+2 if the runs could not be read, else 0.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+TIME_UNIT_NANOSECONDS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path):
+    """Return {benchmark name: nanoseconds per iteration} of the run at path."""
+    with open(path) as run:
+        benchmarks = json.load(run)["benchmarks"]
+
+    times = {}
+    medians = {}
+    for benchmark in benchmarks:
+        if benchmark.get("error_occurred"):
+            continue
+
+        nanoseconds = benchmark["real_time"] * TIME_UNIT_NANOSECONDS[benchmark.get("time_unit", "ns")]
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[benchmark["run_name"]] = nanoseconds
+        else:
+            # Without aggregates the last repetition of a benchmark wins.
+            times[benchmark.get("run_name", benchmark["name"])] = nanoseconds
+
+    times.update(medians)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag benchmarks of a candidate run that regressed from a baseline run.")
+    parser.add_argument("baseline", help="JSON output of the baseline run")
+    parser.add_argument("candidate", help="JSON output of the candidate run")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown above which a benchmark regresses (default: 0.10)")
+    parser.add_argument("--filter", default="", help="only compare benchmarks whose name matches this regular expression")
+    arguments = parser.parse_args()
+
+    try:
+        baseline = load_times(arguments.baseline)
+        candidate = load_times(arguments.candidate)
+    except (OSError, ValueError, KeyError) as error:
+        print("compare_bench: %s" % error, file=sys.stderr)
+        return 2
+
+    pattern = re.compile(arguments.filter)
+    names = [name for name in baseline if name in candidate and pattern.search(name)]
+    width = max([len(name) for name in names] + [len("Benchmark")])
+    print("%-*s %14s %14s %9s" % (width, "Benchmark", "Baseline (ns)", "Candidate (ns)", "Change"))
+
+    regressions = 0
+    for name in names:
+        change = candidate[name] / baseline[name] - 1.0 if baseline[name] else 0.0
+        regressed = arguments.threshold < change
+        regressions += regressed
+        print("%-*s %14.1f %14.1f %+8.1f%%%s" % (width, name, baseline[name], candidate[name], 100.0 * change,
+                                              "  REGRESSION" if regressed else ""))
+
+    for name in sorted(set(baseline) ^ set(candidate)):
+        if pattern.search(name):
+            print("%-*s only in the %s run" % (width, name, "baseline" if name in baseline else "candidate"))
+
+    print("%d of %d benchmarks regressed by more than %.1f%%" % (regressions, len(names), 100.0 * arguments.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -7,7 +7,30 @@
 
 #define private public
 
+// Count throughout the suite, so that the hooks run under every test.
+#define PIQUE_INSTRUMENTATION 1
+
+#include "Test_AESGCM.hpp"
+#include "Test_AnyHashFunction.hpp"
+#include "Test_AsyncHash.hpp"
+#include "Test_BLAKE3.hpp"
+#include "Test_ChaCha20Poly1305.hpp"
+#include "Test_ConstantTime.hpp"
+#include "Test_CpuFeatures.hpp"
+#include "Test_FileHash.hpp"
+#include "Test_HashFunction.hpp"
+#include "Test_Hex.hpp"
+#include "Test_HMAC.hpp"
+#include "Test_Instrumentation.hpp"
 #include "Test_Key.hpp"
+#include "Test_Keyring.hpp"
+#include "Test_MerkleTree.hpp"
+#include "Test_ReadCopyUpdate.hpp"
+#include "Test_SecureArena.hpp"
+#include "Test_SHA256.hpp"
+#include "Test_SHA3.hpp"
+#include "Test_SHA512.hpp"
+#include "Test_ThreadPool.hpp"
 
 int main( int argc, char** argv )
 {
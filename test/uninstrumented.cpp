@@ -0,0 +1,102 @@
+/**
+ * Copyright ©2021. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+
+/**
+ * Build every header the way an application does by default, without
+ * PIQUE_INSTRUMENTATION, and run the hooked paths once. The test suite always
+ * counts, so this is what compiles the disabled hooks, under -Wall -Wextra
+ * -Werror.
+ */
+#include <cstdint>
+#include <cstring>
+
+#include "AESGCM.hpp"
+#include "AnyHashFunction.hpp"
+#include "AsyncHash.hpp"
+#include "BLAKE3.hpp"
+#include "ChaCha20Poly1305.hpp"
+#include "ConstantTime.hpp"
+#include "CpuFeatures.hpp"
+#include "FileHash.hpp"
+#include "HashFunction.hpp"
+#include "Hex.hpp"
+#include "HMAC.hpp"
+#include "Instrumentation.hpp"
+#include "Key.hpp"
+#include "KeyBinding.hpp"
+#include "Keyring.hpp"
+#include "MerkleTree.hpp"
+#include "ReadCopyUpdate.hpp"
+#include "SecureArena.hpp"
+#include "SHA256.hpp"
+#include "SHA3.hpp"
+#include "SHA512.hpp"
+#include "ThreadPool.hpp"
+#include "Zeroize.hpp"
+
+#if defined( PIQUE_INSTRUMENTATION )
+#error "This translation unit checks the build without PIQUE_INSTRUMENTATION"
+#endif
+
+template < typename Hash >
+static bool HashesConsistently( const uint8_t* message, uint64_t messageLength )
+{
+	uint8_t messageDigest[ Hash::DIGEST_SIZE ];
+	uint8_t expectedDigest[ Hash::DIGEST_SIZE ];
+	char hexMessageDigest[ 2 * Hash::DIGEST_SIZE ];
+	Hash hash;
+	hash.update( message, messageLength );
+	hash.digest( messageDigest );
+	hash.hexDigest( hexMessageDigest );
+	Hash::digestMessage( expectedDigest, message, messageLength );
+	return 0 == std::memcmp( messageDigest, expectedDigest, Hash::DIGEST_SIZE );
+}
+
+template < typename Hash >
+static bool ExtendsConsistently( const uint8_t* message, uint64_t messageLength )
+{
+	uint8_t shortDigest[ 32 ];
+	uint8_t longDigest[ 64 ];
+	Hash hash;
+	hash.update( message, messageLength );
+	hash.digest( shortDigest, sizeof( shortDigest ) );
+	hash.digest( longDigest, sizeof( longDigest ) );
+	return 0 == std::memcmp( shortDigest, longDigest, sizeof( shortDigest ) );
+}
+
+int main()
+{
+	static const uint8_t message[] = { 'a', 'b', 'c' };
+	static const uint8_t keyValue[ 32 ] = { 1, 2, 3, 4 };
+	static const uint8_t nonce[ 12 ] = { 0 };
+
+	bool passed = HashesConsistently< Pique::SHA256 >( message, sizeof( message ) )
+		and HashesConsistently< Pique::SHA512 >( message, sizeof( message ) )
+		and HashesConsistently< Pique::SHA3_256 >( message, sizeof( message ) )
+		and ExtendsConsistently< Pique::SHAKE128 >( message, sizeof( message ) )
+		and ExtendsConsistently< Pique::BLAKE3 >( message, sizeof( message ) );
+
+	Pique::AnyHashFunction anyHash( Pique::SHA256 {} );
+	anyHash.update( message, sizeof( message ) );
+
+	Pique::Key key( keyValue, sizeof( keyValue ) );
+	Pique::Keyring keyring;
+	keyring.set( 1, key );
+	passed = passed and ( key == keyring.find( 1 ) );
+
+	uint8_t mac[ Pique::HMAC< Pique::SHA256 >::DIGEST_SIZE ];
+	uint8_t ciphertext[ sizeof( message ) ];
+	uint8_t tag[ 16 ];
+	Pique::HMAC< Pique::SHA256 > hmac( key );
+	Pique::AESGCM aesGcm( key );
+	Pique::ChaCha20Poly1305 chaCha20Poly1305( key );
+	passed = passed and hmac.digestMessage( mac, message, sizeof( message ) )
+		and aesGcm.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) )
+		and chaCha20Poly1305.seal( ciphertext, tag, message, sizeof( message ), nonce, sizeof( nonce ) );
+
+	passed = passed and ( 0 == Pique::Instrumentation::snapshot().counters[ Pique::Instrumentation::HASH_DIGESTS ] );
+	return passed ? 0 : 1;
+}